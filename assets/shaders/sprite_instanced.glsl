@@ -0,0 +1,33 @@
+#shader vertex
+#version 330 core
+
+layout (location = 0) in vec2 position;
+layout (location = 1) in vec4 instance_transform;   // position xy, scale zw
+layout (location = 2) in vec4 instance_rect;        // u, v, width, height...a negative width mirrors the sprite
+layout (location = 3) in float instance_angle;
+
+out vec2 tex_coords;
+
+void main()
+{
+  float c = cos(instance_angle);
+  float s = sin(instance_angle);
+  vec2 scaled = position * instance_transform.zw;
+
+  gl_Position = vec4(scaled.x * c - scaled.y * s + instance_transform.x, scaled.x * s + scaled.y * c + instance_transform.y, 0.f, 1.f);
+  tex_coords = instance_rect.xy + vec2((position.x + 1.f) / 2.f, 1.f - (position.y + 1.f) / 2.f) * instance_rect.zw;
+}
+
+#shader fragment
+#version 330 core
+
+in vec2 tex_coords;
+
+out vec4 out_color;
+
+uniform sampler2D _texture;
+
+void main()
+{
+  out_color = texture(_texture, tex_coords);
+}
@@ -1,18 +1,323 @@
 #pragma once
 
 #include "Core.h"
+#include "Profiler.h"
+#include "vec4.h"
+#include "vector.h"
+#include "unordered_map.h"
+#include "AssetPack.h"
 
 
-enum class ANIM_STATE
+/// Animation API Reference
+////// bool LoadAnimationClips(const char* path);
+////// s32 FindAnimationClip(const char* name);
+////// s32 CreateAnimation(s32 clip);
+////// void DestroyAnimation(s32 animation);
+////// void PlayAnimation(s32 animation, s32 clip);
+////// void SetAnimationFlipped(s32 animation, bool flipped);
+////// void SetAnimationSpeed(s32 animation, f32 speed);
+////// void UpdateAnimations(f32 delta_seconds);
+////// vec4 GetAnimationRect(s32 animation);
+
+// clips come from .enanim files in assets/animations...a clip is a run of frames, each one a uv
+// rect into the sprite sheet with its own duration, plus what happens at the end of the run:
+//   clip <name> <once|loop|pingpong>
+//   frame <u> <v> <width> <height> <seconds>
+//   grid <columns> <rows> <first> <count> <seconds>     (count frames cut row by row from a grid sheet)
+
+// every animated thing owns an animation state, stored as flat arrays and all advanced by one pass
+// of UpdateAnimations per simulation tick...the pass leaves each state's current uv rect in rect[]
+// for the sprite batch to upload as instance data
+
+enum class ANIM_LOOP : u8
 {
-  ACTIVE,
-  INACTIVE
+  ONCE,       // stops on the last frame
+  LOOP,
+  PING_PONG
 };
 
-struct AnimInfo
+struct AnimationClip
 {
-  s32 anim_frame = 0;
-  bool anim_flipped = false;
-  TimerInfo anim_timer;
-  ANIM_STATE anim_state = ANIM_STATE::INACTIVE;
+  std::string name;
+  s32 first_frame;
+  s32 frame_count;
+  ANIM_LOOP loop;
 };
+
+static struct
+{
+  en::vector<AnimationClip> clips;
+  en::unordered_map<std::string, s32> names;
+  en::vector<vec4> frame_rects;       // every clip's frames back to back, u v width height
+  en::vector<f32> frame_seconds;
+} animation_clips;
+
+static struct
+{
+  en::vector<s32> clip;               // -1 for free slots, which the update skips
+  en::vector<s32> frame;              // index inside the clip
+  en::vector<s32> direction;          // 1 or -1, only ping pong ever turns around
+  en::vector<f32> elapsed;            // seconds into the current frame
+  en::vector<f32> frame_end;          // how long the current frame lasts, huge when it never ends
+  en::vector<f32> speed;              // 0 for free slots so they never come due
+  en::vector<u8> flipped;
+  en::vector<vec4> rect;              // written by UpdateAnimations, a flipped rect has a negative width
+  en::vector<s32> free_slots;
+  en::vector<s32> due;                // scratch for the states that change frame this tick, one per slot
+} animations;
+
+static void AddAnimationFrame(AnimationClip& clip, vec4 rect, f32 seconds)
+{
+  animation_clips.frame_rects.PushBack(rect);
+  animation_clips.frame_seconds.PushBack(seconds > 0.001f ? seconds : 0.001f);
+  clip.frame_count++;
+}
+
+bool LoadAnimationClips(const char* path)
+{
+  PROFILE_FUNCTION();
+
+  std::string filepath = AssetPath("animations/").append(path);
+  AssetStream stream(filepath);
+  if (!stream)
+  {
+    DebugPrintToConsole("Failed to load animation clips: ", filepath);
+    return false;
+  }
+
+  // clips are only added once their frames are read, so frames always stay contiguous per clip
+  AnimationClip clip;
+  bool has_clip = false;
+  auto finish_clip = [&]()
+  {
+    if (!has_clip) return;
+
+    if (clip.frame_count == 0)
+    {
+      DebugPrintToConsole("Animation clip has no frames: ", clip.name);
+    }
+    else
+    {
+      animation_clips.names.Insert(clip.name, animation_clips.clips.Size());
+      animation_clips.clips.PushBack(clip);
+    }
+
+    has_clip = false;
+  };
+
+  std::string line;
+  while (std::getline(stream, line))
+  {
+    std::istringstream words(line);
+    std::string word;
+    if (!(words >> word)) continue;
+
+    if (word == "clip")
+    {
+      finish_clip();
+
+      std::string loop;
+      words >> clip.name >> loop;
+      clip.first_frame = animation_clips.frame_rects.Size();
+      clip.frame_count = 0;
+      clip.loop = loop == "once" ? ANIM_LOOP::ONCE : loop == "pingpong" ? ANIM_LOOP::PING_PONG : ANIM_LOOP::LOOP;
+      has_clip = true;
+    }
+    else if (word == "frame" && has_clip)
+    {
+      f32 u, v, width, height, seconds;
+      if (words >> u >> v >> width >> height >> seconds) AddAnimationFrame(clip, vec4(u, v, width, height), seconds);
+    }
+    else if (word == "grid" && has_clip)
+    {
+      s32 columns, rows, first, count;
+      f32 seconds;
+      if (!(words >> columns >> rows >> first >> count >> seconds) || columns <= 0 || rows <= 0) continue;
+
+      for (s32 i = first; i < first + count && i < columns * rows; i++)
+      {
+        AddAnimationFrame(clip, vec4((f32)(i % columns) / columns, (f32)(i / columns) / rows, 1.f / columns, 1.f / rows), seconds);
+      }
+    }
+  }
+
+  finish_clip();
+  DebugPrintToConsole("Successfully loaded animation clips: ", filepath);
+  return true;
+}
+
+s32 FindAnimationClip(const char* name)
+{
+  if (!animation_clips.names.Find(name))
+  {
+    DebugPrintToConsole("Failed to find animation clip: ", name);
+    return -1;
+  }
+
+  return animation_clips.names.At(name);
+}
+
+static const f32 ANIM_FRAME_NEVER_ENDS = 1e30f;
+
+static inline vec4 AnimationRect(s32 frame, bool flipped)
+{
+  vec4 rect = animation_clips.frame_rects[frame];
+  if (flipped) rect = vec4(rect.x() + rect.z(), rect.y(), -rect.z(), rect.w());
+  return rect;
+}
+
+// a destroyed state has clip -1 until its slot is handed out again
+static inline bool IsAnimationAlive(s32 animation)
+{
+  return animation >= 0 && animation < animations.clip.Size() && animations.clip[animation] >= 0;
+}
+
+s32 CreateAnimation(s32 clip)
+{
+  if (clip < 0 || clip >= animation_clips.clips.Size()) return -1;
+
+  s32 animation;
+  if (animations.free_slots.Size() > 0)
+  {
+    animation = animations.free_slots[animations.free_slots.Size() - 1];
+    animations.free_slots.PopBack();
+  }
+  else
+  {
+    animation = animations.clip.Size();
+    animations.clip.PushBack(-1);
+    animations.frame.PushBack(0);
+    animations.direction.PushBack(1);
+    animations.elapsed.PushBack(0.f);
+    animations.frame_end.PushBack(ANIM_FRAME_NEVER_ENDS);
+    animations.speed.PushBack(1.f);
+    animations.flipped.PushBack(0);
+    animations.rect.PushBack(vec4());
+    animations.due.PushBack(0);
+  }
+
+  animations.clip[animation] = clip;
+  animations.frame[animation] = 0;
+  animations.direction[animation] = 1;
+  animations.elapsed[animation] = 0.f;
+  animations.frame_end[animation] = animation_clips.frame_seconds[animation_clips.clips[clip].first_frame];
+  animations.speed[animation] = 1.f;
+  animations.flipped[animation] = 0;
+  animations.rect[animation] = AnimationRect(animation_clips.clips[clip].first_frame, false);
+
+  return animation;
+}
+
+void DestroyAnimation(s32 animation)
+{
+  if (animation < 0 || animation >= animations.clip.Size() || animations.clip[animation] < 0) return;
+
+  animations.clip[animation] = -1;
+  animations.speed[animation] = 0.f;
+  animations.elapsed[animation] = 0.f;
+  animations.free_slots.PushBack(animation);
+}
+
+// switching clips starts the new one from its first frame, asking for the clip that is already
+// playing leaves it alone so this can be called every tick
+void PlayAnimation(s32 animation, s32 clip)
+{
+  if (!IsAnimationAlive(animation) || clip < 0 || clip >= animation_clips.clips.Size() || animations.clip[animation] == clip) return;
+
+  animations.clip[animation] = clip;
+  animations.frame[animation] = 0;
+  animations.direction[animation] = 1;
+  animations.elapsed[animation] = 0.f;
+  animations.frame_end[animation] = animation_clips.frame_seconds[animation_clips.clips[clip].first_frame];
+  animations.rect[animation] = AnimationRect(animation_clips.clips[clip].first_frame, animations.flipped[animation] != 0);
+}
+
+void SetAnimationFlipped(s32 animation, bool flipped)
+{
+  if (!IsAnimationAlive(animation)) return;
+
+  animations.flipped[animation] = flipped ? 1 : 0;
+  const AnimationClip& clip = animation_clips.clips[animations.clip[animation]];
+  animations.rect[animation] = AnimationRect(clip.first_frame + animations.frame[animation], flipped);
+}
+
+// 0 pauses, negative speeds aren't supported
+void SetAnimationSpeed(s32 animation, f32 speed)
+{
+  if (IsAnimationAlive(animation)) animations.speed[animation] = speed > 0.f ? speed : 0.f;
+}
+
+// two passes...the first only advances the clocks and notes which states ran past the end of their
+// frame, it has no branches or clip lookups so it vectorizes. the second steps just those states,
+// usually a small fraction of them since frames last several ticks
+void UpdateAnimations(f32 delta_seconds)
+{
+  PROFILE_FUNCTION();
+
+  s32 count = animations.clip.Size();
+  if (count == 0) return;
+
+  f32* elapsed = &animations.elapsed[0];
+  f32* frame_end = &animations.frame_end[0];
+  const f32* speed = &animations.speed[0];
+  s32* due = &animations.due[0];
+  s32 due_count = 0;
+
+  for (s32 i = 0; i < count; i++)
+  {
+    elapsed[i] += delta_seconds * speed[i];
+    due[due_count] = i;
+    due_count += elapsed[i] >= frame_end[i] ? 1 : 0;
+  }
+
+  const AnimationClip* clips = &animation_clips.clips[0];
+  const f32* seconds = &animation_clips.frame_seconds[0];
+  const s32* clip = &animations.clip[0];
+  s32* frame = &animations.frame[0];
+  s32* direction = &animations.direction[0];
+  const u8* flipped = &animations.flipped[0];
+  vec4* rect = &animations.rect[0];
+
+  for (s32 d = 0; d < due_count; d++)
+  {
+    s32 i = due[d];
+    const AnimationClip& c = clips[clip[i]];
+
+    while (elapsed[i] >= frame_end[i])
+    {
+      elapsed[i] -= frame_end[i];
+      s32 next = frame[i] + direction[i];
+
+      if (next >= c.frame_count || next < 0)
+      {
+        if (c.loop == ANIM_LOOP::ONCE)
+        {
+          elapsed[i] = 0.f;
+          frame_end[i] = ANIM_FRAME_NEVER_ENDS;
+          break;
+        }
+
+        if (c.loop == ANIM_LOOP::LOOP)
+        {
+          next = 0;
+        }
+        else
+        {
+          direction[i] = -direction[i];
+          next = c.frame_count > 1 ? frame[i] + direction[i] : 0;
+        }
+      }
+
+      frame[i] = next;
+      frame_end[i] = seconds[c.first_frame + next];
+    }
+
+    rect[i] = AnimationRect(c.first_frame + frame[i], flipped[i] != 0);
+  }
+}
+
+vec4 GetAnimationRect(s32 animation)
+{
+  if (animation < 0 || animation >= animations.rect.Size()) return vec4(0.f, 0.f, 1.f, 1.f);
+  return animations.rect[animation];
+}
@@ -0,0 +1,661 @@
+#pragma once
+
+#include "Core.h"
+#include "vector.h"
+#include "MappedFile.h"
+#include "Compression.h"
+#include "WorkerPool.h"
+#include <algorithm>
+#include <mutex>
+
+
+/// Asset Pack API Reference
+////// void FindAssetRoot(const char* executable_path);
+////// bool MountAssetPack(const char* path);
+////// void UnmountAssetPack();
+////// AssetSpan FindPackedAsset(const char* path);
+////// bool MapPackedAsset(const char* path, MappedFile& file, bool keep = false);
+////// bool MapAssetFile(const char* path, MappedFile& file, bool keep = false);   // keep when the view outlives the load
+////// bool WriteAssetPack(const char* directory, const char* output, bool compress);
+////// AssetStream stream(path);                       // an istream over an asset, read where it is mapped
+
+// an asset pack is every file under assets/ in one file, mapped whole at startup. a lookup hashes the
+// path, the top bits of the hash pick a bucket and the bucket is a handful of entries (sorted by hash)
+// to compare against, so finding an asset costs the same with 10 files or 100000 and opens nothing.
+// what comes back points straight into the mapping, nothing is read until it is touched
+
+// with EN_LOOSE_ASSETS a file under the asset root wins over the pack's copy, so edited assets (and
+// hot reload) work without repacking...shipping builds leave it off and only look in the pack, or
+// only at loose files when no pack is mounted
+
+// layout: header, entries sorted by hash, (1 << bucket_bits) + 1 bucket starts, the paths, then the
+// data with every entry starting on ASSET_PACK_ALIGN bytes. paths are relative to assets/ with /
+// between folders. tools/AssetPacker.cpp builds one, WriteAssetPack does the work
+
+// a compressed entry is split into ASSET_PACK_BLOCK sized blocks compressed on their own (Compression.h),
+// stored as a table of packed block sizes and then the blocks, so any block can be decoded without the
+// ones before it. big entries are decoded a few blocks a job on the workers, small ones on the calling
+// thread into a scratch arena that empties itself once nothing points into it. entries only get
+// compressed when it saves an eighth, so pngs and the like stay stored and zero copy
+
+const u32 ASSET_PACK_MAGIC = 0x4B504E45;    // "ENPK"
+const u32 ASSET_PACK_VERSION = 2;
+const u32 ASSET_PACK_ALIGN = 64;
+const u32 ASSET_PACK_BLOCK = 64 * 1024;
+const u32 ASSET_PACK_BLOCK_STORED = 0x80000000;     // set in a block's size when it wasn't worth compressing
+const u32 ASSET_PACK_JOB_BLOCKS = 4;                // blocks a decompression job, 256 KB of output
+const u32 ASSET_PACK_SCRATCH_SIZE = 4 * 1024 * 1024;
+const u32 ASSET_PACK_SCRATCH_LIMIT = 256 * 1024;    // bigger entries go on the heap and the workers
+const u32 ASSET_PACK_SHUFFLE_STRIDE = 2;            // 16 bit pcm, the low bytes are noise and the high ones aren't
+
+const u32 ASSET_PACK_COMPRESSED = 1 << 0;
+const u32 ASSET_PACK_SHUFFLED = 1 << 1;             // blocks were byte shuffled before compressing
+
+struct AssetPackHeader
+{
+  u32 magic;
+  u32 version;
+  u32 entry_count;
+  u32 bucket_bits;
+  u64 entries_offset;
+  u64 buckets_offset;
+  u64 paths_offset;
+  u64 data_offset;
+  u64 size;
+};
+
+struct AssetPackEntry
+{
+  u64 hash;
+  u64 offset;             // from the start of the pack
+  u64 size;               // once decompressed
+  u64 packed_size;        // what it takes in the pack, size when it is stored
+  u32 path_offset;        // into the paths
+  u32 path_length;
+  u32 flags;
+  u32 block_count;        // compressed entries only
+};
+
+struct AssetSpan
+{
+  const u8* data = nullptr;
+  u64 size = 0;
+};
+
+static struct
+{
+  MappedFile file;
+  const AssetPackHeader* header = nullptr;
+  const AssetPackEntry* entries = nullptr;
+  const u32* buckets = nullptr;
+  const char* paths = nullptr;
+} asset_pack;
+
+// where small compressed entries are decoded to, bump allocated and reset when the last view into it
+// is unmapped...a full arena means the heap for that one asset
+static struct
+{
+  std::mutex lock;
+  u8* data = nullptr;
+  u64 used = 0;
+  u32 live = 0;
+
+  struct
+  {
+    u64 scratch_loads = 0;
+    u64 heap_loads = 0;
+    u64 parallel_loads = 0;
+  } stats;
+} asset_scratch;
+
+// fnv-1a over the path with \ read as /, so windows paths find the same entry
+static inline u64 HashPackPath(const char* path, u64 length)
+{
+  u64 hash = 14695981039346656037ull;
+  for (u64 i = 0; i < length; i++)
+  {
+    u8 c = path[i] == '\\' ? '/' : (u8)path[i];
+    hash = (hash ^ c) * 1099511628211ull;
+  }
+
+  return hash;
+}
+
+static inline bool SamePackPath(const char* a, const char* b, u64 length)
+{
+  for (u64 i = 0; i < length; i++)
+  {
+    char x = a[i] == '\\' ? '/' : a[i];
+    char y = b[i] == '\\' ? '/' : b[i];
+    if (x != y) return false;
+  }
+
+  return true;
+}
+
+static inline u32 PackBucket(u64 hash, u32 bucket_bits)
+{
+  return (u32)(hash >> (64 - bucket_bits));
+}
+
+// looks next to the executable first, then from the working directory, for an assets folder...the
+// engine is normally run from build/<config>/ so ../../assets/ stays the fallback
+void FindAssetRoot(const char* executable_path)
+{
+  std::filesystem::path executable_dir = std::filesystem::path(executable_path ? executable_path : "").parent_path();
+  std::filesystem::path candidates[] = { executable_dir / "../../assets", executable_dir / "assets", "assets", "../../assets" };
+
+  std::error_code error;
+  for (auto& candidate : candidates)
+  {
+    if (!std::filesystem::is_directory(candidate, error)) continue;
+
+    asset_root = candidate.lexically_normal().generic_string();
+    if (asset_root.empty() || asset_root.back() != '/') asset_root += '/';
+    return;
+  }
+}
+
+void UnmountAssetPack()
+{
+  UnmapFile(asset_pack.file);
+  asset_pack.header = nullptr;
+  asset_pack.entries = nullptr;
+  asset_pack.buckets = nullptr;
+  asset_pack.paths = nullptr;
+}
+
+// checks every offset once here so lookups never have to
+bool MountAssetPack(const char* path)
+{
+  UnmountAssetPack();
+  if (!MapFile(path, asset_pack.file)) return false;
+
+  const u8* data = asset_pack.file.data;
+  u64 size = asset_pack.file.size;
+  const AssetPackHeader* header = (const AssetPackHeader*)data;
+
+  bool ok = size >= sizeof(AssetPackHeader) && header->magic == ASSET_PACK_MAGIC && header->version == ASSET_PACK_VERSION &&
+    header->size == size && header->bucket_bits >= 1 && header->bucket_bits <= 24;
+  // the tables are read in place, so they have to be aligned for the structs they're cast to
+  ok = ok && header->entries_offset % alignof(AssetPackEntry) == 0 && header->buckets_offset % alignof(u32) == 0;
+  ok = ok && header->entries_offset <= size && (size - header->entries_offset) / sizeof(AssetPackEntry) >= header->entry_count;
+  ok = ok && header->buckets_offset <= size && (size - header->buckets_offset) / sizeof(u32) >= ((u64)1 << header->bucket_bits) + 1;
+  ok = ok && header->paths_offset <= header->data_offset && header->data_offset <= size;
+
+  if (ok)
+  {
+    const AssetPackEntry* entries = (const AssetPackEntry*)(data + header->entries_offset);
+    const u32* buckets = (const u32*)(data + header->buckets_offset);
+    u64 paths_size = header->data_offset - header->paths_offset;
+
+    for (u32 e = 0; ok && e < header->entry_count; e++)
+    {
+      const AssetPackEntry& entry = entries[e];
+      ok = entry.offset <= size && entry.offset % ASSET_PACK_ALIGN == 0 && entry.packed_size <= size - entry.offset &&
+        (u64)entry.path_offset + entry.path_length <= paths_size;
+      if (!ok) break;
+
+      if (entry.flags & ASSET_PACK_COMPRESSED)
+      {
+        ok = entry.block_count == (entry.size + ASSET_PACK_BLOCK - 1) / ASSET_PACK_BLOCK &&
+          (u64)entry.block_count * sizeof(u32) <= entry.packed_size;
+      }
+      else ok = entry.flags == 0 && entry.packed_size == entry.size;
+    }
+    for (u32 b = 0; ok && b < (1u << header->bucket_bits); b++) ok = buckets[b] <= buckets[b + 1] && buckets[b + 1] <= header->entry_count;
+  }
+
+  if (!ok)
+  {
+    DebugPrintToConsole("Bad asset pack: ", path);
+    UnmapFile(asset_pack.file);
+    return false;
+  }
+
+  asset_pack.header = header;
+  asset_pack.entries = (const AssetPackEntry*)(data + header->entries_offset);
+  asset_pack.buckets = (const u32*)(data + header->buckets_offset);
+  asset_pack.paths = (const char*)(data + header->paths_offset);
+  DebugPrintToConsole("Mounted asset pack: ", path);
+  return true;
+}
+
+static const AssetPackEntry* FindPackEntry(const char* path)
+{
+  if (!asset_pack.header) return nullptr;
+
+  u64 length = strlen(path);
+  u64 hash = HashPackPath(path, length);
+  u32 bucket = PackBucket(hash, asset_pack.header->bucket_bits);
+
+  for (u32 e = asset_pack.buckets[bucket]; e < asset_pack.buckets[bucket + 1]; e++)
+  {
+    const AssetPackEntry& entry = asset_pack.entries[e];
+    if (entry.hash > hash) break;
+    if (entry.hash == hash && entry.path_length == length && SamePackPath(asset_pack.paths + entry.path_offset, path, length)) return &entry;
+  }
+
+  return nullptr;
+}
+
+// path relative to assets/, an empty span when there is no pack, it isn't in it or it is compressed
+// (MapAssetFile decodes those)
+AssetSpan FindPackedAsset(const char* path)
+{
+  const AssetPackEntry* entry = FindPackEntry(path);
+  if (!entry || (entry->flags & ASSET_PACK_COMPRESSED)) return AssetSpan();
+  return { asset_pack.file.data + entry->offset, entry->size };
+}
+
+// size is what the block decodes to, ASSET_PACK_BLOCK for all but the last
+static bool DecompressPackBlock(const u8* source, u32 packed, u8* destination, u64 size, u32 flags)
+{
+  u32 bytes = packed & ~ASSET_PACK_BLOCK_STORED;
+  if (packed & ASSET_PACK_BLOCK_STORED)
+  {
+    if (bytes != size) return false;
+    memcpy(destination, source, size);
+    return true;
+  }
+
+  if (!(flags & ASSET_PACK_SHUFFLED)) return LzDecompress(source, bytes, destination, size) == (s64)size;
+
+  static thread_local u8 shuffled[ASSET_PACK_BLOCK];
+  if (LzDecompress(source, bytes, shuffled, size) != (s64)size) return false;
+  UnshuffleBytes(destination, shuffled, size, ASSET_PACK_SHUFFLE_STRIDE);
+  return true;
+}
+
+struct AssetBlockJob
+{
+  const AssetPackEntry* entry;
+  const u8* source;       // the first of this job's blocks
+  u32 first_block;
+  u32 block_count;
+  u8* destination;        // the whole entry's
+  std::atomic<bool>* failed;
+};
+
+static void DecompressPackBlocks(const AssetPackEntry& entry, const u8* source, u32 first_block, u32 block_count, u8* destination, std::atomic<bool>& failed)
+{
+  const u32* sizes = (const u32*)(asset_pack.file.data + entry.offset);
+  for (u32 b = first_block; b < first_block + block_count; b++)
+  {
+    u64 at = (u64)b * ASSET_PACK_BLOCK;
+    u64 size = std::min<u64>(ASSET_PACK_BLOCK, entry.size - at);
+    if (!DecompressPackBlock(source, sizes[b], destination + at, size, entry.flags))
+    {
+      failed.store(true, std::memory_order_relaxed);
+      return;
+    }
+
+    source += sizes[b] & ~ASSET_PACK_BLOCK_STORED;
+  }
+}
+
+static void DecompressPackBlocksJob(void* data)
+{
+  AssetBlockJob* job = (AssetBlockJob*)data;
+  DecompressPackBlocks(*job->entry, job->source, job->first_block, job->block_count, job->destination, *job->failed);
+}
+
+// walks the block table once to check it against packed_size and to find where every job starts, the
+// decoding itself is split ASSET_PACK_JOB_BLOCKS at a time across the workers when there is more than a job's worth
+static bool DecompressPackEntry(const AssetPackEntry& entry, u8* destination)
+{
+  const u32* sizes = (const u32*)(asset_pack.file.data + entry.offset);
+  const u8* blocks = (const u8*)(sizes + entry.block_count);
+  u64 blocks_size = entry.packed_size - (u64)entry.block_count * sizeof(u32);
+
+  u32 job_count = (entry.block_count + ASSET_PACK_JOB_BLOCKS - 1) / ASSET_PACK_JOB_BLOCKS;
+  AssetBlockJob* jobs = job_count > 1 ? new AssetBlockJob[job_count] : nullptr;
+  std::atomic<bool> failed(false);
+
+  u64 packed = 0;
+  for (u32 b = 0; b < entry.block_count; b++)
+  {
+    if (jobs && b % ASSET_PACK_JOB_BLOCKS == 0)
+    {
+      u32 j = b / ASSET_PACK_JOB_BLOCKS;
+      jobs[j] = { &entry, blocks + packed, b, std::min(ASSET_PACK_JOB_BLOCKS, entry.block_count - b), destination, &failed };
+    }
+
+    packed += sizes[b] & ~ASSET_PACK_BLOCK_STORED;
+  }
+
+  if (packed > blocks_size)
+  {
+    delete[] jobs;
+    return false;
+  }
+
+  if (!jobs)
+  {
+    DecompressPackBlocks(entry, blocks, 0, entry.block_count, destination, failed);
+    return !failed.load(std::memory_order_relaxed);
+  }
+
+  PROFILE_SCOPE("DecompressPackEntry");
+  JobCounter counter(0);
+  for (u32 j = 0; j < job_count; j++) RunJob(DecompressPackBlocksJob, &jobs[j], &counter);
+  WaitForJobs(counter);
+
+  delete[] jobs;
+  asset_scratch.stats.parallel_loads++;
+  return !failed.load(std::memory_order_relaxed);
+}
+
+static u8* AllocateAssetScratch(u64 size)
+{
+  std::lock_guard<std::mutex> lock(asset_scratch.lock);
+  if (!asset_scratch.data) asset_scratch.data = new u8[ASSET_PACK_SCRATCH_SIZE];
+
+  u64 start = (asset_scratch.used + 15) & ~(u64)15;
+  if (start + size > ASSET_PACK_SCRATCH_SIZE) return nullptr;
+
+  asset_scratch.used = start + size;
+  asset_scratch.live++;
+  asset_scratch.stats.scratch_loads++;
+  return asset_scratch.data + start;
+}
+
+static void ReleaseAssetScratch(const MappedFile& /*file*/)
+{
+  std::lock_guard<std::mutex> lock(asset_scratch.lock);
+  if (--asset_scratch.live == 0) asset_scratch.used = 0;
+}
+
+static void ReleaseAssetHeap(const MappedFile& file)
+{
+  delete[] file.data;
+}
+
+// anything kept stays off the scratch arena, one long lived view in there would stop it ever resetting
+static bool LoadCompressedAsset(const AssetPackEntry& entry, MappedFile& file, bool keep)
+{
+  u8* data = !keep && entry.size <= ASSET_PACK_SCRATCH_LIMIT ? AllocateAssetScratch(entry.size) : nullptr;
+  file.release = ReleaseAssetScratch;
+  if (!data)
+  {
+    data = new u8[entry.size ? entry.size : 1];
+    file.release = ReleaseAssetHeap;
+    asset_scratch.stats.heap_loads++;
+  }
+
+  file.data = data;
+  file.size = entry.size;
+  file.borrowed = true;
+  if (DecompressPackEntry(entry, data)) return true;
+
+  DebugPrintToConsole("Corrupt asset in pack: ", std::string(asset_pack.paths + entry.path_offset, entry.path_length));
+  UnmapFile(file);
+  return false;
+}
+
+// path relative to assets/...comes back borrowed, from the pack's mapping or decompressed into memory
+// UnmapFile gives back. keep says the view is held on to (a mapped sound) rather than read and unmapped
+bool MapPackedAsset(const char* path, MappedFile& file, bool keep = false)
+{
+  file = MappedFile();
+  const AssetPackEntry* entry = FindPackEntry(path);
+  if (!entry) return false;
+  if (entry->flags & ASSET_PACK_COMPRESSED) return LoadCompressedAsset(*entry, file, keep);
+
+  file.data = asset_pack.file.data + entry->offset;
+  file.size = entry->size;
+  file.borrowed = true;
+  return true;
+}
+
+// what every loader reads assets through, path either relative to assets/ or an AssetPath
+bool MapAssetFile(const char* path, MappedFile& file, bool keep = false)
+{
+#ifdef EN_LOOSE_ASSETS
+  if (MapFile(path, file)) return true;
+#else
+  if (!asset_pack.header) return MapFile(path, file);
+#endif
+
+  const char* relative = path;
+  if (strncmp(path, asset_root.c_str(), asset_root.size()) == 0) relative += asset_root.size();
+  return MapPackedAsset(relative, file, keep);
+}
+
+// std::istream over an asset's bytes where they are mapped, for the text formats that are read line
+// by line...fails like an ifstream does when the asset isn't there
+class AssetStream : public std::istream
+{
+  struct Buffer : std::streambuf
+  {
+    void Set(const u8* data, u64 size)
+    {
+      char* begin = (char*)data;
+      setg(begin, begin, begin + size);
+    }
+  };
+
+  Buffer buffer;
+  MappedFile file;
+
+public:
+  AssetStream(const std::string& path) : std::istream(nullptr)
+  {
+    rdbuf(&buffer);
+    if (MapAssetFile(path.c_str(), file)) buffer.Set(file.data, file.size);
+    else setstate(std::ios::failbit);
+  }
+
+  ~AssetStream()
+  {
+    UnmapFile(file);
+  }
+
+  void close()
+  {
+    UnmapFile(file);
+    buffer.Set(nullptr, 0);
+  }
+};
+
+// ---- building a pack
+
+struct AssetPackSource
+{
+  std::string path;       // relative, / separated
+  std::string file;
+  u64 hash;
+  u64 size;
+  std::string packed;     // the compressed entry, empty when it is stored
+};
+
+static inline u64 AlignPack(u64 offset)
+{
+  return (offset + ASSET_PACK_ALIGN - 1) & ~(u64)(ASSET_PACK_ALIGN - 1);
+}
+
+static bool ReadPackSource(const AssetPackSource& source, en::vector<u8>& contents)
+{
+  // en::vector counts in s32, a source past 2 GB can't be held to pack it
+  if (source.size > 0x7FFFFFFF)
+  {
+    DebugPrintToConsole("Asset too big to pack: ", source.file);
+    return false;
+  }
+
+  std::ifstream file(source.file, std::ios::binary);
+  if ((u64)contents.Size() < source.size) contents.Resize((s32)source.size);
+  if (file.read((char*)contents.begin(), (std::streamsize)source.size)) return true;
+
+  DebugPrintToConsole("Failed to read asset: ", source.file);
+  return false;
+}
+
+// block table then blocks, see the top of the file...a block that doesn't shrink is kept as it is
+static void CompressPackSource(AssetPackSource& source, const u8* contents, bool shuffle)
+{
+  u32 block_count = (u32)((source.size + ASSET_PACK_BLOCK - 1) / ASSET_PACK_BLOCK);
+  u64 bound = LzCompressBound(ASSET_PACK_BLOCK);
+  u8* block = new u8[bound];
+  u8* shuffled = new u8[ASSET_PACK_BLOCK];
+
+  std::string packed((u64)block_count * sizeof(u32), '\0');
+  for (u32 b = 0; b < block_count; b++)
+  {
+    const u8* raw = contents + (u64)b * ASSET_PACK_BLOCK;
+    u64 size = std::min<u64>(ASSET_PACK_BLOCK, source.size - (u64)b * ASSET_PACK_BLOCK);
+    const u8* input = raw;
+    if (shuffle)
+    {
+      ShuffleBytes(shuffled, raw, size, ASSET_PACK_SHUFFLE_STRIDE);
+      input = shuffled;
+    }
+
+    u64 bytes = LzCompress(input, size, block, bound);
+    u32 block_size = (u32)bytes;
+    if (bytes == 0 || bytes >= size)
+    {
+      block_size = (u32)size | ASSET_PACK_BLOCK_STORED;
+      packed.append((const char*)raw, size);
+    }
+    else packed.append((const char*)block, bytes);
+
+    memcpy(&packed[(u64)b * sizeof(u32)], &block_size, sizeof(u32));
+  }
+
+  delete[] block;
+  delete[] shuffled;
+
+  // not worth a decode on every load unless it saves an eighth
+  if (packed.size() <= source.size - source.size / 8) source.packed = std::move(packed);
+}
+
+static inline bool IsPcmAsset(const std::string& path)
+{
+  return path.size() > 4 && path.compare(path.size() - 4, 4, ".wav") == 0;
+}
+
+// packs every file under directory, skipping the output itself if it lands in there...with compress
+// every entry that compresses well enough is stored block compressed, wavs byte shuffled first
+bool WriteAssetPack(const char* directory, const char* output, bool compress)
+{
+  std::error_code error;
+  if (!std::filesystem::is_directory(directory, error))
+  {
+    DebugPrintToConsole("Not a directory: ", directory);
+    return false;
+  }
+
+  en::vector<AssetPackSource> sources;
+  std::filesystem::path output_path = std::filesystem::absolute(output, error);
+  for (auto& item : std::filesystem::recursive_directory_iterator(directory, error))
+  {
+    if (!item.is_regular_file(error) || std::filesystem::absolute(item.path(), error) == output_path) continue;
+
+    AssetPackSource source;
+    source.path = item.path().lexically_relative(directory).generic_string();
+    source.file = item.path().string();
+    source.hash = HashPackPath(source.path.c_str(), source.path.size());
+    source.size = (u64)item.file_size(error);
+    sources.PushBack(source);
+  }
+
+  std::sort(sources.begin(), sources.end(), [](const AssetPackSource& a, const AssetPackSource& b)
+  {
+    return a.hash != b.hash ? a.hash < b.hash : a.path < b.path;
+  });
+
+  // about one entry a bucket
+  u32 bucket_bits = 1;
+  while (bucket_bits < 24 && ((u64)1 << bucket_bits) < (u64)sources.Size()) bucket_bits++;
+  u32 bucket_count = 1u << bucket_bits;
+
+  AssetPackHeader header;
+  memset(&header, 0, sizeof(header));
+  header.magic = ASSET_PACK_MAGIC;
+  header.version = ASSET_PACK_VERSION;
+  header.entry_count = (u32)sources.Size();
+  header.bucket_bits = bucket_bits;
+  header.entries_offset = AlignPack(sizeof(AssetPackHeader));
+  header.buckets_offset = header.entries_offset + sources.Size() * sizeof(AssetPackEntry);
+  header.paths_offset = header.buckets_offset + ((u64)bucket_count + 1) * sizeof(u32);
+
+  en::vector<AssetPackEntry> entries;
+  en::vector<u32> buckets;
+  for (u32 b = 0; b <= bucket_count; b++) buckets.PushBack(0);
+
+  std::string paths;
+  en::vector<u8> contents;
+  for (auto& source : sources)
+  {
+    if (compress && source.size > 0)
+    {
+      if (!ReadPackSource(source, contents)) return false;
+      CompressPackSource(source, contents.begin(), IsPcmAsset(source.path));
+    }
+
+    AssetPackEntry entry;
+    memset(&entry, 0, sizeof(entry));
+    entry.hash = source.hash;
+    entry.size = source.size;
+    entry.packed_size = source.packed.empty() ? source.size : source.packed.size();
+    entry.path_offset = (u32)paths.size();
+    entry.path_length = (u32)source.path.size();
+    if (!source.packed.empty())
+    {
+      entry.flags = ASSET_PACK_COMPRESSED | (IsPcmAsset(source.path) ? ASSET_PACK_SHUFFLED : 0);
+      entry.block_count = (u32)((source.size + ASSET_PACK_BLOCK - 1) / ASSET_PACK_BLOCK);
+    }
+    entries.PushBack(entry);
+
+    paths += source.path;
+    buckets[PackBucket(source.hash, bucket_bits) + 1]++;
+  }
+  for (u32 b = 0; b < bucket_count; b++) buckets[b + 1] += buckets[b];
+
+  header.data_offset = AlignPack(header.paths_offset + paths.size());
+  u64 offset = header.data_offset;
+  for (auto& entry : entries)
+  {
+    entry.offset = offset;
+    offset = AlignPack(offset + entry.packed_size);
+  }
+  header.size = offset;
+
+  std::ofstream stream(output, std::ios::binary);
+  if (!stream)
+  {
+    DebugPrintToConsole("Failed to create asset pack: ", output);
+    return false;
+  }
+
+  static const char padding[ASSET_PACK_ALIGN] = {};
+  auto pad_to = [&](u64 at)
+  {
+    u64 written = (u64)stream.tellp();
+    if (at > written) stream.write(padding, (std::streamsize)(at - written));
+  };
+
+  stream.write((const char*)&header, sizeof(header));
+  pad_to(header.entries_offset);
+  stream.write((const char*)entries.begin(), (std::streamsize)(entries.Size() * sizeof(AssetPackEntry)));
+  stream.write((const char*)buckets.begin(), (std::streamsize)(buckets.Size() * sizeof(u32)));
+  stream.write(paths.data(), (std::streamsize)paths.size());
+
+  for (s32 e = 0; e < sources.Size(); e++)
+  {
+    pad_to(entries[e].offset);
+
+    if (!sources[e].packed.empty())
+    {
+      stream.write(sources[e].packed.data(), (std::streamsize)sources[e].packed.size());
+      continue;
+    }
+
+    if (!ReadPackSource(sources[e], contents)) return false;
+    stream.write((const char*)contents.begin(), (std::streamsize)sources[e].size);
+  }
+  pad_to(header.size);
+
+  return (bool)stream;
+}
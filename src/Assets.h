@@ -0,0 +1,427 @@
+#pragma once
+
+#include "Core.h"
+#include "Profiler.h"
+#include "GLGraphics.h"
+#include "Audio.h"
+#include "Simulation.h"
+#include "AsyncIO.h"
+#include "vector.h"
+#include "imgui/imgui.h"
+
+
+/// Assets API Reference
+////// AssetHandle AcquireTexture(const char* path);
+////// void AcquireTextures(const char* const* paths, s32 count, AssetHandle* handles);
+////// void AcquireTexturesAsync(const char* const* paths, s32 count, AssetHandle* handles, u32* pending);
+////// AssetHandle AcquireShader(const char* path);
+////// AssetHandle AcquireSound(const char* path, bool looping, AUDIO_LOAD policy);
+////// void ReleaseAsset(AssetHandle& asset);
+////// bool ReloadAsset(ASSET_TYPE type, const char* path);
+////// u32 AssetTexture(AssetHandle asset);
+////// u32 AssetShader(AssetHandle asset);
+////// SoundHandle AssetSound(AssetHandle asset);
+////// void SetAssetGracePeriod(f32 seconds);
+////// void UpdateAssets();
+////// void ShutdownAssets();
+////// void DrawAssetWindow(bool* open);
+
+// every texture, shader and sound goes through here so each file is only loaded once...assets are
+// looked up by a hash of their type and path, and acquiring one that is already loaded just counts
+// another reference to it
+
+// once the last reference is released the asset waits out a grace period before it is freed,
+// acquiring it again in the meantime takes it back as if nothing happened. that way a scene reload,
+// or switching to a scene and back, doesn't go to disk for what was already there
+
+// the grace period runs on the wall clock and UpdateAssets checks it once a frame. it is kept off the
+// simulation's timer wheel on purpose, rewinding or restoring a snapshot would take those timers back
+// with it and leave assets waiting for a timer that no longer exists
+
+// an asset keeps its slot for good, unloading only frees the gl object or sound behind it, so
+// handles never dangle...a released handle just reloads the asset on its next acquire
+
+// all of this is main thread only, gl objects can't be touched anywhere else
+
+enum class ASSET_TYPE : u8
+{
+  TEXTURE,
+  SHADER,
+  SOUND
+};
+
+const u32 ASSET_TYPE_COUNT = 3;
+const f32 ASSET_DEFAULT_GRACE_SECONDS = 10.f;
+
+enum class ASSET_STATE : u8
+{
+  UNLOADED,
+  LOADED,
+  RELEASING       // no references left, freed once its grace period is up
+};
+
+struct AssetHandle
+{
+  s32 id = -1;
+};
+
+static struct
+{
+  // one entry per asset
+  en::vector<u64> hash;
+  en::vector<ASSET_TYPE> type;
+  en::vector<std::string> path;
+  en::vector<u32> resource;         // gl name, or the sound id
+  en::vector<s32> refs;
+  en::vector<ASSET_STATE> state;
+  en::vector<u64> release_at;       // SimulationNow() the grace period ends at
+  en::vector<bool> looping;         // sounds only, so they reload the way they were first loaded
+  en::vector<AUDIO_LOAD> policy;
+
+  // open addressing from hash to asset, never more than half full
+  s32* table = nullptr;
+  u32 table_size = 0;
+
+  en::vector<s32> releasing;        // the assets waiting out their grace period
+
+  f32 grace_seconds = ASSET_DEFAULT_GRACE_SECONDS;
+
+  struct
+  {
+    u64 hits = 0;                   // acquires that found the asset already loaded
+    u64 revived = 0;                // ...of which it was waiting out its grace period
+    u64 loads = 0;
+    u64 unloads = 0;
+    u64 reloads = 0;
+  } stats;
+} assets;
+
+static const char* asset_type_names[ASSET_TYPE_COUNT] = { "texture", "shader", "sound" };
+
+// FNV-1a with the type folded in first, a texture and a sound with the same name are different assets
+static u64 HashAssetPath(ASSET_TYPE type, const char* path)
+{
+  u64 hash = 14695981039346656037ull;
+  hash = (hash ^ (u8)type) * 1099511628211ull;
+  for (const char* c = path; *c; c++) hash = (hash ^ (u8)*c) * 1099511628211ull;
+  return hash;
+}
+
+static void GrowAssetTable()
+{
+  u32 size = assets.table_size ? assets.table_size * 2 : 256;
+  s32* table = new s32[size];
+  for (u32 i = 0; i < size; i++) table[i] = -1;
+
+  for (s32 a = 0; a < assets.hash.Size(); a++)
+  {
+    u32 slot = (u32)assets.hash[a] & (size - 1);
+    while (table[slot] >= 0) slot = (slot + 1) & (size - 1);
+    table[slot] = a;
+  }
+
+  delete[] assets.table;
+  assets.table = table;
+  assets.table_size = size;
+}
+
+// the table slot holding the path's asset, or the empty slot it would go in
+static u32 AssetTableSlot(ASSET_TYPE type, const char* path, u64 hash)
+{
+  u32 slot = (u32)hash & (assets.table_size - 1);
+  while (assets.table[slot] >= 0)
+  {
+    s32 a = assets.table[slot];
+    if (assets.hash[a] == hash && assets.type[a] == type && assets.path[a] == path) break;
+    slot = (slot + 1) & (assets.table_size - 1);
+  }
+
+  return slot;
+}
+
+// -1 if the path was never asked for
+static s32 LookupAsset(ASSET_TYPE type, const char* path)
+{
+  if (assets.table_size == 0) return -1;
+  return assets.table[AssetTableSlot(type, path, HashAssetPath(type, path))];
+}
+
+// the asset for the path, registering it (unloaded) the first time it is asked for
+static s32 FindAsset(ASSET_TYPE type, const char* path)
+{
+  if ((u32)(assets.hash.Size() + 1) * 2 > assets.table_size) GrowAssetTable();
+
+  u64 hash = HashAssetPath(type, path);
+  u32 slot = AssetTableSlot(type, path, hash);
+  if (assets.table[slot] >= 0) return assets.table[slot];
+
+  s32 a = assets.hash.Size();
+  assets.hash.PushBack(hash);
+  assets.type.PushBack(type);
+  assets.path.PushBack(path);
+  assets.resource.PushBack(0);
+  assets.refs.PushBack(0);
+  assets.state.PushBack(ASSET_STATE::UNLOADED);
+  assets.release_at.PushBack(0);
+  assets.looping.PushBack(false);
+  assets.policy.PushBack(AUDIO_LOAD::RESIDENT);
+  assets.table[slot] = a;
+  return a;
+}
+
+static void UnloadAsset(s32 a)
+{
+  switch (assets.type[a])
+  {
+  case ASSET_TYPE::TEXTURE: if (!headless_graphics) glDeleteTextures(1, &assets.resource[a]); break;
+  case ASSET_TYPE::SHADER: if (!headless_graphics) glDeleteProgram(assets.resource[a]); break;
+  case ASSET_TYPE::SOUND: UnloadSound({ (s32)assets.resource[a] }); break;
+  }
+
+  assets.resource[a] = 0;
+  assets.state[a] = ASSET_STATE::UNLOADED;
+  assets.stats.unloads++;
+}
+
+// there are only ever a handful waiting, a search is fine
+static void StopReleasingAsset(s32 a)
+{
+  for (s32 i = 0; i < assets.releasing.Size(); i++)
+  {
+    if (assets.releasing[i] != a) continue;
+    assets.releasing[i] = assets.releasing[assets.releasing.Size() - 1];
+    assets.releasing.PopBack();
+    return;
+  }
+}
+
+// counts a reference, false if the asset still has to be loaded
+static bool ReferenceAsset(s32 a)
+{
+  assets.refs[a]++;
+
+  if (assets.state[a] == ASSET_STATE::RELEASING)
+  {
+    StopReleasingAsset(a);
+    assets.state[a] = ASSET_STATE::LOADED;
+    assets.stats.revived++;
+  }
+
+  if (assets.state[a] != ASSET_STATE::LOADED) return false;
+
+  assets.stats.hits++;
+  return true;
+}
+
+static AssetHandle AcquireAsset(ASSET_TYPE type, const char* path, bool looping, AUDIO_LOAD policy)
+{
+  s32 a = FindAsset(type, path);
+  if (ReferenceAsset(a)) return { a };
+
+  PROFILE_SCOPE("LoadAsset");
+  switch (type)
+  {
+  case ASSET_TYPE::TEXTURE: assets.resource[a] = LoadGLTexture(path); break;
+  case ASSET_TYPE::SHADER: assets.resource[a] = LoadGLShader(path); break;
+  case ASSET_TYPE::SOUND:
+    assets.looping[a] = looping;
+    assets.policy[a] = policy;
+    assets.resource[a] = (u32)LoadSound(path, looping, policy).id;
+    break;
+  }
+
+  assets.state[a] = ASSET_STATE::LOADED;
+  assets.stats.loads++;
+  return { a };
+}
+
+AssetHandle AcquireTexture(const char* path)
+{
+  return AcquireAsset(ASSET_TYPE::TEXTURE, path, false, AUDIO_LOAD::RESIDENT);
+}
+
+struct TextureRead
+{
+  s32 asset;
+  u32* pending;
+};
+
+static void TextureReadDone(void* user_data, MappedFile& file)
+{
+  TextureRead* read = (TextureRead*)user_data;
+  s32 a = read->asset;
+  UploadGLTextureData(assets.resource[a], file.data, file.size, assets.path[a].c_str());
+  UnmapFile(file);
+
+  (*read->pending)--;
+  delete read;
+}
+
+// hands back every handle straight away, the files of the ones that aren't loaded yet are read
+// through async io and each is decoded and uploaded from PollAsyncReads once it is in. pending goes
+// up by one a read and back down as they finish, so don't let it go away before it is 0...the gl
+// texture exists from the start, so a path asked for twice is only read once
+void AcquireTexturesAsync(const char* const* paths, s32 count, AssetHandle* handles, u32* pending)
+{
+  PROFILE_FUNCTION();
+  for (s32 i = 0; i < count; i++)
+  {
+    s32 a = FindAsset(ASSET_TYPE::TEXTURE, paths[i]);
+    handles[i] = { a };
+    if (ReferenceAsset(a)) continue;
+
+    assets.state[a] = ASSET_STATE::LOADED;
+    assets.stats.loads++;
+    if (headless_graphics) continue;
+
+    glGenTextures(1, &assets.resource[a]);
+
+    (*pending)++;
+    ReadAssetAsync(AssetPath("textures/").append(paths[i]).c_str(), TextureReadDone, new TextureRead{ a, pending });
+  }
+
+  SubmitAsyncReads();
+}
+
+// the same as acquiring them one at a time, except their files are all read at once...returns once
+// these are uploaded, without waiting on anyone else's reads
+void AcquireTextures(const char* const* paths, s32 count, AssetHandle* handles)
+{
+  u32 pending = 0;
+  AcquireTexturesAsync(paths, count, handles, &pending);
+  WaitForAsyncReads(pending);
+}
+
+AssetHandle AcquireShader(const char* path)
+{
+  return AcquireAsset(ASSET_TYPE::SHADER, path, false, AUDIO_LOAD::RESIDENT);
+}
+
+AssetHandle AcquireSound(const char* path, bool looping, AUDIO_LOAD policy)
+{
+  return AcquireAsset(ASSET_TYPE::SOUND, path, looping, policy);
+}
+
+// clears the handle, the asset itself goes after the grace period if nothing acquires it again
+void ReleaseAsset(AssetHandle& asset)
+{
+  s32 a = asset.id;
+  asset.id = -1;
+  if (a < 0 || a >= assets.refs.Size() || assets.refs[a] == 0) return;
+
+  if (--assets.refs[a] > 0) return;
+
+  if (assets.grace_seconds > 0.f)
+  {
+    assets.state[a] = ASSET_STATE::RELEASING;
+    assets.release_at[a] = SimulationNow() + (u64)((f64)assets.grace_seconds * 1e9);
+    assets.releasing.PushBack(a);
+  }
+  else
+  {
+    UnloadAsset(a);
+  }
+}
+
+// loads the file again into the same gl object or sound, for when it changed on disk...false if the
+// asset isn't loaded right now, it will be read fresh whenever it is next acquired anyway
+bool ReloadAsset(ASSET_TYPE type, const char* path)
+{
+  s32 a = LookupAsset(type, path);
+  if (a < 0 || assets.state[a] == ASSET_STATE::UNLOADED) return false;
+
+  PROFILE_SCOPE("ReloadAsset");
+  switch (type)
+  {
+  case ASSET_TYPE::TEXTURE: UploadGLTexture(assets.resource[a], path); break;
+  case ASSET_TYPE::SHADER: BuildGLShader(assets.resource[a], path); break;
+  case ASSET_TYPE::SOUND: ReloadSound({ (s32)assets.resource[a] }, path, assets.looping[a], assets.policy[a]); break;
+  }
+
+  assets.stats.reloads++;
+  return true;
+}
+
+u32 AssetTexture(AssetHandle asset)
+{
+  return asset.id >= 0 && assets.type[asset.id] == ASSET_TYPE::TEXTURE ? assets.resource[asset.id] : 0;
+}
+
+u32 AssetShader(AssetHandle asset)
+{
+  return asset.id >= 0 && assets.type[asset.id] == ASSET_TYPE::SHADER ? assets.resource[asset.id] : 0;
+}
+
+SoundHandle AssetSound(AssetHandle asset)
+{
+  if (asset.id < 0 || assets.type[asset.id] != ASSET_TYPE::SOUND) return {};
+  return { (s32)assets.resource[asset.id] };
+}
+
+// 0 frees assets as soon as their last reference goes, only affects releases from now on
+void SetAssetGracePeriod(f32 seconds)
+{
+  assets.grace_seconds = seconds;
+}
+
+// frees whatever has waited out its grace period, once a frame from the main thread
+void UpdateAssets()
+{
+  if (assets.releasing.Size() == 0) return;
+
+  u64 now = SimulationNow();
+  for (s32 i = 0; i < assets.releasing.Size();)
+  {
+    s32 a = assets.releasing[i];
+    if (now < assets.release_at[a])
+    {
+      i++;
+      continue;
+    }
+
+    assets.releasing[i] = assets.releasing[assets.releasing.Size() - 1];
+    assets.releasing.PopBack();
+    UnloadAsset(a);
+  }
+}
+
+// frees everything still loaded whether it is referenced or not, before gl and audio go away
+void ShutdownAssets()
+{
+  for (s32 a = 0; a < assets.state.Size(); a++)
+  {
+    if (assets.state[a] != ASSET_STATE::UNLOADED) UnloadAsset(a);
+    assets.refs[a] = 0;
+  }
+  assets.releasing.Assign(nullptr, 0);
+}
+
+void DrawAssetWindow(bool* open)
+{
+  if (!ImGui::Begin("Assets", open))
+  {
+    ImGui::End();
+    return;
+  }
+
+  u32 loaded = 0, releasing = 0;
+  for (s32 a = 0; a < assets.state.Size(); a++)
+  {
+    if (assets.state[a] == ASSET_STATE::LOADED) loaded++;
+    else if (assets.state[a] == ASSET_STATE::RELEASING) releasing++;
+  }
+
+  ImGui::Text("%d known, %u loaded, %u waiting to be freed (%.0f s grace)", assets.state.Size(), loaded, releasing, assets.grace_seconds);
+  ImGui::Text("Loads: %llu   Hits: %llu (%llu revived)   Unloads: %llu   Reloads: %llu", (unsigned long long)assets.stats.loads,
+    (unsigned long long)assets.stats.hits, (unsigned long long)assets.stats.revived, (unsigned long long)assets.stats.unloads,
+    (unsigned long long)assets.stats.reloads);
+  ImGui::Separator();
+
+  static const char* state_names[] = { "unloaded", "loaded", "releasing" };
+  for (s32 a = 0; a < assets.state.Size(); a++)
+  {
+    ImGui::Text("%-8s %-10s %3d  %s", asset_type_names[(u32)assets.type[a]], state_names[(u32)assets.state[a]], assets.refs[a], assets.path[a].c_str());
+  }
+
+  ImGui::End();
+}
@@ -0,0 +1,579 @@
+#pragma once
+
+#include "Core.h"
+#include "Profiler.h"
+#include "vector.h"
+#include "MappedFile.h"
+#include "AssetPack.h"
+#include "WorkerPool.h"
+#include <mutex>
+
+#ifdef __linux__
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+
+#ifndef __NR_io_uring_setup
+#define __NR_io_uring_setup 425
+#define __NR_io_uring_enter 426
+#define __NR_io_uring_register 427
+#endif
+#endif
+
+
+/// Async IO API Reference
+////// bool InitAsyncIO(u32 queue_depth, ASYNC_IO backend = ASYNC_IO::RING);    // false if it had to fall back to the workers
+////// void ShutdownAsyncIO();
+////// void ReadFileAsync(const char* path, AsyncReadCallback callback, void* user_data);
+////// void ReadAssetAsync(const char* path, AsyncReadCallback callback, void* user_data);
+////// void SubmitAsyncReads();
+////// u32 PollAsyncReads();                          // runs the callbacks of finished reads, returns how many
+////// void WaitForAsyncReads();
+////// void WaitForAsyncReads(const u32& pending);    // until the caller's callbacks count pending down to 0
+////// const char* AsyncIOBackendName();
+
+// reads whole files without blocking whoever asked for them...queue as many as you like, up to
+// queue_depth of them are in flight at once and the rest wait their turn. nothing goes out until
+// SubmitAsyncReads (or a poll or a wait), so a batch of reads costs one system call to start
+//
+// on linux the reads go through an io_uring set up with raw syscalls, no liburing. every read is an
+// openat, then reads until the file is in (into one of the registered staging slots when it fits in
+// ASYNC_IO_SLOT_SIZE, so the kernel doesn't have to map the buffer again for each read), then a close.
+// anywhere else, or when the kernel won't give us a ring, each read is a job on the worker pool instead
+//
+// a callback gets the file as a MappedFile and owns it from then on, UnmapFile gives the memory back
+// (a staging slot or the heap)...a read that failed has no data. callbacks run on whichever thread
+// polls or waits, and queueing and polling are for one thread at a time, the main thread in the engine.
+// every file has to be unmapped before ShutdownAsyncIO
+
+const u32 ASYNC_IO_DEFAULT_DEPTH = 64;
+const u32 ASYNC_IO_SLOT_SIZE = 64 * 1024;
+const u32 ASYNC_IO_SLOT_COUNT = 64;
+
+enum class ASYNC_IO : u8
+{
+  THREADS,
+  RING
+};
+
+using AsyncReadCallback = void(*)(void* user_data, MappedFile& file);
+
+struct AsyncRead
+{
+  std::string path;
+  std::string packed_path;      // looked up in the asset pack when the loose file isn't there, empty for plain files
+  AsyncReadCallback callback = nullptr;
+  void* user_data = nullptr;
+  MappedFile file;
+  s32 fd = -1;                  // open while the ring reads it
+  u64 done = 0;                 // bytes read so far
+};
+
+static struct
+{
+  ASYNC_IO backend = ASYNC_IO::THREADS;
+  u32 depth = ASYNC_IO_DEFAULT_DEPTH;
+
+  u8* slots = nullptr;                  // ASYNC_IO_SLOT_COUNT staging buffers back to back
+  en::vector<u32> free_slots;
+  std::mutex slot_lock;
+
+  en::vector<AsyncRead*> free_reads;
+  en::vector<AsyncRead*> pending;       // queued and not handed out yet, from pending_head on
+  s32 pending_head = 0;
+  u32 in_flight = 0;                    // handed out and their callbacks not run yet
+  JobCounter jobs{ 0 };
+
+  en::vector<AsyncRead*> finished;      // guarded by finished_lock, the workers add to it
+  en::vector<AsyncRead*> running;       // the poll's copy of it
+  std::mutex finished_lock;
+
+#ifdef __linux__
+  s32 ring_fd = -1;
+  u8* sq_ring = nullptr;
+  u8* cq_ring = nullptr;
+  u64 sq_ring_size = 0;
+  u64 cq_ring_size = 0;
+  io_uring_sqe* sqes = nullptr;
+  u64 sqes_size = 0;
+  u32* sq_head = nullptr;
+  u32* sq_tail = nullptr;
+  u32* sq_array = nullptr;
+  u32 sq_mask = 0;
+  u32 sq_entries = 0;
+  u32* cq_head = nullptr;
+  u32* cq_tail = nullptr;
+  io_uring_cqe* cqes = nullptr;
+  u32 cq_mask = 0;
+  u32 unsubmitted = 0;
+  bool registered = false;              // the slots are registered buffers
+#endif
+
+  struct
+  {
+    u64 reads = 0;
+    u64 failed = 0;
+    u64 bytes = 0;
+    u64 staged = 0;                     // read into a staging slot
+    u64 packed = 0;                     // came out of the asset pack instead
+    u64 submits = 0;                    // io_uring_enter calls that submitted something
+  } stats;
+} async_io;
+
+static void ReleaseAsyncSlot(const MappedFile& file)
+{
+  std::lock_guard<std::mutex> lock(async_io.slot_lock);
+  async_io.free_slots.PushBack((u32)((file.data - async_io.slots) / ASYNC_IO_SLOT_SIZE));
+}
+
+static void ReleaseAsyncHeap(const MappedFile& file)
+{
+  delete[] file.data;
+}
+
+// a staging slot when one is free and the file fits, otherwise the heap
+static u8* AllocateAsyncBuffer(MappedFile& file, u64 size)
+{
+  u8* data = nullptr;
+  if (async_io.slots && size <= ASYNC_IO_SLOT_SIZE)
+  {
+    std::lock_guard<std::mutex> lock(async_io.slot_lock);
+    if (async_io.free_slots.Size() > 0)
+    {
+      data = async_io.slots + (u64)async_io.free_slots[async_io.free_slots.Size() - 1] * ASYNC_IO_SLOT_SIZE;
+      async_io.free_slots.PopBack();
+    }
+  }
+
+  file.release = data ? ReleaseAsyncSlot : ReleaseAsyncHeap;
+  if (!data) data = new u8[size];
+
+  file.data = data;
+  file.size = size;
+  file.borrowed = true;
+  return data;
+}
+
+static inline bool IsAsyncSlot(const MappedFile& file)
+{
+  return file.release == ReleaseAsyncSlot;
+}
+
+// any thread, the callback runs on the next poll
+static void FinishAsyncRead(AsyncRead* read)
+{
+  if (!read->file.data && !read->packed_path.empty()) MapPackedAsset(read->packed_path.c_str(), read->file);
+
+  std::lock_guard<std::mutex> lock(async_io.finished_lock);
+  async_io.finished.PushBack(read);
+}
+
+// ---- the worker pool
+
+// what every loader did before, on a worker instead
+static void AsyncReadJob(void* data)
+{
+  AsyncRead* read = (AsyncRead*)data;
+  FILE* file = fopen(read->path.c_str(), "rb");
+  if (file)
+  {
+    // not ftell, its long is 32 bits on windows
+    std::error_code error;
+    u64 size = (u64)std::filesystem::file_size(read->path, error);
+
+    if (!error && size > 0)
+    {
+      u8* buffer = AllocateAsyncBuffer(read->file, size);
+      if (fread(buffer, 1, (size_t)size, file) != (size_t)size) UnmapFile(read->file);
+    }
+
+    fclose(file);
+  }
+
+  FinishAsyncRead(read);
+}
+
+// ---- io_uring
+
+#ifdef __linux__
+static bool SetupAsyncRing(u32 depth)
+{
+  io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  s32 fd = (s32)syscall(__NR_io_uring_setup, depth, &params);
+  if (fd < 0) return false;
+
+  // openat and plain reads came in with 5.6, the same release as this feature bit
+  if (!(params.features & IORING_FEAT_RW_CUR_POS))
+  {
+    close(fd);
+    return false;
+  }
+
+  async_io.sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(u32);
+  async_io.cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (single_mmap) async_io.sq_ring_size = async_io.cq_ring_size = std::max(async_io.sq_ring_size, async_io.cq_ring_size);
+
+  void* sq_ring = mmap(nullptr, async_io.sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+  void* cq_ring = single_mmap ? sq_ring : mmap(nullptr, async_io.cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+  async_io.sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+  void* sqes = mmap(nullptr, async_io.sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+
+  if (sq_ring == MAP_FAILED || cq_ring == MAP_FAILED || sqes == MAP_FAILED)
+  {
+    if (sq_ring != MAP_FAILED) munmap(sq_ring, async_io.sq_ring_size);
+    if (cq_ring != MAP_FAILED && !single_mmap) munmap(cq_ring, async_io.cq_ring_size);
+    if (sqes != MAP_FAILED) munmap(sqes, async_io.sqes_size);
+    close(fd);
+    return false;
+  }
+
+  async_io.ring_fd = fd;
+  async_io.sq_ring = (u8*)sq_ring;
+  async_io.cq_ring = (u8*)cq_ring;
+  async_io.sqes = (io_uring_sqe*)sqes;
+  async_io.sq_head = (u32*)(async_io.sq_ring + params.sq_off.head);
+  async_io.sq_tail = (u32*)(async_io.sq_ring + params.sq_off.tail);
+  async_io.sq_array = (u32*)(async_io.sq_ring + params.sq_off.array);
+  async_io.sq_mask = *(u32*)(async_io.sq_ring + params.sq_off.ring_mask);
+  async_io.sq_entries = params.sq_entries;
+  async_io.cq_head = (u32*)(async_io.cq_ring + params.cq_off.head);
+  async_io.cq_tail = (u32*)(async_io.cq_ring + params.cq_off.tail);
+  async_io.cqes = (io_uring_cqe*)(async_io.cq_ring + params.cq_off.cqes);
+  async_io.cq_mask = *(u32*)(async_io.cq_ring + params.cq_off.ring_mask);
+  async_io.unsubmitted = 0;
+
+  // pinned memory counts against RLIMIT_MEMLOCK, without it the slots are read into like any buffer
+  iovec slots = { async_io.slots, (size_t)ASYNC_IO_SLOT_COUNT * ASYNC_IO_SLOT_SIZE };
+  async_io.registered = async_io.slots && syscall(__NR_io_uring_register, fd, IORING_REGISTER_BUFFERS, &slots, 1) == 0;
+  return true;
+}
+
+static void CloseAsyncRing()
+{
+  if (async_io.ring_fd < 0) return;
+
+  if (async_io.registered) syscall(__NR_io_uring_register, async_io.ring_fd, IORING_UNREGISTER_BUFFERS, nullptr, 0);
+  munmap(async_io.sqes, async_io.sqes_size);
+  if (async_io.cq_ring != async_io.sq_ring) munmap(async_io.cq_ring, async_io.cq_ring_size);
+  munmap(async_io.sq_ring, async_io.sq_ring_size);
+  close(async_io.ring_fd);
+
+  async_io.ring_fd = -1;
+  async_io.registered = false;
+}
+
+// only this thread moves the tail, the kernel moves the head as it takes entries
+static bool PushAsyncSqe(u8 opcode, s32 fd, const void* address, u32 length, u64 offset, u32 flags, u16 buffer_index, AsyncRead* read)
+{
+  u32 tail = *async_io.sq_tail;
+  if (tail - __atomic_load_n(async_io.sq_head, __ATOMIC_ACQUIRE) >= async_io.sq_entries) return false;
+
+  u32 index = tail & async_io.sq_mask;
+  io_uring_sqe* sqe = &async_io.sqes[index];
+  memset(sqe, 0, sizeof(*sqe));
+  sqe->opcode = opcode;
+  sqe->fd = fd;
+  sqe->addr = (u64)(uintptr_t)address;
+  sqe->len = length;
+  sqe->off = offset;
+  sqe->open_flags = flags;
+  sqe->buf_index = buffer_index;
+  sqe->user_data = (u64)(uintptr_t)read;
+
+  async_io.sq_array[index] = index;
+  __atomic_store_n(async_io.sq_tail, tail + 1, __ATOMIC_RELEASE);
+  async_io.unsubmitted++;
+  return true;
+}
+
+static s32 EnterAsyncRing(u32 submit, u32 wait)
+{
+  s32 result;
+  do
+  {
+    result = (s32)syscall(__NR_io_uring_enter, async_io.ring_fd, submit, wait, wait ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+  } while (result < 0 && errno == EINTR);
+
+  if (result > 0)
+  {
+    async_io.unsubmitted -= std::min((u32)result, async_io.unsubmitted);
+    async_io.stats.submits++;
+  }
+
+  return result;
+}
+
+static void EndRingRead(AsyncRead* read)
+{
+  if (read->fd >= 0) close(read->fd);
+  read->fd = -1;
+  FinishAsyncRead(read);
+}
+
+// the rest of the file, a short read just asks again for what's left
+static void ReadRing(AsyncRead* read)
+{
+  u8* at = (u8*)read->file.data + read->done;
+  u32 length = (u32)std::min<u64>(read->file.size - read->done, 0x40000000);
+  bool fixed = async_io.registered && IsAsyncSlot(read->file);
+
+  if (!PushAsyncSqe(fixed ? IORING_OP_READ_FIXED : IORING_OP_READ, read->fd, at, length, read->done, 0, 0, read))
+  {
+    UnmapFile(read->file);
+    EndRingRead(read);
+  }
+}
+
+static void CompleteRingStep(AsyncRead* read, s32 result)
+{
+  // the openat came back
+  if (read->fd < 0)
+  {
+    if (result < 0)
+    {
+      EndRingRead(read);
+      return;
+    }
+
+    read->fd = result;
+    struct stat info;
+    if (fstat(read->fd, &info) != 0 || info.st_size <= 0)
+    {
+      EndRingRead(read);
+      return;
+    }
+
+    AllocateAsyncBuffer(read->file, (u64)info.st_size);
+    ReadRing(read);
+    return;
+  }
+
+  if (result <= 0)
+  {
+    UnmapFile(read->file);
+    EndRingRead(read);
+    return;
+  }
+
+  read->done += (u64)result;
+  if (read->done < read->file.size) ReadRing(read);
+  else EndRingRead(read);
+}
+
+static void StartRingRead(AsyncRead* read)
+{
+  if (!PushAsyncSqe(IORING_OP_OPENAT, AT_FDCWD, read->path.c_str(), 0, 0, O_RDONLY | O_CLOEXEC, 0, read)) FinishAsyncRead(read);
+}
+
+static u32 ReapAsyncRing()
+{
+  u32 head = *async_io.cq_head;
+  u32 tail = __atomic_load_n(async_io.cq_tail, __ATOMIC_ACQUIRE);
+  u32 count = tail - head;
+
+  for (; head != tail; head++)
+  {
+    io_uring_cqe* cqe = &async_io.cqes[head & async_io.cq_mask];
+    CompleteRingStep((AsyncRead*)(uintptr_t)cqe->user_data, cqe->res);
+  }
+
+  __atomic_store_n(async_io.cq_head, head, __ATOMIC_RELEASE);
+  return count;
+}
+#endif
+
+// ---- queueing and polling
+
+static void StartPendingReads()
+{
+  while (async_io.pending_head < async_io.pending.Size() && async_io.in_flight < async_io.depth)
+  {
+    AsyncRead* read = async_io.pending[async_io.pending_head++];
+    async_io.in_flight++;
+
+#ifdef __linux__
+    if (async_io.backend == ASYNC_IO::RING)
+    {
+      StartRingRead(read);
+      continue;
+    }
+#endif
+    RunBackgroundJob(AsyncReadJob, read, &async_io.jobs);
+  }
+
+  if (async_io.pending_head == async_io.pending.Size())
+  {
+    async_io.pending.Assign(nullptr, 0);
+    async_io.pending_head = 0;
+  }
+}
+
+static AsyncRead* NewAsyncRead(const char* path, const char* packed_path, AsyncReadCallback callback, void* user_data)
+{
+  AsyncRead* read;
+  if (async_io.free_reads.Size() > 0)
+  {
+    read = async_io.free_reads[async_io.free_reads.Size() - 1];
+    async_io.free_reads.PopBack();
+  }
+  else read = new AsyncRead();
+
+  read->path = path;
+  read->packed_path = packed_path;
+  read->callback = callback;
+  read->user_data = user_data;
+  read->file = MappedFile();
+  read->fd = -1;
+  read->done = 0;
+  return read;
+}
+
+void ReadFileAsync(const char* path, AsyncReadCallback callback, void* user_data)
+{
+  async_io.pending.PushBack(NewAsyncRead(path, "", callback, user_data));
+}
+
+// an asset by the same rules as MapAssetFile, path either relative to assets/ or an AssetPath...a
+// packed asset is found straight away and only waits for the next poll to be handed over
+void ReadAssetAsync(const char* path, AsyncReadCallback callback, void* user_data)
+{
+  const char* relative = path;
+  if (strncmp(path, asset_root.c_str(), asset_root.size()) == 0) relative += asset_root.size();
+
+#ifdef EN_LOOSE_ASSETS
+  async_io.pending.PushBack(NewAsyncRead(path, asset_pack.header ? relative : "", callback, user_data));
+#else
+  if (!asset_pack.header)
+  {
+    async_io.pending.PushBack(NewAsyncRead(path, "", callback, user_data));
+    return;
+  }
+
+  async_io.in_flight++;
+  FinishAsyncRead(NewAsyncRead(path, relative, callback, user_data));
+#endif
+}
+
+// hands the queued reads out, one system call for the lot on the ring
+void SubmitAsyncReads()
+{
+  StartPendingReads();
+#ifdef __linux__
+  if (async_io.backend == ASYNC_IO::RING && async_io.unsubmitted > 0) EnterAsyncRing(async_io.unsubmitted, 0);
+#endif
+}
+
+u32 PollAsyncReads()
+{
+  PROFILE_FUNCTION();
+  SubmitAsyncReads();
+#ifdef __linux__
+  if (async_io.backend == ASYNC_IO::RING && ReapAsyncRing() > 0 && async_io.unsubmitted > 0) EnterAsyncRing(async_io.unsubmitted, 0);
+#endif
+
+  {
+    std::lock_guard<std::mutex> lock(async_io.finished_lock);
+    async_io.running.Assign(async_io.finished.begin(), async_io.finished.Size());
+    async_io.finished.Assign(nullptr, 0);
+  }
+
+  for (AsyncRead* read : async_io.running)
+  {
+    async_io.in_flight--;
+    async_io.stats.reads++;
+    if (read->file.data) async_io.stats.bytes += read->file.size;
+    else async_io.stats.failed++;
+    if (read->file.data && IsAsyncSlot(read->file)) async_io.stats.staged++;
+    else if (read->file.data && read->file.release != ReleaseAsyncHeap) async_io.stats.packed++;
+
+    MappedFile file = read->file;
+    read->file = MappedFile();
+    async_io.free_reads.PushBack(read);
+    read->callback(read->user_data, file);
+  }
+
+  u32 count = (u32)async_io.running.Size();
+  if (count > 0) SubmitAsyncReads();
+  return count;
+}
+
+static inline bool AsyncReadsOutstanding()
+{
+  return async_io.in_flight > 0 || async_io.pending_head < async_io.pending.Size();
+}
+
+// until every queued read has had its callback, including any the callbacks queue...with pending,
+// only until that reaches 0, other reads finishing along the way get their callbacks too
+void WaitForAsyncReads(const u32* pending)
+{
+  PROFILE_FUNCTION();
+  while (pending ? *pending > 0 && AsyncReadsOutstanding() : AsyncReadsOutstanding())
+  {
+    if (PollAsyncReads() > 0) continue;
+
+#ifdef __linux__
+    if (async_io.backend == ASYNC_IO::RING)
+    {
+      EnterAsyncRing(async_io.unsubmitted, 1);
+      continue;
+    }
+#endif
+    if (!RunOneJob()) std::this_thread::yield();
+  }
+}
+
+void WaitForAsyncReads()
+{
+  WaitForAsyncReads(nullptr);
+}
+
+void WaitForAsyncReads(const u32& pending)
+{
+  WaitForAsyncReads(&pending);
+}
+
+void ShutdownAsyncIO()
+{
+  WaitForAsyncReads();
+  WaitForJobs(async_io.jobs);
+#ifdef __linux__
+  CloseAsyncRing();
+#endif
+
+  for (AsyncRead* read : async_io.free_reads) delete read;
+  async_io.free_reads.Assign(nullptr, 0);
+  async_io.free_slots.Assign(nullptr, 0);
+  delete[] async_io.slots;
+  async_io.slots = nullptr;
+  async_io.backend = ASYNC_IO::THREADS;
+  async_io.depth = ASYNC_IO_DEFAULT_DEPTH;
+}
+
+const char* AsyncIOBackendName()
+{
+#ifdef __linux__
+  if (async_io.backend == ASYNC_IO::RING) return async_io.registered ? "io_uring, registered buffers" : "io_uring";
+#endif
+  return "worker pool";
+}
+
+// asking for the ring and not getting it still works, on the workers...false says so
+bool InitAsyncIO(u32 queue_depth, ASYNC_IO backend = ASYNC_IO::RING)
+{
+  ShutdownAsyncIO();
+
+  async_io.depth = queue_depth ? queue_depth : ASYNC_IO_DEFAULT_DEPTH;
+  async_io.stats = {};
+  async_io.slots = new u8[(u64)ASYNC_IO_SLOT_COUNT * ASYNC_IO_SLOT_SIZE];
+  for (u32 s = 0; s < ASYNC_IO_SLOT_COUNT; s++) async_io.free_slots.PushBack(ASYNC_IO_SLOT_COUNT - 1 - s);
+
+  async_io.backend = ASYNC_IO::THREADS;
+#ifdef __linux__
+  if (backend == ASYNC_IO::RING && SetupAsyncRing(async_io.depth)) async_io.backend = ASYNC_IO::RING;
+#endif
+
+  DebugPrintToConsole("Async IO: ", AsyncIOBackendName());
+  return async_io.backend == backend;
+}
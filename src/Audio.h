@@ -1,69 +1,546 @@
 #pragma once
 
 #include "Core.h"
-#include "fmod/fmod.hpp"
+#include "Profiler.h"
 #include "unordered_map.h"
+#include "spsc_queue.h"
+#include "AudioBackend.h"
+#include "AudioVoices.h"
+#include "imgui/imgui.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
 
 
 /// Audio API Reference
-////// bool InitSound();
-////// bool LoadSound(const char* path);
-////// bool PlaySound(const char* path);
-////// bool StopSound(const char* path);
+////// bool InitSound(AUDIO_BACKEND type, const char* capture_path);
+////// void ShutdownSound();
+////// SoundHandle LoadSound(const char* path, bool looping, AUDIO_LOAD policy);
+////// AUDIO_LOAD DefaultLoadPolicy(bool looping);
+////// void UnloadSound(SoundHandle sound);
+////// void ReloadSound(SoundHandle sound, const char* path, bool looping, AUDIO_LOAD policy);
+////// void WaitForSoundLoads();
+////// SoundHandle FindSound(const char* name);
+////// SoundEvent PlaySound(SoundHandle sound);
+////// SoundEvent PlaySound(SoundHandle sound, const VoiceParams& params);
+////// void StopSound(SoundEvent event);
+////// void StopAllSounds(SoundHandle sound);
+////// void SetSoundParams(SoundEvent event, const VoiceParams& params);
+////// bool IsSoundPlaying(SoundEvent event);
+////// void DrawAudioWindow(bool* open);
 
-FMOD::System* audio_system;
+// the voice manager and the backend belong to the audio thread...gameplay only ever pushes small
+// commands into a lock free queue, so playing a sound costs the main thread a few nanoseconds and a
+// slow frame never holds the audio up. all of the play/stop/set calls must come from the main thread
 
-// these variables are currently not in use...playSound is being passed nullptr instead of audio channels for the time being
-FMOD::Channel* audio_channels[4];   // audio system can play up to 4 sounds simultaneously
-s32 audio_channels_in_use = 0;
+// sounds are looked up by name once (FindSound) and played by handle from then on
 
-en::unordered_map<std::string, FMOD::Sound*> scene_sounds;
+// LoadSound only queues the file for the loader thread and hands back the handle straight away,
+// plays of a sound that is still loading wait on the audio thread until it is ready
 
-bool InitSound()
+// looping sounds are treated as music, they outrank every sound effect and only play once at a time
+const u8 SOUND_PRIORITY_MUSIC = 255;
+const u8 SOUND_PRIORITY_EFFECT = 128;
+const u16 SOUND_EFFECT_MAX_INSTANCES = 8;
+
+const u32 AUDIO_COMMAND_QUEUE_SIZE = 4096;
+const u32 AUDIO_EVENT_SLOTS = 4096;         // a sound event can be stopped/changed until this many newer plays happened
+const u32 AUDIO_THREAD_PERIOD_US = 2000;
+const u32 AUDIO_DEFERRED_PLAYS = 64;        // plays waiting on a sound that is still loading
+
+struct SoundHandle
 {
-  if (FMOD::System_Create(&audio_system) != FMOD_OK) return false;
-  if (audio_system->init(64, FMOD_INIT_NORMAL, 0)) return false;
+  s32 id = -1;
+};
 
-  return true;
+struct SoundEvent
+{
+  u32 id = 0;
+};
+
+enum class AUDIO_COMMAND : u8
+{
+  PLAY,
+  STOP,
+  STOP_ALL,
+  SET_PARAMS
+};
+
+struct AudioCommand
+{
+  AUDIO_COMMAND type;
+  s32 sound;
+  u32 event;
+  VoiceParams params;
+};
+
+struct AudioEventSlot
+{
+  u32 event = 0;
+  VoiceHandle voice;
+};
+
+struct AudioLoadJob
+{
+  s32 sound;
+  std::string path;
+  bool looping;
+  AUDIO_LOAD policy;
+};
+
+AudioBackend* audio_backend = nullptr;
+
+en::unordered_map<std::string, s32> scene_sounds;
+
+static struct
+{
+  std::thread thread;
+  std::atomic<bool> running{ false };
+  std::mutex lock;                              // held by the audio thread while it updates, only sound loading ever waits on it
+  en::spsc_queue<AudioCommand, AUDIO_COMMAND_QUEUE_SIZE> commands;
+
+  u32 next_event = 0;                           // main thread only
+  u64 dropped_commands = 0;                     // main thread only
+
+  AudioEventSlot events[AUDIO_EVENT_SLOTS];     // audio thread only
+  std::atomic<u32> events_playing[AUDIO_EVENT_SLOTS] = {};   // the event a slot holds from PlaySound until it is over, then 0
+  AudioCommand deferred[AUDIO_DEFERRED_PLAYS];  // audio thread only
+  u32 deferred_count = 0;
+  std::atomic<u64> processed_commands{ 0 };
+} audio;
+
+static struct
+{
+  std::thread thread;
+  std::mutex lock;
+  std::condition_variable wake;
+  std::condition_variable idle;
+  en::vector<AudioLoadJob> jobs;
+  s32 next_job = 0;
+  bool running = false;
+  bool busy = false;
+} audio_loader;
+
+static const char* audio_load_names[] = { "resident", "compressed", "stream", "mapped" };
+
+// what each load policy costs, read by the audio window...sounds and bytes are what is loaded right
+// now, a sound's share comes off again when it is unloaded or reloaded
+static struct
+{
+  std::atomic<u32> sounds[AUDIO_LOAD_COUNT] = {};
+  std::atomic<u64> bytes[AUDIO_LOAD_COUNT] = {};
+  std::atomic<u32> loads[AUDIO_LOAD_COUNT] = {};
+  std::atomic<u64> load_ns[AUDIO_LOAD_COUNT] = {};
+  std::atomic<u32> failed{ 0 };
+
+  // per sound id, what it added above...guarded by audio.lock
+  en::vector<u64> sound_bytes;
+  en::vector<AUDIO_LOAD> sound_policy;
+  en::vector<bool> counted;
+} audio_memory;
+
+// under audio.lock
+static void CountSoundMemory(s32 sound, AUDIO_LOAD policy, u64 bytes)
+{
+  while (audio_memory.counted.Size() <= sound)
+  {
+    audio_memory.sound_bytes.PushBack(0);
+    audio_memory.sound_policy.PushBack(AUDIO_LOAD::RESIDENT);
+    audio_memory.counted.PushBack(false);
+  }
+
+  audio_memory.sound_bytes[sound] = bytes;
+  audio_memory.sound_policy[sound] = policy;
+  audio_memory.counted[sound] = true;
+  audio_memory.sounds[(u32)policy]++;
+  audio_memory.bytes[(u32)policy] += bytes;
+}
+
+// under audio.lock
+static void UncountSoundMemory(s32 sound)
+{
+  if (sound >= audio_memory.counted.Size() || !audio_memory.counted[sound]) return;
+
+  u32 policy = (u32)audio_memory.sound_policy[sound];
+  audio_memory.sounds[policy]--;
+  audio_memory.bytes[policy] -= audio_memory.sound_bytes[sound];
+  audio_memory.counted[sound] = false;
 }
 
-FMOD::Sound* LoadSound(const char* path, bool looping)
+// only clears the slot if a newer play hasn't taken it over in the meantime
+static inline void EndAudioEvent(u32 event)
 {
-  FMOD::Sound* sound;
-  std::string sound_path = AssetPath("audio/").append(path);
-  if (looping)
+  u32 expected = event;
+  audio.events_playing[event % AUDIO_EVENT_SLOTS].compare_exchange_strong(expected, 0, std::memory_order_acq_rel);
+}
+
+static void StartAudioEvent(const AudioCommand& c)
+{
+  AudioEventSlot& slot = audio.events[c.event % AUDIO_EVENT_SLOTS];
+  slot.event = c.event;
+  slot.voice = PlayVoice(c.sound, c.params);
+
+  // refused, by the instance limit or a sound that failed to load
+  if (!IsVoiceActive(slot.voice))
   {
-    if (audio_system->createSound(sound_path.c_str(), FMOD_DEFAULT | FMOD_LOOP_NORMAL, 0, &sound) == FMOD_OK)
+    EndAudioEvent(c.event);
+    slot.event = 0;
+  }
+}
+
+// voices that finished by themselves or were stolen during the update...one pass over the slots
+// every audio tick, a few microseconds
+static void EndFinishedAudioEvents()
+{
+  for (u32 i = 0; i < AUDIO_EVENT_SLOTS; i++)
+  {
+    AudioEventSlot& slot = audio.events[i];
+    if (slot.event == 0 || IsVoiceActive(slot.voice)) continue;
+
+    EndAudioEvent(slot.event);
+    slot.event = 0;
+  }
+}
+
+// drops deferred plays matching the event, or every deferred play of the sound when event is 0
+static void CancelDeferredPlays(u32 event, s32 sound)
+{
+  for (u32 i = audio.deferred_count; i > 0; i--)
+  {
+    AudioCommand& c = audio.deferred[i - 1];
+    if (event != 0 ? c.event != event : c.sound != sound) continue;
+
+    EndAudioEvent(c.event);
+    audio.deferred[i - 1] = audio.deferred[--audio.deferred_count];
+  }
+}
+
+static void StartDeferredPlays()
+{
+  for (u32 i = audio.deferred_count; i > 0; i--)
+  {
+    AudioCommand c = audio.deferred[i - 1];
+    if (GetSoundState(c.sound) == SOUND_STATE::LOADING) continue;
+
+    audio.deferred[i - 1] = audio.deferred[--audio.deferred_count];
+    StartAudioEvent(c);
+  }
+}
+
+static void ProcessAudioCommands()
+{
+  StartDeferredPlays();
+
+  AudioCommand c;
+  u64 processed = 0;
+  while (audio.commands.Pop(c))
+  {
+    AudioEventSlot& slot = audio.events[c.event % AUDIO_EVENT_SLOTS];
+    bool current = c.event != 0 && slot.event == c.event;
+
+    switch (c.type)
     {
-      DebugPrintToConsole("Successfully loaded audio asset: ", sound_path);
-      return sound;
+      case AUDIO_COMMAND::PLAY:
+        if (GetSoundState(c.sound) != SOUND_STATE::LOADING) StartAudioEvent(c);
+        else if (audio.deferred_count < AUDIO_DEFERRED_PLAYS) audio.deferred[audio.deferred_count++] = c;
+        else EndAudioEvent(c.event);
+        break;
+      case AUDIO_COMMAND::STOP:
+        if (current)
+        {
+          StopVoice(slot.voice);
+          EndAudioEvent(c.event);
+          slot.event = 0;
+        }
+        else CancelDeferredPlays(c.event, -1);
+        break;
+      case AUDIO_COMMAND::STOP_ALL:
+        StopAllVoices(c.sound);
+        CancelDeferredPlays(0, c.sound);
+        break;
+      case AUDIO_COMMAND::SET_PARAMS:
+        if (current) SetVoiceParams(slot.voice, c.params);
+        break;
     }
+
+    processed++;
   }
-  else
+
+  audio.processed_commands.fetch_add(processed, std::memory_order_relaxed);
+}
+
+static void AudioThreadMain()
+{
+  ProfilerSetThreadName("Audio");
+
+  auto last = std::chrono::steady_clock::now();
+  while (audio.running.load(std::memory_order_acquire))
+  {
+    auto now = std::chrono::steady_clock::now();
+    f32 delta_seconds = std::chrono::duration<f32>(now - last).count();
+    last = now;
+
+    {
+      PROFILE_SCOPE("AudioUpdate");
+      std::lock_guard<std::mutex> guard(audio.lock);
+      ProcessAudioCommands();
+      UpdateVoices(delta_seconds);
+      EndFinishedAudioEvents();
+    }
+
+    std::this_thread::sleep_for(std::chrono::microseconds(AUDIO_THREAD_PERIOD_US));
+  }
+}
+
+static void LoadSoundJob(const AudioLoadJob& job)
+{
+  PROFILE_SCOPE("LoadSound");
+
+  auto start = std::chrono::steady_clock::now();
+  PreparedSound prepared;
+  bool loaded = audio_backend->PrepareSound(job.path.c_str(), job.looping, job.policy, prepared);
+  u64 load_ns = (u64)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+  {
+    std::lock_guard<std::mutex> guard(audio.lock);
+    CompletePendingSound(job.sound, loaded ? audio_backend->AddSound(prepared) : -1, prepared.length_seconds);
+
+    // one unloaded while it was loading is already gone again
+    if (GetSoundState(job.sound) == SOUND_STATE::LOADED) CountSoundMemory(job.sound, job.policy, prepared.resident_bytes);
+  }
+
+  if (!loaded)
+  {
+    audio_memory.failed++;
+    DebugPrintToConsole("Failed to load audio asset: ", job.path);
+    return;
+  }
+
+  u32 policy = (u32)job.policy;
+  audio_memory.loads[policy]++;
+  audio_memory.load_ns[policy] += load_ns;
+  DebugPrintToConsole("Successfully loaded audio asset: ", job.path);
+}
+
+static void AudioLoaderMain()
+{
+  ProfilerSetThreadName("AudioLoader");
+
+  std::unique_lock<std::mutex> guard(audio_loader.lock);
+  while (true)
   {
-    if (audio_system->createSound(sound_path.c_str(), FMOD_DEFAULT, 0, &sound) == FMOD_OK)
+    audio_loader.wake.wait(guard, [] { return !audio_loader.running || audio_loader.next_job < audio_loader.jobs.Size(); });
+    if (!audio_loader.running) break;
+
+    AudioLoadJob job = audio_loader.jobs[audio_loader.next_job++];
+    if (audio_loader.next_job == audio_loader.jobs.Size())
     {
-      DebugPrintToConsole("Successfully loaded audio asset: ", sound_path);
-      return sound;
+      audio_loader.jobs.Clear();
+      audio_loader.next_job = 0;
     }
+
+    audio_loader.busy = true;
+    guard.unlock();
+    LoadSoundJob(job);
+    guard.lock();
+    audio_loader.busy = false;
+
+    if (audio_loader.next_job == audio_loader.jobs.Size()) audio_loader.idle.notify_all();
+  }
+}
+
+// capture_path writes everything that plays to a WAV file, which forces the software mixer
+bool InitSound(AUDIO_BACKEND type, const char* capture_path)
+{
+  audio_backend = CreateAudioBackend(type, capture_path);
+  if (!audio_backend || !audio_backend->Init(MAX_REAL_VOICES))
+  {
+    delete audio_backend;
+    audio_backend = nullptr;
+    return false;
   }
 
-  return nullptr;
+  InitVoiceManager(audio_backend);
+
+  audio.running.store(true, std::memory_order_release);
+  audio.thread = std::thread(AudioThreadMain);
+
+  audio_loader.running = true;
+  audio_loader.thread = std::thread(AudioLoaderMain);
+  return true;
 }
 
-bool PlaySound(const char* sound)
+void ShutdownSound()
 {
-  std::string sound_path = AssetPath("audio/").append(sound);
-  if (audio_system->playSound(scene_sounds.At(sound), nullptr, false, nullptr) == FMOD_OK)
+  if (!audio_backend) return;
+
   {
-    return true;
+    std::lock_guard<std::mutex> guard(audio_loader.lock);
+    audio_loader.running = false;
   }
+  audio_loader.wake.notify_one();
+  if (audio_loader.thread.joinable()) audio_loader.thread.join();
 
-  DebugPrintToConsole("Failed to play sound!");
-  return false;
+  audio.running.store(false, std::memory_order_release);
+  if (audio.thread.joinable()) audio.thread.join();
+
+  audio_backend->Shutdown();
+  delete audio_backend;
+  audio_backend = nullptr;
+}
+
+// short sounds are decoded up front, anything that loops is music or ambience and streams
+AUDIO_LOAD DefaultLoadPolicy(bool looping)
+{
+  return looping ? AUDIO_LOAD::STREAM : AUDIO_LOAD::RESIDENT;
+}
+
+SoundHandle LoadSound(const char* path, bool looping, AUDIO_LOAD policy)
+{
+  if (!audio_backend) return {};
+
+  s32 sound;
+  {
+    std::lock_guard<std::mutex> guard(audio.lock);
+    u16 max_instances = looping || policy == AUDIO_LOAD::STREAM ? 1 : SOUND_EFFECT_MAX_INSTANCES;
+    sound = RegisterPendingSound(looping, looping ? SOUND_PRIORITY_MUSIC : SOUND_PRIORITY_EFFECT, max_instances);
+  }
+
+  {
+    std::lock_guard<std::mutex> guard(audio_loader.lock);
+    audio_loader.jobs.PushBack({ sound, AssetPath("audio/").append(path), looping, policy });
+  }
+
+  audio_loader.wake.notify_one();
+  return { sound };
+}
+
+// stops every voice playing it and frees its samples, the handle stops working...a sound still
+// loading is freed as soon as it finishes
+void UnloadSound(SoundHandle sound)
+{
+  if (!audio_backend || sound.id < 0) return;
+
+  std::lock_guard<std::mutex> guard(audio.lock);
+  UncountSoundMemory(sound.id);
+  UnloadVoiceSound(sound.id);
+}
+
+// loads the file again under the same handle, anything playing the sound stops...plays that come in
+// while it reloads wait for it like they would for a first load
+void ReloadSound(SoundHandle sound, const char* path, bool looping, AUDIO_LOAD policy)
+{
+  if (!audio_backend || sound.id < 0) return;
+
+  {
+    std::lock_guard<std::mutex> guard(audio.lock);
+    if (!ReloadVoiceSound(sound.id)) return;
+    UncountSoundMemory(sound.id);
+  }
+
+  {
+    std::lock_guard<std::mutex> guard(audio_loader.lock);
+    audio_loader.jobs.PushBack({ sound.id, AssetPath("audio/").append(path), looping, policy });
+  }
+
+  audio_loader.wake.notify_one();
 }
 
-bool StopSound(const char* sound)           // TODO : write this function!
+void WaitForSoundLoads()
 {
+  if (!audio_backend) return;
+
+  std::unique_lock<std::mutex> guard(audio_loader.lock);
+  audio_loader.idle.wait(guard, [] { return audio_loader.next_job == audio_loader.jobs.Size() && !audio_loader.busy; });
+}
+
+SoundHandle FindSound(const char* name)
+{
+  if (!scene_sounds.Find(name))
+  {
+    DebugPrintToConsole("Failed to find sound: ", name);
+    return {};
+  }
+
+  return { scene_sounds.At(name) };
+}
+
+static inline bool PushAudioCommand(const AudioCommand& command)
+{
+  if (audio.commands.Push(command)) return true;
+
+  audio.dropped_commands++;
   return false;
 }
+
+SoundEvent PlaySound(SoundHandle sound, const VoiceParams& params)
+{
+  if (!audio_backend || sound.id < 0) return {};    // headless replays run without audio
+
+  u32 event = ++audio.next_event;
+  if (event == 0) event = ++audio.next_event;
+
+  // marked before the command goes out so it never looks finished before the audio thread sees it
+  audio.events_playing[event % AUDIO_EVENT_SLOTS].store(event, std::memory_order_release);
+  if (!PushAudioCommand({ AUDIO_COMMAND::PLAY, sound.id, event, params }))
+  {
+    audio.events_playing[event % AUDIO_EVENT_SLOTS].store(0, std::memory_order_relaxed);
+    return {};
+  }
+  return { event };
+}
+
+SoundEvent PlaySound(SoundHandle sound)
+{
+  return PlaySound(sound, VoiceParams());
+}
+
+void StopSound(SoundEvent event)
+{
+  if (audio_backend && event.id != 0) PushAudioCommand({ AUDIO_COMMAND::STOP, -1, event.id, VoiceParams() });
+}
+
+void StopAllSounds(SoundHandle sound)
+{
+  if (audio_backend && sound.id >= 0) PushAudioCommand({ AUDIO_COMMAND::STOP_ALL, sound.id, 0, VoiceParams() });
+}
+
+void SetSoundParams(SoundEvent event, const VoiceParams& params)
+{
+  if (audio_backend && event.id != 0) PushAudioCommand({ AUDIO_COMMAND::SET_PARAMS, -1, event.id, params });
+}
+
+// from PlaySound until the sound ends, is stopped or gets stolen, waiting for its sound to load counts
+bool IsSoundPlaying(SoundEvent event)
+{
+  return event.id != 0 && audio.events_playing[event.id % AUDIO_EVENT_SLOTS].load(std::memory_order_acquire) == event.id;
+}
+
+void DrawAudioWindow(bool* open)
+{
+  if (!ImGui::Begin("Audio", open))
+  {
+    ImGui::End();
+    return;
+  }
+
+  ImGui::Text("%-10s %6s %12s %10s", "policy", "sounds", "resident", "avg load");
+  u64 total_bytes = 0;
+  for (u32 p = 0; p < AUDIO_LOAD_COUNT; p++)
+  {
+    u32 sounds = audio_memory.sounds[p].load();
+    u64 bytes = audio_memory.bytes[p].load();
+    u32 loads = audio_memory.loads[p].load();
+    f64 avg_ms = loads > 0 ? audio_memory.load_ns[p].load() / 1e6 / loads : 0.0;
+    total_bytes += bytes;
+    ImGui::Text("%-10s %6u %9.1f KB %7.2f ms", audio_load_names[p], sounds, bytes / 1024.0, avg_ms);
+  }
+
+  ImGui::Text("Total resident: %.1f KB", total_bytes / 1024.0);
+  // two disk chunks of 16 bit stereo plus the decoded window, what one playing stream holds on top
+  ImGui::Text("Stream buffers: %.0f KB per playing voice", (STREAM_CHUNK_FRAMES * 2 * 2 * sizeof(s16) + MIXER_WINDOW_FRAMES * 2 * sizeof(f32)) / 1024.0);
+  ImGui::Text("Failed loads: %u   Dropped commands: %llu", audio_memory.failed.load(), (unsigned long long)audio.dropped_commands);
+
+  ImGui::End();
+}
@@ -0,0 +1,453 @@
+#pragma once
+
+#include "Core.h"
+#include "vector.h"
+#include "AudioMixer.h"
+
+#ifdef EN_FMOD
+#include "fmod/fmod.hpp"
+#endif
+
+
+/// Audio Backend API Reference
+////// AudioBackend* CreateAudioBackend(AUDIO_BACKEND type, const char* capture_path);
+////// bool AudioBackend::Init(u32 voice_count);
+////// bool AudioBackend::PrepareSound(const char* path, bool looping, AUDIO_LOAD policy, PreparedSound& prepared);
+////// s32 AudioBackend::AddSound(PreparedSound& prepared);
+////// void AudioBackend::RemoveSound(s32 sound);
+////// bool AudioBackend::StartVoice(u32 voice, s32 sound, const VoiceParams& params, f32 start_seconds);
+////// void AudioBackend::StopVoice(u32 voice);
+////// void AudioBackend::SetVoiceParams(u32 voice, const VoiceParams& params);
+////// bool AudioBackend::IsVoicePlaying(u32 voice);
+////// void AudioBackend::Update(f32 delta_seconds);
+
+// a backend only knows about a fixed number of voice slots and the sounds loaded into it, deciding
+// which sound plays in which slot is the voice manager's job (see AudioVoices.h)
+
+// loading is split in two so it can happen off the audio thread...PrepareSound does the slow part
+// and may run on any thread without touching the backend, AddSound hands the result over and is
+// called with the audio lock held
+
+// FMOD only ships windows binaries in lib/, so it is only built with EN_FMOD...everywhere else the
+// built in software mixer (see AudioMixer.h) plays sounds instead
+
+enum class AUDIO_BACKEND
+{
+  FMOD,
+  SOFTWARE,
+  NONE        // plays nothing but keeps track of what would be playing, used headless and in tests
+};
+
+struct VoiceParams
+{
+  f32 volume = 1.f;
+  f32 pan = 0.f;          // -1 left, 1 right
+  f32 pitch = 1.f;
+};
+
+struct PreparedSound
+{
+  void* native = nullptr;         // whatever the backend needs carried from PrepareSound to AddSound
+  f32 length_seconds = 0.f;
+  u64 resident_bytes = 0;
+  bool looping = false;
+};
+
+struct AudioBackend
+{
+  virtual ~AudioBackend() {}
+
+  virtual bool Init(u32 voice_count) = 0;
+  virtual void Shutdown() = 0;
+  virtual void Update(f32 delta_seconds) = 0;
+
+  virtual bool PrepareSound(const char* path, bool looping, AUDIO_LOAD policy, PreparedSound& prepared) = 0;
+  virtual s32 AddSound(PreparedSound& prepared) = 0;
+  virtual void RemoveSound(s32 sound) = 0;          // no voice may still be playing it
+  virtual bool StartVoice(u32 voice, s32 sound, const VoiceParams& params, f32 start_seconds) = 0;
+  virtual void StopVoice(u32 voice) = 0;
+  virtual void SetVoiceParams(u32 voice, const VoiceParams& params) = 0;
+  virtual bool IsVoicePlaying(u32 voice) = 0;
+};
+
+#ifdef EN_FMOD
+struct FMODAudioBackend : AudioBackend
+{
+  FMOD::System* system = nullptr;
+  en::vector<FMOD::Sound*> sounds;
+  en::vector<MappedFile> mapped;          // per sound, what a MAPPED or STREAM one plays out of...empty for the rest
+  FMOD::Channel** channels = nullptr;
+  u32 voice_count = 0;
+
+  bool Init(u32 _voice_count) override
+  {
+    if (FMOD::System_Create(&system) != FMOD_OK) return false;
+    if (system->init(_voice_count, FMOD_INIT_NORMAL, 0) != FMOD_OK) return false;
+
+    voice_count = _voice_count;
+    channels = new FMOD::Channel*[voice_count];
+    for (u32 i = 0; i < voice_count; i++) channels[i] = nullptr;
+
+    return true;
+  }
+
+  void Shutdown() override
+  {
+    for (s32 s = 0; s < sounds.Size(); s++) RemoveSound(s);
+    sounds.Clear();
+    mapped.Clear();
+    if (system)
+    {
+      system->close();
+      system->release();
+    }
+
+    delete[] channels;
+    channels = nullptr;
+    system = nullptr;
+  }
+
+  void Update(f32 /*delta_seconds*/) override
+  {
+    system->update();
+  }
+
+  // the pcm is handed to fmod as raw samples pointing into the mapping, so it never copies them
+  bool PrepareMappedSound(const char* path, bool looping, PreparedSound& prepared)
+  {
+    MappedFile file;
+    WavInfo info;
+    if (!MapAssetFile(path, file, true)) return false;
+    if (!ParseWavHeader(file.data, file.size, info) || info.data_bytes == 0)
+    {
+      UnmapFile(file);
+      return false;
+    }
+
+    FMOD_CREATESOUNDEXINFO exinfo = {};
+    exinfo.cbsize = sizeof(exinfo);
+    exinfo.length = info.data_bytes;
+    exinfo.numchannels = info.channels;
+    exinfo.defaultfrequency = info.sample_rate;
+    exinfo.format = info.bits == 16 ? FMOD_SOUND_FORMAT_PCM16 : FMOD_SOUND_FORMAT_PCMFLOAT;
+
+    FMOD_MODE mode = FMOD_OPENMEMORY_POINT | FMOD_OPENRAW | FMOD_CREATESAMPLE | (looping ? FMOD_LOOP_NORMAL : FMOD_DEFAULT);
+    FMOD::Sound* sound;
+    if (system->createSound((const char*)file.data + info.data_offset, mode, &exinfo, &sound) != FMOD_OK)
+    {
+      UnmapFile(file);
+      return false;
+    }
+
+    // rides along on the sound until AddSound gives it a slot
+    sound->setUserData(new MappedFile(file));
+
+    prepared.native = sound;
+    prepared.length_seconds = (f32)info.data_bytes / (info.channels * info.bits / 8) / info.sample_rate;
+    prepared.resident_bytes = info.data_bytes;
+    prepared.looping = looping;
+    return true;
+  }
+
+  // the fmod system is thread safe, so createSound can run on the loader thread...the file is read
+  // through the pack like every other asset, a sample is copied out of it while it is created but a
+  // stream decodes out of it for as long as it plays, so that one stays mapped like a MAPPED sound
+  bool PrepareSound(const char* path, bool looping, AUDIO_LOAD policy, PreparedSound& prepared) override
+  {
+    if (policy == AUDIO_LOAD::MAPPED) return PrepareMappedSound(path, looping, prepared);
+
+    bool stream = policy == AUDIO_LOAD::STREAM;
+    MappedFile file;
+    if (!MapAssetFile(path, file, stream)) return false;
+
+    FMOD_CREATESOUNDEXINFO exinfo = {};
+    exinfo.cbsize = sizeof(exinfo);
+    exinfo.length = (u32)file.size;
+
+    FMOD_MODE mode = stream ? FMOD_OPENMEMORY_POINT : FMOD_OPENMEMORY;
+    if (policy == AUDIO_LOAD::RESIDENT) mode |= FMOD_CREATESAMPLE;
+    else if (policy == AUDIO_LOAD::COMPRESSED) mode |= FMOD_CREATECOMPRESSEDSAMPLE;
+    else mode |= FMOD_CREATESTREAM;
+    if (looping) mode |= FMOD_LOOP_NORMAL;
+
+    FMOD::Sound* sound;
+    bool created = system->createSound((const char*)file.data, mode, &exinfo, &sound) == FMOD_OK;
+    if (!created || !stream) UnmapFile(file);
+    if (!created) return false;
+    if (stream) sound->setUserData(new MappedFile(file));
+
+    u32 length_ms = 0;
+    u32 pcm_bytes = 0;
+    sound->getLength(&length_ms, FMOD_TIMEUNIT_MS);
+    if (policy != AUDIO_LOAD::STREAM) sound->getLength(&pcm_bytes, FMOD_TIMEUNIT_PCMBYTES);
+
+    prepared.native = sound;
+    prepared.length_seconds = length_ms / 1000.f;
+    prepared.resident_bytes = pcm_bytes;
+    prepared.looping = looping;
+    return true;
+  }
+
+  s32 AddSound(PreparedSound& prepared) override
+  {
+    FMOD::Sound* sound = (FMOD::Sound*)prepared.native;
+    MappedFile file;
+    void* user_data = nullptr;
+    sound->getUserData(&user_data);
+    if (user_data)
+    {
+      file = *(MappedFile*)user_data;
+      delete (MappedFile*)user_data;
+      sound->setUserData(nullptr);
+    }
+
+    sounds.PushBack(sound);
+    mapped.PushBack(file);
+    return sounds.Size() - 1;
+  }
+
+  // a mapped sound's file goes once fmod has let go of the sound pointing into it
+  void RemoveSound(s32 sound) override
+  {
+    if (!sounds[sound]) return;
+
+    sounds[sound]->release();
+    sounds[sound] = nullptr;
+    UnmapFile(mapped[sound]);
+  }
+
+  bool StartVoice(u32 voice, s32 sound, const VoiceParams& params, f32 start_seconds) override
+  {
+    StopVoice(voice);
+
+    FMOD::Channel* channel = nullptr;
+    if (system->playSound(sounds[sound], nullptr, true, &channel) != FMOD_OK) return false;
+
+    channel->setVolume(params.volume);
+    channel->setPan(params.pan);
+    channel->setPitch(params.pitch);
+    if (start_seconds > 0.f) channel->setPosition((u32)(start_seconds * 1000.f), FMOD_TIMEUNIT_MS);
+    channel->setPaused(false);
+    channels[voice] = channel;
+
+    return true;
+  }
+
+  void StopVoice(u32 voice) override
+  {
+    if (channels[voice]) channels[voice]->stop();
+    channels[voice] = nullptr;
+  }
+
+  void SetVoiceParams(u32 voice, const VoiceParams& params) override
+  {
+    FMOD::Channel* channel = channels[voice];
+    if (!channel) return;
+
+    channel->setVolume(params.volume);
+    channel->setPan(params.pan);
+    channel->setPitch(params.pitch);
+  }
+
+  bool IsVoicePlaying(u32 voice) override
+  {
+    bool playing = false;
+    if (channels[voice] && channels[voice]->isPlaying(&playing) != FMOD_OK) playing = false;
+    return playing;
+  }
+};
+#endif
+
+// mixes on Update, as many blocks as the elapsed time covers, and hands them to a null or WAV sink
+struct SoftwareAudioBackend : AudioBackend
+{
+  AudioMixer mixer;
+  AudioSink sink;
+  const char* capture_path = nullptr;     // set before Init to write the mix to a WAV file
+  f64 frames_due = 0.0;
+  alignas(32) f32 block[2][MIXER_BLOCK_FRAMES];
+
+  bool Init(u32 voice_count) override
+  {
+    InitMixer(mixer, voice_count, RESAMPLE_MODE::CUBIC);
+    OpenAudioSink(sink, capture_path ? AUDIO_SINK::WAV : AUDIO_SINK::NONE, capture_path, SAMPLE_FORMAT::S16, MIXER_SAMPLE_RATE);
+    return true;
+  }
+
+  void Shutdown() override
+  {
+    CloseAudioSink(sink);
+    ShutdownMixer(mixer);
+  }
+
+  void Update(f32 delta_seconds) override
+  {
+    frames_due += delta_seconds * (f64)MIXER_SAMPLE_RATE;
+    while (frames_due >= MIXER_BLOCK_FRAMES)
+    {
+      MixAudio(mixer, block[0], block[1], MIXER_BLOCK_FRAMES);
+      WriteAudioSink(sink, block[0], block[1], MIXER_BLOCK_FRAMES);
+      frames_due -= MIXER_BLOCK_FRAMES;
+    }
+  }
+
+  bool PrepareSound(const char* path, bool looping, AUDIO_LOAD policy, PreparedSound& prepared) override
+  {
+    MixerSound* sound = new MixerSound;
+    if (!LoadWavSound(path, looping, policy, *sound))
+    {
+      FreeMixerSound(*sound);
+      delete sound;
+      return false;
+    }
+
+    prepared.native = sound;
+    prepared.length_seconds = (f32)sound->frame_count / sound->sample_rate;
+    prepared.resident_bytes = MixerSoundBytes(*sound);
+    prepared.looping = looping;
+    return true;
+  }
+
+  s32 AddSound(PreparedSound& prepared) override
+  {
+    MixerSound* sound = (MixerSound*)prepared.native;
+    s32 id = AddMixerSound(mixer, *sound);
+    delete sound;
+    return id;
+  }
+
+  void RemoveSound(s32 sound) override
+  {
+    RemoveMixerSound(mixer, sound);
+  }
+
+  bool StartVoice(u32 voice, s32 sound, const VoiceParams& params, f32 start_seconds) override
+  {
+    StartMixerVoice(mixer, voice, sound, params.volume, params.pan, params.pitch, start_seconds);
+    return true;
+  }
+
+  void StopVoice(u32 voice) override
+  {
+    StopMixerVoice(mixer, voice);
+  }
+
+  void SetVoiceParams(u32 voice, const VoiceParams& params) override
+  {
+    SetMixerVoiceParams(mixer, voice, params.volume, params.pan, params.pitch);
+  }
+
+  bool IsVoicePlaying(u32 voice) override
+  {
+    return mixer.voices[voice].sound >= 0;
+  }
+};
+
+struct NullAudioBackend : AudioBackend
+{
+  struct NullVoice
+  {
+    s32 sound = -1;
+    f32 remaining = 0.f;
+  };
+
+  struct NullSound
+  {
+    f32 length_seconds;
+    bool looping;
+  };
+
+  en::vector<NullSound> sounds;
+  NullVoice* voices = nullptr;
+  u32 voice_count = 0;
+  u64 voices_started = 0;
+  u64 voices_stopped = 0;
+
+  bool Init(u32 _voice_count) override
+  {
+    voice_count = _voice_count;
+    voices = new NullVoice[voice_count];
+    return true;
+  }
+
+  void Shutdown() override
+  {
+    delete[] voices;
+    voices = nullptr;
+  }
+
+  void Update(f32 delta_seconds) override
+  {
+    for (u32 i = 0; i < voice_count; i++)
+    {
+      NullVoice& v = voices[i];
+      if (v.sound < 0 || sounds[v.sound].looping) continue;
+
+      v.remaining -= delta_seconds;
+      if (v.remaining <= 0.f) v.sound = -1;
+    }
+  }
+
+  // the null backend never touches the disk, every loaded sound pretends to be half a second long
+  bool PrepareSound(const char* /*path*/, bool looping, AUDIO_LOAD /*policy*/, PreparedSound& prepared) override
+  {
+    prepared.length_seconds = 0.5f;
+    prepared.looping = looping;
+    return true;
+  }
+
+  s32 AddSound(PreparedSound& prepared) override
+  {
+    return AddNullSound(prepared.length_seconds, prepared.looping);
+  }
+
+  void RemoveSound(s32 /*sound*/) override {}
+
+  s32 AddNullSound(f32 length_seconds, bool looping)
+  {
+    sounds.PushBack({ length_seconds, looping });
+    return sounds.Size() - 1;
+  }
+
+  bool StartVoice(u32 voice, s32 sound, const VoiceParams& /*params*/, f32 start_seconds) override
+  {
+    voices[voice].sound = sound;
+    voices[voice].remaining = sounds[sound].length_seconds - start_seconds;
+    voices_started++;
+    return true;
+  }
+
+  void StopVoice(u32 voice) override
+  {
+    if (voices[voice].sound >= 0) voices_stopped++;
+    voices[voice].sound = -1;
+  }
+
+  void SetVoiceParams(u32 /*voice*/, const VoiceParams& /*params*/) override {}
+
+  bool IsVoicePlaying(u32 voice) override
+  {
+    return voices[voice].sound >= 0;
+  }
+};
+
+AudioBackend* CreateAudioBackend(AUDIO_BACKEND type, const char* capture_path)
+{
+#ifdef EN_FMOD
+  if (type == AUDIO_BACKEND::FMOD && !capture_path) return new FMODAudioBackend;
+#endif
+
+  switch (type)
+  {
+    case AUDIO_BACKEND::FMOD:
+    case AUDIO_BACKEND::SOFTWARE:
+    {
+      SoftwareAudioBackend* backend = new SoftwareAudioBackend;
+      backend->capture_path = capture_path;
+      return backend;
+    }
+    case AUDIO_BACKEND::NONE: return new NullAudioBackend;
+  }
+
+  return nullptr;
+}
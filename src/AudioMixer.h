@@ -0,0 +1,1188 @@
+#pragma once
+
+#include "Core.h"
+#include "Profiler.h"
+#include "vector.h"
+#include "AssetPack.h"
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define EN_MIXER_LANES 8
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define EN_MIXER_LANES 4
+#else
+#define EN_MIXER_LANES 1
+#endif
+
+
+/// Audio Mixer API Reference
+////// bool AllocMixerSound(MixerSound& sound, u32 channels, u32 frame_count, u32 sample_rate, bool looping);
+////// void WriteMixerSoundGuards(MixerSound& sound);
+////// void FreeMixerSound(MixerSound& sound);
+////// u64 MixerSoundBytes(const MixerSound& sound);
+////// bool LoadWavSound(const char* path, bool looping, AUDIO_LOAD policy, MixerSound& sound);
+////// bool InitMixer(AudioMixer& mixer, u32 voice_count, RESAMPLE_MODE resample);
+////// void ShutdownMixer(AudioMixer& mixer);
+////// s32 AddMixerSound(AudioMixer& mixer, const MixerSound& sound);
+////// void RemoveMixerSound(AudioMixer& mixer, s32 sound);
+////// void StartMixerVoice(AudioMixer& mixer, u32 voice, s32 sound, f32 volume, f32 pan, f32 pitch, f32 start_seconds);
+////// void StopMixerVoice(AudioMixer& mixer, u32 voice);
+////// void SetMixerVoiceParams(AudioMixer& mixer, u32 voice, f32 volume, f32 pan, f32 pitch);
+////// void MixAudio(AudioMixer& mixer, f32* out_left, f32* out_right, u32 frames);
+////// void InterleaveS16(const f32* left, const f32* right, s16* out, u32 frames);
+////// void InterleaveF32(const f32* left, const f32* right, f32* out, u32 frames);
+////// bool OpenAudioSink(AudioSink& sink, AUDIO_SINK type, const char* path, SAMPLE_FORMAT format, u32 sample_rate);
+////// void WriteAudioSink(AudioSink& sink, const f32* left, const f32* right, u32 frames);
+////// void CloseAudioSink(AudioSink& sink);
+
+// the software mixer keeps every sound as planar f32 samples and mixes into a planar f32 stereo
+// bus...voices are resampled to the mixer rate with 32.32 fixed point positions, scaled by their
+// left/right gains and summed with SSE/AVX, and the bus is only interleaved into s16 or f32 at
+// the very end when it goes out to a sink
+
+// how a sound is kept in memory is its load policy:
+//   RESIDENT   : decoded to f32 up front, voices read the samples directly
+//   COMPRESSED : IMA ADPCM in memory (1/8th of f32), decoded into a small window per voice as it plays
+//   STREAM     : nothing in memory but the file header, a stream thread reads the samples into two
+//                chunks per voice just ahead of the mixer
+//   MAPPED     : the file is memory mapped and voices read the pcm straight out of the mapped pages,
+//                loading is only checking the header
+
+const u32 MIXER_SAMPLE_RATE = 48000;
+const u32 MIXER_BLOCK_FRAMES = 256;     // ~5.3ms at 48kHz, this is the callback budget a block has to fit in
+const u32 MIXER_WINDOW_FRAMES = 1024;   // decoded frames a compressed, streamed or mapped voice keeps around
+const u32 ADPCM_BLOCK_FRAMES = 1024;
+const u32 ADPCM_BLOCK_BYTES = 4 + ADPCM_BLOCK_FRAMES / 2;
+const u32 STREAM_CHUNK_FRAMES = 16384;  // ~0.37s at 44.1kHz, a streaming voice double buffers two of these
+
+enum class RESAMPLE_MODE
+{
+  LINEAR,
+  CUBIC       // catmull-rom, needs one frame before and two after the read position
+};
+
+enum class AUDIO_LOAD
+{
+  RESIDENT,
+  COMPRESSED,
+  STREAM,
+  MAPPED
+};
+
+const u32 AUDIO_LOAD_COUNT = 4;
+
+enum class SAMPLE_FORMAT
+{
+  S16,
+  F32
+};
+
+enum class AUDIO_SINK
+{
+  NONE,       // converts the mix and throws it away, used to measure the full output path headless
+  WAV
+};
+
+// planes point one frame into data so interpolation can read a frame before the start and three
+// after the end...for looping sounds those guard frames wrap around, otherwise they are silence
+struct MixerSound
+{
+  AUDIO_LOAD policy = AUDIO_LOAD::RESIDENT;
+  f32* data = nullptr;
+  f32* planes[2] = {};      // mono sounds point both planes at the same samples
+  u32 channels = 0;
+  u32 frame_count = 0;
+  u32 sample_rate = 0;
+  bool looping = false;
+
+  u8* adpcm = nullptr;      // COMPRESSED, ADPCM_BLOCK_BYTES per channel per block
+  u64 adpcm_bytes = 0;
+
+  std::string path;         // STREAM, where the samples are on disk
+  u64 data_offset = 0;
+  u16 sample_bits = 16;     // STREAM and MAPPED, 16 bit pcm or 32 bit float
+
+  MappedFile mapped;        // MAPPED, pcm points at the data chunk inside it
+  const u8* pcm = nullptr;
+};
+
+enum STREAM_CHUNK_STATE : u32
+{
+  STREAM_CHUNK_EMPTY,
+  STREAM_CHUNK_READY
+};
+
+// the stream thread only fills EMPTY chunks and the mixer only reads READY ones, the state flips
+// are the only thing the two share
+struct MixerStreamChunk
+{
+  std::atomic<u32> state{ STREAM_CHUNK_EMPTY };
+  u32 frames = 0;
+  bool end = false;         // a non looping sound has nothing after this chunk
+  u8* bytes = nullptr;
+};
+
+struct MixerStream
+{
+  std::string path;
+  u64 data_offset = 0;
+  u32 frame_count = 0;
+  u32 channels = 0;
+  u16 sample_bits = 16;
+  bool looping = false;
+
+  std::ifstream file;       // stream thread only
+  u64 next_fill_frame = 0;  // stream thread only
+  u32 next_fill_chunk = 0;  // stream thread only
+  bool read_everything = false;
+
+  u32 read_chunk = 0;       // mixer only
+  u32 read_offset = 0;      // mixer only
+  bool ended = false;       // mixer only
+
+  bool filling = false;     // stream_lock
+  bool retired = false;     // stream_lock
+
+  MixerStreamChunk chunks[2];
+};
+
+// decoded frames around the read position of a compressed, streamed or mapped voice...base counts on past
+// the end of a looping sound so the window never has to care about the wrap
+struct MixerWindow
+{
+  s64 base = 0;
+  u32 count = 0;
+  f32 frames[2][MIXER_WINDOW_FRAMES];
+
+  u64 next_frame = 0;       // COMPRESSED and MAPPED read position
+  s32 predictor[2] = {};
+  s32 step_index[2] = {};
+
+  MixerStream* stream = nullptr;
+};
+
+struct MixerVoice
+{
+  s32 sound = -1;
+  u64 position = 0;         // 32.32 fixed point frame in the sound
+  u64 step = 0;             // 32.32 fixed point frames advanced per output frame
+  f32 gain_left = 0.f;
+  f32 gain_right = 0.f;
+};
+
+struct AudioMixer
+{
+  RESAMPLE_MODE resample = RESAMPLE_MODE::CUBIC;
+  en::vector<MixerSound> sounds;
+  MixerVoice* voices = nullptr;
+  MixerWindow* windows = nullptr;
+  u32 voice_count = 0;
+  u64 stream_stalls = 0;    // blocks a streamed voice sat out because its next chunk wasn't read yet
+  alignas(32) f32 scratch[2][MIXER_BLOCK_FRAMES];
+
+  std::thread stream_thread;
+  std::atomic<bool> streaming{ false };
+  std::mutex stream_lock;
+  std::condition_variable stream_wake;
+  en::vector<MixerStream*> streams;
+};
+
+struct AudioSink
+{
+  AUDIO_SINK type = AUDIO_SINK::NONE;
+  SAMPLE_FORMAT format = SAMPLE_FORMAT::S16;
+  u32 sample_rate = 0;
+  u64 frames_written = 0;
+  std::ofstream file;
+  alignas(32) f32 buffer[MIXER_BLOCK_FRAMES * 2];   // big enough for a block of interleaved f32 or s16
+};
+
+bool AllocMixerSound(MixerSound& sound, u32 channels, u32 frame_count, u32 sample_rate, bool looping)
+{
+  if (channels < 1 || channels > 2 || frame_count == 0 || sample_rate == 0) return false;
+
+  u32 stride = frame_count + 4;
+  sound.policy = AUDIO_LOAD::RESIDENT;
+  sound.data = new f32[stride * channels];
+  sound.planes[0] = sound.data + 1;
+  sound.planes[1] = channels == 2 ? sound.data + stride + 1 : sound.planes[0];
+  sound.channels = channels;
+  sound.frame_count = frame_count;
+  sound.sample_rate = sample_rate;
+  sound.looping = looping;
+
+  return true;
+}
+
+// call once the planes are filled in
+void WriteMixerSoundGuards(MixerSound& sound)
+{
+  for (u32 c = 0; c < sound.channels; c++)
+  {
+    f32* plane = sound.planes[c];
+    u32 count = sound.frame_count;
+
+    plane[-1] = sound.looping ? plane[count - 1] : 0.f;
+    for (u32 i = 0; i < 3; i++) plane[count + i] = sound.looping ? plane[i % count] : 0.f;
+  }
+}
+
+void FreeMixerSound(MixerSound& sound)
+{
+  delete[] sound.data;
+  delete[] sound.adpcm;
+  UnmapFile(sound.mapped);
+  sound = MixerSound();
+}
+
+u64 MixerSoundBytes(const MixerSound& sound)
+{
+  switch (sound.policy)
+  {
+    case AUDIO_LOAD::RESIDENT: return (u64)(sound.frame_count + 4) * sound.channels * sizeof(f32);
+    case AUDIO_LOAD::COMPRESSED: return sound.adpcm_bytes;
+    case AUDIO_LOAD::STREAM: return 0;
+    case AUDIO_LOAD::MAPPED: return (u64)sound.frame_count * sound.channels * sound.sample_bits / 8;    // clean file cache pages, the os can drop them
+  }
+
+  return 0;
+}
+
+static const s32 adpcm_index_table[16] = { -1, -1, -1, -1, 2, 4, 6, 8, -1, -1, -1, -1, 2, 4, 6, 8 };
+
+static const s32 adpcm_step_table[89] =
+{
+  7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45, 50, 55, 60, 66, 73, 80, 88, 97,
+  107, 118, 130, 143, 157, 173, 190, 209, 230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796,
+  876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871,
+  5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623,
+  27086, 29794, 32767
+};
+
+static inline s32 AdpcmDecodeNibble(u8 nibble, s32& predictor, s32& step_index)
+{
+  s32 step = adpcm_step_table[step_index];
+  s32 delta = step >> 3;
+  if (nibble & 4) delta += step;
+  if (nibble & 2) delta += step >> 1;
+  if (nibble & 1) delta += step >> 2;
+
+  predictor += (nibble & 8) ? -delta : delta;
+  predictor = predictor < -32768 ? -32768 : predictor > 32767 ? 32767 : predictor;
+  step_index += adpcm_index_table[nibble];
+  step_index = step_index < 0 ? 0 : step_index > 88 ? 88 : step_index;
+
+  return predictor;
+}
+
+// the encoder runs the decoder alongside so its prediction never drifts from what playback hears
+static u8 AdpcmEncodeSample(s32 sample, s32& predictor, s32& step_index)
+{
+  s32 step = adpcm_step_table[step_index];
+  s32 diff = sample - predictor;
+  u8 nibble = 0;
+  if (diff < 0)
+  {
+    nibble = 8;
+    diff = -diff;
+  }
+
+  if (diff >= step) { nibble |= 4; diff -= step; }
+  if (diff >= step >> 1) { nibble |= 2; diff -= step >> 1; }
+  if (diff >= step >> 2) nibble |= 1;
+
+  AdpcmDecodeNibble(nibble, predictor, step_index);
+  return nibble;
+}
+
+// each block restarts from a stored predictor and step index so a voice can seek to any block
+static void EncodeAdpcm(MixerSound& sound, const s16* const* samples)
+{
+  u32 blocks = (sound.frame_count + ADPCM_BLOCK_FRAMES - 1) / ADPCM_BLOCK_FRAMES;
+  sound.adpcm_bytes = (u64)blocks * sound.channels * ADPCM_BLOCK_BYTES;
+  sound.adpcm = new u8[sound.adpcm_bytes];
+  memset(sound.adpcm, 0, sound.adpcm_bytes);
+
+  for (u32 c = 0; c < sound.channels; c++)
+  {
+    s32 step_index = 0;
+    for (u32 b = 0; b < blocks; b++)
+    {
+      u8* block = sound.adpcm + ((u64)b * sound.channels + c) * ADPCM_BLOCK_BYTES;
+      u32 first = b * ADPCM_BLOCK_FRAMES;
+      s32 predictor = samples[c][first];
+
+      s16 stored = (s16)predictor;
+      memcpy(block, &stored, 2);
+      block[2] = (u8)step_index;
+
+      for (u32 i = 0; i < ADPCM_BLOCK_FRAMES && first + i < sound.frame_count; i++)
+      {
+        u8 nibble = AdpcmEncodeSample(samples[c][first + i], predictor, step_index);
+        block[4 + i / 2] |= (i & 1) ? (u8)(nibble << 4) : nibble;
+      }
+    }
+  }
+}
+
+struct WavInfo
+{
+  u16 format = 0;
+  u16 channels = 0;
+  u16 bits = 0;
+  u32 sample_rate = 0;
+  u64 data_offset = 0;
+  u32 data_bytes = 0;
+};
+
+// walks the riff chunks of a whole file in memory, data_bytes is cut down to what the file really has
+static bool ParseWavHeader(const u8* bytes, u64 size, WavInfo& info)
+{
+  if (size < 12 || memcmp(bytes, "RIFF", 4) != 0 || memcmp(bytes + 8, "WAVE", 4) != 0) return false;
+
+  u64 offset = 12;
+  while (offset + 8 <= size)
+  {
+    const u8* id = bytes + offset;
+    u32 chunk_size;
+    memcpy(&chunk_size, bytes + offset + 4, 4);
+    offset += 8;
+
+    if (memcmp(id, "fmt ", 4) == 0)
+    {
+      if (chunk_size < 16 || offset + 16 > size) return false;
+
+      const u8* fmt = bytes + offset;
+      memcpy(&info.format, fmt, 2);
+      memcpy(&info.channels, fmt + 2, 2);
+      memcpy(&info.sample_rate, fmt + 4, 4);
+      memcpy(&info.bits, fmt + 14, 2);
+      if (info.format == 0xFFFE && chunk_size >= 26 && offset + 26 <= size) memcpy(&info.format, fmt + 24, 2);    // extensible, the real tag leads the sub format
+    }
+    else if (memcmp(id, "data", 4) == 0)
+    {
+      info.data_offset = offset;
+      info.data_bytes = (u32)(size - offset < chunk_size ? size - offset : chunk_size);
+      break;
+    }
+
+    offset += (u64)chunk_size + (chunk_size & 1);
+  }
+
+  bool pcm16 = info.format == 1 && info.bits == 16;
+  bool float32 = info.format == 3 && info.bits == 32;
+  return info.data_offset != 0 && (pcm16 || float32) && info.channels >= 1 && info.channels <= 2 && info.sample_rate > 0;
+}
+
+static inline f32 WavSample(const u8* frame, u32 channel, u16 bits)
+{
+  if (bits == 16)
+  {
+    s16 value;
+    memcpy(&value, frame + channel * 2, 2);
+    return value * (1.f / 32768.f);
+  }
+
+  f32 value;
+  memcpy(&value, frame + channel * 4, 4);
+  return value;
+}
+
+// every policy reads the header out of a mapping, RESIDENT and COMPRESSED decode straight from it
+// and only MAPPED keeps it around once the sound is loaded
+bool LoadWavSound(const char* path, bool looping, AUDIO_LOAD policy, MixerSound& sound)
+{
+  MappedFile file;
+  WavInfo info;
+  if (!MapAssetFile(path, file, policy == AUDIO_LOAD::MAPPED || policy == AUDIO_LOAD::STREAM)) return false;
+
+  u32 frame_bytes = 0;
+  u32 frame_count = 0;
+  if (ParseWavHeader(file.data, file.size, info))
+  {
+    frame_bytes = info.channels * info.bits / 8;
+    frame_count = info.data_bytes / frame_bytes;
+  }
+
+  if (frame_count == 0)
+  {
+    UnmapFile(file);
+    return false;
+  }
+
+  // a packed sound has no file of its own to stream from, but it is already mapped with the pack
+  if (policy == AUDIO_LOAD::STREAM && file.borrowed) policy = AUDIO_LOAD::MAPPED;
+
+  const u8* samples = file.data + info.data_offset;
+  sound.policy = policy;
+  sound.channels = info.channels;
+  sound.frame_count = frame_count;
+  sound.sample_rate = info.sample_rate;
+  sound.looping = looping;
+  sound.sample_bits = info.bits;
+
+  if (policy == AUDIO_LOAD::MAPPED)
+  {
+    sound.mapped = file;
+    sound.pcm = samples;
+    return true;
+  }
+
+  if (policy == AUDIO_LOAD::STREAM)
+  {
+    sound.path = path;
+    sound.data_offset = info.data_offset;
+  }
+  else if (policy == AUDIO_LOAD::COMPRESSED)
+  {
+    s16* planes[2] = {};
+    for (u32 c = 0; c < info.channels; c++)
+    {
+      planes[c] = new s16[frame_count];
+      for (u32 i = 0; i < frame_count; i++)
+      {
+        f32 value = WavSample(samples + (u64)i * frame_bytes, c, info.bits) * 32768.f;
+        planes[c][i] = (s16)(value < -32768.f ? -32768.f : value > 32767.f ? 32767.f : value);
+      }
+    }
+
+    EncodeAdpcm(sound, planes);
+    for (u32 c = 0; c < info.channels; c++) delete[] planes[c];
+  }
+  else
+  {
+    AllocMixerSound(sound, info.channels, frame_count, info.sample_rate, looping);
+    for (u32 c = 0; c < info.channels; c++)
+    {
+      f32* plane = sound.planes[c];
+      for (u32 i = 0; i < frame_count; i++) plane[i] = WavSample(samples + (u64)i * frame_bytes, c, info.bits);
+    }
+
+    WriteMixerSoundGuards(sound);
+  }
+
+  UnmapFile(file);
+  return true;
+}
+
+static void FillStreamChunk(MixerStream& stream, MixerStreamChunk& chunk)
+{
+  u32 frame_bytes = stream.channels * stream.sample_bits / 8;
+  if (!chunk.bytes) chunk.bytes = new u8[STREAM_CHUNK_FRAMES * frame_bytes];
+  if (!stream.file.is_open()) stream.file.open(stream.path, std::ios::binary);
+
+  u32 filled = 0;
+  chunk.end = false;
+  while (filled < STREAM_CHUNK_FRAMES)
+  {
+    if (stream.next_fill_frame >= stream.frame_count)
+    {
+      if (!stream.looping) break;
+      stream.next_fill_frame = 0;
+    }
+
+    u32 count = STREAM_CHUNK_FRAMES - filled;
+    if (stream.next_fill_frame + count > stream.frame_count) count = (u32)(stream.frame_count - stream.next_fill_frame);
+
+    stream.file.seekg(stream.data_offset + stream.next_fill_frame * frame_bytes);
+    u32 read = (u32)(stream.file.read((char*)chunk.bytes + filled * frame_bytes, (u64)count * frame_bytes).gcount() / frame_bytes);
+    if (read < count)
+    {
+      // the file went short underneath us, whatever is missing plays as silence
+      stream.file.clear();
+      memset(chunk.bytes + (filled + read) * frame_bytes, 0, (u64)(count - read) * frame_bytes);
+    }
+
+    filled += count;
+    stream.next_fill_frame += count;
+  }
+
+  if (!stream.looping && stream.next_fill_frame >= stream.frame_count)
+  {
+    chunk.end = true;
+    stream.read_everything = true;
+  }
+
+  chunk.frames = filled;
+}
+
+static void RemoveStream(AudioMixer& mixer, MixerStream* stream)
+{
+  for (s32 i = 0; i < mixer.streams.Size(); i++)
+  {
+    if (mixer.streams[i] == stream)
+    {
+      mixer.streams[i] = mixer.streams[mixer.streams.Size() - 1];
+      mixer.streams.PopBack();
+      break;
+    }
+  }
+
+  for (auto& chunk : stream->chunks) delete[] chunk.bytes;
+  delete stream;
+}
+
+static void MixerStreamThread(AudioMixer* mixer)
+{
+  ProfilerSetThreadName("AudioStream");
+
+  while (mixer->streaming.load(std::memory_order_acquire))
+  {
+    MixerStream* work = nullptr;
+    {
+      std::unique_lock<std::mutex> guard(mixer->stream_lock);
+      for (auto stream : mixer->streams)
+      {
+        if (!stream->retired && !stream->read_everything &&
+            stream->chunks[stream->next_fill_chunk].state.load(std::memory_order_acquire) == STREAM_CHUNK_EMPTY)
+        {
+          work = stream;
+          work->filling = true;
+          break;
+        }
+      }
+
+      if (!work)
+      {
+        mixer->stream_wake.wait_for(guard, std::chrono::milliseconds(2));
+        continue;
+      }
+    }
+
+    {
+      PROFILE_SCOPE("FillStreamChunk");
+      MixerStreamChunk& chunk = work->chunks[work->next_fill_chunk];
+      FillStreamChunk(*work, chunk);
+      chunk.state.store(STREAM_CHUNK_READY, std::memory_order_release);
+      work->next_fill_chunk ^= 1;
+    }
+
+    std::lock_guard<std::mutex> guard(mixer->stream_lock);
+    work->filling = false;
+    if (work->retired) RemoveStream(*mixer, work);
+  }
+}
+
+static void StartStream(AudioMixer& mixer, MixerWindow& window, const MixerSound& sound, u64 frame)
+{
+  MixerStream* stream = new MixerStream;
+  stream->path = sound.path;
+  stream->data_offset = sound.data_offset;
+  stream->frame_count = sound.frame_count;
+  stream->channels = sound.channels;
+  stream->sample_bits = sound.sample_bits;
+  stream->looping = sound.looping;
+  stream->next_fill_frame = frame;
+
+  {
+    std::lock_guard<std::mutex> guard(mixer.stream_lock);
+    mixer.streams.PushBack(stream);
+  }
+
+  mixer.stream_wake.notify_one();
+  window.stream = stream;
+}
+
+static void RetireStream(AudioMixer& mixer, MixerWindow& window)
+{
+  if (!window.stream) return;
+
+  std::lock_guard<std::mutex> guard(mixer.stream_lock);
+  if (window.stream->filling) window.stream->retired = true;
+  else RemoveStream(mixer, window.stream);
+
+  window.stream = nullptr;
+}
+
+// reads frames from the stream's chunks, returns fewer than asked for when the stream thread hasn't
+// caught up yet...past the end of a non looping sound it reads silence
+static u32 ReadStreamFrames(MixerStream& stream, f32* left, f32* right, u32 count)
+{
+  u32 frame_bytes = stream.channels * stream.sample_bits / 8;
+  u32 done = 0;
+
+  while (done < count)
+  {
+    if (stream.ended)
+    {
+      memset(left + done, 0, (count - done) * sizeof(f32));
+      memset(right + done, 0, (count - done) * sizeof(f32));
+      return count;
+    }
+
+    MixerStreamChunk& chunk = stream.chunks[stream.read_chunk];
+    if (chunk.state.load(std::memory_order_acquire) != STREAM_CHUNK_READY) break;
+
+    u32 n = chunk.frames - stream.read_offset;
+    if (n > count - done) n = count - done;
+
+    const u8* frame = chunk.bytes + (u64)stream.read_offset * frame_bytes;
+    for (u32 i = 0; i < n; i++, frame += frame_bytes)
+    {
+      left[done + i] = WavSample(frame, 0, stream.sample_bits);
+      right[done + i] = stream.channels == 2 ? WavSample(frame, 1, stream.sample_bits) : left[done + i];
+    }
+
+    done += n;
+    stream.read_offset += n;
+    if (stream.read_offset == chunk.frames)
+    {
+      stream.ended = chunk.end;
+      stream.read_offset = 0;
+      stream.read_chunk ^= 1;
+      chunk.state.store(STREAM_CHUNK_EMPTY, std::memory_order_release);
+    }
+  }
+
+  return done;
+}
+
+// decodes window.next_frame, block headers reset the predictor so any block can be started cold
+static inline void DecodeAdpcmFrame(const MixerSound& sound, MixerWindow& window, f32* out)
+{
+  u64 frame = window.next_frame++;
+  u32 k = (u32)(frame % ADPCM_BLOCK_FRAMES);
+  for (u32 c = 0; c < sound.channels; c++)
+  {
+    const u8* block = sound.adpcm + (frame / ADPCM_BLOCK_FRAMES * sound.channels + c) * ADPCM_BLOCK_BYTES;
+    if (k == 0)
+    {
+      s16 stored;
+      memcpy(&stored, block, 2);
+      window.predictor[c] = stored;
+      window.step_index[c] = block[2];
+    }
+
+    u8 nibble = (block[4 + k / 2] >> ((k & 1) * 4)) & 15;
+    out[c] = AdpcmDecodeNibble(nibble, window.predictor[c], window.step_index[c]) * (1.f / 32768.f);
+  }
+}
+
+static void SeekAdpcm(const MixerSound& sound, MixerWindow& window, u64 frame)
+{
+  if (frame >= sound.frame_count)
+  {
+    window.next_frame = sound.frame_count;
+    return;
+  }
+
+  // mid block the predictor can only be rebuilt by decoding from the block start
+  f32 discard[2];
+  window.next_frame = frame - frame % ADPCM_BLOCK_FRAMES;
+  while (window.next_frame < frame) DecodeAdpcmFrame(sound, window, discard);
+}
+
+// converts straight out of the mapped pages in runs up to the end of the sound
+static u32 ReadMappedFrames(const MixerSound& sound, MixerWindow& window, f32* left, f32* right, u32 count)
+{
+  u32 frame_bytes = sound.channels * sound.sample_bits / 8;
+  u32 done = 0;
+  while (done < count)
+  {
+    if (window.next_frame >= sound.frame_count)
+    {
+      if (!sound.looping)
+      {
+        memset(left + done, 0, (count - done) * sizeof(f32));
+        memset(right + done, 0, (count - done) * sizeof(f32));
+        return count;
+      }
+
+      window.next_frame = 0;
+    }
+
+    u32 run = count - done;
+    if (window.next_frame + run > sound.frame_count) run = (u32)(sound.frame_count - window.next_frame);
+
+    const u8* frame = sound.pcm + window.next_frame * frame_bytes;
+    f32* l = left + done;
+    f32* r = right + done;
+    if (sound.sample_bits == 16 && sound.channels == 2)
+    {
+      const s16* samples = (const s16*)frame;
+      for (u32 i = 0; i < run; i++)
+      {
+        l[i] = samples[i * 2] * (1.f / 32768.f);
+        r[i] = samples[i * 2 + 1] * (1.f / 32768.f);
+      }
+    }
+    else
+    {
+      for (u32 i = 0; i < run; i++, frame += frame_bytes)
+      {
+        l[i] = WavSample(frame, 0, sound.sample_bits);
+        r[i] = sound.channels == 2 ? WavSample(frame, 1, sound.sample_bits) : l[i];
+      }
+    }
+
+    window.next_frame += run;
+    done += run;
+  }
+
+  return count;
+}
+
+static u32 ReadAdpcmFrames(const MixerSound& sound, MixerWindow& window, f32* left, f32* right, u32 count)
+{
+  for (u32 i = 0; i < count; i++)
+  {
+    if (window.next_frame >= sound.frame_count)
+    {
+      if (!sound.looping)
+      {
+        left[i] = right[i] = 0.f;
+        continue;
+      }
+
+      window.next_frame = 0;
+    }
+
+    f32 frame[2];
+    DecodeAdpcmFrame(sound, window, frame);
+    left[i] = frame[0];
+    right[i] = sound.channels == 2 ? frame[1] : frame[0];
+  }
+
+  return count;
+}
+
+// starts the window over at frame first, which is one before the first frame the voice will read
+static void ResetWindow(AudioMixer& mixer, MixerWindow& window, const MixerSound& sound, s64 first)
+{
+  window.base = first;
+  window.count = 0;
+
+  u64 start = first < 0 ? 0 : (u64)first;
+  if (first < 0)
+  {
+    window.frames[0][0] = window.frames[1][0] = 0.f;
+    window.count = 1;
+  }
+
+  if (sound.policy == AUDIO_LOAD::COMPRESSED)
+  {
+    SeekAdpcm(sound, window, start);
+  }
+  else if (sound.policy == AUDIO_LOAD::STREAM)
+  {
+    RetireStream(mixer, window);
+    StartStream(mixer, window, sound, start);
+  }
+  else if (sound.policy == AUDIO_LOAD::MAPPED)
+  {
+    window.next_frame = start < sound.frame_count ? start : sound.frame_count;
+  }
+}
+
+// makes sure the window holds the taps for position onwards and trims count to what it can cover,
+// false when there is nothing to mix yet because a stream is still waiting on the disk
+static bool PrepareWindow(AudioMixer& mixer, MixerWindow& window, const MixerSound& sound, u64 position, u64 step, u32& count)
+{
+  s64 first = (s64)(position >> 32) - 1;
+  if (first < window.base || first > window.base + (s64)window.count)
+  {
+    ResetWindow(mixer, window, sound, first);
+  }
+  else if (first > window.base)
+  {
+    u32 shift = (u32)(first - window.base);
+    for (u32 c = 0; c < 2; c++) memmove(window.frames[c], window.frames[c] + shift, (window.count - shift) * sizeof(f32));
+    window.count -= shift;
+    window.base = first;
+  }
+
+  if (window.count < MIXER_WINDOW_FRAMES)
+  {
+    u32 wanted = MIXER_WINDOW_FRAMES - window.count;
+    f32* left = window.frames[0] + window.count;
+    f32* right = window.frames[1] + window.count;
+    if (sound.policy == AUDIO_LOAD::STREAM) window.count += ReadStreamFrames(*window.stream, left, right, wanted);
+    else if (sound.policy == AUDIO_LOAD::MAPPED) window.count += ReadMappedFrames(sound, window, left, right, wanted);
+    else window.count += ReadAdpcmFrames(sound, window, left, right, wanted);
+  }
+
+  // the last frame that still has both of its taps after it inside the window
+  s64 last = window.base + (s64)window.count - 3;
+  if (last < (s64)(position >> 32)) return false;
+
+  u64 limit = ((u64)(last + 1) << 32) - position;
+  u64 available = (limit + step - 1) / step;
+  if (available < count) count = (u32)available;
+
+  return true;
+}
+
+bool InitMixer(AudioMixer& mixer, u32 voice_count, RESAMPLE_MODE resample)
+{
+  mixer.voices = new MixerVoice[voice_count];
+  mixer.windows = new MixerWindow[voice_count];
+  mixer.voice_count = voice_count;
+  mixer.resample = resample;
+
+  mixer.streaming.store(true, std::memory_order_release);
+  mixer.stream_thread = std::thread(MixerStreamThread, &mixer);
+  return true;
+}
+
+void ShutdownMixer(AudioMixer& mixer)
+{
+  mixer.streaming.store(false, std::memory_order_release);
+  mixer.stream_wake.notify_one();
+  if (mixer.stream_thread.joinable()) mixer.stream_thread.join();
+
+  for (u32 i = 0; i < mixer.voice_count; i++) RetireStream(mixer, mixer.windows[i]);
+  for (auto& s : mixer.sounds) FreeMixerSound(s);
+  mixer.sounds.Clear();
+
+  delete[] mixer.voices;
+  delete[] mixer.windows;
+  mixer.voices = nullptr;
+  mixer.windows = nullptr;
+  mixer.voice_count = 0;
+}
+
+s32 AddMixerSound(AudioMixer& mixer, const MixerSound& sound)
+{
+  mixer.sounds.PushBack(sound);
+  return mixer.sounds.Size() - 1;
+}
+
+void SetMixerVoiceParams(AudioMixer& mixer, u32 voice, f32 volume, f32 pan, f32 pitch)
+{
+  MixerVoice& v = mixer.voices[voice];
+  if (v.sound < 0) return;
+
+  // equal power pan so a sound doesn't get quieter as it crosses the middle
+  f32 angle = (pan < -1.f ? -1.f : pan > 1.f ? 1.f : pan) * 0.25f * 3.14159265f + 0.25f * 3.14159265f;
+  v.gain_left = volume * cosf(angle);
+  v.gain_right = volume * sinf(angle);
+
+  f32 rate = pitch < 0.01f ? 0.01f : pitch;
+  v.step = (u64)((f64)rate * mixer.sounds[v.sound].sample_rate / MIXER_SAMPLE_RATE * 4294967296.0);
+}
+
+void StopMixerVoice(AudioMixer& mixer, u32 voice)
+{
+  mixer.voices[voice].sound = -1;
+  RetireStream(mixer, mixer.windows[voice]);
+}
+
+// frees the samples but keeps the slot, so the ids of the sounds after it don't move
+void RemoveMixerSound(AudioMixer& mixer, s32 sound)
+{
+  for (u32 i = 0; i < mixer.voice_count; i++)
+  {
+    if (mixer.voices[i].sound == sound) StopMixerVoice(mixer, i);
+  }
+
+  FreeMixerSound(mixer.sounds[sound]);
+}
+
+void StartMixerVoice(AudioMixer& mixer, u32 voice, s32 sound, f32 volume, f32 pan, f32 pitch, f32 start_seconds)
+{
+  StopMixerVoice(mixer, voice);
+
+  MixerVoice& v = mixer.voices[voice];
+  MixerSound& s = mixer.sounds[sound];
+
+  v.sound = sound;
+  v.position = (u64)((f64)start_seconds * s.sample_rate * 4294967296.0);
+  if (s.looping) v.position %= (u64)s.frame_count << 32;
+  SetMixerVoiceParams(mixer, voice, volume, pan, pitch);
+
+  if (s.policy != AUDIO_LOAD::RESIDENT) ResetWindow(mixer, mixer.windows[voice], s, (s64)(v.position >> 32) - 1);
+}
+
+static inline f32 ResampleFrame(const f32* src, u64 position, RESAMPLE_MODE mode)
+{
+  const f32* x = src + (position >> 32);
+  f32 t = (u32)position * (1.f / 4294967296.f);
+
+  if (mode == RESAMPLE_MODE::LINEAR) return x[0] + (x[1] - x[0]) * t;
+
+  f32 c1 = 0.5f * (x[1] - x[-1]);
+  f32 c2 = x[-1] - 2.5f * x[0] + 2.f * x[1] - 0.5f * x[2];
+  f32 c3 = 0.5f * (x[2] - x[-1]) + 1.5f * (x[0] - x[1]);
+  return ((c3 * t + c2) * t + c1) * t + x[0];
+}
+
+static void ResamplePlane(const f32* src, u64 position, u64 step, f32* out, u32 count, RESAMPLE_MODE mode)
+{
+  u32 i = 0;
+
+#if EN_MIXER_LANES >= 4
+  // one unaligned load grabs x[-1..2] for an output frame, four of them transposed give the four
+  // taps for four output frames side by side
+  const f32 to_fraction = 1.f / 4294967296.f;
+  __m128 half = _mm_set1_ps(0.5f);
+  __m128 one_half = _mm_set1_ps(1.5f);
+  __m128 two = _mm_set1_ps(2.f);
+  __m128 two_half = _mm_set1_ps(2.5f);
+
+  for (; i + 4 <= count; i += 4)
+  {
+    u64 p0 = position;
+    u64 p1 = p0 + step;
+    u64 p2 = p1 + step;
+    u64 p3 = p2 + step;
+    position = p3 + step;
+
+    __m128 xm1 = _mm_loadu_ps(src + (p0 >> 32) - 1);
+    __m128 x0 = _mm_loadu_ps(src + (p1 >> 32) - 1);
+    __m128 x1 = _mm_loadu_ps(src + (p2 >> 32) - 1);
+    __m128 x2 = _mm_loadu_ps(src + (p3 >> 32) - 1);
+    _MM_TRANSPOSE4_PS(xm1, x0, x1, x2);
+
+    __m128 t = _mm_set_ps((u32)p3 * to_fraction, (u32)p2 * to_fraction, (u32)p1 * to_fraction, (u32)p0 * to_fraction);
+    __m128 result;
+    if (mode == RESAMPLE_MODE::LINEAR)
+    {
+      result = _mm_add_ps(x0, _mm_mul_ps(_mm_sub_ps(x1, x0), t));
+    }
+    else
+    {
+      __m128 c1 = _mm_mul_ps(half, _mm_sub_ps(x1, xm1));
+      __m128 c2 = _mm_sub_ps(_mm_add_ps(_mm_sub_ps(xm1, _mm_mul_ps(two_half, x0)), _mm_mul_ps(two, x1)), _mm_mul_ps(half, x2));
+      __m128 c3 = _mm_add_ps(_mm_mul_ps(half, _mm_sub_ps(x2, xm1)), _mm_mul_ps(one_half, _mm_sub_ps(x0, x1)));
+      result = _mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(c3, t), c2), t), c1), t), x0);
+    }
+
+    _mm_storeu_ps(out + i, result);
+  }
+#endif
+
+  for (; i < count; i++, position += step)
+  {
+    out[i] = ResampleFrame(src, position, mode);
+  }
+}
+
+static void AccumulateScaled(f32* out, const f32* in, f32 gain, u32 count)
+{
+  u32 i = 0;
+
+#if EN_MIXER_LANES == 8
+  __m256 g = _mm256_set1_ps(gain);
+  for (; i + 8 <= count; i += 8)
+  {
+    _mm256_storeu_ps(out + i, _mm256_add_ps(_mm256_loadu_ps(out + i), _mm256_mul_ps(_mm256_loadu_ps(in + i), g)));
+  }
+#elif EN_MIXER_LANES == 4
+  __m128 g = _mm_set1_ps(gain);
+  for (; i + 4 <= count; i += 4)
+  {
+    _mm_storeu_ps(out + i, _mm_add_ps(_mm_loadu_ps(out + i), _mm_mul_ps(_mm_loadu_ps(in + i), g)));
+  }
+#endif
+
+  for (; i < count; i++) out[i] += in[i] * gain;
+}
+
+static void MixVoice(AudioMixer& mixer, u32 index, f32* out_left, f32* out_right, u32 frames)
+{
+  MixerVoice& v = mixer.voices[index];
+  MixerWindow& window = mixer.windows[index];
+  MixerSound& s = mixer.sounds[v.sound];
+  u64 end = (u64)s.frame_count << 32;
+  u32 done = 0;
+
+  while (done < frames)
+  {
+    if (v.position >= end)
+    {
+      if (!s.looping) break;
+
+      // the window keeps counting past the end, so it moves back by the same whole loops
+      u64 loops = v.position / end;
+      v.position -= loops * end;
+      window.base -= (s64)(loops * s.frame_count);
+    }
+
+    u32 count = frames - done;
+    u64 until_end = (end - v.position + v.step - 1) / v.step;
+    if (until_end < count) count = (u32)until_end;
+
+    const f32* left = s.planes[0] + (v.position >> 32);
+    const f32* right = s.planes[1] + (v.position >> 32);
+    if (s.policy != AUDIO_LOAD::RESIDENT)
+    {
+      if (!PrepareWindow(mixer, window, s, v.position, v.step, count))
+      {
+        mixer.stream_stalls++;
+        return;
+      }
+
+      // frames[c] + 1 lines frame window.base + 1 up with index 0, just like a resident plane
+      u64 local = v.position - ((u64)(window.base + 1) << 32);
+      ResamplePlane(window.frames[0] + 1, local, v.step, mixer.scratch[0], count, mixer.resample);
+      if (s.channels == 2) ResamplePlane(window.frames[1] + 1, local, v.step, mixer.scratch[1], count, mixer.resample);
+
+      left = mixer.scratch[0];
+      right = s.channels == 2 ? mixer.scratch[1] : mixer.scratch[0];
+    }
+    else if (v.step != ((u64)1 << 32) || (u32)v.position != 0)
+    {
+      ResamplePlane(s.planes[0], v.position, v.step, mixer.scratch[0], count, mixer.resample);
+      if (s.channels == 2) ResamplePlane(s.planes[1], v.position, v.step, mixer.scratch[1], count, mixer.resample);
+
+      left = mixer.scratch[0];
+      right = s.channels == 2 ? mixer.scratch[1] : mixer.scratch[0];
+    }
+
+    AccumulateScaled(out_left + done, left, v.gain_left, count);
+    AccumulateScaled(out_right + done, right, v.gain_right, count);
+
+    v.position += v.step * count;
+    done += count;
+  }
+
+  if (!s.looping && v.position >= end) StopMixerVoice(mixer, index);
+}
+
+// mixes every playing voice into out_left/out_right, overwriting whatever was there
+void MixAudio(AudioMixer& mixer, f32* out_left, f32* out_right, u32 frames)
+{
+  memset(out_left, 0, frames * sizeof(f32));
+  memset(out_right, 0, frames * sizeof(f32));
+
+  for (u32 offset = 0; offset < frames; offset += MIXER_BLOCK_FRAMES)
+  {
+    u32 count = frames - offset < MIXER_BLOCK_FRAMES ? frames - offset : MIXER_BLOCK_FRAMES;
+    for (u32 i = 0; i < mixer.voice_count; i++)
+    {
+      if (mixer.voices[i].sound >= 0) MixVoice(mixer, i, out_left + offset, out_right + offset, count);
+    }
+  }
+}
+
+void InterleaveS16(const f32* left, const f32* right, s16* out, u32 frames)
+{
+  u32 i = 0;
+
+#if EN_MIXER_LANES >= 4
+  __m128 scale = _mm_set1_ps(32767.f);
+  __m128 lower = _mm_set1_ps(-1.f);
+  __m128 upper = _mm_set1_ps(1.f);
+  for (; i + 4 <= frames; i += 4)
+  {
+    __m128i l = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(left + i), lower), upper), scale));
+    __m128i r = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_loadu_ps(right + i), lower), upper), scale));
+    _mm_storeu_si128((__m128i*)(out + i * 2), _mm_packs_epi32(_mm_unpacklo_epi32(l, r), _mm_unpackhi_epi32(l, r)));
+  }
+#endif
+
+  for (; i < frames; i++)
+  {
+    f32 l = left[i] < -1.f ? -1.f : left[i] > 1.f ? 1.f : left[i];
+    f32 r = right[i] < -1.f ? -1.f : right[i] > 1.f ? 1.f : right[i];
+    out[i * 2] = (s16)lrintf(l * 32767.f);
+    out[i * 2 + 1] = (s16)lrintf(r * 32767.f);
+  }
+}
+
+void InterleaveF32(const f32* left, const f32* right, f32* out, u32 frames)
+{
+  u32 i = 0;
+
+#if EN_MIXER_LANES >= 4
+  for (; i + 4 <= frames; i += 4)
+  {
+    __m128 l = _mm_loadu_ps(left + i);
+    __m128 r = _mm_loadu_ps(right + i);
+    _mm_storeu_ps(out + i * 2, _mm_unpacklo_ps(l, r));
+    _mm_storeu_ps(out + i * 2 + 4, _mm_unpackhi_ps(l, r));
+  }
+#endif
+
+  for (; i < frames; i++)
+  {
+    out[i * 2] = left[i];
+    out[i * 2 + 1] = right[i];
+  }
+}
+
+static void WriteWavHeader(AudioSink& sink)
+{
+  u16 format = sink.format == SAMPLE_FORMAT::S16 ? 1 : 3;
+  u16 channels = 2;
+  u16 bits = sink.format == SAMPLE_FORMAT::S16 ? 16 : 32;
+  u16 block_align = channels * bits / 8;
+  u32 byte_rate = sink.sample_rate * block_align;
+  u32 data_bytes = (u32)(sink.frames_written * block_align);
+  u32 riff_bytes = 36 + data_bytes;
+  u32 fmt_bytes = 16;
+
+  sink.file.write("RIFF", 4);
+  sink.file.write((const char*)&riff_bytes, 4);
+  sink.file.write("WAVEfmt ", 8);
+  sink.file.write((const char*)&fmt_bytes, 4);
+  sink.file.write((const char*)&format, 2);
+  sink.file.write((const char*)&channels, 2);
+  sink.file.write((const char*)&sink.sample_rate, 4);
+  sink.file.write((const char*)&byte_rate, 4);
+  sink.file.write((const char*)&block_align, 2);
+  sink.file.write((const char*)&bits, 2);
+  sink.file.write("data", 4);
+  sink.file.write((const char*)&data_bytes, 4);
+}
+
+bool OpenAudioSink(AudioSink& sink, AUDIO_SINK type, const char* path, SAMPLE_FORMAT format, u32 sample_rate)
+{
+  sink.type = type;
+  sink.format = format;
+  sink.sample_rate = sample_rate;
+  sink.frames_written = 0;
+
+  if (type != AUDIO_SINK::WAV) return true;
+
+  // the sizes in the header are patched in when the sink closes
+  sink.file.open(path, std::ios::binary);
+  if (!sink.file.is_open())
+  {
+    DebugPrintToConsole("Failed to open audio sink: ", path);
+    sink.type = AUDIO_SINK::NONE;
+    return false;
+  }
+
+  WriteWavHeader(sink);
+  return true;
+}
+
+void WriteAudioSink(AudioSink& sink, const f32* left, const f32* right, u32 frames)
+{
+  for (u32 offset = 0; offset < frames; offset += MIXER_BLOCK_FRAMES)
+  {
+    u32 count = frames - offset < MIXER_BLOCK_FRAMES ? frames - offset : MIXER_BLOCK_FRAMES;
+    u32 bytes;
+    if (sink.format == SAMPLE_FORMAT::S16)
+    {
+      InterleaveS16(left + offset, right + offset, (s16*)sink.buffer, count);
+      bytes = count * 2 * sizeof(s16);
+    }
+    else
+    {
+      InterleaveF32(left + offset, right + offset, sink.buffer, count);
+      bytes = count * 2 * sizeof(f32);
+    }
+
+    if (sink.type == AUDIO_SINK::WAV) sink.file.write((const char*)sink.buffer, bytes);
+    sink.frames_written += count;
+  }
+}
+
+void CloseAudioSink(AudioSink& sink)
+{
+  if (sink.type == AUDIO_SINK::WAV && sink.file.is_open())
+  {
+    sink.file.seekp(0);
+    WriteWavHeader(sink);
+    sink.file.close();
+  }
+
+  sink.type = AUDIO_SINK::NONE;
+}
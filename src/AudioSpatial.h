@@ -0,0 +1,303 @@
+#pragma once
+
+#include "Core.h"
+#include "Profiler.h"
+#include "vec2.h"
+#include "vector.h"
+#include "Audio.h"
+#include <algorithm>
+
+
+/// Spatial Audio API Reference
+////// s32 CreateSoundEmitter(SoundHandle sound, vec2 position, f32 max_distance, f32 volume);
+////// void DestroySoundEmitter(s32 emitter);
+////// void SetSoundEmitterPosition(s32 emitter, vec2 position);
+////// void SetAudioListener(vec2 position);
+////// SoundEvent PlaySoundAt(SoundHandle sound, vec2 position, f32 max_distance, f32 volume);
+////// void UpdateSoundEmitters();
+
+// emitters are looping sounds placed in the world (fires, machines, waterfalls...). they live on
+// the main thread as flat arrays, and once per simulation tick a single SSE pass works out every
+// emitter's gain and pan against the listener and drops the ones out of earshot...only the loudest
+// EMITTER_MAX_PLAYING of what is left turn into PLAY/SET_PARAMS/STOP commands, so however many
+// emitters a scene has the voice pool and the command queue only ever see a few hundred of them
+
+// one shot sounds at a position go through PlaySoundAt, which does the same maths for one sound
+
+const u32 EMITTER_MAX_PLAYING = 256;
+const f32 EMITTER_PARAM_EPSILON = 0.01f;    // smaller gain/pan changes than this aren't worth a command
+
+struct SoundEmitterStats
+{
+  u32 emitters = 0;
+  u32 in_range = 0;
+  u32 playing = 0;
+  u32 started = 0;
+  u32 stopped = 0;
+  u32 updated = 0;
+  u64 update_ns = 0;
+};
+
+// structure of arrays so the pass streams through positions and ranges four emitters at a time
+static struct
+{
+  en::vector<f32> x;
+  en::vector<f32> y;
+  en::vector<f32> max_distance_sq;          // negative for free slots, which keeps them out of range
+  en::vector<f32> inv_max_distance;
+  en::vector<f32> volume;
+  en::vector<f32> gain;                     // written by the pass, zero when out of range
+  en::vector<f32> pan;
+
+  en::vector<s32> sound;
+  en::vector<u32> event;                    // SoundEvent id while playing, 0 otherwise
+  en::vector<f32> sent_gain;                // what the playing voice was last told
+  en::vector<f32> sent_pan;
+  en::vector<u32> chosen_tick;
+  en::vector<u32> candidates;               // one per emitter so the pass never has to grow it
+  u32 candidate_count = 0;
+
+  en::vector<s32> free_slots;
+  u32 playing[EMITTER_MAX_PLAYING];
+  u32 playing_count = 0;
+
+  f32 listener_x = 0.f;
+  f32 listener_y = 0.f;
+  u32 tick = 0;
+  SoundEmitterStats stats;
+} sound_emitters;
+
+s32 CreateSoundEmitter(SoundHandle sound, vec2 position, f32 max_distance, f32 volume)
+{
+  if (max_distance <= 0.f) return -1;
+
+  s32 emitter;
+  if (sound_emitters.free_slots.Size() > 0)
+  {
+    emitter = sound_emitters.free_slots[sound_emitters.free_slots.Size() - 1];
+    sound_emitters.free_slots.PopBack();
+  }
+  else
+  {
+    emitter = sound_emitters.x.Size();
+    sound_emitters.x.PushBack(0.f);
+    sound_emitters.y.PushBack(0.f);
+    sound_emitters.max_distance_sq.PushBack(-1.f);
+    sound_emitters.inv_max_distance.PushBack(0.f);
+    sound_emitters.volume.PushBack(0.f);
+    sound_emitters.gain.PushBack(0.f);
+    sound_emitters.pan.PushBack(0.f);
+    sound_emitters.sound.PushBack(-1);
+    sound_emitters.event.PushBack(0);
+    sound_emitters.sent_gain.PushBack(0.f);
+    sound_emitters.sent_pan.PushBack(0.f);
+    sound_emitters.chosen_tick.PushBack(0);
+    sound_emitters.candidates.PushBack(0);
+  }
+
+  sound_emitters.x[emitter] = position.x();
+  sound_emitters.y[emitter] = position.y();
+  sound_emitters.max_distance_sq[emitter] = max_distance * max_distance;
+  sound_emitters.inv_max_distance[emitter] = 1.f / max_distance;
+  sound_emitters.volume[emitter] = volume;
+  sound_emitters.sound[emitter] = sound.id;
+  sound_emitters.event[emitter] = 0;
+  sound_emitters.stats.emitters++;
+
+  return emitter;
+}
+
+void DestroySoundEmitter(s32 emitter)
+{
+  if (emitter < 0 || emitter >= sound_emitters.x.Size() || sound_emitters.max_distance_sq[emitter] < 0.f) return;
+
+  if (sound_emitters.event[emitter] != 0) StopSound({ sound_emitters.event[emitter] });
+  sound_emitters.event[emitter] = 0;
+  sound_emitters.max_distance_sq[emitter] = -1.f;
+  sound_emitters.free_slots.PushBack(emitter);
+  sound_emitters.stats.emitters--;
+}
+
+void SetSoundEmitterPosition(s32 emitter, vec2 position)
+{
+  if (emitter < 0 || emitter >= sound_emitters.x.Size()) return;
+
+  sound_emitters.x[emitter] = position.x();
+  sound_emitters.y[emitter] = position.y();
+}
+
+void SetAudioListener(vec2 position)
+{
+  sound_emitters.listener_x = position.x();
+  sound_emitters.listener_y = position.y();
+}
+
+// gain falls off with the square of the remaining distance, pan is fully over by half the range
+static inline void SpatializeEmitter(f32 dx, f32 dy, f32 max_distance_sq, f32 inv_max_distance, f32 volume, f32& gain, f32& pan)
+{
+  f32 distance_sq = dx * dx + dy * dy;
+  if (!(distance_sq < max_distance_sq))
+  {
+    gain = 0.f;
+    pan = 0.f;
+    return;
+  }
+
+  f32 falloff = 1.f - sqrtf(distance_sq) * inv_max_distance;
+  gain = volume * falloff * falloff;
+
+  f32 p = dx * 2.f * inv_max_distance;
+  pan = p < -1.f ? -1.f : p > 1.f ? 1.f : p;
+}
+
+SoundEvent PlaySoundAt(SoundHandle sound, vec2 position, f32 max_distance, f32 volume)
+{
+  if (max_distance <= 0.f) return {};
+
+  VoiceParams params;
+  f32 dx = position.x() - sound_emitters.listener_x;
+  f32 dy = position.y() - sound_emitters.listener_y;
+  SpatializeEmitter(dx, dy, max_distance * max_distance, 1.f / max_distance, volume, params.volume, params.pan);
+  if (params.volume < MIN_AUDIBLE_VOLUME) return {};
+
+  return PlaySound(sound, params);
+}
+
+// fills gain/pan for every emitter and collects the audible ones into candidates
+static void SpatializeEmitters()
+{
+  u32 count = (u32)sound_emitters.x.Size();
+  sound_emitters.candidate_count = 0;
+  if (count == 0) return;
+
+  const f32* x = &sound_emitters.x[0];
+  const f32* y = &sound_emitters.y[0];
+  const f32* max_distance_sq = &sound_emitters.max_distance_sq[0];
+  const f32* inv_max_distance = &sound_emitters.inv_max_distance[0];
+  const f32* volume = &sound_emitters.volume[0];
+  f32* gain = &sound_emitters.gain[0];
+  f32* pan = &sound_emitters.pan[0];
+  u32* candidates = &sound_emitters.candidates[0];
+  u32 found = 0;
+  f32 listener_x = sound_emitters.listener_x;
+  f32 listener_y = sound_emitters.listener_y;
+  u32 i = 0;
+
+#if EN_MIXER_LANES >= 4
+  __m128 lx = _mm_set1_ps(listener_x);
+  __m128 ly = _mm_set1_ps(listener_y);
+  __m128 one = _mm_set1_ps(1.f);
+  __m128 two = _mm_set1_ps(2.f);
+  __m128 minus_one = _mm_set1_ps(-1.f);
+  __m128 audible = _mm_set1_ps(MIN_AUDIBLE_VOLUME);
+
+  for (; i + 4 <= count; i += 4)
+  {
+    __m128 dx = _mm_sub_ps(_mm_loadu_ps(x + i), lx);
+    __m128 dy = _mm_sub_ps(_mm_loadu_ps(y + i), ly);
+    __m128 distance_sq = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+    __m128 in_range = _mm_cmplt_ps(distance_sq, _mm_loadu_ps(max_distance_sq + i));
+
+    __m128 inv = _mm_loadu_ps(inv_max_distance + i);
+    __m128 falloff = _mm_sub_ps(one, _mm_mul_ps(_mm_sqrt_ps(distance_sq), inv));
+    __m128 g = _mm_and_ps(in_range, _mm_mul_ps(_mm_loadu_ps(volume + i), _mm_mul_ps(falloff, falloff)));
+    __m128 p = _mm_and_ps(in_range, _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_mul_ps(dx, two), inv), minus_one), one));
+    _mm_storeu_ps(gain + i, g);
+    _mm_storeu_ps(pan + i, p);
+
+    // branch free compaction, every lane is written and only the audible ones move found on
+    s32 mask = _mm_movemask_ps(_mm_cmpge_ps(g, audible));
+    for (u32 lane = 0; lane < 4; lane++)
+    {
+      candidates[found] = i + lane;
+      found += (mask >> lane) & 1;
+    }
+  }
+#endif
+
+  for (; i < count; i++)
+  {
+    SpatializeEmitter(x[i] - listener_x, y[i] - listener_y, max_distance_sq[i], inv_max_distance[i], volume[i], gain[i], pan[i]);
+    if (gain[i] >= MIN_AUDIBLE_VOLUME) candidates[found++] = i;
+  }
+
+  sound_emitters.candidate_count = found;
+}
+
+// call once per simulation tick after gameplay has moved things around
+void UpdateSoundEmitters()
+{
+  PROFILE_FUNCTION();
+
+  auto start = std::chrono::steady_clock::now();
+  SoundEmitterStats& stats = sound_emitters.stats;
+  stats.started = stats.stopped = stats.updated = 0;
+
+  // the audio thread lets go of a sound that ended on its own, an event still set here would be
+  // stale and the emitter would never play it again
+  for (u32 i = 0; i < sound_emitters.playing_count; i++)
+  {
+    u32 e = sound_emitters.playing[i];
+    if (sound_emitters.event[e] != 0 && !IsSoundPlaying({ sound_emitters.event[e] })) sound_emitters.event[e] = 0;
+  }
+
+  SpatializeEmitters();
+  stats.in_range = sound_emitters.candidate_count;
+
+  // past the budget only the loudest emitters get to play
+  u32* first = sound_emitters.candidates.begin();
+  u32* last = first + sound_emitters.candidate_count;
+  const f32* gain = stats.in_range > 0 ? &sound_emitters.gain[0] : nullptr;
+  if (stats.in_range > EMITTER_MAX_PLAYING)
+  {
+    std::nth_element(first, first + EMITTER_MAX_PLAYING, last, [gain](u32 a, u32 b) { return gain[a] > gain[b]; });
+    last = first + EMITTER_MAX_PLAYING;
+  }
+
+  u32 tick = ++sound_emitters.tick;
+  for (u32* c = first; c < last; c++)
+  {
+    u32 e = *c;
+    f32 g = sound_emitters.gain[e];
+    f32 p = sound_emitters.pan[e];
+    sound_emitters.chosen_tick[e] = tick;
+
+    if (sound_emitters.event[e] == 0)
+    {
+      VoiceParams params;
+      params.volume = g;
+      params.pan = p;
+      sound_emitters.event[e] = PlaySound({ sound_emitters.sound[e] }, params).id;
+      sound_emitters.sent_gain[e] = g;
+      sound_emitters.sent_pan[e] = p;
+      stats.started++;
+    }
+    else if (fabsf(g - sound_emitters.sent_gain[e]) > EMITTER_PARAM_EPSILON || fabsf(p - sound_emitters.sent_pan[e]) > EMITTER_PARAM_EPSILON)
+    {
+      VoiceParams params;
+      params.volume = g;
+      params.pan = p;
+      SetSoundParams({ sound_emitters.event[e] }, params);
+      sound_emitters.sent_gain[e] = g;
+      sound_emitters.sent_pan[e] = p;
+      stats.updated++;
+    }
+  }
+
+  // whatever played last tick and wasn't chosen again has gone out of range or been outranked
+  for (u32 i = 0; i < sound_emitters.playing_count; i++)
+  {
+    u32 e = sound_emitters.playing[i];
+    if (sound_emitters.chosen_tick[e] == tick || sound_emitters.event[e] == 0) continue;
+
+    StopSound({ sound_emitters.event[e] });
+    sound_emitters.event[e] = 0;
+    stats.stopped++;
+  }
+
+  sound_emitters.playing_count = (u32)(last - first);
+  memcpy(sound_emitters.playing, first, sound_emitters.playing_count * sizeof(u32));
+
+  stats.playing = sound_emitters.playing_count;
+  stats.update_ns = (u64)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
@@ -0,0 +1,442 @@
+#pragma once
+
+#include "Core.h"
+#include "vector.h"
+#include "AudioBackend.h"
+
+
+/// Voice Manager API Reference
+////// void InitVoiceManager(AudioBackend* backend);
+////// s32 RegisterSound(s32 backend_sound, f32 length_seconds, bool looping, u8 priority, u16 max_instances);
+////// s32 RegisterPendingSound(bool looping, u8 priority, u16 max_instances);
+////// void CompletePendingSound(s32 sound, s32 backend_sound, f32 length_seconds);
+////// void UnloadVoiceSound(s32 sound);
+////// bool ReloadVoiceSound(s32 sound);
+////// SOUND_STATE GetSoundState(s32 sound);
+////// VoiceHandle PlayVoice(s32 sound, const VoiceParams& params);
+////// void StopVoice(VoiceHandle handle);
+////// void StopAllVoices(s32 sound);
+////// bool SetVoiceParams(VoiceHandle handle, const VoiceParams& params);
+////// bool IsVoiceActive(VoiceHandle handle);
+////// void UpdateVoices(f32 delta_seconds);
+
+// every sound that is playing owns a voice from a fixed pool, but only MAX_REAL_VOICES of them are
+// actually handed to the backend...the rest are virtual, they keep their playback position ticking
+// along and cost nothing to mix until they become important enough to take a real voice back
+
+// importance is priority first, then how loud the voice is, then how recently it started...when a
+// pool is full the least important voice is the one that gets stolen
+
+const u32 MAX_REAL_VOICES = 32;
+const u32 MAX_VOICES = 1024;
+const f32 MIN_AUDIBLE_VOLUME = 0.01f;     // quieter than this and a voice is never worth a real slot
+
+// low 16 bits are the voice index, high 16 bits the generation, zero is never a valid handle
+struct VoiceHandle
+{
+  u32 id = 0;
+};
+
+enum class SOUND_STATE : u8
+{
+  LOADING,
+  LOADED,
+  FAILED,
+  UNLOADING,      // unloaded while it was still loading, it goes as soon as the load completes
+  UNLOADED
+};
+
+struct SoundInfo
+{
+  s32 backend_sound;
+  f32 length_seconds;
+  u8 priority;
+  u16 max_instances;
+  u16 instance_count;
+  bool looping;
+  SOUND_STATE state;
+};
+
+struct Voice
+{
+  u16 generation = 1;
+  bool active = false;
+  s32 sound = -1;
+  s32 real_slot = -1;         // -1 while virtual
+  u32 active_index = 0;       // position in voice_manager.active
+  VoiceParams params;
+  f32 audibility = 0.f;
+  f32 elapsed = 0.f;
+  u64 start_order = 0;
+};
+
+struct VoiceStats
+{
+  u64 plays = 0;
+  u64 rejected = 0;
+  u64 stolen = 0;
+  u64 instance_limited = 0;
+  u64 virtualized = 0;
+  u64 promoted = 0;
+  u64 not_loaded = 0;
+};
+
+static struct
+{
+  AudioBackend* backend = nullptr;
+  en::vector<SoundInfo> sounds;
+
+  Voice voices[MAX_VOICES];
+  u16 free_list[MAX_VOICES];
+  u32 free_count = 0;
+
+  u16 active[MAX_VOICES];             // dense list of active voice indices so updates skip the free ones
+  u32 active_count = 0;
+
+  s32 real_slots[MAX_REAL_VOICES];    // voice index in each backend slot, -1 if the slot is free
+  u64 play_counter = 0;
+
+  VoiceStats stats;
+} voice_manager;
+
+void InitVoiceManager(AudioBackend* backend)
+{
+  voice_manager.backend = backend;
+  voice_manager.sounds.Clear();
+  voice_manager.active_count = 0;
+  voice_manager.play_counter = 0;
+  voice_manager.stats = VoiceStats();
+  for (u32 i = 0; i < MAX_VOICES; i++) voice_manager.voices[i].active = false;
+
+  voice_manager.free_count = MAX_VOICES;
+  for (u32 i = 0; i < MAX_VOICES; i++) voice_manager.free_list[i] = (u16)(MAX_VOICES - 1 - i);
+  for (u32 i = 0; i < MAX_REAL_VOICES; i++) voice_manager.real_slots[i] = -1;
+}
+
+s32 RegisterSound(s32 backend_sound, f32 length_seconds, bool looping, u8 priority, u16 max_instances)
+{
+  voice_manager.sounds.PushBack({ backend_sound, length_seconds, priority, max_instances, 0, looping, SOUND_STATE::LOADED });
+  return voice_manager.sounds.Size() - 1;
+}
+
+// reserves the sound id while the backend is still loading it, plays are refused until it completes
+s32 RegisterPendingSound(bool looping, u8 priority, u16 max_instances)
+{
+  voice_manager.sounds.PushBack({ -1, 0.f, priority, max_instances, 0, looping, SOUND_STATE::LOADING });
+  return voice_manager.sounds.Size() - 1;
+}
+
+// a backend_sound of -1 marks the load as failed
+void CompletePendingSound(s32 sound, s32 backend_sound, f32 length_seconds)
+{
+  SoundInfo& info = voice_manager.sounds[sound];
+  if (info.state == SOUND_STATE::UNLOADING)
+  {
+    if (backend_sound >= 0) voice_manager.backend->RemoveSound(backend_sound);
+    info.state = SOUND_STATE::UNLOADED;
+    return;
+  }
+
+  info.backend_sound = backend_sound;
+  info.length_seconds = length_seconds;
+  info.state = backend_sound >= 0 ? SOUND_STATE::LOADED : SOUND_STATE::FAILED;
+}
+
+SOUND_STATE GetSoundState(s32 sound)
+{
+  if (sound < 0 || sound >= voice_manager.sounds.Size()) return SOUND_STATE::FAILED;
+  return voice_manager.sounds[sound].state;
+}
+
+static inline f32 VoiceAudibility(const VoiceParams& params)
+{
+  f32 audibility = params.volume;
+  return audibility > 1.f ? 1.f : audibility;
+}
+
+static inline bool IsLessImportant(const Voice& a, const Voice& b)
+{
+  u8 a_priority = voice_manager.sounds[a.sound].priority;
+  u8 b_priority = voice_manager.sounds[b.sound].priority;
+  if (a_priority != b_priority) return a_priority < b_priority;
+  if (a.audibility != b.audibility) return a.audibility < b.audibility;
+  return a.start_order < b.start_order;
+}
+
+static inline Voice* ResolveVoice(VoiceHandle handle)
+{
+  u32 index = handle.id & 0xFFFF;
+  if (handle.id == 0 || index >= MAX_VOICES) return nullptr;
+
+  Voice& v = voice_manager.voices[index];
+  if (!v.active || v.generation != (u16)(handle.id >> 16)) return nullptr;
+
+  return &v;
+}
+
+static void VirtualizeVoice(u32 index)
+{
+  Voice& v = voice_manager.voices[index];
+  if (v.real_slot < 0) return;
+
+  voice_manager.backend->StopVoice(v.real_slot);
+  voice_manager.real_slots[v.real_slot] = -1;
+  v.real_slot = -1;
+  voice_manager.stats.virtualized++;
+}
+
+static void FreeVoice(u32 index)
+{
+  Voice& v = voice_manager.voices[index];
+  if (v.real_slot >= 0)
+  {
+    voice_manager.backend->StopVoice(v.real_slot);
+    voice_manager.real_slots[v.real_slot] = -1;
+    v.real_slot = -1;
+  }
+
+  u16 moved = voice_manager.active[--voice_manager.active_count];
+  voice_manager.active[v.active_index] = moved;
+  voice_manager.voices[moved].active_index = v.active_index;
+
+  voice_manager.sounds[v.sound].instance_count--;
+  v.active = false;
+  v.generation++;
+  if (v.generation == 0) v.generation = 1;
+  voice_manager.free_list[voice_manager.free_count++] = (u16)index;
+}
+
+// gives a voice a backend slot if one is free or a less important voice can be pushed out of one
+static bool TryMakeVoiceReal(u32 index)
+{
+  Voice& v = voice_manager.voices[index];
+  if (v.real_slot >= 0) return true;
+  if (v.audibility < MIN_AUDIBLE_VOLUME) return false;
+
+  s32 slot = -1;
+  s32 weakest_slot = -1;
+  for (u32 i = 0; i < MAX_REAL_VOICES; i++)
+  {
+    s32 occupant = voice_manager.real_slots[i];
+    if (occupant < 0)
+    {
+      slot = (s32)i;
+      break;
+    }
+
+    if (weakest_slot < 0 || IsLessImportant(voice_manager.voices[occupant], voice_manager.voices[voice_manager.real_slots[weakest_slot]]))
+    {
+      weakest_slot = (s32)i;
+    }
+  }
+
+  if (slot < 0)
+  {
+    u32 weakest = (u32)voice_manager.real_slots[weakest_slot];
+    if (!IsLessImportant(voice_manager.voices[weakest], v)) return false;
+
+    VirtualizeVoice(weakest);
+    slot = weakest_slot;
+  }
+
+  SoundInfo& info = voice_manager.sounds[v.sound];
+  if (!voice_manager.backend->StartVoice(slot, info.backend_sound, v.params, v.elapsed)) return false;
+
+  voice_manager.real_slots[slot] = (s32)index;
+  v.real_slot = slot;
+  return true;
+}
+
+VoiceHandle PlayVoice(s32 sound, const VoiceParams& params)
+{
+  if (sound < 0 || sound >= voice_manager.sounds.Size()) return {};
+
+  SoundInfo& info = voice_manager.sounds[sound];
+  if (info.state != SOUND_STATE::LOADED)
+  {
+    voice_manager.stats.not_loaded++;
+    return {};
+  }
+
+  Voice candidate;
+  candidate.sound = sound;
+  candidate.params = params;
+  candidate.audibility = VoiceAudibility(params);
+  candidate.start_order = ++voice_manager.play_counter;
+
+  // over the per-sound limit, the oldest instance of the same sound makes room
+  if (info.instance_count >= info.max_instances)
+  {
+    s32 oldest = -1;
+    for (u32 i = 0; i < voice_manager.active_count; i++)
+    {
+      u16 index = voice_manager.active[i];
+      Voice& v = voice_manager.voices[index];
+      if (v.sound == sound && (oldest < 0 || v.start_order < voice_manager.voices[oldest].start_order)) oldest = index;
+    }
+
+    if (oldest >= 0)
+    {
+      FreeVoice(oldest);
+      voice_manager.stats.instance_limited++;
+    }
+  }
+
+  if (voice_manager.free_count == 0)
+  {
+    u32 weakest = voice_manager.active[0];
+    for (u32 i = 1; i < voice_manager.active_count; i++)
+    {
+      u16 index = voice_manager.active[i];
+      if (IsLessImportant(voice_manager.voices[index], voice_manager.voices[weakest])) weakest = index;
+    }
+
+    if (!IsLessImportant(voice_manager.voices[weakest], candidate))
+    {
+      voice_manager.stats.rejected++;
+      return {};
+    }
+
+    FreeVoice(weakest);
+    voice_manager.stats.stolen++;
+  }
+
+  u32 index = voice_manager.free_list[--voice_manager.free_count];
+  Voice& v = voice_manager.voices[index];
+  u16 generation = v.generation;
+  v = candidate;
+  v.generation = generation;
+  v.active = true;
+  v.active_index = voice_manager.active_count;
+  voice_manager.active[voice_manager.active_count++] = (u16)index;
+  info.instance_count++;
+  voice_manager.stats.plays++;
+
+  TryMakeVoiceReal(index);
+
+  return { ((u32)generation << 16) | index };
+}
+
+void StopVoice(VoiceHandle handle)
+{
+  Voice* v = ResolveVoice(handle);
+  if (v) FreeVoice(handle.id & 0xFFFF);
+}
+
+void StopAllVoices(s32 sound)
+{
+  for (u32 i = voice_manager.active_count; i > 0; i--)
+  {
+    u16 index = voice_manager.active[i - 1];
+    if (voice_manager.voices[index].sound == sound) FreeVoice(index);
+  }
+}
+
+// stops everything playing it and puts the sound back to loading, for when the file is loaded into
+// the same id again...false if it isn't loaded (or already loading) in the first place
+bool ReloadVoiceSound(s32 sound)
+{
+  if (sound < 0 || sound >= voice_manager.sounds.Size()) return false;
+
+  SoundInfo& info = voice_manager.sounds[sound];
+  if (info.state != SOUND_STATE::LOADED && info.state != SOUND_STATE::FAILED) return false;
+
+  StopAllVoices(sound);
+  if (info.state == SOUND_STATE::LOADED) voice_manager.backend->RemoveSound(info.backend_sound);
+  info.backend_sound = -1;
+  info.state = SOUND_STATE::LOADING;
+  return true;
+}
+
+// stops everything playing it and frees it in the backend, the id is never handed out again
+void UnloadVoiceSound(s32 sound)
+{
+  if (sound < 0 || sound >= voice_manager.sounds.Size()) return;
+
+  StopAllVoices(sound);
+
+  SoundInfo& info = voice_manager.sounds[sound];
+  if (info.state == SOUND_STATE::LOADING)
+  {
+    info.state = SOUND_STATE::UNLOADING;
+  }
+  else if (info.state == SOUND_STATE::LOADED)
+  {
+    voice_manager.backend->RemoveSound(info.backend_sound);
+    info.state = SOUND_STATE::UNLOADED;
+  }
+}
+
+bool SetVoiceParams(VoiceHandle handle, const VoiceParams& params)
+{
+  Voice* v = ResolveVoice(handle);
+  if (!v) return false;
+
+  v->params = params;
+  v->audibility = VoiceAudibility(params);
+  if (v->real_slot >= 0) voice_manager.backend->SetVoiceParams(v->real_slot, params);
+
+  return true;
+}
+
+bool IsVoiceActive(VoiceHandle handle)
+{
+  return ResolveVoice(handle) != nullptr;
+}
+
+void UpdateVoices(f32 delta_seconds)
+{
+  voice_manager.backend->Update(delta_seconds);
+
+  // walk backwards so FreeVoice swapping the last entry into the hole never skips anything
+  for (u32 i = voice_manager.active_count; i > 0; i--)
+  {
+    u16 index = voice_manager.active[i - 1];
+    Voice& v = voice_manager.voices[index];
+    SoundInfo& info = voice_manager.sounds[v.sound];
+
+    v.elapsed += delta_seconds * v.params.pitch;
+    if (info.looping && info.length_seconds > 0.f)
+    {
+      v.elapsed = fmodf(v.elapsed, info.length_seconds);
+    }
+
+    if (v.real_slot >= 0)
+    {
+      if (!voice_manager.backend->IsVoicePlaying(v.real_slot))
+      {
+        FreeVoice(index);
+      }
+      else if (v.audibility < MIN_AUDIBLE_VOLUME)
+      {
+        VirtualizeVoice(index);
+      }
+    }
+    else if (!info.looping && v.elapsed >= info.length_seconds)
+    {
+      FreeVoice(index);
+    }
+  }
+
+  // virtual voices that got loud enough try to win a backend slot back
+  for (u32 i = 0; i < voice_manager.active_count; i++)
+  {
+    u16 index = voice_manager.active[i];
+    Voice& v = voice_manager.voices[index];
+    if (v.real_slot < 0 && v.audibility >= MIN_AUDIBLE_VOLUME && TryMakeVoiceReal(index))
+    {
+      voice_manager.stats.promoted++;
+    }
+  }
+}
+
+u32 RealVoiceCount()
+{
+  u32 count = 0;
+  for (u32 i = 0; i < MAX_REAL_VOICES; i++)
+  {
+    if (voice_manager.real_slots[i] >= 0) count++;
+  }
+
+  return count;
+}
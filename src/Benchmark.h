@@ -0,0 +1,77 @@
+#pragma once
+
+#include "Core.h"
+#include "vector.h"
+#include <chrono>
+
+
+/// Benchmark API Reference
+////// void RegisterBenchmark(const char* name, BenchmarkFunc func);
+////// bool RunBenchmark(const char* name);                    // "all" runs every registered benchmark
+////// void ListBenchmarks();
+////// u64 BenchmarkNow();
+////// void ReportBenchmark(const char* label, u64 operations, u64 elapsed_ns);
+
+// benchmarks run headless from the command line before any window or GL context exists:
+// Engine --bench <name>
+
+using BenchmarkFunc = void(*)(void);
+
+struct BenchmarkInfo
+{
+  const char* name;
+  BenchmarkFunc func;
+};
+
+en::vector<BenchmarkInfo> benchmarks;
+
+// keeps the optimizer from throwing away results the benchmark never reads
+static volatile u64 benchmark_sink = 0;
+
+void RegisterBenchmark(const char* name, BenchmarkFunc func)
+{
+  benchmarks.PushBack({ name, func });
+}
+
+static inline u64 BenchmarkNow()
+{
+  return (u64)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void ReportBenchmark(const char* label, u64 operations, u64 elapsed_ns)
+{
+  f64 ns_per_op = operations ? (f64)elapsed_ns / (f64)operations : 0.0;
+  f64 ops_per_sec = elapsed_ns ? (f64)operations * 1e9 / (f64)elapsed_ns : 0.0;
+  printf("  %-44s %12.3f ms %12.2f ns/op %14.0f ops/s\n", label, elapsed_ns / 1e6, ns_per_op, ops_per_sec);
+}
+
+void ListBenchmarks()
+{
+  printf("Available benchmarks:\n");
+  for (auto& b : benchmarks)
+  {
+    printf("  %s\n", b.name);
+  }
+}
+
+bool RunBenchmark(const char* name)
+{
+  bool found = false;
+  for (auto& b : benchmarks)
+  {
+    if (strcmp(name, "all") == 0 || strcmp(name, b.name) == 0)
+    {
+      printf("[%s]\n", b.name);
+      b.func();
+      found = true;
+    }
+  }
+
+  if (!found)
+  {
+    printf("Unknown benchmark: %s\n", name);
+    ListBenchmarks();
+  }
+
+  return found;
+}
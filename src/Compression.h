@@ -0,0 +1,389 @@
+#pragma once
+
+#include "Core.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define EN_COMPRESSION_SSE2 1
+#endif
+
+
+/// Compression API Reference
+////// u64 LzCompressBound(u64 size);
+////// u64 LzDecompressBound(u64 size);
+////// u64 LzCompress(const u8* source, u64 size, u8* destination, u64 capacity);
+////// s64 LzDecompress(const u8* source, u64 size, u8* destination, u64 capacity);
+////// void XorBytes(u8* destination, const u8* a, const u8* b, u64 size);
+////// void ShuffleBytes(u8* destination, const u8* source, u64 size, u32 stride);
+////// void UnshuffleBytes(u8* destination, const u8* source, u64 size, u32 stride);
+
+// an lz4 style codec, same block format: a token with the literal and match lengths, the literals,
+// a 2 byte offset back into what was already written and however many 255s the lengths need. the
+// compressor takes the first 4 byte match its hash table points at, no chains and no lazy matching,
+// and speeds up through data it can't find matches in...the decompressor is a loop of 16 byte copies
+
+// both the input and the output of one call have to fit in memory, blocks are up to the caller.
+// LzCompress returns 0 when destination is smaller than LzCompressBound, LzDecompress returns -1
+// on anything that would read or write out of bounds, so a corrupt block can't do damage
+
+// the filters get data ready for it: XorBytes against an earlier copy of the same thing leaves zeroes
+// wherever nothing changed, ShuffleBytes regroups arrays of stride sized values byte by byte so the
+// mostly equal high bytes of floats and small ints end up next to each other
+
+const u32 LZ_MIN_MATCH = 4;
+const u32 LZ_HASH_BITS = 14;
+const u32 LZ_MAX_OFFSET = 65535;
+const u32 LZ_LAST_LITERALS = 5;     // a block always ends in at least this many literals...
+const u32 LZ_MATCH_LIMIT = 12;      // ...and no match starts closer than this to the end
+const u32 LZ_SKIP_TRIGGER = 6;      // every 2^6 misses in a row the search steps one byte further
+
+static inline u32 LzRead32(const u8* at)
+{
+  u32 value;
+  memcpy(&value, at, sizeof(value));
+  return value;
+}
+
+static inline u64 LzRead64(const u8* at)
+{
+  u64 value;
+  memcpy(&value, at, sizeof(value));
+  return value;
+}
+
+static inline u32 LzHash(u32 sequence)
+{
+  return (sequence * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+static inline u32 LzTrailingZeroBytes(u64 value)
+{
+#ifdef _MSC_VER
+  unsigned long bit;
+  _BitScanForward64(&bit, value);
+  return (u32)bit >> 3;
+#else
+  return (u32)__builtin_ctzll(value) >> 3;
+#endif
+}
+
+// copies at least count bytes 16 at a time, so up to 15 past the end get written too
+static inline void LzWildCopy(u8* destination, const u8* source, u64 count)
+{
+  u8* end = destination + count;
+  do
+  {
+    memcpy(destination, source, 16);
+    destination += 16;
+    source += 16;
+  } while (destination < end);
+}
+
+static inline u8* LzWriteLength(u8* out, u64 length)
+{
+  while (length >= 255)
+  {
+    *out++ = 255;
+    length -= 255;
+  }
+
+  *out++ = (u8)length;
+  return out;
+}
+
+u64 LzCompressBound(u64 size)
+{
+  return size + size / 255 + 16;
+}
+
+// the most size compressed bytes can turn back into, a run of 255s in a match length is the best the
+// format can do...anything claiming more than this is corrupt
+u64 LzDecompressBound(u64 size)
+{
+  return size * 255 + 32;
+}
+
+static u8* LzWriteSequence(u8* out, const u8* literals, u64 literal_count, u32 offset, u64 match_length)
+{
+  u8* token = out++;
+  u32 literal_nibble = literal_count < 15 ? (u32)literal_count : 15;
+  if (literal_count >= 15) out = LzWriteLength(out, literal_count - 15);
+
+  if (literal_count > 0) memcpy(out, literals, literal_count);
+  out += literal_count;
+
+  if (match_length == 0)
+  {
+    *token = (u8)(literal_nibble << 4);
+    return out;
+  }
+
+  *out++ = (u8)offset;
+  *out++ = (u8)(offset >> 8);
+
+  u64 extra = match_length - LZ_MIN_MATCH;
+  *token = (u8)((literal_nibble << 4) | (extra < 15 ? extra : 15));
+  if (extra >= 15) out = LzWriteLength(out, extra - 15);
+  return out;
+}
+
+// one block, up to 4 GB
+u64 LzCompress(const u8* source, u64 size, u8* destination, u64 capacity)
+{
+  if (capacity < LzCompressBound(size) || size > 0xFFFFFFFFull) return 0;
+
+  // positions relative to source, 0 doubles as empty...a bad candidate just fails the compare
+  static thread_local u32 table[1 << LZ_HASH_BITS];
+  memset(table, 0, sizeof(table));
+
+  const u8* in = source;
+  const u8* anchor = source;
+  const u8* end = source + size;
+  u8* out = destination;
+
+  if (size > LZ_MATCH_LIMIT)
+  {
+    const u8* match_start_limit = end - LZ_MATCH_LIMIT;
+    const u8* match_end_limit = end - LZ_LAST_LITERALS;
+    in++;
+    while (in < match_start_limit)
+    {
+      const u8* match;
+      u32 misses = 1 << LZ_SKIP_TRIGGER;
+      for (;;)
+      {
+        u32 sequence = LzRead32(in);
+        u32 hash = LzHash(sequence);
+        match = source + table[hash];
+        table[hash] = (u32)(in - source);
+
+        if (match < in && in - match <= LZ_MAX_OFFSET && LzRead32(match) == sequence) break;
+
+        in += misses++ >> LZ_SKIP_TRIGGER;
+        if (in >= match_start_limit) goto last_literals;
+      }
+
+      // the match may well have started earlier than where the hash caught it
+      while (in > anchor && match > source && in[-1] == match[-1])
+      {
+        in--;
+        match--;
+      }
+
+      const u8* match_end = in + LZ_MIN_MATCH;
+      const u8* compare = match + LZ_MIN_MATCH;
+      while (match_end + 8 <= match_end_limit)
+      {
+        u64 difference = LzRead64(match_end) ^ LzRead64(compare);
+        if (difference)
+        {
+          match_end += LzTrailingZeroBytes(difference);
+          goto match_found;
+        }
+
+        match_end += 8;
+        compare += 8;
+      }
+      while (match_end < match_end_limit && *match_end == *compare)
+      {
+        match_end++;
+        compare++;
+      }
+
+    match_found:
+      out = LzWriteSequence(out, anchor, (u64)(in - anchor), (u32)(in - match), (u64)(match_end - in));
+      in = match_end;
+      anchor = in;
+
+      if (in < match_start_limit) table[LzHash(LzRead32(in - 2))] = (u32)(in - 2 - source);
+    }
+  }
+
+last_literals:
+  out = LzWriteSequence(out, anchor, (u64)(end - anchor), 0, 0);
+  return (u64)(out - destination);
+}
+
+// returns how many bytes it wrote
+s64 LzDecompress(const u8* source, u64 size, u8* destination, u64 capacity)
+{
+  const u8* in = source;
+  const u8* in_end = source + size;
+  u8* out = destination;
+  u8* out_end = destination + capacity;
+
+  for (;;)
+  {
+    if (in >= in_end) return -1;
+    u32 token = *in++;
+
+    u64 literal_count = token >> 4;
+    if (literal_count == 15)
+    {
+      u8 more;
+      do
+      {
+        if (in >= in_end) return -1;
+        more = *in++;
+        literal_count += more;
+      } while (more == 255);
+    }
+
+    if (literal_count > (u64)(in_end - in) || literal_count > (u64)(out_end - out)) return -1;
+    if (literal_count + 16 <= (u64)(in_end - in) && literal_count + 16 <= (u64)(out_end - out)) LzWildCopy(out, in, literal_count);
+    else memcpy(out, in, literal_count);
+    in += literal_count;
+    out += literal_count;
+
+    // the last sequence is literals only
+    if (in == in_end) break;
+    if (in_end - in < 2) return -1;
+
+    u32 offset = in[0] | (in[1] << 8);
+    in += 2;
+    if (offset == 0 || offset > (u64)(out - destination)) return -1;
+
+    u64 match_length = (token & 15) + LZ_MIN_MATCH;
+    if ((token & 15) == 15)
+    {
+      u8 more;
+      do
+      {
+        if (in >= in_end) return -1;
+        more = *in++;
+        match_length += more;
+      } while (more == 255);
+    }
+
+    if (match_length > (u64)(out_end - out)) return -1;
+
+    const u8* match = out - offset;
+    u8* match_end = out + match_length;
+    if (match_length + 16 > (u64)(out_end - out))
+    {
+      while (out < match_end) *out++ = *match++;
+      continue;
+    }
+
+    // a close offset is a repeating pattern, once 16 or more bytes of it are out any multiple of the
+    // offset past 16 points at the same bytes and the wide copies can take over
+    if (offset < 16)
+    {
+      u32 period = offset;
+      while (period < 16) period += offset;
+
+      u8* pattern_end = out + period < match_end ? out + period : match_end;
+      while (out < pattern_end) *out++ = *match++;
+      match = out - period;
+    }
+
+    if (out < match_end) LzWildCopy(out, match, (u64)(match_end - out));
+    out = match_end;
+  }
+
+  return (s64)(out - destination);
+}
+
+void XorBytes(u8* destination, const u8* a, const u8* b, u64 size)
+{
+  u64 i = 0;
+  for (; i + 8 <= size; i += 8)
+  {
+    u64 value = LzRead64(a + i) ^ LzRead64(b + i);
+    memcpy(destination + i, &value, sizeof(value));
+  }
+  for (; i < size; i++) destination[i] = a[i] ^ b[i];
+}
+
+// 4 byte values are the common case, 16 at a time gets transposed in registers
+static u64 ShuffleBytes4(u8* destination, const u8* source, u64 count)
+{
+  u64 i = 0;
+#ifdef EN_COMPRESSION_SSE2
+  for (; i + 16 <= count; i += 16)
+  {
+    __m128i x0 = _mm_loadu_si128((const __m128i*)(source + i * 4));
+    __m128i x1 = _mm_loadu_si128((const __m128i*)(source + i * 4 + 16));
+    __m128i x2 = _mm_loadu_si128((const __m128i*)(source + i * 4 + 32));
+    __m128i x3 = _mm_loadu_si128((const __m128i*)(source + i * 4 + 48));
+
+    // three rounds of interleaving leave bytes 0 and 1 of 8 values in x0 and x2, bytes 2 and 3 in x1 and x3
+    for (u32 round = 0; round < 3; round++)
+    {
+      __m128i y0 = _mm_unpacklo_epi8(x0, x1);
+      __m128i y1 = _mm_unpackhi_epi8(x0, x1);
+      __m128i y2 = _mm_unpacklo_epi8(x2, x3);
+      __m128i y3 = _mm_unpackhi_epi8(x2, x3);
+      x0 = y0;
+      x1 = y1;
+      x2 = y2;
+      x3 = y3;
+    }
+
+    _mm_storeu_si128((__m128i*)(destination + i), _mm_unpacklo_epi64(x0, x2));
+    _mm_storeu_si128((__m128i*)(destination + count + i), _mm_unpackhi_epi64(x0, x2));
+    _mm_storeu_si128((__m128i*)(destination + count * 2 + i), _mm_unpacklo_epi64(x1, x3));
+    _mm_storeu_si128((__m128i*)(destination + count * 3 + i), _mm_unpackhi_epi64(x1, x3));
+  }
+#endif
+  return i;
+}
+
+static u64 UnshuffleBytes4(u8* destination, const u8* source, u64 count)
+{
+  u64 i = 0;
+#ifdef EN_COMPRESSION_SSE2
+  for (; i + 16 <= count; i += 16)
+  {
+    __m128i a = _mm_loadu_si128((const __m128i*)(source + i));
+    __m128i b = _mm_loadu_si128((const __m128i*)(source + count + i));
+    __m128i c = _mm_loadu_si128((const __m128i*)(source + count * 2 + i));
+    __m128i d = _mm_loadu_si128((const __m128i*)(source + count * 3 + i));
+
+    __m128i ab_low = _mm_unpacklo_epi8(a, b);
+    __m128i ab_high = _mm_unpackhi_epi8(a, b);
+    __m128i cd_low = _mm_unpacklo_epi8(c, d);
+    __m128i cd_high = _mm_unpackhi_epi8(c, d);
+
+    _mm_storeu_si128((__m128i*)(destination + i * 4), _mm_unpacklo_epi16(ab_low, cd_low));
+    _mm_storeu_si128((__m128i*)(destination + i * 4 + 16), _mm_unpackhi_epi16(ab_low, cd_low));
+    _mm_storeu_si128((__m128i*)(destination + i * 4 + 32), _mm_unpacklo_epi16(ab_high, cd_high));
+    _mm_storeu_si128((__m128i*)(destination + i * 4 + 48), _mm_unpackhi_epi16(ab_high, cd_high));
+  }
+#endif
+  return i;
+}
+
+// byte k of every value goes into the k-th run of size / stride bytes, anything past the last
+// whole value is copied as it is
+void ShuffleBytes(u8* destination, const u8* source, u64 size, u32 stride)
+{
+  u64 count = size / stride;
+  u64 done = stride == 4 ? ShuffleBytes4(destination, source, count) : 0;
+  for (u32 k = 0; k < stride; k++)
+  {
+    u8* run = destination + k * count;
+    const u8* from = source + k;
+    for (u64 i = done; i < count; i++) run[i] = from[i * stride];
+  }
+
+  if (size > count * stride) memcpy(destination + count * stride, source + count * stride, size - count * stride);
+}
+
+void UnshuffleBytes(u8* destination, const u8* source, u64 size, u32 stride)
+{
+  u64 count = size / stride;
+  u64 done = stride == 4 ? UnshuffleBytes4(destination, source, count) : 0;
+  for (u32 k = 0; k < stride; k++)
+  {
+    const u8* run = source + k * count;
+    u8* to = destination + k;
+    for (u64 i = done; i < count; i++) to[i * stride] = run[i];
+  }
+
+  if (size > count * stride) memcpy(destination + count * stride, source + count * stride, size - count * stride);
+}
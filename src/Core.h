@@ -11,8 +11,13 @@
 #include <random>
 
 
+using u8 = uint8_t;
+using s16 = int16_t;
+using u16 = uint16_t;
 using s32 = int32_t;
 using u32 = uint32_t;
+using s64 = int64_t;
+using u64 = uint64_t;
 using f32  = float;
 using f64 = double;
 
@@ -30,14 +35,15 @@ static void DebugPrintToConsole(T var1, Types... var2)
   std::cout << '\n';
 }
 
+// where assets/ is, FindAssetRoot (AssetPack.h) points it at the real one at startup
+std::string asset_root = "../../assets/";
+
 std::string AssetPath(const char* filename)
 {
-  std::string prefix = "../../assets/";
-  return prefix.append(filename);
+  return asset_root + filename;
 }
 
-std::string AssetPath(std::string path)
+std::string AssetPath(const std::string& path)
 {
-  std::string prefix = "../../assets/";
-  return prefix.append(path);
+  return asset_root + path;
 }
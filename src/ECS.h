@@ -0,0 +1,458 @@
+#pragma once
+
+#include "Core.h"
+#include "Profiler.h"
+#include "Entity.h"
+#include "vector.h"
+
+
+/// ECS API Reference
+////// Entity CreateEntity(ComponentMask components);
+////// void CreateEntities(ComponentMask components, s32 count, Entity* entities);
+////// void DestroyEntity(Entity entity);
+////// void DestroyAllEntities();
+////// bool IsEntityAlive(Entity entity);
+////// u32 EntityCount();
+////// void AddComponent(Entity entity, COMPONENT component);
+////// void RemoveComponent(Entity entity, COMPONENT component);
+////// bool HasComponent(Entity entity, COMPONENT component);
+////// void SetComponentTeardown(COMPONENT component, ComponentTeardown teardown);
+////// T* GetComponent<T>(Entity entity, COMPONENT component);
+////// EcsQuery CreateQuery(ComponentMask all, ComponentMask none);
+////// void ForEachChunk(EcsQuery& query, Func func);
+////// T* ChunkColumn<T>(const EcsChunk& chunk, COMPONENT component);
+
+// entities with the same set of components share an archetype, and an archetype keeps its entities
+// in fixed size chunks with one column per component...a chunk holds every component of a run of
+// entities back to back, so a system walking a column touches nothing but the data it asked for
+
+// adding or removing a component moves the entity to the archetype for its new set, the moves between
+// two archetypes are cached on the archetype so only the first one has to look the target up. rows
+// are kept packed by moving the archetype's last entity into the hole
+
+// queries remember which archetypes match and only look at archetypes created since they last ran.
+// nothing may create, destroy or change the components of entities while a query is being walked
+
+// a component holding a handle into another system (an animation slot, a sound emitter) can have a
+// teardown, it runs on the component whenever an entity loses it: RemoveComponent, DestroyEntity
+// and DestroyAllEntities alike
+
+using ComponentMask = u32;
+using ComponentTeardown = void(*)(void* component);
+
+const u32 ECS_CHUNK_BYTES = 16 * 1024;
+const u32 ECS_COLUMN_ALIGN = 16;
+
+static inline ComponentMask ComponentBit(COMPONENT component)
+{
+  return 1u << (u32)component;
+}
+
+struct EcsArchetype
+{
+  ComponentMask mask;
+  s32 chunk_capacity;                       // rows per chunk
+  s32 column_offsets[COMPONENT_COUNT];      // where each column starts inside a chunk, -1 when the archetype doesn't have it
+  s32 add_edge[COMPONENT_COUNT];            // archetype an entity moves to when it gains/loses a component, -1 until the first move
+  s32 remove_edge[COMPONENT_COUNT];
+  en::vector<u8*> chunks;                   // every chunk but the last one is full
+  s32 count;
+};
+
+struct EcsChunk
+{
+  const EcsArchetype* archetype;
+  u8* data;
+  s32 count;
+};
+
+struct EcsQuery
+{
+  ComponentMask all = 0;
+  ComponentMask none = 0;
+  en::vector<s32> archetypes;
+  s32 checked = 0;                          // archetypes before this one have already been matched
+};
+
+static struct
+{
+  en::vector<EcsArchetype> archetypes;
+
+  // one entry per entity slot, slots are reused through the free list
+  en::vector<s32> entity_archetype;         // -1 for free slots
+  en::vector<s32> entity_row;
+  en::vector<u32> entity_generation;
+  en::vector<s32> free_entities;
+  u32 live = 0;
+
+  ComponentTeardown teardowns[COMPONENT_COUNT] = {};
+  ComponentMask teardown_mask = 0;          // the components that have one
+
+  struct
+  {
+    u64 moves = 0;                          // entities moved between archetypes by Add/RemoveComponent
+    u32 chunks = 0;
+  } stats;
+} ecs;
+
+// the chunk layout for a mask, returns the rows per chunk...the entity column comes first, then each
+// component column rounded up to ECS_COLUMN_ALIGN
+static s32 ArchetypeLayout(ComponentMask mask, s32 column_offsets[COMPONENT_COUNT])
+{
+  u32 row_bytes = sizeof(Entity);
+  u32 columns = 1;
+  for (u32 c = 0; c < COMPONENT_COUNT; c++)
+  {
+    if (mask & (1u << c))
+    {
+      row_bytes += component_sizes[c];
+      columns++;
+    }
+  }
+
+  s32 chunk_capacity = (s32)((ECS_CHUNK_BYTES - columns * ECS_COLUMN_ALIGN) / row_bytes);
+
+  u32 offset = ((u32)chunk_capacity * sizeof(Entity) + ECS_COLUMN_ALIGN - 1) & ~(ECS_COLUMN_ALIGN - 1);
+  for (u32 c = 0; c < COMPONENT_COUNT; c++)
+  {
+    column_offsets[c] = -1;
+    if (mask & (1u << c))
+    {
+      column_offsets[c] = (s32)offset;
+      offset = (offset + component_sizes[c] * chunk_capacity + ECS_COLUMN_ALIGN - 1) & ~(ECS_COLUMN_ALIGN - 1);
+    }
+  }
+
+  return chunk_capacity;
+}
+
+// -1 when nothing has made an archetype for the mask yet
+static s32 LookupArchetype(ComponentMask mask)
+{
+  for (s32 i = 0; i < ecs.archetypes.Size(); i++)
+  {
+    if (ecs.archetypes[i].mask == mask) return i;
+  }
+
+  return -1;
+}
+
+static s32 FindArchetype(ComponentMask mask)
+{
+  s32 found = LookupArchetype(mask);
+  if (found >= 0) return found;
+
+  EcsArchetype archetype;
+  archetype.mask = mask;
+  archetype.count = 0;
+  archetype.chunk_capacity = ArchetypeLayout(mask, archetype.column_offsets);
+
+  for (u32 c = 0; c < COMPONENT_COUNT; c++)
+  {
+    archetype.add_edge[c] = -1;
+    archetype.remove_edge[c] = -1;
+  }
+
+  ecs.archetypes.PushBack(archetype);
+  return ecs.archetypes.Size() - 1;
+}
+
+static inline u8* ArchetypeRow(EcsArchetype& archetype, s32 row, s32 offset, u32 size)
+{
+  return archetype.chunks[row / archetype.chunk_capacity] + offset + (u32)(row % archetype.chunk_capacity) * size;
+}
+
+static inline Entity* ArchetypeEntity(EcsArchetype& archetype, s32 row)
+{
+  return (Entity*)ArchetypeRow(archetype, row, 0, sizeof(Entity));
+}
+
+static s32 AppendRow(EcsArchetype& archetype, Entity entity)
+{
+  s32 row = archetype.count++;
+  if (row / archetype.chunk_capacity >= archetype.chunks.Size())
+  {
+    archetype.chunks.PushBack(new u8[ECS_CHUNK_BYTES]);
+    ecs.stats.chunks++;
+  }
+
+  *ArchetypeEntity(archetype, row) = entity;
+  return row;
+}
+
+// fills the hole at row with the archetype's last entity
+static void RemoveRow(EcsArchetype& archetype, s32 row)
+{
+  s32 last = archetype.count - 1;
+  if (row != last)
+  {
+    Entity moved = *ArchetypeEntity(archetype, last);
+    *ArchetypeEntity(archetype, row) = moved;
+
+    for (u32 c = 0; c < COMPONENT_COUNT; c++)
+    {
+      s32 offset = archetype.column_offsets[c];
+      if (offset < 0) continue;
+      memcpy(ArchetypeRow(archetype, row, offset, component_sizes[c]), ArchetypeRow(archetype, last, offset, component_sizes[c]), component_sizes[c]);
+    }
+
+    ecs.entity_row[(s32)(moved.id & 0xFFFFFFFF)] = row;
+  }
+
+  archetype.count--;
+}
+
+static inline s32 EntitySlot(Entity entity)
+{
+  s32 slot = (s32)(entity.id & 0xFFFFFFFF);
+  if (entity.id == 0 || slot >= ecs.entity_archetype.Size()) return -1;
+  if (ecs.entity_generation[slot] != (u32)(entity.id >> 32) || ecs.entity_archetype[slot] < 0) return -1;
+  return slot;
+}
+
+static Entity CreateEntityIn(s32 a)
+{
+  s32 slot;
+  if (ecs.free_entities.Size() > 0)
+  {
+    slot = ecs.free_entities[ecs.free_entities.Size() - 1];
+    ecs.free_entities.PopBack();
+  }
+  else
+  {
+    slot = ecs.entity_archetype.Size();
+    ecs.entity_archetype.PushBack(-1);
+    ecs.entity_row.PushBack(-1);
+    ecs.entity_generation.PushBack(1);
+  }
+
+  Entity entity = { ((u64)ecs.entity_generation[slot] << 32) | (u64)slot };
+  EcsArchetype& archetype = ecs.archetypes[a];
+  s32 row = AppendRow(archetype, entity);
+
+  for (u32 c = 0; c < COMPONENT_COUNT; c++)
+  {
+    if (archetype.column_offsets[c] >= 0) ConstructComponent((COMPONENT)c, ArchetypeRow(archetype, row, archetype.column_offsets[c], component_sizes[c]));
+  }
+
+  ecs.entity_archetype[slot] = a;
+  ecs.entity_row[slot] = row;
+  ecs.live++;
+  return entity;
+}
+
+Entity CreateEntity(ComponentMask components)
+{
+  return CreateEntityIn(FindArchetype(components));
+}
+
+// the archetype is looked up once for the lot, the new entities end up in consecutive rows
+void CreateEntities(ComponentMask components, s32 count, Entity* entities)
+{
+  s32 a = FindArchetype(components);
+  for (s32 i = 0; i < count; i++) entities[i] = CreateEntityIn(a);
+}
+
+void SetComponentTeardown(COMPONENT component, ComponentTeardown teardown)
+{
+  ecs.teardowns[(u32)component] = teardown;
+  if (teardown) ecs.teardown_mask |= ComponentBit(component);
+  else ecs.teardown_mask &= ~ComponentBit(component);
+}
+
+static void TeardownComponents(EcsArchetype& archetype, s32 row, ComponentMask components)
+{
+  components &= archetype.mask & ecs.teardown_mask;
+  for (u32 c = 0; components; c++)
+  {
+    if (!(components & (1u << c))) continue;
+
+    ecs.teardowns[c](ArchetypeRow(archetype, row, archetype.column_offsets[c], component_sizes[c]));
+    components &= ~(1u << c);
+  }
+}
+
+void DestroyEntity(Entity entity)
+{
+  s32 slot = EntitySlot(entity);
+  if (slot < 0) return;
+
+  TeardownComponents(ecs.archetypes[ecs.entity_archetype[slot]], ecs.entity_row[slot], ~0u);
+  RemoveRow(ecs.archetypes[ecs.entity_archetype[slot]], ecs.entity_row[slot]);
+
+  ecs.entity_archetype[slot] = -1;
+  ecs.entity_generation[slot]++;
+  if (ecs.entity_generation[slot] == 0) ecs.entity_generation[slot] = 1;
+  ecs.free_entities.PushBack(slot);
+  ecs.live--;
+}
+
+// archetypes survive so cached queries stay valid, only their chunks go
+void DestroyAllEntities()
+{
+  for (auto& archetype : ecs.archetypes)
+  {
+    if (archetype.mask & ecs.teardown_mask)
+    {
+      for (s32 row = 0; row < archetype.count; row++) TeardownComponents(archetype, row, ~0u);
+    }
+
+    for (u8* chunk : archetype.chunks) delete[] chunk;
+    archetype.chunks = en::vector<u8*>();
+    archetype.count = 0;
+  }
+
+  for (s32 slot = 0; slot < ecs.entity_archetype.Size(); slot++)
+  {
+    if (ecs.entity_archetype[slot] < 0) continue;
+
+    ecs.entity_archetype[slot] = -1;
+    ecs.entity_generation[slot]++;
+    if (ecs.entity_generation[slot] == 0) ecs.entity_generation[slot] = 1;
+    ecs.free_entities.PushBack(slot);
+  }
+
+  ecs.live = 0;
+  ecs.stats.chunks = 0;
+}
+
+bool IsEntityAlive(Entity entity)
+{
+  return EntitySlot(entity) >= 0;
+}
+
+u32 EntityCount()
+{
+  return ecs.live;
+}
+
+static void MoveEntity(s32 slot, s32 target)
+{
+  EcsArchetype& from = ecs.archetypes[ecs.entity_archetype[slot]];
+  EcsArchetype& to = ecs.archetypes[target];
+  s32 from_row = ecs.entity_row[slot];
+  s32 to_row = AppendRow(to, *ArchetypeEntity(from, from_row));
+
+  // components both archetypes have are copied over, ones the entity just gained start out default
+  for (u32 c = 0; c < COMPONENT_COUNT; c++)
+  {
+    s32 offset = to.column_offsets[c];
+    if (offset < 0) continue;
+
+    u8* destination = ArchetypeRow(to, to_row, offset, component_sizes[c]);
+    if (from.column_offsets[c] >= 0) memcpy(destination, ArchetypeRow(from, from_row, from.column_offsets[c], component_sizes[c]), component_sizes[c]);
+    else ConstructComponent((COMPONENT)c, destination);
+  }
+
+  RemoveRow(from, from_row);
+  ecs.entity_archetype[slot] = target;
+  ecs.entity_row[slot] = to_row;
+  ecs.stats.moves++;
+}
+
+void AddComponent(Entity entity, COMPONENT component)
+{
+  s32 slot = EntitySlot(entity);
+  if (slot < 0) return;
+
+  s32 a = ecs.entity_archetype[slot];
+  ComponentMask mask = ecs.archetypes[a].mask;
+  if (mask & ComponentBit(component)) return;
+
+  s32 target = ecs.archetypes[a].add_edge[(u32)component];
+  if (target < 0)
+  {
+    target = FindArchetype(mask | ComponentBit(component));
+    ecs.archetypes[a].add_edge[(u32)component] = target;
+  }
+
+  MoveEntity(slot, target);
+}
+
+void RemoveComponent(Entity entity, COMPONENT component)
+{
+  s32 slot = EntitySlot(entity);
+  if (slot < 0) return;
+
+  s32 a = ecs.entity_archetype[slot];
+  ComponentMask mask = ecs.archetypes[a].mask;
+  if (!(mask & ComponentBit(component))) return;
+
+  s32 target = ecs.archetypes[a].remove_edge[(u32)component];
+  if (target < 0)
+  {
+    target = FindArchetype(mask & ~ComponentBit(component));
+    ecs.archetypes[a].remove_edge[(u32)component] = target;
+  }
+
+  TeardownComponents(ecs.archetypes[a], ecs.entity_row[slot], ComponentBit(component));
+  MoveEntity(slot, target);
+}
+
+bool HasComponent(Entity entity, COMPONENT component)
+{
+  s32 slot = EntitySlot(entity);
+  return slot >= 0 && (ecs.archetypes[ecs.entity_archetype[slot]].mask & ComponentBit(component)) != 0;
+}
+
+// only good until the next structural change, which can move the entity to another row
+template <typename T>
+T* GetComponent(Entity entity, COMPONENT component)
+{
+  s32 slot = EntitySlot(entity);
+  if (slot < 0) return nullptr;
+
+  EcsArchetype& archetype = ecs.archetypes[ecs.entity_archetype[slot]];
+  s32 offset = archetype.column_offsets[(u32)component];
+  if (offset < 0) return nullptr;
+
+  return (T*)ArchetypeRow(archetype, ecs.entity_row[slot], offset, sizeof(T));
+}
+
+EcsQuery CreateQuery(ComponentMask all, ComponentMask none)
+{
+  EcsQuery query;
+  query.all = all;
+  query.none = none;
+  return query;
+}
+
+static void UpdateQuery(EcsQuery& query)
+{
+  for (; query.checked < ecs.archetypes.Size(); query.checked++)
+  {
+    ComponentMask mask = ecs.archetypes[query.checked].mask;
+    if ((mask & query.all) == query.all && (mask & query.none) == 0) query.archetypes.PushBack(query.checked);
+  }
+}
+
+// calls func(const EcsChunk&) once for every non empty chunk of every matching archetype
+template <typename Func>
+void ForEachChunk(EcsQuery& query, Func func)
+{
+  UpdateQuery(query);
+
+  for (s32 a : query.archetypes)
+  {
+    EcsArchetype& archetype = ecs.archetypes[a];
+    s32 left = archetype.count;
+    for (s32 c = 0; left > 0; c++)
+    {
+      EcsChunk chunk = { &archetype, archetype.chunks[c], left < archetype.chunk_capacity ? left : archetype.chunk_capacity };
+      func(chunk);
+      left -= chunk.count;
+    }
+  }
+}
+
+template <typename T>
+static inline T* ChunkColumn(const EcsChunk& chunk, COMPONENT component)
+{
+  s32 offset = chunk.archetype->column_offsets[(u32)component];
+  return offset < 0 ? nullptr : (T*)(chunk.data + offset);
+}
+
+static inline const Entity* ChunkEntities(const EcsChunk& chunk)
+{
+  return (const Entity*)chunk.data;
+}
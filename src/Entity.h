@@ -2,6 +2,7 @@
 
 #include "Core.h"
 #include "vec2.h"
+#include <new>
 
 
 struct Vertex
@@ -9,15 +10,103 @@ struct Vertex
   vec2 position;
 };
 
+const Vertex quad_vertices[4] = { vec2(1.f, 1.f), vec2(1.f, -1.f), vec2(-1.f, -1.f), vec2(-1.f, 1.f) };
+
+// an entity is just a handle, everything it has lives in the components below (see ECS.h)
 struct Entity
 {
-public:
-  Vertex verts[4] = { vec2(1.f, 1.f), vec2(1.f, -1.f), vec2(-1.f, -1.f), vec2(-1.f, 1.f) };
+  u64 id = 0;     // slot in the low 32 bits, generation in the high 32, 0 is never a live entity
+};
+
+enum class COMPONENT : u8
+{
+  TRANSFORM,
+  BASE_SCALE,
+  SPRITE,
+  ANIMATED,
+  VELOCITY,
+  SOUND_SOURCE,
+  SCENE_NODE,
+  PREFAB
+};
+
+const u32 COMPONENT_COUNT = 8;
+
+struct Transform
+{
   vec2 position;
   vec2 scale;
-  u32 vao, vbo, ebo;
-  u32 shader;
-  u32 texture;
   f32 angle = 0.f;
-  bool editor_selected = false;
 };
+
+// the scale at an aspect ratio of 1, Transform::scale is rebuilt from it whenever the window resizes
+struct BaseScale
+{
+  vec2 scale = vec2(1.f, 1.f);
+};
+
+// vao and shader stay 0 for sprites drawn by the sprite batch
+struct Sprite
+{
+  u32 texture = 0;
+  u32 shader = 0;
+  u32 vao = 0;
+};
+
+struct Animated
+{
+  s32 animation = -1;       // see Animation.h
+};
+
+struct Velocity
+{
+  vec2 velocity;
+};
+
+struct SoundSource
+{
+  s32 emitter = -1;         // see AudioSpatial.h
+};
+
+// an entity in the scene graph has its Transform written by it, see SceneGraph.h
+struct SceneNode
+{
+  s32 node = -1;
+};
+
+// an instance of a prefab (see Prefabs.h) takes its sprite and base scale from the prefab unless it
+// has a Sprite or BaseScale of its own
+struct PrefabInstance
+{
+  s32 prefab = -1;
+};
+
+const u32 component_sizes[COMPONENT_COUNT] =
+{
+  sizeof(Transform),
+  sizeof(BaseScale),
+  sizeof(Sprite),
+  sizeof(Animated),
+  sizeof(Velocity),
+  sizeof(SoundSource),
+  sizeof(SceneNode),
+  sizeof(PrefabInstance)
+};
+
+const char* component_names[COMPONENT_COUNT] = { "Transform", "BaseScale", "Sprite", "Animated", "Velocity", "SoundSource", "SceneNode", "Prefab" };
+
+// writes a default constructed component, new components and components an entity gains start out like this
+static void ConstructComponent(COMPONENT component, void* memory)
+{
+  switch (component)
+  {
+  case COMPONENT::TRANSFORM: new (memory) Transform(); break;
+  case COMPONENT::BASE_SCALE: new (memory) BaseScale(); break;
+  case COMPONENT::SPRITE: new (memory) Sprite(); break;
+  case COMPONENT::ANIMATED: new (memory) Animated(); break;
+  case COMPONENT::VELOCITY: new (memory) Velocity(); break;
+  case COMPONENT::SOUND_SOURCE: new (memory) SoundSource(); break;
+  case COMPONENT::SCENE_NODE: new (memory) SceneNode(); break;
+  case COMPONENT::PREFAB: new (memory) PrefabInstance(); break;
+  }
+}
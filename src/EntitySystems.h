@@ -0,0 +1,262 @@
+#pragma once
+
+#include "Core.h"
+#include "Profiler.h"
+#include "FrameStats.h"
+#include "GLGraphics.h"
+#include "ECS.h"
+#include "Animation.h"
+#include "AudioSpatial.h"
+#include "SceneGraph.h"
+#include "Prefabs.h"
+#include "SpriteBatch.h"
+#include "mat4.h"
+
+
+/// Entity Systems API Reference
+////// void MoveEntities(f32 delta_seconds);
+////// void RescaleEntities();
+////// void AttachSoundEmitter(Entity entity, SoundHandle sound, f32 max_distance, f32 volume);
+////// void UpdateSoundSources();
+////// void DrawEntities(SpriteBatch& batch);
+
+// the engine's systems over the components in Entity.h, each one is a query and a loop down the
+// columns it needs
+
+// sprites are drawn relative to the camera, at the origin the screen is the -1..1 square it always was
+static struct
+{
+  vec2 position;
+} camera;
+
+static struct
+{
+  EcsQuery moving = CreateQuery(ComponentBit(COMPONENT::TRANSFORM) | ComponentBit(COMPONENT::VELOCITY), ComponentBit(COMPONENT::SCENE_NODE));
+  EcsQuery moving_nodes = CreateQuery(ComponentBit(COMPONENT::VELOCITY) | ComponentBit(COMPONENT::SCENE_NODE), 0);
+  EcsQuery scaled = CreateQuery(ComponentBit(COMPONENT::TRANSFORM) | ComponentBit(COMPONENT::BASE_SCALE), ComponentBit(COMPONENT::SCENE_NODE));
+  EcsQuery scaled_nodes = CreateQuery(ComponentBit(COMPONENT::BASE_SCALE) | ComponentBit(COMPONENT::SCENE_NODE), 0);
+  EcsQuery prefab_scaled = CreateQuery(ComponentBit(COMPONENT::TRANSFORM) | ComponentBit(COMPONENT::PREFAB),
+    ComponentBit(COMPONENT::BASE_SCALE) | ComponentBit(COMPONENT::SCENE_NODE));
+  EcsQuery prefab_scaled_nodes = CreateQuery(ComponentBit(COMPONENT::PREFAB) | ComponentBit(COMPONENT::SCENE_NODE), ComponentBit(COMPONENT::BASE_SCALE));
+  EcsQuery sound_sources = CreateQuery(ComponentBit(COMPONENT::TRANSFORM) | ComponentBit(COMPONENT::SOUND_SOURCE), 0);
+  EcsQuery animated_sprites = CreateQuery(ComponentBit(COMPONENT::TRANSFORM) | ComponentBit(COMPONENT::SPRITE) | ComponentBit(COMPONENT::ANIMATED), 0);
+  EcsQuery static_sprites = CreateQuery(ComponentBit(COMPONENT::TRANSFORM) | ComponentBit(COMPONENT::SPRITE), ComponentBit(COMPONENT::ANIMATED));
+  EcsQuery prefab_sprites = CreateQuery(ComponentBit(COMPONENT::TRANSFORM) | ComponentBit(COMPONENT::PREFAB), ComponentBit(COMPONENT::SPRITE));
+} entity_queries;
+
+static void TeardownAnimated(void* component)
+{
+  Animated* animated = (Animated*)component;
+  DestroyAnimation(animated->animation);
+  animated->animation = -1;
+}
+
+static void TeardownSoundSource(void* component)
+{
+  SoundSource* source = (SoundSource*)component;
+  DestroySoundEmitter(source->emitter);
+  source->emitter = -1;
+}
+
+static void TeardownSceneNode(void* component)
+{
+  SceneNode* node = (SceneNode*)component;
+  ReleaseNode(node->node);
+  node->node = -1;
+}
+
+// set up before main like the queries, an entity can't lose one of these without freeing what it held
+static struct EntityTeardowns
+{
+  EntityTeardowns()
+  {
+    SetComponentTeardown(COMPONENT::ANIMATED, TeardownAnimated);
+    SetComponentTeardown(COMPONENT::SOUND_SOURCE, TeardownSoundSource);
+    SetComponentTeardown(COMPONENT::SCENE_NODE, TeardownSceneNode);
+  }
+} entity_teardowns;
+
+// physics, just integrating velocities for now
+void MoveEntities(f32 delta_seconds)
+{
+  PROFILE_FUNCTION();
+
+  ForEachChunk(entity_queries.moving, [&](const EcsChunk& chunk)
+  {
+    Transform* transform = ChunkColumn<Transform>(chunk, COMPONENT::TRANSFORM);
+    const Velocity* velocity = ChunkColumn<Velocity>(chunk, COMPONENT::VELOCITY);
+
+    for (s32 i = 0; i < chunk.count; i++)
+    {
+      transform[i].position = vec2(transform[i].position.x() + velocity[i].velocity.x() * delta_seconds, transform[i].position.y() + velocity[i].velocity.y() * delta_seconds);
+    }
+  });
+
+  // anything in the scene graph moves relative to its parent, the graph writes the Transform later
+  ForEachChunk(entity_queries.moving_nodes, [&](const EcsChunk& chunk)
+  {
+    const Velocity* velocity = ChunkColumn<Velocity>(chunk, COMPONENT::VELOCITY);
+    const SceneNode* node = ChunkColumn<SceneNode>(chunk, COMPONENT::SCENE_NODE);
+
+    for (s32 i = 0; i < chunk.count; i++)
+    {
+      TranslateNode(node[i].node, vec2(velocity[i].velocity.x() * delta_seconds, velocity[i].velocity.y() * delta_seconds));
+    }
+  });
+}
+
+// keeps sprites square on screen, called whenever the aspect ratio changes
+void RescaleEntities()
+{
+  ForEachChunk(entity_queries.scaled, [&](const EcsChunk& chunk)
+  {
+    Transform* transform = ChunkColumn<Transform>(chunk, COMPONENT::TRANSFORM);
+    const BaseScale* base = ChunkColumn<BaseScale>(chunk, COMPONENT::BASE_SCALE);
+
+    for (s32 i = 0; i < chunk.count; i++)
+    {
+      transform[i].scale = vec2(base[i].scale.x(), base[i].scale.y() * aspect_ratio);
+    }
+  });
+
+  // only roots of the scene graph, everything below them picks the aspect ratio up from them
+  ForEachChunk(entity_queries.scaled_nodes, [&](const EcsChunk& chunk)
+  {
+    const BaseScale* base = ChunkColumn<BaseScale>(chunk, COMPONENT::BASE_SCALE);
+    const SceneNode* node = ChunkColumn<SceneNode>(chunk, COMPONENT::SCENE_NODE);
+
+    for (s32 i = 0; i < chunk.count; i++)
+    {
+      if (!IsRootNode(node[i].node)) continue;
+
+      Transform local = GetNodeLocal(node[i].node);
+      local.scale = vec2(base[i].scale.x(), base[i].scale.y() * aspect_ratio);
+      SetNodeLocal(node[i].node, local);
+    }
+  });
+
+  // prefab instances without a scale of their own go by their prefab's
+  ForEachChunk(entity_queries.prefab_scaled, [&](const EcsChunk& chunk)
+  {
+    Transform* transform = ChunkColumn<Transform>(chunk, COMPONENT::TRANSFORM);
+    const PrefabInstance* instance = ChunkColumn<PrefabInstance>(chunk, COMPONENT::PREFAB);
+
+    for (s32 i = 0; i < chunk.count; i++)
+    {
+      if (!IsPrefab(instance[i].prefab)) continue;
+
+      vec2 scale = prefabs.scale[instance[i].prefab].scale;
+      transform[i].scale = vec2(scale.x(), scale.y() * aspect_ratio);
+    }
+  });
+
+  ForEachChunk(entity_queries.prefab_scaled_nodes, [&](const EcsChunk& chunk)
+  {
+    const PrefabInstance* instance = ChunkColumn<PrefabInstance>(chunk, COMPONENT::PREFAB);
+    const SceneNode* node = ChunkColumn<SceneNode>(chunk, COMPONENT::SCENE_NODE);
+
+    for (s32 i = 0; i < chunk.count; i++)
+    {
+      if (!IsRootNode(node[i].node) || !IsPrefab(instance[i].prefab)) continue;
+
+      vec2 scale = prefabs.scale[instance[i].prefab].scale;
+      Transform local = GetNodeLocal(node[i].node);
+      local.scale = vec2(scale.x(), scale.y() * aspect_ratio);
+      SetNodeLocal(node[i].node, local);
+    }
+  });
+}
+
+void AttachSoundEmitter(Entity entity, SoundHandle sound, f32 max_distance, f32 volume)
+{
+  Transform* transform = GetComponent<Transform>(entity, COMPONENT::TRANSFORM);
+  if (!transform) return;
+
+  vec2 position = transform->position;
+  AddComponent(entity, COMPONENT::SOUND_SOURCE);
+
+  SoundSource* source = GetComponent<SoundSource>(entity, COMPONENT::SOUND_SOURCE);
+  DestroySoundEmitter(source->emitter);
+  source->emitter = CreateSoundEmitter(sound, position, max_distance, volume);
+}
+
+void UpdateSoundSources()
+{
+  PROFILE_FUNCTION();
+
+  ForEachChunk(entity_queries.sound_sources, [&](const EcsChunk& chunk)
+  {
+    const Transform* transform = ChunkColumn<Transform>(chunk, COMPONENT::TRANSFORM);
+    const SoundSource* source = ChunkColumn<SoundSource>(chunk, COMPONENT::SOUND_SOURCE);
+
+    for (s32 i = 0; i < chunk.count; i++) SetSoundEmitterPosition(source[i].emitter, transform[i].position);
+  });
+}
+
+static void DrawSprite(SpriteBatch& batch, const Transform& t, const Sprite& sprite)
+{
+  vec2 position = vec2(t.position.x() - camera.position.x(), t.position.y() - camera.position.y());
+
+  // no shader of its own (streamed world sprites), the whole texture goes through the batch
+  if (sprite.shader == 0)
+  {
+    PushSprite(batch, sprite.texture, position, t.scale, t.angle, vec4(0.f, 0.f, 1.f, 1.f));
+    return;
+  }
+
+  mat4 matrix = mat4::Translate(vec3(position.x(), position.y(), 0.f));
+  matrix *= mat4::Rotate(t.angle, vec3(0.f, 0.f, 1.f));
+  matrix *= mat4::Scale(vec3(t.scale.x(), t.scale.y(), 1.f));
+
+  glUseProgram(sprite.shader);
+  glUniformMatrix4fv(glGetUniformLocation(sprite.shader, "transform"), 1, GL_FALSE, matrix.elements);
+
+  glBindVertexArray(sprite.vao);
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D, sprite.texture);
+  glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+  CountDrawCall();
+  CountStateChanges(4);
+}
+
+// static sprites with a shader still draw one by one with it, the rest go through the sprite batch
+// and the batch is flushed last so animated sprites stay on top
+void DrawEntities(SpriteBatch& batch)
+{
+  PROFILE_FUNCTION();
+
+  ForEachChunk(entity_queries.static_sprites, [&](const EcsChunk& chunk)
+  {
+    const Transform* transform = ChunkColumn<Transform>(chunk, COMPONENT::TRANSFORM);
+    const Sprite* sprite = ChunkColumn<Sprite>(chunk, COMPONENT::SPRITE);
+
+    for (s32 i = 0; i < chunk.count; i++) DrawSprite(batch, transform[i], sprite[i]);
+  });
+
+  // instances without a sprite of their own draw their prefab's
+  ForEachChunk(entity_queries.prefab_sprites, [&](const EcsChunk& chunk)
+  {
+    const Transform* transform = ChunkColumn<Transform>(chunk, COMPONENT::TRANSFORM);
+    const PrefabInstance* instance = ChunkColumn<PrefabInstance>(chunk, COMPONENT::PREFAB);
+
+    for (s32 i = 0; i < chunk.count; i++)
+    {
+      if (IsPrefab(instance[i].prefab)) DrawSprite(batch, transform[i], prefabs.sprite[instance[i].prefab]);
+    }
+  });
+
+  ForEachChunk(entity_queries.animated_sprites, [&](const EcsChunk& chunk)
+  {
+    const Transform* transform = ChunkColumn<Transform>(chunk, COMPONENT::TRANSFORM);
+    const Sprite* sprite = ChunkColumn<Sprite>(chunk, COMPONENT::SPRITE);
+    const Animated* animated = ChunkColumn<Animated>(chunk, COMPONENT::ANIMATED);
+
+    for (s32 i = 0; i < chunk.count; i++)
+    {
+      vec2 position = vec2(transform[i].position.x() - camera.position.x(), transform[i].position.y() - camera.position.y());
+      PushSprite(batch, sprite[i].texture, position, transform[i].scale, transform[i].angle, GetAnimationRect(animated[i].animation));
+    }
+  });
+
+  FlushSprites(batch);
+}
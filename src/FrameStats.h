@@ -0,0 +1,278 @@
+#pragma once
+
+#include "Core.h"
+#include "imgui/imgui.h"
+#include <atomic>
+#include <new>
+#include <cstdlib>
+
+
+/// Frame Stats API Reference
+////// void RecordFrameTime(f32 frame_ms);
+////// void ComputeFrameStats(FrameStatsSummary& summary);
+////// void CountDrawCall();
+////// void CountStateChanges(u32 count);
+////// void CountVerticesUploaded(u32 count);
+////// void SetEntityCounts(u32 entity_count, u32 particle_count);
+////// void FrameStatsEndFrame();
+////// void DrawFrameStatsWindow(bool* open);
+
+// frame times go into a rolling window and a bucketed histogram at the same time...the histogram
+// is what the percentiles are read from so the overlay never has to sort anything
+
+// buckets are 50us wide up to 100ms, anything slower lands in the last bucket
+const u32 FRAME_STATS_WINDOW = 1024;
+const u32 FRAME_STATS_BUCKETS = 2000;
+const f32 FRAME_STATS_BUCKET_MS = 0.05f;
+
+struct FrameCounters
+{
+  std::atomic<u32> draw_calls{ 0 };
+  std::atomic<u32> state_changes{ 0 };
+  std::atomic<u32> vertices_uploaded{ 0 };
+  std::atomic<u32> entities{ 0 };
+  std::atomic<u32> particles{ 0 };
+  std::atomic<u32> allocations{ 0 };
+};
+
+struct FrameCountersSnapshot
+{
+  u32 draw_calls = 0;
+  u32 state_changes = 0;
+  u32 vertices_uploaded = 0;
+  u32 entities = 0;
+  u32 particles = 0;
+  u32 allocations = 0;
+};
+
+struct FrameStatsSummary
+{
+  u32 frame_count = 0;
+  u32 over_budget_count = 0;
+  f32 min_ms = 0.f;
+  f32 avg_ms = 0.f;
+  f32 p50_ms = 0.f;
+  f32 p95_ms = 0.f;
+  f32 p99_ms = 0.f;
+  f32 max_ms = 0.f;
+};
+
+static struct
+{
+  f32 frame_times[FRAME_STATS_WINDOW] = {};
+  bool over_budget[FRAME_STATS_WINDOW] = {};   // judged against the budget at the time, the slider can move it since
+  std::atomic<u32> histogram[FRAME_STATS_BUCKETS] = {};
+  std::atomic<u64> frame_index{ 0 };
+  std::atomic<u32> over_budget_count{ 0 };
+  f64 window_sum_ms = 0.0;
+  f32 budget_ms = 1000.f / 60.f;
+  u64 total_hitches = 0;
+
+  FrameCounters counters;
+  FrameCountersSnapshot last_counters;
+} frame_stats;
+
+// every heap allocation in the process goes through here so the overlay can report allocations per frame
+void* operator new(size_t size)
+{
+  frame_stats.counters.allocations.fetch_add(1, std::memory_order_relaxed);
+  if (size == 0) size = 1;
+  void* ptr = malloc(size);
+  if (!ptr) throw std::bad_alloc();
+  return ptr;
+}
+
+void* operator new[](size_t size)
+{
+  frame_stats.counters.allocations.fetch_add(1, std::memory_order_relaxed);
+  if (size == 0) size = 1;
+  void* ptr = malloc(size);
+  if (!ptr) throw std::bad_alloc();
+  return ptr;
+}
+
+void operator delete(void* ptr) noexcept { free(ptr); }
+void operator delete[](void* ptr) noexcept { free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { free(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { free(ptr); }
+
+static inline u32 FrameStatsBucket(f32 frame_ms)
+{
+  s32 bucket = (s32)(frame_ms / FRAME_STATS_BUCKET_MS);
+  if (bucket < 0) return 0;
+  if (bucket >= (s32)FRAME_STATS_BUCKETS) return FRAME_STATS_BUCKETS - 1;
+  return (u32)bucket;
+}
+
+// called once per frame by whichever thread owns the frame loop, readers may run on any thread
+void RecordFrameTime(f32 frame_ms)
+{
+  u64 index = frame_stats.frame_index.load(std::memory_order_relaxed);
+  u32 slot = (u32)(index % FRAME_STATS_WINDOW);
+
+  if (index >= FRAME_STATS_WINDOW)
+  {
+    f32 evicted_ms = frame_stats.frame_times[slot];
+    frame_stats.histogram[FrameStatsBucket(evicted_ms)].fetch_sub(1, std::memory_order_relaxed);
+    frame_stats.window_sum_ms -= evicted_ms;
+    if (frame_stats.over_budget[slot]) frame_stats.over_budget_count.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  bool over_budget = frame_ms > frame_stats.budget_ms;
+  frame_stats.frame_times[slot] = frame_ms;
+  frame_stats.over_budget[slot] = over_budget;
+  frame_stats.histogram[FrameStatsBucket(frame_ms)].fetch_add(1, std::memory_order_relaxed);
+  frame_stats.window_sum_ms += frame_ms;
+  if (over_budget)
+  {
+    frame_stats.over_budget_count.fetch_add(1, std::memory_order_relaxed);
+    frame_stats.total_hitches++;
+  }
+
+  frame_stats.frame_index.store(index + 1, std::memory_order_release);
+}
+
+void ComputeFrameStats(FrameStatsSummary& summary)
+{
+  u64 frame_index = frame_stats.frame_index.load(std::memory_order_acquire);
+  u32 frame_count = frame_index < FRAME_STATS_WINDOW ? (u32)frame_index : FRAME_STATS_WINDOW;
+
+  summary = {};
+  summary.frame_count = frame_count;
+  summary.over_budget_count = frame_stats.over_budget_count.load(std::memory_order_relaxed);
+  if (frame_count == 0) return;
+
+  summary.min_ms = frame_stats.frame_times[0];
+  summary.max_ms = frame_stats.frame_times[0];
+  for (u32 i = 1; i < frame_count; i++)
+  {
+    f32 frame_ms = frame_stats.frame_times[i];
+    if (frame_ms < summary.min_ms) summary.min_ms = frame_ms;
+    if (frame_ms > summary.max_ms) summary.max_ms = frame_ms;
+  }
+
+  summary.avg_ms = (f32)(frame_stats.window_sum_ms / frame_count);
+
+  u32 p50_target = (u32)ceilf(frame_count * 0.50f);
+  u32 p95_target = (u32)ceilf(frame_count * 0.95f);
+  u32 p99_target = (u32)ceilf(frame_count * 0.99f);
+  u32 seen = 0;
+  bool p50_found = false, p95_found = false;
+
+  for (u32 b = 0; b < FRAME_STATS_BUCKETS; b++)
+  {
+    seen += frame_stats.histogram[b].load(std::memory_order_relaxed);
+    f32 bucket_ms = (b + 1) * FRAME_STATS_BUCKET_MS;
+
+    if (!p50_found && seen >= p50_target) { summary.p50_ms = bucket_ms; p50_found = true; }
+    if (!p95_found && seen >= p95_target) { summary.p95_ms = bucket_ms; p95_found = true; }
+    if (seen >= p99_target)
+    {
+      summary.p99_ms = bucket_ms;
+      break;
+    }
+  }
+
+  // the histogram only knows the bucket, clamp so the percentiles never read past the real max
+  if (summary.p50_ms > summary.max_ms) summary.p50_ms = summary.max_ms;
+  if (summary.p95_ms > summary.max_ms) summary.p95_ms = summary.max_ms;
+  if (summary.p99_ms > summary.max_ms) summary.p99_ms = summary.max_ms;
+}
+
+static inline void CountDrawCall()
+{
+  frame_stats.counters.draw_calls.fetch_add(1, std::memory_order_relaxed);
+}
+
+static inline void CountStateChanges(u32 count)
+{
+  frame_stats.counters.state_changes.fetch_add(count, std::memory_order_relaxed);
+}
+
+static inline void CountVerticesUploaded(u32 count)
+{
+  frame_stats.counters.vertices_uploaded.fetch_add(count, std::memory_order_relaxed);
+}
+
+void SetEntityCounts(u32 entity_count, u32 particle_count)
+{
+  frame_stats.counters.entities.store(entity_count, std::memory_order_relaxed);
+  frame_stats.counters.particles.store(particle_count, std::memory_order_relaxed);
+}
+
+void FrameStatsEndFrame()
+{
+  FrameCountersSnapshot& last = frame_stats.last_counters;
+  FrameCounters& counters = frame_stats.counters;
+
+  last.draw_calls = counters.draw_calls.exchange(0, std::memory_order_relaxed);
+  last.state_changes = counters.state_changes.exchange(0, std::memory_order_relaxed);
+  last.vertices_uploaded = counters.vertices_uploaded.exchange(0, std::memory_order_relaxed);
+  last.allocations = counters.allocations.exchange(0, std::memory_order_relaxed);
+  last.entities = counters.entities.load(std::memory_order_relaxed);
+  last.particles = counters.particles.load(std::memory_order_relaxed);
+}
+
+void DrawFrameStatsWindow(bool* open)
+{
+  if (!ImGui::Begin("Performance", open))
+  {
+    ImGui::End();
+    return;
+  }
+
+  FrameStatsSummary summary;
+  ComputeFrameStats(summary);
+
+  ImGui::Text("Frames: %u   Budget: %.2f ms", summary.frame_count, frame_stats.budget_ms);
+  ImGui::Text("min %.2f  avg %.2f  max %.2f ms", summary.min_ms, summary.avg_ms, summary.max_ms);
+  ImGui::Text("p50 %.2f  p95 %.2f  p99 %.2f ms", summary.p50_ms, summary.p95_ms, summary.p99_ms);
+
+  if (summary.over_budget_count > 0)
+  {
+    ImGui::TextColored(ImVec4(1.f, 0.3f, 0.3f, 1.f), "Over budget: %u in window, %llu total", summary.over_budget_count, (unsigned long long)frame_stats.total_hitches);
+  }
+  else
+  {
+    ImGui::Text("Over budget: 0 in window, %llu total", (unsigned long long)frame_stats.total_hitches);
+  }
+
+  ImGui::SliderFloat("Budget (ms)", &frame_stats.budget_ms, 4.f, 50.f);
+
+  // frame graph, oldest frame on the left, bars over budget are drawn red
+  ImDrawList* draw_list = ImGui::GetWindowDrawList();
+  ImVec2 origin = ImGui::GetCursorScreenPos();
+  ImVec2 size = ImVec2(ImGui::GetContentRegionAvail().x, 80.f);
+  ImGui::InvisibleButton("frame_graph", size);
+
+  f32 graph_max_ms = summary.max_ms > frame_stats.budget_ms * 2.f ? summary.max_ms : frame_stats.budget_ms * 2.f;
+  f32 bar_width = size.x / FRAME_STATS_WINDOW;
+  u64 frame_index = frame_stats.frame_index.load(std::memory_order_acquire);
+
+  draw_list->AddRectFilled(origin, ImVec2(origin.x + size.x, origin.y + size.y), IM_COL32(20, 20, 20, 255));
+  for (u32 i = 0; i < summary.frame_count; i++)
+  {
+    u64 index = frame_index - summary.frame_count + i;
+    f32 frame_ms = frame_stats.frame_times[index % FRAME_STATS_WINDOW];
+    f32 height = size.y * (frame_ms / graph_max_ms);
+    if (height > size.y) height = size.y;
+
+    f32 x = origin.x + (FRAME_STATS_WINDOW - summary.frame_count + i) * bar_width;
+    ImU32 color = frame_ms > frame_stats.budget_ms ? IM_COL32(230, 60, 60, 255) : IM_COL32(90, 200, 90, 255);
+    draw_list->AddRectFilled(ImVec2(x, origin.y + size.y - height), ImVec2(x + (bar_width > 1.f ? bar_width : 1.f), origin.y + size.y), color);
+  }
+
+  f32 budget_y = origin.y + size.y - size.y * (frame_stats.budget_ms / graph_max_ms);
+  draw_list->AddLine(ImVec2(origin.x, budget_y), ImVec2(origin.x + size.x, budget_y), IM_COL32(255, 255, 0, 255));
+
+  const FrameCountersSnapshot& counters = frame_stats.last_counters;
+  ImGui::Separator();
+  ImGui::Text("Draw calls:        %u", counters.draw_calls);
+  ImGui::Text("GL state changes:  %u", counters.state_changes);
+  ImGui::Text("Vertices uploaded: %u", counters.vertices_uploaded);
+  ImGui::Text("Entities:          %u", counters.entities);
+  ImGui::Text("Particles:         %u", counters.particles);
+  ImGui::Text("Allocations:       %u", counters.allocations);
+
+  ImGui::End();
+}
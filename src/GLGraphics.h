@@ -4,27 +4,38 @@
 
 #include "glew/glew.h"
 #include "Core.h"
+#include "Profiler.h"
 #include "unordered_map.h"
+#include "AssetPack.h"
 #include "stb/stb_image.h"
 
 
 /// Graphics API Reference
 ////// u32 LoadGLTexture(const char* texture);
+////// bool UploadGLTexture(u32 texture_id, const char* texture);
+////// bool UploadGLTextureData(u32 texture_id, const u8* file_data, u64 file_size, const char* texture);
 ////// u32 LoadGLShader(const char* shader);
+////// bool BuildGLShader(u32 program, const char* shader);
+
+// the upload and build functions (re)fill a texture or program that already exists, so whatever holds
+// the gl name keeps working when the file behind it is reloaded
 
 u32 quad_indices[] = { 0, 1, 3, 1, 2, 3 };
 
+// set by a replay, which runs without a window or gl context...textures and shaders load as name 0
+static bool headless_graphics = false;
+
 en::unordered_map<std::string, u32> scene_textures;
 
-u32 LoadGLTexture(const char* texture)
+// the image file's bytes already in memory, read some other way (async io) than UploadGLTexture does
+bool UploadGLTextureData(u32 texture_id, const u8* file_data, u64 file_size, const char* texture)
 {
+  PROFILE_FUNCTION();
   std::string filepath = AssetPath("textures/").append(texture);
 
-  u32 texture_id;
-  glGenTextures(1, &texture_id);
-
   s32 width, height, nr_components;
-  unsigned char* data = stbi_load(filepath.c_str(), &width, &height, &nr_components, 0);
+  unsigned char* data = nullptr;
+  if (file_data) data = stbi_load_from_memory(file_data, (s32)file_size, &width, &height, &nr_components, 0);
   if (data)
   {
     GLenum format;
@@ -50,6 +61,26 @@ u32 LoadGLTexture(const char* texture)
     stbi_image_free(data);
   }
 
+  return data != nullptr;
+}
+
+bool UploadGLTexture(u32 texture_id, const char* texture)
+{
+  MappedFile file;
+  MapAssetFile(AssetPath("textures/").append(texture).c_str(), file);
+  bool uploaded = UploadGLTextureData(texture_id, file.data, file.size, texture);
+  UnmapFile(file);
+  return uploaded;
+}
+
+u32 LoadGLTexture(const char* texture)
+{
+  if (headless_graphics) return 0;
+
+  u32 texture_id;
+  glGenTextures(1, &texture_id);
+  UploadGLTexture(texture_id, texture);
+
   return texture_id;
 }
 
@@ -62,10 +93,12 @@ enum class SHADER_TYPE
 
 en::unordered_map<std::string, u32> scene_shaders;
 
-u32 LoadGLShader(const char* shader)
+// a program that fails to compile is left as it was, so a typo while editing a shader doesn't take it down
+bool BuildGLShader(u32 program, const char* shader)
 {
+  PROFILE_FUNCTION();
   std::string filepath = AssetPath("shaders/").append(shader);
-  std::ifstream stream(filepath);
+  AssetStream stream(filepath);
   std::string line;
   std::stringstream shader_streams[2];
   SHADER_TYPE type = SHADER_TYPE::NONE;
@@ -112,8 +145,9 @@ u32 LoadGLShader(const char* shader)
     glGetShaderInfoLog(vs, 512, nullptr, log_info);
     DebugPrintToConsole("Failed to load shader: ", filepath);
     DebugPrintToConsole(log_info);
+    glDeleteShader(vs);
 
-    return 9999;
+    return false;
   }
 
   u32 fs = glCreateShader(GL_FRAGMENT_SHADER);
@@ -128,11 +162,18 @@ u32 LoadGLShader(const char* shader)
     glGetShaderInfoLog(fs, 512, nullptr, log_info);
     DebugPrintToConsole("Failed to load shader: ", filepath);
     DebugPrintToConsole(log_info);
+    glDeleteShader(vs);
+    glDeleteShader(fs);
 
-    return 9999;
+    return false;
   }
 
-  u32 program = glCreateProgram();
+  // the stages of a previous build were flagged for deletion when it finished, detaching them frees them
+  u32 attached[2];
+  s32 attached_count = 0;
+  glGetAttachedShaders(program, 2, &attached_count, attached);
+  for (s32 i = 0; i < attached_count; i++) glDetachShader(program, attached[i]);
+
   glAttachShader(program, vs);
   glAttachShader(program, fs);
   glLinkProgram(program);
@@ -144,7 +185,7 @@ u32 LoadGLShader(const char* shader)
     DebugPrintToConsole("Failed to load shader: ", filepath);
     DebugPrintToConsole(log_info);
 
-    return 9999;
+    return false;
   }
 
   glUseProgram(program);
@@ -155,5 +196,19 @@ u32 LoadGLShader(const char* shader)
 
   DebugPrintToConsole("Successfully loaded shader: ", filepath);
   
+  return true;
+}
+
+u32 LoadGLShader(const char* shader)
+{
+  if (headless_graphics) return 0;
+
+  u32 program = glCreateProgram();
+  if (!BuildGLShader(program, shader))
+  {
+    glDeleteProgram(program);
+    return 9999;
+  }
+
   return program;
 }
@@ -0,0 +1,303 @@
+#pragma once
+
+#include "Core.h"
+#include "Profiler.h"
+#include "vector.h"
+#include "Assets.h"
+#include "Scene.h"
+#include <chrono>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <cerrno>
+#endif
+
+
+/// Hot Reload API Reference
+////// bool InitFileWatcher(FileWatcher& watcher, const char* root);
+////// void ShutdownFileWatcher(FileWatcher& watcher);
+////// u32 PollFileWatcher(FileWatcher& watcher, en::vector<std::string>& changed, en::vector<u64>* latency_ns);
+////// bool InitHotReload();
+////// void ShutdownHotReload();
+////// void UpdateHotReload();
+
+// watches assets/ and reloads whatever changes on disk while the game runs...a texture, shader or
+// sound is reloaded in place behind its asset, so nothing holding it notices, and a change to the
+// loaded scene's file goes through ReloadScene, which only touches the entities that changed
+
+// editors rarely save in one go (truncate, write, rename a temp file over the old one...), so every
+// file has to stay quiet for HOT_RELOAD_DEBOUNCE_MS before it counts as changed
+
+// on linux the watcher is inotify on the root and each folder directly under it, elsewhere it scans
+// the modification times of the same folders every HOT_RELOAD_SCAN_MS
+
+const u32 HOT_RELOAD_DEBOUNCE_MS = 30;
+const u32 HOT_RELOAD_SCAN_MS = 50;
+const u32 FILE_WATCHER_MAX_DIRS = 32;
+
+struct PendingFileChange
+{
+  std::string path;             // relative to the watched root
+  u64 first_ns;                 // first event of this burst, reload latency is measured from it
+  u64 last_ns;
+};
+
+struct FileWatcher
+{
+  std::string root;
+  std::string dirs[FILE_WATCHER_MAX_DIRS];    // "" for the root itself, "textures/" and so on
+  u32 dir_count = 0;
+  en::vector<PendingFileChange> pending;
+
+#ifdef __linux__
+  s32 fd = -1;
+  s32 watches[FILE_WATCHER_MAX_DIRS];
+#else
+  en::vector<std::string> scanned_paths;
+  en::vector<s64> scanned_times;
+  u64 next_scan_ns = 0;
+#endif
+};
+
+static u64 FileWatcherNow()
+{
+  return (u64)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void NoteFileChange(FileWatcher& watcher, const std::string& path, u64 now)
+{
+  for (auto& change : watcher.pending)
+  {
+    if (change.path == path)
+    {
+      change.last_ns = now;
+      return;
+    }
+  }
+
+  watcher.pending.PushBack({ path, now, now });
+}
+
+#ifdef __linux__
+static bool WatchFileSystem(FileWatcher& watcher)
+{
+  watcher.fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (watcher.fd < 0) return false;
+
+  // a finished write or a file moved into place, which is how most editors save
+  for (u32 d = 0; d < watcher.dir_count; d++)
+  {
+    std::string path = watcher.root + watcher.dirs[d];
+    watcher.watches[d] = inotify_add_watch(watcher.fd, path.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+    if (watcher.watches[d] < 0) DebugPrintToConsole("Failed to watch: ", path);
+  }
+
+  return true;
+}
+
+static void ReadFileSystemEvents(FileWatcher& watcher, u64 now)
+{
+  alignas(inotify_event) char buffer[4096];
+  while (true)
+  {
+    ssize_t bytes = read(watcher.fd, buffer, sizeof(buffer));
+    if (bytes <= 0) break;
+
+    for (char* at = buffer; at < buffer + bytes;)
+    {
+      inotify_event* event = (inotify_event*)at;
+      at += sizeof(inotify_event) + event->len;
+      if (event->len == 0 || (event->mask & IN_ISDIR)) continue;
+
+      for (u32 d = 0; d < watcher.dir_count; d++)
+      {
+        if (watcher.watches[d] != event->wd) continue;
+
+        NoteFileChange(watcher, watcher.dirs[d] + event->name, now);
+        break;
+      }
+    }
+  }
+}
+
+static void StopWatchingFileSystem(FileWatcher& watcher)
+{
+  if (watcher.fd >= 0) close(watcher.fd);
+  watcher.fd = -1;
+}
+#else
+// the first scan only records what is there, everything after compares against it
+static void ScanFileSystem(FileWatcher& watcher, u64 now, bool record_only)
+{
+  std::error_code error;
+  for (u32 d = 0; d < watcher.dir_count; d++)
+  {
+    for (const auto& entry : std::filesystem::directory_iterator(watcher.root + watcher.dirs[d], error))
+    {
+      if (!entry.is_regular_file(error)) continue;
+
+      std::string path = watcher.dirs[d] + entry.path().filename().string();
+      s64 time = (s64)entry.last_write_time(error).time_since_epoch().count();
+
+      s32 known = -1;
+      for (s32 i = 0; i < watcher.scanned_paths.Size(); i++)
+      {
+        if (watcher.scanned_paths[i] == path)
+        {
+          known = i;
+          break;
+        }
+      }
+
+      if (known < 0)
+      {
+        watcher.scanned_paths.PushBack(path);
+        watcher.scanned_times.PushBack(time);
+        if (!record_only) NoteFileChange(watcher, path, now);
+      }
+      else if (watcher.scanned_times[known] != time)
+      {
+        watcher.scanned_times[known] = time;
+        NoteFileChange(watcher, path, now);
+      }
+    }
+  }
+}
+
+static bool WatchFileSystem(FileWatcher& watcher)
+{
+  ScanFileSystem(watcher, FileWatcherNow(), true);
+  return true;
+}
+
+static void ReadFileSystemEvents(FileWatcher& watcher, u64 now)
+{
+  if (now < watcher.next_scan_ns) return;
+
+  watcher.next_scan_ns = now + HOT_RELOAD_SCAN_MS * 1000000ull;
+  ScanFileSystem(watcher, now, false);
+}
+
+static void StopWatchingFileSystem(FileWatcher& /*watcher*/) {}
+#endif
+
+// root needs its trailing slash, the folders directly under it are watched too
+bool InitFileWatcher(FileWatcher& watcher, const char* root)
+{
+  watcher.root = root;
+  watcher.dir_count = 0;
+  watcher.dirs[watcher.dir_count++] = "";
+
+  std::error_code error;
+  for (const auto& entry : std::filesystem::directory_iterator(watcher.root, error))
+  {
+    if (!entry.is_directory(error) || watcher.dir_count == FILE_WATCHER_MAX_DIRS) continue;
+    watcher.dirs[watcher.dir_count++] = entry.path().filename().string() + "/";
+  }
+
+  if (error)
+  {
+    DebugPrintToConsole("Failed to watch: ", watcher.root);
+    return false;
+  }
+
+  return WatchFileSystem(watcher);
+}
+
+void ShutdownFileWatcher(FileWatcher& watcher)
+{
+  StopWatchingFileSystem(watcher);
+  watcher.pending = en::vector<PendingFileChange>();
+}
+
+// hands out the files that changed and have since been quiet for HOT_RELOAD_DEBOUNCE_MS, with how
+// long ago their first change was in latency_ns (optional, same order)
+u32 PollFileWatcher(FileWatcher& watcher, en::vector<std::string>& changed, en::vector<u64>* latency_ns = nullptr)
+{
+  u64 now = FileWatcherNow();
+  ReadFileSystemEvents(watcher, now);
+
+  u32 count = 0;
+  for (s32 i = watcher.pending.Size() - 1; i >= 0; i--)
+  {
+    PendingFileChange& change = watcher.pending[i];
+    if (now - change.last_ns < HOT_RELOAD_DEBOUNCE_MS * 1000000ull) continue;
+
+    changed.PushBack(change.path);
+    if (latency_ns) latency_ns->PushBack(now - change.first_ns);
+    count++;
+
+    watcher.pending[i] = watcher.pending[watcher.pending.Size() - 1];
+    watcher.pending.PopBack();
+  }
+
+  return count;
+}
+
+static struct
+{
+  FileWatcher watcher;
+  bool running = false;
+
+  struct
+  {
+    u32 reloads = 0;
+    f64 last_ms = 0.0;      // first change on disk to reloaded, for the last reload
+  } stats;
+} hot_reload;
+
+bool InitHotReload()
+{
+  hot_reload.running = InitFileWatcher(hot_reload.watcher, AssetPath("").c_str());
+  return hot_reload.running;
+}
+
+void ShutdownHotReload()
+{
+  if (hot_reload.running) ShutdownFileWatcher(hot_reload.watcher);
+  hot_reload.running = false;
+}
+
+// main thread, once a frame...a reload lands on screen the frame it happens
+void UpdateHotReload()
+{
+  if (!hot_reload.running) return;
+
+  PROFILE_FUNCTION();
+
+  en::vector<std::string> changed;
+  en::vector<u64> latency_ns;
+  if (PollFileWatcher(hot_reload.watcher, changed, &latency_ns) == 0) return;
+
+  for (s32 i = 0; i < changed.Size(); i++)
+  {
+    const std::string& path = changed[i];
+    auto slash = path.find('/');
+    if (slash == std::string::npos) continue;
+
+    std::string dir = path.substr(0, slash + 1);
+    std::string name = path.substr(slash + 1);
+    u64 start = FileWatcherNow();
+
+    bool reloaded = false;
+    if (dir == "textures/") reloaded = ReloadAsset(ASSET_TYPE::TEXTURE, name.c_str());
+    else if (dir == "shaders/") reloaded = ReloadAsset(ASSET_TYPE::SHADER, name.c_str());
+    else if (dir == "audio/") reloaded = ReloadAsset(ASSET_TYPE::SOUND, name.c_str());
+    else if (dir == "scenes/" && name == LoadedScenePath())
+    {
+      ReloadScene();
+      reloaded = true;
+    }
+
+    if (!reloaded) continue;
+
+    hot_reload.stats.reloads++;
+    hot_reload.stats.last_ms = (latency_ns[i] + FileWatcherNow() - start) / 1e6;
+
+    char summary[256];
+    snprintf(summary, sizeof(summary), "%s (%.1f ms after the change)", path.c_str(), hot_reload.stats.last_ms);
+    DebugPrintToConsole("Hot reloaded: ", summary);
+  }
+}
@@ -1,127 +1,366 @@
 #pragma once
 
 #include "Core.h"
+#include "Profiler.h"
 #include "Entity.h"
-#include "unordered_map.h"
 #include "glfw/glfw3.h"
-#include "Scene.h"
+#include "Simulation.h"
+#include "InputRecording.h"
+#include <functional>
 
 
+/// Input API Reference
+////// s32 CreateInputAction(const char* name);
+////// bool BindInput(s32 action, s32 input_code);
+////// bool OnInputAction(s32 action, BUTTON_ACTION edge, InputCallback callback);
+////// void PushInputEvent(s32 input_code, bool down, u64 timestamp_ns);
+////// void PollGamepads();
+////// void ProcessInputTick();
+////// bool IsInputDown(s32 input_code);
+////// bool IsActionDown(s32 action);
+////// bool WasActionPressed(s32 action);
+////// bool WasActionReleased(s32 action);
+////// s32 InputMouseButton(s32 button);
+////// s32 InputGamepadButton(s32 joystick, s32 button);
+
+// every key, mouse button and gamepad button gets a slot in one flat input code table, keys use
+// their GLFW key code directly and mouse/gamepad buttons are offset past GLFW_KEY_LAST
+
+// game code binds any number of input codes to an action and registers callbacks on the action's
+// edges...PRESS fires once when the first bound input goes down, HOLD fires every frame while any
+// bound input is down and RELEASE fires once when the last one comes back up
+
+// callbacks are std::function so lambdas can capture whatever context they need
+
+// the GLFW callbacks never touch game state, they push timestamped events into a queue that the
+// simulation drains one fixed tick at a time (see Simulation.h)...that is also the only place
+// events get recorded, so a replay feeds the exact same transitions into the exact same ticks
+
 enum class BUTTON_ACTION
 {
   PRESS,
-  HOLD
+  HOLD,
+  RELEASE
 };
 
-// the user input system currently supports functions that return void with no params and
-// functions that require a GLFWwindow* passed to them and return void
+using InputCallback = std::function<void()>;
+
+const s32 INPUT_KEY_COUNT = GLFW_KEY_LAST + 1;
+const s32 INPUT_MOUSE_BASE = INPUT_KEY_COUNT;
+const s32 INPUT_MOUSE_COUNT = GLFW_MOUSE_BUTTON_LAST + 1;
+const s32 INPUT_GAMEPAD_BASE = INPUT_MOUSE_BASE + INPUT_MOUSE_COUNT;
+const s32 INPUT_GAMEPAD_BUTTONS = GLFW_GAMEPAD_BUTTON_LAST + 1;
+const s32 INPUT_GAMEPAD_COUNT = GLFW_JOYSTICK_LAST + 1;
+const s32 INPUT_CODE_COUNT = INPUT_GAMEPAD_BASE + INPUT_GAMEPAD_COUNT * INPUT_GAMEPAD_BUTTONS;
+
+const s32 MAX_INPUT_ACTIONS = 128;
+const s32 MAX_ACTIONS_PER_INPUT = 4;
+const s32 MAX_CALLBACKS_PER_EDGE = 4;
+const s32 MAX_INPUT_EVENTS_PER_FRAME = 256;
+const u32 INPUT_EVENT_QUEUE_SIZE = 1024;
 
-// lambdas that do not capture or require params are also supported
+static inline s32 InputMouseButton(s32 button)
+{
+  return INPUT_MOUSE_BASE + button;
+}
 
-// currently data can only be modified if it is in global scope
+static inline s32 InputGamepadButton(s32 joystick, s32 button)
+{
+  return INPUT_GAMEPAD_BASE + joystick * INPUT_GAMEPAD_BUTTONS + button;
+}
 
-using InputFunc = void(*)(void);
-using GLFWInputFunc = void(*)(GLFWwindow*);   // this is used ONLY when setting up input for a function
-                                              // that requires a GLFWwindow* to be passed to it
+struct InputEvent
+{
+  u64 timestamp_ns;
+  s32 input_code;
+  bool down;
+};
 
-struct FuncInfo
+struct InputActionInfo
 {
-  InputFunc func;
-  BUTTON_ACTION action;
+  const char* name = "";
+  s32 held_count = 0;                 // how many bound inputs are currently down
+  bool pressed = false;               // edges from the last tick
+  bool released = false;
+  InputCallback callbacks[3][MAX_CALLBACKS_PER_EDGE];
+  s32 callback_count[3] = {};
 };
 
 static struct
 {
-  en::unordered_map<s32, FuncInfo> _InputFuncs = {};
-} input_wrapper;
+  u8 current[INPUT_CODE_COUNT] = {};                // written as queued events are consumed
+  u8 previous[INPUT_CODE_COUNT] = {};               // state at the end of the last tick
+
+  s16 bound_actions[INPUT_CODE_COUNT][MAX_ACTIONS_PER_INPUT];
+  u8 bound_action_count[INPUT_CODE_COUNT] = {};
+
+  InputActionInfo actions[MAX_INPUT_ACTIONS];
+  s32 action_count = 0;
+
+  s32 hold_actions[MAX_INPUT_ACTIONS];              // only actions with HOLD callbacks get visited every frame
+  s32 hold_action_count = 0;
+
+  InputEvent queue[INPUT_EVENT_QUEUE_SIZE];         // waiting for the tick that covers their timestamp
+  u32 queue_head = 0;
+  u32 queue_tail = 0;
+  u64 dropped_events = 0;
+
+  u8 gamepad_polled[INPUT_GAMEPAD_COUNT * INPUT_GAMEPAD_BUTTONS] = {};
+
+  s32 changed[MAX_INPUT_EVENTS_PER_FRAME];          // (input code << 1) | down, for every transition since the last tick
+  s32 changed_count = 0;
+  bool changed_overflow = false;
+
+  s32 edge_actions[2 * MAX_INPUT_ACTIONS];          // actions whose pressed/released flags need clearing
+  s32 edge_action_count = 0;
+
+} input;
+
+s32 CreateInputAction(const char* name)
+{
+  if (input.action_count >= MAX_INPUT_ACTIONS)
+  {
+    DebugPrintToConsole("Too many input actions, could not create: ", name);
+    return -1;
+  }
+
+  s32 action = input.action_count++;
+  input.actions[action].name = name;
+  return action;
+}
+
+bool BindInput(s32 action, s32 input_code)
+{
+  if (action < 0 || action >= input.action_count || input_code < 0 || input_code >= INPUT_CODE_COUNT)
+  {
+    DebugPrintToConsole("Invalid input binding!");
+    return false;
+  }
+
+  u8& count = input.bound_action_count[input_code];
+  for (s32 i = 0; i < count; i++)
+  {
+    if (input.bound_actions[input_code][i] == action) return true;
+  }
+
+  if (count >= MAX_ACTIONS_PER_INPUT)
+  {
+    DebugPrintToConsole("Too many actions bound to input code: ", input_code);
+    return false;
+  }
+
+  input.bound_actions[input_code][count++] = (s16)action;
+  if (input.current[input_code]) input.actions[action].held_count++;
+
+  return true;
+}
+
+bool OnInputAction(s32 action, BUTTON_ACTION edge, InputCallback callback)
+{
+  if (action < 0 || action >= input.action_count || !callback)
+  {
+    DebugPrintToConsole("Invalid input callback!");
+    return false;
+  }
+
+  InputActionInfo& info = input.actions[action];
+  s32& count = info.callback_count[(s32)edge];
+  if (count >= MAX_CALLBACKS_PER_EDGE)
+  {
+    DebugPrintToConsole("Too many callbacks on input action: ", info.name);
+    return false;
+  }
+
+  if (edge == BUTTON_ACTION::HOLD && count == 0)
+  {
+    input.hold_actions[input.hold_action_count++] = action;
+  }
+
+  info.callbacks[(s32)edge][count++] = callback;
+  return true;
+}
 
-void SetKeyboardInput(InputFunc func, s32 button, BUTTON_ACTION action)
+static inline void SetInputState(s32 input_code, bool down)
 {
-  FuncInfo f;
-  f.func = func;
-  f.action = action;
+  if (input_code < 0 || input_code >= INPUT_CODE_COUNT) return;
+  if (input.current[input_code] == (u8)down) return;
 
-  if (input_wrapper._InputFuncs.Find(button) == false)
+  input.current[input_code] = (u8)down;
+  if (input.changed_count < MAX_INPUT_EVENTS_PER_FRAME)
   {
-    input_wrapper._InputFuncs.Insert(button, f);
+    input.changed[input.changed_count++] = (input_code << 1) | (down ? 1 : 0);
   }
   else
   {
-    input_wrapper._InputFuncs.At(button) = f;
+    input.changed_overflow = true;
   }
 }
 
-s32 possible_keybindings[] = 
+void PushInputEvent(s32 input_code, bool down, u64 timestamp_ns)
 {
-  GLFW_KEY_SPACE,
-  GLFW_KEY_A,
-  GLFW_KEY_D,
-  GLFW_KEY_S,
-  GLFW_KEY_W,
-  GLFW_KEY_ESCAPE
-};
+  if (input_code < 0 || input_code >= INPUT_CODE_COUNT) return;
+
+  if (input.queue_tail - input.queue_head >= INPUT_EVENT_QUEUE_SIZE)
+  {
+    input.dropped_events++;
+    return;
+  }
 
-void ProcessKeyboardInput(GLFWwindow* window)
+  input.queue[input.queue_tail % INPUT_EVENT_QUEUE_SIZE] = { timestamp_ns, input_code, down };
+  input.queue_tail++;
+}
+
+static inline bool IsInputDown(s32 input_code)
+{
+  return input_code >= 0 && input_code < INPUT_CODE_COUNT && input.current[input_code];
+}
+
+static inline bool IsActionDown(s32 action)
+{
+  return input.actions[action].held_count > 0;
+}
+
+static inline bool WasActionPressed(s32 action)
+{
+  return input.actions[action].pressed;
+}
+
+static inline bool WasActionReleased(s32 action)
+{
+  return input.actions[action].released;
+}
+
+// gamepads have no button callback in GLFW, so they are polled once per frame and turned into events
+void PollGamepads()
 {
-  for (s32 i = 0; i < (sizeof(possible_keybindings) / sizeof(possible_keybindings[0])); i++)
+  GLFWgamepadstate state;
+  u64 now_ns = SimulationNow();
+
+  for (s32 jid = 0; jid < INPUT_GAMEPAD_COUNT; jid++)
   {
-    if (glfwGetKey(window, possible_keybindings[i]) == GLFW_PRESS && input_wrapper._InputFuncs.At(possible_keybindings[i]).action == BUTTON_ACTION::HOLD)
+    if (!glfwJoystickIsGamepad(jid) || !glfwGetGamepadState(jid, &state)) continue;
+
+    for (s32 b = 0; b < INPUT_GAMEPAD_BUTTONS; b++)
     {
-        if (!input_wrapper._InputFuncs.At(possible_keybindings[i]).func)
-        {
-            DebugPrintToConsole("Empty function!");
-        }
-        else
-        {
-            input_wrapper._InputFuncs.At(possible_keybindings[i]).func();
-        }
+      u8 down = state.buttons[b] == GLFW_PRESS;
+      u8& polled = input.gamepad_polled[jid * INPUT_GAMEPAD_BUTTONS + b];
+      if (polled == down) continue;
+
+      polled = down;
+      PushInputEvent(InputGamepadButton(jid, b), down != 0, now_ns);
     }
   }
 }
 
-void KeyCallback(GLFWwindow* window, s32 key, s32 scancode, s32 action, s32 mods)
+static void FireInputCallbacks(InputActionInfo& info, BUTTON_ACTION edge)
+{
+  s32 count = info.callback_count[(s32)edge];
+  for (s32 i = 0; i < count; i++)
+  {
+    info.callbacks[(s32)edge][i]();
+  }
+}
+
+static inline void MarkActionEdge(s32 action)
+{
+  if (input.edge_action_count < 2 * MAX_INPUT_ACTIONS) input.edge_actions[input.edge_action_count++] = action;
+}
+
+// transitions are applied in the order they happened so a tap shorter than a frame still fires PRESS and RELEASE
+static void ApplyInputChange(s32 input_code, bool down)
 {
-  for (s32 i = 0; i < (sizeof(possible_keybindings) / sizeof(possible_keybindings[0])); i++)
+  if (down == (input.previous[input_code] != 0)) return;
+  input.previous[input_code] = (u8)down;
+
+  for (s32 i = 0; i < input.bound_action_count[input_code]; i++)
   {
-    if (key == possible_keybindings[i] && action == GLFW_PRESS)
+    s32 action = input.bound_actions[input_code][i];
+    InputActionInfo& info = input.actions[action];
+
+    info.held_count += down ? 1 : -1;
+    if (down && info.held_count == 1)
+    {
+      info.pressed = true;
+      MarkActionEdge(action);
+      FireInputCallbacks(info, BUTTON_ACTION::PRESS);
+    }
+    else if (!down && info.held_count == 0)
     {
-      if (input_wrapper._InputFuncs.At(key).action == BUTTON_ACTION::PRESS)
-      {
-        try
-        {
-          input_wrapper._InputFuncs.At(key).func();
-        }
-        catch (const std::exception&)
-        {
-            return;
-        }
-      }
+      info.released = true;
+      MarkActionEdge(action);
+      FireInputCallbacks(info, BUTTON_ACTION::RELEASE);
     }
   }
 }
 
-void MouseButtonCallback(GLFWwindow* window, s32 button, s32 action, s32 mods)
+// call at the start of every simulation tick, consumes the queued events that happened before the
+// end of the tick...only the inputs that changed and the actions with HOLD callbacks are visited
+// so the cost doesn't depend on how many codes exist
+void ProcessInputTick()
 {
-  if (button == GLFW_MOUSE_BUTTON_LEFT && action == GLFW_PRESS)
+  PROFILE_FUNCTION();
+
+  for (s32 i = 0; i < input.edge_action_count; i++)
+  {
+    input.actions[input.edge_actions[i]].pressed = false;
+    input.actions[input.edge_actions[i]].released = false;
+  }
+  input.edge_action_count = 0;
+
+  u64 tick_end_ns = simulation.time_ns + SIMULATION_TICK_NS;
+  while (input.queue_head != input.queue_tail)
+  {
+    InputEvent& e = input.queue[input.queue_head % INPUT_EVENT_QUEUE_SIZE];
+    if (e.timestamp_ns >= tick_end_ns) break;
+
+    if (input_recording.recording) RecordInputEvent(simulation.tick, e.input_code, e.down);
+    SetInputState(e.input_code, e.down);
+    input.queue_head++;
+  }
+
+  if (input.changed_overflow)
+  {
+    for (s32 code = 0; code < INPUT_CODE_COUNT; code++)
+    {
+      ApplyInputChange(code, input.current[code] != 0);
+    }
+  }
+  else
   {
-    f64 mouse_x, mouse_y;
-    glfwGetCursorPos(window, &mouse_x, &mouse_y);
+    for (s32 i = 0; i < input.changed_count; i++)
+    {
+      ApplyInputChange(input.changed[i] >> 1, (input.changed[i] & 1) != 0);
+    }
+  }
+
+  input.changed_count = 0;
+  input.changed_overflow = false;
 
-    mouse_x = 2.0 * (mouse_x / (f64)window_width) - 1.0;
-    mouse_y = 2.0 * (1.0 - (mouse_y / (f64)window_height)) - 1.0;
+  for (s32 i = 0; i < input.hold_action_count; i++)
+  {
+    InputActionInfo& info = input.actions[input.hold_actions[i]];
+    if (info.held_count > 0) FireInputCallbacks(info, BUTTON_ACTION::HOLD);
   }
 }
 
-void FramebufferSizeCallback(GLFWwindow* window, s32 width, s32 height)
+void KeyCallback(GLFWwindow* /*window*/, s32 key, s32 /*scancode*/, s32 action, s32 /*mods*/)
+{
+  if (action == GLFW_REPEAT) return;
+  PushInputEvent(key, action == GLFW_PRESS, SimulationNow());
+}
+
+void MouseButtonCallback(GLFWwindow* /*window*/, s32 button, s32 action, s32 /*mods*/)
+{
+  if (button < 0 || button >= INPUT_MOUSE_COUNT) return;
+  PushInputEvent(InputMouseButton(button), action == GLFW_PRESS, SimulationNow());
+}
+
+// whoever registers this rescales what depends on the aspect ratio afterwards, input doesn't know about the scene
+void FramebufferSizeCallback(GLFWwindow* /*window*/, s32 width, s32 height)
 {
   window_width = width;
   window_height = height;
   aspect_ratio = (f32)window_width / (f32)window_height;
 
-  for (s32 i = 0; i < entities.Size(); i++)
-  {
-    entities[i].scale = vec2(original_scales[i].x(), original_scales[i].y() * aspect_ratio);
-  }
-
   glViewport(0, 0, width, height);
 }
@@ -0,0 +1,189 @@
+#pragma once
+
+#include "Core.h"
+#include "vector.h"
+#include "Simulation.h"
+
+
+/// Input Recording API Reference
+////// void StartInputRecording(const char* path, u64 seed);
+////// void RecordInputEvent(u64 tick, s32 input_code, bool down);
+////// bool StopInputRecording();
+////// bool LoadInputRecording(const char* path, InputSession& session);
+
+// a recording is every input transition tagged with the simulation tick that consumed it, plus the
+// rng seed...replaying those transitions on the same ticks reproduces the session exactly
+
+// file layout (little endian):
+//   header  : "ENIR", u16 version, u16 tick rate, u64 seed, u64 tick count, u32 event count
+//   events  : varint tick delta from the previous event, u16 input code with the down flag in bit 15
+
+const u16 INPUT_RECORDING_VERSION = 1;
+const u64 INPUT_RECORDING_HEADER_BYTES = 4 + 2 + 2 + 8 + 8 + 4;
+const u64 INPUT_RECORDING_MIN_EVENT_BYTES = 3;
+const u64 INPUT_RECORDING_MAX_TICKS = (u64)SIMULATION_TICK_HZ * 60 * 60 * 24;   // a day
+
+struct RecordedInputEvent
+{
+  u64 tick;
+  u16 input_code;
+  bool down;
+};
+
+struct InputSession
+{
+  u64 seed = 0;
+  u64 tick_count = 0;
+  u16 tick_hz = 0;
+  en::vector<RecordedInputEvent> events;
+};
+
+static struct
+{
+  bool recording = false;
+  std::string path;
+  u64 first_tick = 0;
+  InputSession session;
+} input_recording;
+
+void StartInputRecording(const char* path, u64 seed)
+{
+  input_recording.recording = true;
+  input_recording.path = path;
+  input_recording.first_tick = simulation.tick;
+  input_recording.session = InputSession();
+  input_recording.session.seed = seed;
+  input_recording.session.tick_hz = SIMULATION_TICK_HZ;
+}
+
+void RecordInputEvent(u64 tick, s32 input_code, bool down)
+{
+  input_recording.session.events.PushBack({ tick - input_recording.first_tick, (u16)input_code, down });
+}
+
+static void WriteVarint(std::ofstream& stream, u64 value)
+{
+  while (value >= 0x80)
+  {
+    stream.put((char)(value | 0x80));
+    value >>= 7;
+  }
+  stream.put((char)value);
+}
+
+static bool ReadVarint(std::ifstream& stream, u64& value)
+{
+  value = 0;
+  for (s32 shift = 0; shift < 64; shift += 7)
+  {
+    s32 byte = stream.get();
+    if (byte == EOF) return false;
+
+    value |= (u64)(byte & 0x7F) << shift;
+    if (!(byte & 0x80)) return true;
+  }
+
+  return false;
+}
+
+template <typename T>
+static void WritePOD(std::ofstream& stream, const T& value)
+{
+  stream.write((const char*)&value, sizeof(T));
+}
+
+template <typename T>
+static bool ReadPOD(std::ifstream& stream, T& value)
+{
+  return (bool)stream.read((char*)&value, sizeof(T));
+}
+
+bool StopInputRecording()
+{
+  if (!input_recording.recording) return false;
+  input_recording.recording = false;
+
+  InputSession& session = input_recording.session;
+  session.tick_count = simulation.tick - input_recording.first_tick;
+
+  std::ofstream stream(input_recording.path, std::ios::binary);
+  if (!stream.is_open())
+  {
+    DebugPrintToConsole("Failed to write input recording: ", input_recording.path);
+    return false;
+  }
+
+  u32 event_count = (u32)session.events.Size();
+  stream.write("ENIR", 4);
+  WritePOD(stream, INPUT_RECORDING_VERSION);
+  WritePOD(stream, session.tick_hz);
+  WritePOD(stream, session.seed);
+  WritePOD(stream, session.tick_count);
+  WritePOD(stream, event_count);
+
+  u64 last_tick = 0;
+  for (auto& e : session.events)
+  {
+    WriteVarint(stream, e.tick - last_tick);
+    WritePOD(stream, (u16)(e.input_code | (e.down ? 0x8000 : 0)));
+    last_tick = e.tick;
+  }
+
+  DebugPrintToConsole("Wrote input recording: ", input_recording.path, " (", session.tick_count, " ticks, ", event_count, " events)");
+  return true;
+}
+
+bool LoadInputRecording(const char* path, InputSession& session)
+{
+  std::ifstream stream(path, std::ios::binary);
+  char magic[4];
+  u16 version = 0;
+  u32 event_count = 0;
+
+  if (!stream.is_open() || !stream.read(magic, 4) || memcmp(magic, "ENIR", 4) != 0)
+  {
+    DebugPrintToConsole("Not an input recording: ", path);
+    return false;
+  }
+
+  if (!ReadPOD(stream, version) || version != INPUT_RECORDING_VERSION || !ReadPOD(stream, session.tick_hz) ||
+      !ReadPOD(stream, session.seed) || !ReadPOD(stream, session.tick_count) || !ReadPOD(stream, event_count))
+  {
+    DebugPrintToConsole("Unsupported input recording: ", path);
+    return false;
+  }
+
+  // the counts come from the file, anything they'd have us allocate has to fit in it first
+  stream.seekg(0, std::ios::end);
+  u64 file_bytes = (u64)stream.tellg();
+  stream.seekg(INPUT_RECORDING_HEADER_BYTES);
+  if (session.tick_count > INPUT_RECORDING_MAX_TICKS || event_count > (file_bytes - INPUT_RECORDING_HEADER_BYTES) / INPUT_RECORDING_MIN_EVENT_BYTES)
+  {
+    DebugPrintToConsole("Corrupt input recording: ", path);
+    return false;
+  }
+
+  u64 tick = 0;
+  for (u32 i = 0; i < event_count; i++)
+  {
+    u64 delta;
+    u16 packed;
+    if (!ReadVarint(stream, delta) || !ReadPOD(stream, packed))
+    {
+      DebugPrintToConsole("Truncated input recording: ", path);
+      return false;
+    }
+
+    // every event was consumed by one of the recorded ticks
+    if (delta >= session.tick_count - tick)
+    {
+      DebugPrintToConsole("Corrupt input recording: ", path);
+      return false;
+    }
+
+    tick += delta;
+    session.events.PushBack({ tick, (u16)(packed & 0x7FFF), (packed & 0x8000) != 0 });
+  }
+
+  return true;
+}
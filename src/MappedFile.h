@@ -0,0 +1,93 @@
+#pragma once
+
+#include "Core.h"
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+
+/// Mapped File API Reference
+////// bool MapFile(const char* path, MappedFile& file);
+////// void UnmapFile(MappedFile& file);
+
+// read only view of a whole file...the pages come from the os file cache as they are touched, so
+// mapping is about as cheap as opening the file and nothing is copied onto the heap
+
+// the view keeps the file open by itself, so the handles are closed as soon as it exists
+// a borrowed view isn't a file of its own, it points into some other mapping (an asset pack's) or
+// at memory someone else owns...unmapping it calls release when there is one and otherwise just
+// forgets it
+struct MappedFile;
+using MappedFileRelease = void(*)(const MappedFile& file);
+
+struct MappedFile
+{
+  const u8* data = nullptr;
+  u64 size = 0;
+  bool borrowed = false;
+  MappedFileRelease release = nullptr;
+};
+
+void UnmapFile(MappedFile& file)
+{
+  if (file.release) file.release(file);
+#ifdef _WIN32
+  else if (file.data && !file.borrowed) UnmapViewOfFile(file.data);
+#else
+  else if (file.data && !file.borrowed) munmap((void*)file.data, (size_t)file.size);
+#endif
+
+  file = MappedFile();
+}
+
+bool MapFile(const char* path, MappedFile& file)
+{
+  file = MappedFile();
+
+#ifdef _WIN32
+  HANDLE handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (handle == INVALID_HANDLE_VALUE) return false;
+
+  LARGE_INTEGER size;
+  HANDLE mapping = nullptr;
+  if (GetFileSizeEx(handle, &size) && size.QuadPart > 0) mapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (mapping)
+  {
+    file.data = (const u8*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    file.size = file.data ? (u64)size.QuadPart : 0;
+    CloseHandle(mapping);
+  }
+
+  CloseHandle(handle);
+#else
+  s32 fd = open(path, O_RDONLY);
+  if (fd < 0) return false;
+
+  struct stat info;
+  if (fstat(fd, &info) == 0 && info.st_size > 0)
+  {
+    void* view = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (view != MAP_FAILED)
+    {
+      file.data = (const u8*)view;
+      file.size = (u64)info.st_size;
+    }
+  }
+
+  close(fd);
+#endif
+
+  return file.data != nullptr;
+}
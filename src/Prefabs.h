@@ -0,0 +1,159 @@
+#pragma once
+
+#include "Core.h"
+#include "Profiler.h"
+#include "vector.h"
+#include "ECS.h"
+
+
+/// Prefab API Reference
+////// s32 DefinePrefab(const char* name, Sprite sprite, vec2 scale, f32 angle);
+////// s32 FindPrefab(const char* name);
+////// Entity SpawnPrefab(s32 prefab, vec2 position);
+////// void SpawnPrefabs(s32 prefab, s32 count, const vec2* positions, Entity* entities);
+////// void OverridePrefabSprite(Entity entity, Sprite sprite);
+////// void OverridePrefabScale(Entity entity, vec2 scale);
+////// void RevertPrefabOverrides(Entity entity);
+////// Sprite EntitySprite(Entity entity);
+////// vec2 EntityBaseScale(Entity entity);
+////// void ClearPrefabs();
+
+// a prefab is a named template holding what its instances have in common, their sprite (texture,
+// shader and the shared quad), base scale and starting angle, once...an instance is a Transform and
+// a PrefabInstance naming its prefab, 4 bytes on top of what it can't share
+
+// overriding the sprite or scale of one instance gives it its own Sprite or BaseScale component, which
+// wins over the prefab's, so memory goes up with the overrides and not with the instances. redefining
+// a prefab changes every instance that hasn't overridden what changed
+
+static struct
+{
+  // one entry per prefab, ids stay put for good
+  en::vector<std::string> name;
+  en::vector<Sprite> sprite;
+  en::vector<BaseScale> scale;
+  en::vector<f32> angle;
+} prefabs;
+
+s32 FindPrefab(const char* name)
+{
+  for (s32 p = 0; p < prefabs.name.Size(); p++)
+  {
+    if (prefabs.name[p] == name) return p;
+  }
+
+  return -1;
+}
+
+// an instance can name a prefab that was never defined or was cleared since, those draw nothing and
+// keep whatever scale they have
+static inline bool IsPrefab(s32 prefab)
+{
+  return prefab >= 0 && prefab < prefabs.name.Size();
+}
+
+// defining a name that is already there replaces its data and keeps its id
+s32 DefinePrefab(const char* name, Sprite sprite, vec2 scale, f32 angle)
+{
+  s32 p = FindPrefab(name);
+  if (p < 0)
+  {
+    p = prefabs.name.Size();
+    prefabs.name.PushBack(name);
+    prefabs.sprite.PushBack(sprite);
+    prefabs.scale.PushBack(BaseScale());
+    prefabs.angle.PushBack(angle);
+  }
+
+  prefabs.sprite[p] = sprite;
+  prefabs.scale[p].scale = scale;
+  prefabs.angle[p] = angle;
+  return p;
+}
+
+static inline void StartPrefabInstance(Entity entity, s32 prefab, vec2 position)
+{
+  Transform* transform = GetComponent<Transform>(entity, COMPONENT::TRANSFORM);
+  transform->position = position;
+  transform->angle = prefabs.angle[prefab];
+  transform->scale = vec2(prefabs.scale[prefab].scale.x(), prefabs.scale[prefab].scale.y() * aspect_ratio);
+  GetComponent<PrefabInstance>(entity, COMPONENT::PREFAB)->prefab = prefab;
+}
+
+Entity SpawnPrefab(s32 prefab, vec2 position)
+{
+  if (!IsPrefab(prefab)) return Entity();
+
+  Entity entity = CreateEntity(ComponentBit(COMPONENT::TRANSFORM) | ComponentBit(COMPONENT::PREFAB));
+  StartPrefabInstance(entity, prefab, position);
+  return entity;
+}
+
+// count instances in one go, entities gets them in the same order as positions
+void SpawnPrefabs(s32 prefab, s32 count, const vec2* positions, Entity* entities)
+{
+  if (!IsPrefab(prefab)) return;
+
+  PROFILE_FUNCTION();
+  CreateEntities(ComponentBit(COMPONENT::TRANSFORM) | ComponentBit(COMPONENT::PREFAB), count, entities);
+  for (s32 i = 0; i < count; i++) StartPrefabInstance(entities[i], prefab, positions[i]);
+}
+
+void OverridePrefabSprite(Entity entity, Sprite sprite)
+{
+  AddComponent(entity, COMPONENT::SPRITE);
+  Sprite* own = GetComponent<Sprite>(entity, COMPONENT::SPRITE);
+  if (own) *own = sprite;
+}
+
+// the Transform follows straight away, unless the entity is in the scene graph which scales it itself
+void OverridePrefabScale(Entity entity, vec2 scale)
+{
+  AddComponent(entity, COMPONENT::BASE_SCALE);
+  BaseScale* own = GetComponent<BaseScale>(entity, COMPONENT::BASE_SCALE);
+  if (!own) return;
+
+  own->scale = scale;
+  if (!HasComponent(entity, COMPONENT::SCENE_NODE)) GetComponent<Transform>(entity, COMPONENT::TRANSFORM)->scale = vec2(scale.x(), scale.y() * aspect_ratio);
+}
+
+// back to whatever the prefab says
+void RevertPrefabOverrides(Entity entity)
+{
+  PrefabInstance* instance = GetComponent<PrefabInstance>(entity, COMPONENT::PREFAB);
+  if (!instance) return;
+
+  RemoveComponent(entity, COMPONENT::SPRITE);
+  RemoveComponent(entity, COMPONENT::BASE_SCALE);
+  if (!IsPrefab(instance->prefab)) return;
+
+  vec2 scale = prefabs.scale[instance->prefab].scale;
+  if (!HasComponent(entity, COMPONENT::SCENE_NODE)) GetComponent<Transform>(entity, COMPONENT::TRANSFORM)->scale = vec2(scale.x(), scale.y() * aspect_ratio);
+}
+
+// the entity's own sprite if it has one, otherwise its prefab's
+Sprite EntitySprite(Entity entity)
+{
+  if (Sprite* own = GetComponent<Sprite>(entity, COMPONENT::SPRITE)) return *own;
+  PrefabInstance* instance = GetComponent<PrefabInstance>(entity, COMPONENT::PREFAB);
+  if (instance && IsPrefab(instance->prefab)) return prefabs.sprite[instance->prefab];
+  return Sprite();
+}
+
+vec2 EntityBaseScale(Entity entity)
+{
+  if (BaseScale* own = GetComponent<BaseScale>(entity, COMPONENT::BASE_SCALE)) return own->scale;
+  PrefabInstance* instance = GetComponent<PrefabInstance>(entity, COMPONENT::PREFAB);
+  if (instance && IsPrefab(instance->prefab)) return prefabs.scale[instance->prefab].scale;
+  return vec2(1.f, 1.f);
+}
+
+// instances left alive keep pointing at ids that no longer exist and stop drawing until they are
+// given one again
+void ClearPrefabs()
+{
+  prefabs.name.Clear();
+  prefabs.sprite.Clear();
+  prefabs.scale.Clear();
+  prefabs.angle.Clear();
+}
@@ -0,0 +1,403 @@
+#pragma once
+
+#include "Core.h"
+#include "imgui/imgui.h"
+#include <atomic>
+#include <chrono>
+
+
+/// Profiler API Reference
+////// PROFILE_SCOPE(name);                          // times the enclosing scope, name must be a string literal
+////// PROFILE_FUNCTION();
+////// void ProfilerSetThreadName(const char* name);
+////// void ProfilerBeginFrame();
+////// void ProfilerEndFrame();
+////// void ProfilerStartCapture();
+////// void ProfilerStopCapture();
+////// bool ExportChromeTrace(const char* path);
+////// void DrawProfilerWindow(bool* open);
+
+// zones only exist when EN_PROFILE is defined (cmake -DENGINE_PROFILE=ON), otherwise every macro
+// expands to nothing and the api functions are empty so call sites don't need their own #ifdefs
+
+// each thread records finished zones into its own ring buffer, the main thread drains all of the
+// rings once per frame in ProfilerEndFrame...the writer and reader only share two atomic indices.
+// a buffer is filled in, name included, before its pointer is published, so name a thread before
+// its first zone. threads past PROFILER_MAX_THREADS get no buffer and their zones are only counted
+
+const u32 PROFILER_RING_SIZE = 1 << 14;            // zones per thread between two drains
+const u32 PROFILER_MAX_THREADS = 64;
+const u32 PROFILER_MAX_FRAME_ZONES = 1 << 15;
+const u32 PROFILER_MAX_CAPTURE_ZONES = 1 << 22;   // ~128MB of zones, roughly a minute of a busy frame
+
+struct ProfileZone
+{
+  const char* name;
+  u64 start_ns;
+  u64 end_ns;
+  u32 depth;
+  u32 thread_id;
+};
+
+static inline u64 ProfilerNow()
+{
+  static const auto origin = std::chrono::steady_clock::now();
+  return (u64)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - origin).count();
+}
+
+#ifdef EN_PROFILE
+
+struct ProfilerThreadBuffer
+{
+  ProfileZone zones[PROFILER_RING_SIZE];
+  std::atomic<u64> write_index{ 0 };
+  std::atomic<u64> read_index{ 0 };
+  u64 dropped = 0;
+  u32 thread_id = 0;
+  u32 depth = 0;
+  char name[32] = {};
+};
+
+static struct
+{
+  std::atomic<ProfilerThreadBuffer*> threads[PROFILER_MAX_THREADS] = {};
+  std::atomic<u32> thread_count{ 0 };
+  std::atomic<u64> overflow_zones{ 0 };        // recorded by threads that didn't get a buffer
+
+  ProfileZone* frame_zones = nullptr;          // everything drained during the last frame
+  u32 frame_zone_count = 0;
+  ProfileZone* view_zones = nullptr;           // what the flame graph draws, frozen while paused
+  u32 view_zone_count = 0;
+  u64 frame_start_ns = 0;
+  u64 view_start_ns = 0;
+  u64 view_end_ns = 0;
+
+  ProfileZone* capture_zones = nullptr;
+  u32 capture_zone_count = 0;
+  bool capturing = false;
+  bool paused = false;
+} profiler;
+
+static thread_local ProfilerThreadBuffer* profiler_thread_buffer = nullptr;
+static thread_local bool profiler_thread_registered = false;
+
+// nullptr once the slots have run out
+static ProfilerThreadBuffer* ProfilerThisThread(const char* name = nullptr)
+{
+  if (profiler_thread_registered) return profiler_thread_buffer;
+  profiler_thread_registered = true;
+
+  u32 index = profiler.thread_count.fetch_add(1);
+  if (index >= PROFILER_MAX_THREADS) return nullptr;
+
+  ProfilerThreadBuffer* buffer = new ProfilerThreadBuffer;
+  buffer->thread_id = index;
+  if (name) snprintf(buffer->name, sizeof(buffer->name), "%s", name);
+  else snprintf(buffer->name, sizeof(buffer->name), "Thread %u", index);
+
+  profiler_thread_buffer = buffer;
+  profiler.threads[index].store(buffer, std::memory_order_release);
+  return buffer;
+}
+
+static inline void ProfilerRecord(ProfilerThreadBuffer* buffer, const char* name, u64 start_ns, u64 end_ns, u32 depth)
+{
+  u64 write = buffer->write_index.load(std::memory_order_relaxed);
+  if (write - buffer->read_index.load(std::memory_order_acquire) >= PROFILER_RING_SIZE)
+  {
+    buffer->dropped++;
+    return;
+  }
+
+  ProfileZone& zone = buffer->zones[write & (PROFILER_RING_SIZE - 1)];
+  zone.name = name;
+  zone.start_ns = start_ns;
+  zone.end_ns = end_ns;
+  zone.depth = depth;
+  zone.thread_id = buffer->thread_id;
+  buffer->write_index.store(write + 1, std::memory_order_release);
+}
+
+struct ProfileScope
+{
+  const char* name;
+  u64 start_ns;
+  ProfilerThreadBuffer* buffer;
+
+  ProfileScope(const char* _name) : name(_name)
+  {
+    buffer = ProfilerThisThread();
+    if (buffer) buffer->depth++;
+    start_ns = ProfilerNow();
+  }
+
+  ~ProfileScope()
+  {
+    if (!buffer)
+    {
+      profiler.overflow_zones.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+
+    u64 end_ns = ProfilerNow();
+    buffer->depth--;
+    ProfilerRecord(buffer, name, start_ns, end_ns, buffer->depth);
+  }
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profile_scope_, __LINE__)(name)
+#define PROFILE_FUNCTION() PROFILE_SCOPE(__FUNCTION__)
+
+// the main thread may be reading a published buffer's name, so a thread that has already recorded a
+// zone keeps the name it had
+void ProfilerSetThreadName(const char* name)
+{
+  ProfilerThisThread(name);
+}
+
+void ProfilerBeginFrame()
+{
+  if (!profiler.frame_zones)
+  {
+    profiler.frame_zones = new ProfileZone[PROFILER_MAX_FRAME_ZONES];
+    profiler.view_zones = new ProfileZone[PROFILER_MAX_FRAME_ZONES];
+  }
+
+  profiler.frame_start_ns = ProfilerNow();
+}
+
+void ProfilerEndFrame()
+{
+  u64 frame_end_ns = ProfilerNow();
+  profiler.frame_zone_count = 0;
+
+  u32 thread_count = profiler.thread_count.load(std::memory_order_acquire);
+  if (thread_count > PROFILER_MAX_THREADS) thread_count = PROFILER_MAX_THREADS;
+
+  for (u32 t = 0; t < thread_count; t++)
+  {
+    ProfilerThreadBuffer* buffer = profiler.threads[t].load(std::memory_order_acquire);
+    if (!buffer) continue;    // registered but the pointer isn't published yet, catch it next frame
+
+    u64 read = buffer->read_index.load(std::memory_order_relaxed);
+    u64 write = buffer->write_index.load(std::memory_order_acquire);
+
+    for (; read < write; read++)
+    {
+      const ProfileZone& zone = buffer->zones[read & (PROFILER_RING_SIZE - 1)];
+
+      if (profiler.frame_zones && profiler.frame_zone_count < PROFILER_MAX_FRAME_ZONES)
+      {
+        profiler.frame_zones[profiler.frame_zone_count++] = zone;
+      }
+
+      if (profiler.capturing && profiler.capture_zone_count < PROFILER_MAX_CAPTURE_ZONES)
+      {
+        profiler.capture_zones[profiler.capture_zone_count++] = zone;
+      }
+    }
+
+    buffer->read_index.store(read, std::memory_order_release);
+  }
+
+  if (!profiler.paused && profiler.frame_zones)
+  {
+    memcpy(profiler.view_zones, profiler.frame_zones, profiler.frame_zone_count * sizeof(ProfileZone));
+    profiler.view_zone_count = profiler.frame_zone_count;
+    profiler.view_start_ns = profiler.frame_start_ns;
+    profiler.view_end_ns = frame_end_ns;
+  }
+}
+
+void ProfilerStartCapture()
+{
+  if (!profiler.capture_zones) profiler.capture_zones = new ProfileZone[PROFILER_MAX_CAPTURE_ZONES];
+
+  profiler.capture_zone_count = 0;
+  profiler.capturing = true;
+}
+
+void ProfilerStopCapture()
+{
+  profiler.capturing = false;
+}
+
+static void WriteJSONString(std::ofstream& stream, const char* str)
+{
+  stream << '"';
+  for (const char* c = str; *c; c++)
+  {
+    if (*c == '"' || *c == '\\') stream << '\\';
+    stream << *c;
+  }
+  stream << '"';
+}
+
+// writes the last capture in the chrome trace_event format, open it in chrome://tracing or ui.perfetto.dev
+bool ExportChromeTrace(const char* path)
+{
+  std::ofstream stream(path);
+  if (!stream.is_open())
+  {
+    DebugPrintToConsole("Failed to write profiler trace: ", path);
+    return false;
+  }
+
+  char timestamp[64];
+  stream << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+
+  u32 thread_count = profiler.thread_count.load(std::memory_order_acquire);
+  if (thread_count > PROFILER_MAX_THREADS) thread_count = PROFILER_MAX_THREADS;
+
+  bool first = true;
+  for (u32 t = 0; t < thread_count; t++)
+  {
+    ProfilerThreadBuffer* buffer = profiler.threads[t].load(std::memory_order_acquire);
+    if (!buffer) continue;
+
+    if (!first) stream << ",\n";
+    stream << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << t << ",\"args\":{\"name\":";
+    WriteJSONString(stream, buffer->name);
+    stream << "}}";
+    first = false;
+  }
+
+  for (u32 i = 0; i < profiler.capture_zone_count; i++)
+  {
+    const ProfileZone& zone = profiler.capture_zones[i];
+
+    if (!first) stream << ",\n";
+    stream << "{\"name\":";
+    WriteJSONString(stream, zone.name);
+    snprintf(timestamp, sizeof(timestamp), ",\"ts\":%.3f,\"dur\":%.3f", zone.start_ns / 1000.0, (zone.end_ns - zone.start_ns) / 1000.0);
+    stream << ",\"cat\":\"engine\",\"ph\":\"X\"" << timestamp << ",\"pid\":0,\"tid\":" << zone.thread_id << '}';
+    first = false;
+  }
+
+  stream << "\n]}\n";
+  DebugPrintToConsole("Wrote profiler trace: ", path, " (", profiler.capture_zone_count, " zones)");
+
+  return true;
+}
+
+static ImU32 ProfilerZoneColor(const char* name)
+{
+  // zones keep the same color from frame to frame by hashing the name pointer
+  u64 hash = (u64)(uintptr_t)name * 0x9E3779B97F4A7C15ull;
+  u8 r = 90 + (u8)((hash >> 16) % 130);
+  u8 g = 90 + (u8)((hash >> 32) % 130);
+  u8 b = 90 + (u8)((hash >> 48) % 130);
+  return IM_COL32(r, g, b, 255);
+}
+
+void DrawProfilerWindow(bool* open)
+{
+  if (!ImGui::Begin("Profiler", open))
+  {
+    ImGui::End();
+    return;
+  }
+
+  ImGui::Checkbox("Pause", &profiler.paused);
+  ImGui::SameLine();
+  if (!profiler.capturing)
+  {
+    if (ImGui::Button("Start Capture")) ProfilerStartCapture();
+  }
+  else
+  {
+    if (ImGui::Button("Stop Capture"))
+    {
+      ProfilerStopCapture();
+      ExportChromeTrace("profile_trace.json");
+    }
+    ImGui::SameLine();
+    ImGui::Text("%u zones", profiler.capture_zone_count);
+  }
+
+  f64 frame_ns = (f64)(profiler.view_end_ns - profiler.view_start_ns);
+  ImGui::Text("Frame: %.3f ms, %u zones", frame_ns / 1000000.0, profiler.view_zone_count);
+  u64 overflow_zones = profiler.overflow_zones.load(std::memory_order_relaxed);
+  if (overflow_zones) ImGui::Text("%llu zones dropped from threads past the first %u", (unsigned long long)overflow_zones, PROFILER_MAX_THREADS);
+  if (frame_ns <= 0.0)
+  {
+    ImGui::End();
+    return;
+  }
+
+  ImDrawList* draw_list = ImGui::GetWindowDrawList();
+  f32 width = ImGui::GetContentRegionAvail().x;
+  f32 row_height = ImGui::GetTextLineHeight() + 4.f;
+  f64 px_per_ns = width / frame_ns;
+
+  u32 thread_count = profiler.thread_count.load(std::memory_order_acquire);
+  if (thread_count > PROFILER_MAX_THREADS) thread_count = PROFILER_MAX_THREADS;
+
+  for (u32 t = 0; t < thread_count; t++)
+  {
+    ProfilerThreadBuffer* buffer = profiler.threads[t].load(std::memory_order_acquire);
+    if (!buffer) continue;
+
+    u32 max_depth = 0;
+    bool has_zones = false;
+    for (u32 i = 0; i < profiler.view_zone_count; i++)
+    {
+      const ProfileZone& zone = profiler.view_zones[i];
+      if (zone.thread_id != t) continue;
+      has_zones = true;
+      if (zone.depth > max_depth) max_depth = zone.depth;
+    }
+
+    if (!has_zones) continue;
+
+    ImGui::TextUnformatted(buffer->name);
+    ImVec2 origin = ImGui::GetCursorScreenPos();
+    f32 lane_height = (max_depth + 1) * row_height;
+    ImGui::InvisibleButton(buffer->name, ImVec2(width, lane_height));
+    ImVec2 mouse = ImGui::GetIO().MousePos;
+
+    for (u32 i = 0; i < profiler.view_zone_count; i++)
+    {
+      const ProfileZone& zone = profiler.view_zones[i];
+      if (zone.thread_id != t || zone.end_ns < profiler.view_start_ns || zone.start_ns > profiler.view_end_ns) continue;
+
+      f64 start = zone.start_ns > profiler.view_start_ns ? (f64)(zone.start_ns - profiler.view_start_ns) : 0.0;
+      f64 end = zone.end_ns < profiler.view_end_ns ? (f64)(zone.end_ns - profiler.view_start_ns) : frame_ns;
+
+      ImVec2 min = ImVec2(origin.x + (f32)(start * px_per_ns), origin.y + zone.depth * row_height);
+      ImVec2 max = ImVec2(origin.x + (f32)(end * px_per_ns), min.y + row_height - 1.f);
+      if (max.x - min.x < 1.f) max.x = min.x + 1.f;
+
+      draw_list->AddRectFilled(min, max, ProfilerZoneColor(zone.name));
+      if (max.x - min.x > 20.f)
+      {
+        ImVec4 clip = ImVec4(min.x, min.y, max.x - 2.f, max.y);
+        draw_list->AddText(nullptr, 0.f, ImVec2(min.x + 2.f, min.y + 2.f), IM_COL32_BLACK, zone.name, nullptr, 0.f, &clip);
+      }
+
+      if (mouse.x >= min.x && mouse.x < max.x && mouse.y >= min.y && mouse.y < max.y)
+      {
+        ImGui::SetTooltip("%s\n%.3f ms", zone.name, (zone.end_ns - zone.start_ns) / 1000000.0);
+      }
+    }
+  }
+
+  ImGui::End();
+}
+
+#else
+
+#define PROFILE_SCOPE(name)
+#define PROFILE_FUNCTION()
+
+void ProfilerSetThreadName(const char* /*name*/) {}
+void ProfilerBeginFrame() {}
+void ProfilerEndFrame() {}
+void ProfilerStartCapture() {}
+void ProfilerStopCapture() {}
+bool ExportChromeTrace(const char* /*path*/) { return false; }
+void DrawProfilerWindow(bool* /*open*/) {}
+
+#endif
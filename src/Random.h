@@ -0,0 +1,313 @@
+#pragma once
+
+#include "Core.h"
+#include "vec2.h"
+#include <atomic>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define EN_RANDOM_LANES 8
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define EN_RANDOM_LANES 4
+#else
+#define EN_RANDOM_LANES 1
+#endif
+
+
+/// Random API Reference
+////// void SeedRandom(u64 seed);
+////// void SetRandomStream(u32 stream);
+////// u32 RandomU32();
+////// f32 RandomFloat();                                            // [0, 1)
+////// f32 RandomFloatInRange(f32 lower, f32 upper);
+////// f32 RandomNormal(f32 mean, f32 std_dev);
+////// vec2 RandomUnitVec2();
+////// void RandomFillFloats(f32* out, s32 count, f32 lower, f32 upper);
+
+// every thread draws from its own PCG32 stream. the main thread and the workers get fixed stream ids
+// (0 and their worker index), so a seed reproduces their sequences...which jobs draw from a worker's
+// stream still depends on scheduling though. any other thread gets an id past RANDOM_FIXED_STREAMS
+// in the order it first asks for a number, so its sequence isn't reproducible
+
+// the float fills run xoshiro128+ in 4 (SSE2) or 8 (AVX2) lanes side by side, its low bits are
+// weak but only the top 23 bits ever make it into a float...setting them as the mantissa of 1.0
+// gives a float in [1, 2) without an int to float conversion
+
+const f32 RANDOM_PI = 3.14159265f;
+const u32 RANDOM_FIXED_STREAMS = 64;      // ids below this are handed out with SetRandomStream
+
+static inline u64 SplitMix64(u64& state)
+{
+  u64 z = (state += 0x9E3779B97F4A7C15ull);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+  return z ^ (z >> 31);
+}
+
+static inline f32 U32ToUnitFloat(u32 x)
+{
+  return (x >> 8) * (1.f / 16777216.f);
+}
+
+struct PCG32
+{
+  u64 state = 0x853C49E6748FEA9Bull;
+  u64 inc = 0xDA3E39CB94B95BDBull;
+
+  void Seed(u64 seed, u64 stream)
+  {
+    state = 0;
+    inc = (stream << 1u) | 1u;
+    Next();
+    state += seed;
+    Next();
+  }
+
+  u32 Next()
+  {
+    u64 old_state = state;
+    state = old_state * 6364136223846793005ull + inc;
+    u32 xorshifted = (u32)(((old_state >> 18u) ^ old_state) >> 27u);
+    u32 rot = (u32)(old_state >> 59u);
+    return (xorshifted >> rot) | (xorshifted << ((~rot + 1u) & 31));
+  }
+};
+
+struct Xoshiro256
+{
+  u64 s[4];
+
+  void Seed(u64 seed)
+  {
+    u64 sm = seed;
+    for (s32 i = 0; i < 4; i++) s[i] = SplitMix64(sm);
+  }
+
+  static inline u64 Rotl(u64 x, s32 k)
+  {
+    return (x << k) | (x >> (64 - k));
+  }
+
+  u64 Next()
+  {
+    u64 result = Rotl(s[1] * 5, 7) * 9;
+    u64 t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = Rotl(s[3], 45);
+
+    return result;
+  }
+};
+
+// lanes of xoshiro128+ stored lane-major so one load grabs the same state word for every lane
+struct alignas(32) RandomBatchState
+{
+  u32 s[4][EN_RANDOM_LANES];
+};
+
+struct RandomThreadState
+{
+  PCG32 pcg;
+  RandomBatchState batch;
+  u64 seed_generation = 0;
+  f32 spare_normal = 0.f;
+  bool has_spare_normal = false;
+};
+
+static struct
+{
+  std::atomic<u64> seed{ 0x2D2D2D2D5EEDull };
+  std::atomic<u64> seed_generation{ 1 };
+  std::atomic<u32> next_stream{ RANDOM_FIXED_STREAMS };
+} random_context;
+
+static thread_local RandomThreadState random_thread_state;
+static thread_local u32 random_thread_stream = 0xFFFFFFFF;
+
+// reseeds every thread's stream, threads pick the new seed up the next time they draw a number and
+// keep the stream id they already had
+void SeedRandom(u64 seed)
+{
+  random_context.seed.store(seed);
+  random_context.seed_generation.fetch_add(1);
+}
+
+static void SeedThreadState(RandomThreadState& state, u64 seed, u32 stream)
+{
+  state.pcg.Seed(seed, stream);
+
+  u64 sm = seed ^ ((u64)stream * 0xD1B54A32D192ED03ull);
+  for (s32 lane = 0; lane < EN_RANDOM_LANES; lane++)
+  {
+    for (s32 word = 0; word < 4; word++)
+    {
+      state.batch.s[word][lane] = (u32)SplitMix64(sm);
+    }
+  }
+
+  state.has_spare_normal = false;
+}
+
+static inline RandomThreadState& RandomState()
+{
+  RandomThreadState& state = random_thread_state;
+  u64 generation = random_context.seed_generation.load(std::memory_order_relaxed);
+  if (state.seed_generation != generation)
+  {
+    if (random_thread_stream == 0xFFFFFFFF) random_thread_stream = random_context.next_stream.fetch_add(1);
+    SeedThreadState(state, random_context.seed.load(), random_thread_stream);
+    state.seed_generation = generation;
+  }
+
+  return state;
+}
+
+// call on the thread itself, before it draws...the stream restarts from the current seed
+void SetRandomStream(u32 stream)
+{
+  random_thread_stream = stream;
+  random_thread_state.seed_generation = 0;
+}
+
+u32 RandomU32()
+{
+  return RandomState().pcg.Next();
+}
+
+f32 RandomFloat()
+{
+  return U32ToUnitFloat(RandomState().pcg.Next());
+}
+
+f32 RandomFloatInRange(f32 lower, f32 upper)
+{
+  return lower + (upper - lower) * RandomFloat();
+}
+
+// marsaglia polar method, every other call is served from the spare
+f32 RandomNormal(f32 mean, f32 std_dev)
+{
+  RandomThreadState& state = RandomState();
+  if (state.has_spare_normal)
+  {
+    state.has_spare_normal = false;
+    return mean + std_dev * state.spare_normal;
+  }
+
+  f32 u, v, s;
+  do
+  {
+    u = 2.f * U32ToUnitFloat(state.pcg.Next()) - 1.f;
+    v = 2.f * U32ToUnitFloat(state.pcg.Next()) - 1.f;
+    s = u * u + v * v;
+  } while (s >= 1.f || s == 0.f);
+
+  f32 scale = sqrtf(-2.f * logf(s) / s);
+  state.spare_normal = v * scale;
+  state.has_spare_normal = true;
+
+  return mean + std_dev * u * scale;
+}
+
+vec2 RandomUnitVec2()
+{
+  f32 angle = 2.f * RANDOM_PI * RandomFloat();
+  return vec2(cosf(angle), sinf(angle));
+}
+
+static inline void RandomFillFloatsScalar(RandomBatchState& batch, f32* out, s32 count, f32 lower, f32 range)
+{
+  for (s32 i = 0; i < count; i++)
+  {
+    s32 lane = i % EN_RANDOM_LANES;
+    u32 result = batch.s[0][lane] + batch.s[3][lane];
+    u32 t = batch.s[1][lane] << 9;
+
+    batch.s[2][lane] ^= batch.s[0][lane];
+    batch.s[3][lane] ^= batch.s[1][lane];
+    batch.s[1][lane] ^= batch.s[2][lane];
+    batch.s[0][lane] ^= batch.s[3][lane];
+    batch.s[2][lane] ^= t;
+    batch.s[3][lane] = (batch.s[3][lane] << 11) | (batch.s[3][lane] >> 21);
+
+    out[i] = lower + range * U32ToUnitFloat(result);
+  }
+}
+
+// fills out[0..count) with uniform floats in [lower, upper)
+void RandomFillFloats(f32* out, s32 count, f32 lower, f32 upper)
+{
+  RandomBatchState& batch = RandomState().batch;
+  f32 range = upper - lower;
+  s32 i = 0;
+
+#if EN_RANDOM_LANES == 8
+  __m256i s0 = _mm256_load_si256((__m256i*)batch.s[0]);
+  __m256i s1 = _mm256_load_si256((__m256i*)batch.s[1]);
+  __m256i s2 = _mm256_load_si256((__m256i*)batch.s[2]);
+  __m256i s3 = _mm256_load_si256((__m256i*)batch.s[3]);
+  __m256i exponent = _mm256_set1_epi32(0x3F800000);
+  __m256 one = _mm256_set1_ps(1.f);
+  __m256 scale = _mm256_set1_ps(range);
+  __m256 offset = _mm256_set1_ps(lower);
+
+  for (; i + 8 <= count; i += 8)
+  {
+    __m256i result = _mm256_add_epi32(s0, s3);
+    __m256i t = _mm256_slli_epi32(s1, 9);
+
+    s2 = _mm256_xor_si256(s2, s0);
+    s3 = _mm256_xor_si256(s3, s1);
+    s1 = _mm256_xor_si256(s1, s2);
+    s0 = _mm256_xor_si256(s0, s3);
+    s2 = _mm256_xor_si256(s2, t);
+    s3 = _mm256_or_si256(_mm256_slli_epi32(s3, 11), _mm256_srli_epi32(s3, 21));
+
+    __m256 one_to_two = _mm256_castsi256_ps(_mm256_or_si256(_mm256_srli_epi32(result, 9), exponent));
+    _mm256_storeu_ps(out + i, _mm256_add_ps(_mm256_mul_ps(_mm256_sub_ps(one_to_two, one), scale), offset));
+  }
+
+  _mm256_store_si256((__m256i*)batch.s[0], s0);
+  _mm256_store_si256((__m256i*)batch.s[1], s1);
+  _mm256_store_si256((__m256i*)batch.s[2], s2);
+  _mm256_store_si256((__m256i*)batch.s[3], s3);
+#elif EN_RANDOM_LANES == 4
+  __m128i s0 = _mm_load_si128((__m128i*)batch.s[0]);
+  __m128i s1 = _mm_load_si128((__m128i*)batch.s[1]);
+  __m128i s2 = _mm_load_si128((__m128i*)batch.s[2]);
+  __m128i s3 = _mm_load_si128((__m128i*)batch.s[3]);
+  __m128i exponent = _mm_set1_epi32(0x3F800000);
+  __m128 one = _mm_set1_ps(1.f);
+  __m128 scale = _mm_set1_ps(range);
+  __m128 offset = _mm_set1_ps(lower);
+
+  for (; i + 4 <= count; i += 4)
+  {
+    __m128i result = _mm_add_epi32(s0, s3);
+    __m128i t = _mm_slli_epi32(s1, 9);
+
+    s2 = _mm_xor_si128(s2, s0);
+    s3 = _mm_xor_si128(s3, s1);
+    s1 = _mm_xor_si128(s1, s2);
+    s0 = _mm_xor_si128(s0, s3);
+    s2 = _mm_xor_si128(s2, t);
+    s3 = _mm_or_si128(_mm_slli_epi32(s3, 11), _mm_srli_epi32(s3, 21));
+
+    __m128 one_to_two = _mm_castsi128_ps(_mm_or_si128(_mm_srli_epi32(result, 9), exponent));
+    _mm_storeu_ps(out + i, _mm_add_ps(_mm_mul_ps(_mm_sub_ps(one_to_two, one), scale), offset));
+  }
+
+  _mm_store_si128((__m128i*)batch.s[0], s0);
+  _mm_store_si128((__m128i*)batch.s[1], s1);
+  _mm_store_si128((__m128i*)batch.s[2], s2);
+  _mm_store_si128((__m128i*)batch.s[3], s3);
+#endif
+
+  RandomFillFloatsScalar(batch, out + i, count - i, lower, range);
+}
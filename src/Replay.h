@@ -0,0 +1,142 @@
+#pragma once
+
+#include "Core.h"
+#include "Simulation.h"
+#include "InputRecording.h"
+#include "Input.h"
+#include "Random.h"
+#include <algorithm>
+
+
+/// Replay API Reference
+////// bool ReplayInputSession(const char* path, SimulationTickFunc tick, const char* baseline_path);
+
+// replays a recorded session headlessly as fast as the ticks run and writes the tick timings next
+// to the recording as <path>.timings...passing the .timings file of an older build as the baseline
+// prints how every statistic moved, which is how we catch performance regressions between builds
+
+struct ReplayTimings
+{
+  u64 ticks = 0;
+  f64 total_ms = 0.0;
+  f64 min_us = 0.0;
+  f64 avg_us = 0.0;
+  f64 p50_us = 0.0;
+  f64 p95_us = 0.0;
+  f64 p99_us = 0.0;
+  f64 max_us = 0.0;
+};
+
+static const char* replay_timing_names[] = { "ticks", "total_ms", "min_us", "avg_us", "p50_us", "p95_us", "p99_us", "max_us" };
+
+static void ReplayTimingValues(const ReplayTimings& timings, f64 values[8])
+{
+  values[0] = (f64)timings.ticks;
+  values[1] = timings.total_ms;
+  values[2] = timings.min_us;
+  values[3] = timings.avg_us;
+  values[4] = timings.p50_us;
+  values[5] = timings.p95_us;
+  values[6] = timings.p99_us;
+  values[7] = timings.max_us;
+}
+
+static bool LoadReplayTimings(const char* path, f64 values[8])
+{
+  std::ifstream stream(path);
+  if (!stream.is_open()) return false;
+
+  std::string name;
+  f64 value;
+  while (stream >> name >> value)
+  {
+    for (s32 i = 0; i < 8; i++)
+    {
+      if (name == replay_timing_names[i]) values[i] = value;
+    }
+  }
+
+  return true;
+}
+
+bool ReplayInputSession(const char* path, SimulationTickFunc tick, const char* baseline_path)
+{
+  InputSession session;
+  if (!LoadInputRecording(path, session)) return false;
+
+  if (session.tick_hz != SIMULATION_TICK_HZ)
+  {
+    DebugPrintToConsole("Recording was made at a different tick rate: ", path);
+    return false;
+  }
+
+  SeedRandom(session.seed);
+  simulation.tick = 0;
+  simulation.time_ns = 0;
+
+  en::vector<u64> tick_ns((s32)session.tick_count);
+  s32 next_event = 0;
+  u64 replay_start = SimulationNow();
+
+  for (u64 t = 0; t < session.tick_count; t++)
+  {
+    while (next_event < session.events.Size() && session.events[next_event].tick == t)
+    {
+      RecordedInputEvent& e = session.events[next_event++];
+      PushInputEvent(e.input_code, e.down, simulation.time_ns);
+    }
+
+    u64 start = SimulationNow();
+    tick();
+    tick_ns.PushBack(SimulationNow() - start);
+
+    simulation.time_ns += SIMULATION_TICK_NS;
+    simulation.tick++;
+  }
+
+  ReplayTimings timings;
+  timings.ticks = session.tick_count;
+  timings.total_ms = (SimulationNow() - replay_start) / 1e6;
+
+  if (session.tick_count > 0)
+  {
+    u64 sum = 0;
+    for (u64 t = 0; t < session.tick_count; t++) sum += tick_ns[t];
+    std::sort(tick_ns.begin(), tick_ns.end());
+
+    auto percentile = [&](f64 p) { return tick_ns[(u64)(p * (session.tick_count - 1))] / 1000.0; };
+    timings.min_us = tick_ns[0] / 1000.0;
+    timings.avg_us = (f64)sum / session.tick_count / 1000.0;
+    timings.p50_us = percentile(0.50);
+    timings.p95_us = percentile(0.95);
+    timings.p99_us = percentile(0.99);
+    timings.max_us = tick_ns[session.tick_count - 1] / 1000.0;
+  }
+
+  f64 values[8];
+  ReplayTimingValues(timings, values);
+
+  // read the baseline before writing the report in case both are the same file
+  f64 baseline[8] = {};
+  bool has_baseline = baseline_path && LoadReplayTimings(baseline_path, baseline);
+  if (baseline_path && !has_baseline) DebugPrintToConsole("Could not read baseline timings: ", baseline_path);
+
+  std::string report_path = std::string(path) + ".timings";
+  std::ofstream report(report_path);
+  for (s32 i = 0; i < 8; i++) report << replay_timing_names[i] << ' ' << values[i] << '\n';
+
+  printf("Replayed %s: %llu ticks, %d events\n", path, (unsigned long long)session.tick_count, session.events.Size());
+  for (s32 i = 0; i < 8; i++)
+  {
+    if (has_baseline && baseline[i] != 0.0)
+    {
+      printf("  %-10s %12.3f   baseline %12.3f   %+7.1f%%\n", replay_timing_names[i], values[i], baseline[i], 100.0 * (values[i] - baseline[i]) / baseline[i]);
+    }
+    else
+    {
+      printf("  %-10s %12.3f\n", replay_timing_names[i], values[i]);
+    }
+  }
+
+  return true;
+}
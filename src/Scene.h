@@ -1,13 +1,17 @@
 #pragma once
 
 #include "Core.h"
+#include "Profiler.h"
+#include "FrameStats.h"
 #include "vector.h"
 #include "GLGraphics.h"
+#include "Assets.h"
+#include "ECS.h"
+#include "SceneGraph.h"
+#include "Prefabs.h"
+#include "AssetPack.h"
 
 
-en::vector<Entity> entities;
-en::vector<vec2> original_scales;
-
 //en::vector<std::string> LoadSceneSelector()
 //{
 //  en::vector<std::string> result;
@@ -25,36 +29,201 @@ en::vector<vec2> original_scales;
 //  return result;
 //}
 
-void LoadScene(const char* scene_path)
+/// Scene API Reference
+////// void LoadScene(const char* scene_path);
+////// void ReloadScene();
+////// const char* LoadedScenePath();
+
+// a scene file lists the shaders, textures and sounds it uses, then one #Entity line per entity:
+// "#Entity: shader index, texture index, x y, angle, scale x scale y[, parent entity index]"
+
+// entities that only differ in where they are can share a prefab instead (see Prefabs.h), defined
+// before its first instance:
+// "#Prefab: name, shader index, texture index, angle, scale x scale y"
+// "#Instance: name, x y[, parent entity index][; angle a][; scale x y][; sprite shader index texture index]"
+// an #Instance line counts as an entity line for parent indices, and only the scale and sprite after
+// a ; are stored on the entity itself
+
+// ReloadScene reads the file again and only touches what changed...entities whose line reads the
+// same (and whose parent is still the same entity) are left exactly as they are, changed lines are
+// applied to the entity that was there, and only added or removed lines create or destroy entities
+
+const u8 PREFAB_OVERRIDE_SPRITE = 1 << 0;
+const u8 PREFAB_OVERRIDE_SCALE = 1 << 1;
+
+// an instance's shader, texture, angle and scale are filled in from its prefab where it doesn't
+// override them, so a changed prefab shows up as changed lines on reload
+struct SceneEntityDesc
 {
-  entities.Clear();
-  original_scales.Clear();
-  scene_shaders.Clear();
-  scene_textures.Clear();
-  scene_sounds.Clear();
+  std::string shader;
+  std::string texture;
+  vec2 position;
+  f32 angle = 0.f;
+  vec2 scale;
+  s32 parent = -1;        // index of another #Entity line, position, angle and scale are then relative to it
+  std::string prefab;     // empty for an #Entity line
+  u8 overrides = 0;
+};
 
-  std::string path = AssetPath("scenes/").append(scene_path);
-  std::ifstream scene_stream(path);
+struct ScenePrefabDesc
+{
+  std::string name;
+  std::string shader;
+  std::string texture;
+  f32 angle = 0.f;
+  vec2 scale;
+};
 
-  std::string line;
+struct SceneFile
+{
+  en::vector<std::string> shaders;
+  en::vector<std::string> textures;
+  en::vector<std::string> sounds;
+  en::vector<ScenePrefabDesc> prefabs;
+  en::vector<SceneEntityDesc> entities;
+};
+
+static struct
+{
+  std::string path;                     // under scenes/, empty until the first LoadScene
+  en::vector<AssetHandle> assets;       // everything the scene holds on to
+  en::vector<SceneEntityDesc> descs;    // one per #Entity line...
+  en::vector<Entity> entities;          // ...and the entity made from it
+  u32 quad_vao = 0;                     // every scene sprite draws the same quad
+} loaded_scene;
+
+static bool SameSceneEntity(const SceneEntityDesc& a, const SceneEntityDesc& b)
+{
+  return a.shader == b.shader && a.texture == b.texture && a.position.x() == b.position.x() && a.position.y() == b.position.y() &&
+    a.angle == b.angle && a.scale.x() == b.scale.x() && a.scale.y() == b.scale.y() && a.parent == b.parent && a.prefab == b.prefab &&
+    a.overrides == b.overrides;
+}
+
+static bool ParseSceneEntity(const std::string& line, SceneFile& file, SceneEntityDesc& desc)
+{
+  f32 px, py, angle, sx, sy;
+  s32 shader, texture;
+  s32 parent = -1;
+  s32 fields = sscanf(line.c_str(), "#Entity: %d, %d, %f %f, %f, %f %f, %d", &shader, &texture, &px, &py, &angle, &sx, &sy, &parent);
+  if (fields < 7 || shader < 0 || shader >= file.shaders.Size() || texture < 0 || texture >= file.textures.Size())
+  {
+    DebugPrintToConsole("Bad scene entity: ", line);
+    return false;
+  }
+
+  desc.shader = file.shaders[shader];
+  desc.texture = file.textures[texture];
+  desc.position = vec2(px, py);
+  desc.angle = angle;
+  desc.scale = vec2(sx, sy);
+  desc.parent = parent;
+  return true;
+}
 
-  en::vector<std::string> scene_shader_names;
-  en::vector<std::string> scene_texture_names;
-  en::vector<std::string> scene_sound_names;
+static bool ParseScenePrefab(const std::string& line, SceneFile& file)
+{
+  char name[64];
+  f32 angle, sx, sy;
+  s32 shader, texture;
+  s32 fields = sscanf(line.c_str(), "#Prefab: %63[^,], %d, %d, %f, %f %f", name, &shader, &texture, &angle, &sx, &sy);
+  if (fields < 6 || shader < 0 || shader >= file.shaders.Size() || texture < 0 || texture >= file.textures.Size())
+  {
+    DebugPrintToConsole("Bad scene prefab: ", line);
+    return false;
+  }
+
+  ScenePrefabDesc prefab;
+  prefab.name = name;
+  prefab.shader = file.shaders[shader];
+  prefab.texture = file.textures[texture];
+  prefab.angle = angle;
+  prefab.scale = vec2(sx, sy);
+  file.prefabs.PushBack(prefab);
+  return true;
+}
+
+static bool ParseSceneInstance(const std::string& line, SceneFile& file, SceneEntityDesc& desc)
+{
+  char name[64];
+  f32 px, py;
+  s32 parent = -1;
+  s32 fields = sscanf(line.c_str(), "#Instance: %63[^,], %f %f, %d", name, &px, &py, &parent);
 
+  s32 prefab = -1;
+  for (s32 p = 0; fields >= 3 && p < file.prefabs.Size(); p++)
+  {
+    if (file.prefabs[p].name == name) prefab = p;
+  }
+
+  if (prefab < 0)
+  {
+    DebugPrintToConsole("Bad scene instance: ", line);
+    return false;
+  }
+
+  ScenePrefabDesc& defaults = file.prefabs[prefab];
+  desc.prefab = name;
+  desc.shader = defaults.shader;
+  desc.texture = defaults.texture;
+  desc.position = vec2(px, py);
+  desc.angle = defaults.angle;
+  desc.scale = defaults.scale;
+  desc.parent = parent;
+
+  for (auto at = line.find(';'); at != std::string::npos; at = line.find(';', at + 1))
+  {
+    const char* field = line.c_str() + at + 1;
+    f32 x, y;
+    s32 shader, texture;
+    if (sscanf(field, " angle %f", &x) == 1)
+    {
+      desc.angle = x;
+    }
+    else if (sscanf(field, " scale %f %f", &x, &y) == 2)
+    {
+      desc.scale = vec2(x, y);
+      desc.overrides |= PREFAB_OVERRIDE_SCALE;
+    }
+    else if (sscanf(field, " sprite %d %d", &shader, &texture) == 2 && shader >= 0 && shader < file.shaders.Size() &&
+      texture >= 0 && texture < file.textures.Size())
+    {
+      desc.shader = file.shaders[shader];
+      desc.texture = file.textures[texture];
+      desc.overrides |= PREFAB_OVERRIDE_SPRITE;
+    }
+    else
+    {
+      DebugPrintToConsole("Bad scene instance override: ", line);
+    }
+  }
+
+  return true;
+}
+
+static bool ReadSceneFile(const char* scene_path, SceneFile& file)
+{
+  std::string path = AssetPath("scenes/").append(scene_path);
+  AssetStream scene_stream(path);
+  if (!scene_stream)
+  {
+    DebugPrintToConsole("Failed to open scene: ", path);
+    return false;
+  }
+
+  std::string line;
   while (std::getline(scene_stream, line))
   {
     if (line.find(".glsl") != std::string::npos)
     {
-      scene_shader_names.PushBack(line);
+      file.shaders.PushBack(line);
     }
     else if (line.find(".png") != std::string::npos)
     {
-      scene_texture_names.PushBack(line);
+      file.textures.PushBack(line);
     }
     else if (line.find(".wav") != std::string::npos)
     {
-      scene_sound_names.PushBack(line);
+      file.sounds.PushBack(line);
     }
     else
     {
@@ -62,109 +231,339 @@ void LoadScene(const char* scene_path)
     }
   }
 
-  for (const auto& s : scene_shader_names)
+  while (std::getline(scene_stream, line))
+  {
+    SceneEntityDesc desc;
+    if (line.find("#Prefab") != std::string::npos) ParseScenePrefab(line, file);
+    else if (line.find("#Instance") != std::string::npos && ParseSceneInstance(line, file, desc)) file.entities.PushBack(desc);
+    else if (line.find("#Entity") != std::string::npos && ParseSceneEntity(line, file, desc)) file.entities.PushBack(desc);
+  }
+
+  for (s32 i = 0; i < file.entities.Size(); i++)
+  {
+    s32 parent = file.entities[i].parent;
+    if (parent >= file.entities.Size() || parent == i)
+    {
+      DebugPrintToConsole("Scene entity has no such parent: ", parent);
+      file.entities[i].parent = -1;
+    }
+  }
+
+  return true;
+}
+
+// the new assets are acquired before the old ones are released, so whatever the two share is never
+// unloaded in between
+static void AcquireSceneAssets(SceneFile& file)
+{
+  scene_shaders.Clear();
+  scene_textures.Clear();
+  scene_sounds.Clear();
+
+  en::vector<AssetHandle> previous_assets = loaded_scene.assets;
+  loaded_scene.assets = en::vector<AssetHandle>();
+
+  for (const auto& s : file.shaders)
   {
     std::string s_path = s;
-    u32 shader = LoadGLShader(s_path.c_str());
-    scene_shaders.Insert(s_path, shader);
+    AssetHandle shader = AcquireShader(s_path.c_str());
+    loaded_scene.assets.PushBack(shader);
+    scene_shaders.Insert(s_path, AssetShader(shader));
+  }
+
+  // textures are the bulk of a scene's bytes, their files are all read at once
+  en::vector<const char*> texture_paths;
+  en::vector<AssetHandle> textures;
+  for (auto& t : file.textures)
+  {
+    texture_paths.PushBack(t.c_str());
+    textures.PushBack(AssetHandle());
   }
 
-  for (const auto& t : scene_texture_names)
+  AcquireTextures(texture_paths.begin(), texture_paths.Size(), textures.begin());
+  for (s32 t = 0; t < textures.Size(); t++)
   {
-    std::string t_path = t;
-    u32 texture = LoadGLTexture(t_path.c_str());
-    scene_textures.Insert(t_path, texture);
+    loaded_scene.assets.PushBack(textures[t]);
+    scene_textures.Insert(file.textures[t], AssetTexture(textures[t]));
   }
 
-  for (const auto& s : scene_sound_names)
+  // sound lines are "[*]name.wav [resident|compressed|stream|mapped]", a leading * loops the sound
+  for (const auto& s : file.sounds)
   {
     std::string s_path = s;
-    if (s_path.find("*") != std::string::npos)
+    bool looping = s_path.find("*") != std::string::npos;
+    if (looping) s_path.erase(s_path.find("*"), 1);
+
+    AUDIO_LOAD policy = DefaultLoadPolicy(looping);
+    auto space = s_path.find(" ");
+    if (space != std::string::npos)
     {
-      auto star = s_path.find("*");
-      s_path.erase(star, 1);
+      std::string policy_name = s_path.substr(space + 1);
+      s_path.erase(space);
 
-      FMOD::Sound* sound = LoadSound(s_path.c_str(), true);
-      if (sound != nullptr)
-      {
-        scene_sounds.Insert(s_path, sound);
-      }
+      if (policy_name == "resident") policy = AUDIO_LOAD::RESIDENT;
+      else if (policy_name == "compressed") policy = AUDIO_LOAD::COMPRESSED;
+      else if (policy_name == "stream") policy = AUDIO_LOAD::STREAM;
+      else if (policy_name == "mapped") policy = AUDIO_LOAD::MAPPED;
+      else DebugPrintToConsole("Unknown audio load policy: ", policy_name);
     }
-    else
+
+    AssetHandle asset = AcquireSound(s_path.c_str(), looping, policy);
+    loaded_scene.assets.PushBack(asset);
+
+    SoundHandle sound = AssetSound(asset);
+    if (sound.id >= 0)
     {
-      FMOD::Sound* sound = LoadSound(s_path.c_str(), false);
-      if (sound != nullptr)
-      {
-        scene_sounds.Insert(s_path, sound);
-      }
+      scene_sounds.Insert(s_path, sound.id);
     }
   }
 
-  while (std::getline(scene_stream, line))
+  for (auto& asset : previous_assets) ReleaseAsset(asset);
+}
+
+static u32 SceneQuadVao()
+{
+  if (loaded_scene.quad_vao != 0 || headless_graphics) return loaded_scene.quad_vao;
+
+  u32 vbo, ebo;
+  glGenVertexArrays(1, &loaded_scene.quad_vao);
+  glGenBuffers(1, &vbo);
+  glGenBuffers(1, &ebo);
+  glBindVertexArray(loaded_scene.quad_vao);
+  glBindBuffer(GL_ARRAY_BUFFER, vbo);
+  glBufferData(GL_ARRAY_BUFFER, 4 * sizeof(Vertex), quad_vertices, GL_STATIC_DRAW);
+  CountVerticesUploaded(4);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, 6 * sizeof(u32), quad_indices, GL_STATIC_DRAW);
+  glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(f32), (void*)0);
+  glEnableVertexAttribArray(0);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  glBindVertexArray(0);
+
+  return loaded_scene.quad_vao;
+}
+
+// redefining a prefab keeps its id, so the instances a reload leaves alone follow it too
+static void DefineScenePrefabs(SceneFile& file)
+{
+  for (auto& prefab : file.prefabs)
+  {
+    Sprite sprite;
+    sprite.shader = scene_shaders.At(prefab.shader);
+    sprite.texture = scene_textures.At(prefab.texture);
+    sprite.vao = SceneQuadVao();
+    DefinePrefab(prefab.name.c_str(), sprite, prefab.scale, prefab.angle);
+  }
+}
+
+// an #Entity line has everything, an instance only what it overrides
+static ComponentMask SceneEntityComponents(const SceneEntityDesc& desc)
+{
+  ComponentMask components = ComponentBit(COMPONENT::TRANSFORM);
+  if (desc.prefab.empty()) return components | ComponentBit(COMPONENT::BASE_SCALE) | ComponentBit(COMPONENT::SPRITE);
+
+  components |= ComponentBit(COMPONENT::PREFAB);
+  if (desc.overrides & PREFAB_OVERRIDE_SPRITE) components |= ComponentBit(COMPONENT::SPRITE);
+  if (desc.overrides & PREFAB_OVERRIDE_SCALE) components |= ComponentBit(COMPONENT::BASE_SCALE);
+  return components;
+}
+
+static Entity CreateSceneEntity(const SceneEntityDesc& desc)
+{
+  return CreateEntity(SceneEntityComponents(desc));
+}
+
+// parent is the entity of the desc's parent line, or a null entity
+static void ApplySceneEntity(Entity entity, const SceneEntityDesc& desc, Entity parent)
+{
+  PROFILE_SCOPE("LoadSceneEntity");
+
+  // a line that turned from an #Entity into an #Instance, or changed its overrides, gains or loses components
+  ComponentMask components = SceneEntityComponents(desc);
+  const COMPONENT optional[] = { COMPONENT::BASE_SCALE, COMPONENT::SPRITE, COMPONENT::PREFAB };
+  for (COMPONENT component : optional)
   {
-    if (line.find("#Entity") != std::string::npos)
+    bool wanted = (components & ComponentBit(component)) != 0;
+    if (wanted == HasComponent(entity, component)) continue;
+
+    if (wanted) AddComponent(entity, component);
+    else RemoveComponent(entity, component);
+  }
+
+  if (Sprite* sprite = GetComponent<Sprite>(entity, COMPONENT::SPRITE))
+  {
+    sprite->shader = scene_shaders.At(desc.shader);
+    sprite->texture = scene_textures.At(desc.texture);
+    sprite->vao = SceneQuadVao();
+  }
+
+  if (BaseScale* base = GetComponent<BaseScale>(entity, COMPONENT::BASE_SCALE)) base->scale = desc.scale;
+  if (PrefabInstance* instance = GetComponent<PrefabInstance>(entity, COMPONENT::PREFAB)) instance->prefab = FindPrefab(desc.prefab.c_str());
+
+  Transform local;
+  local.position = desc.position;
+  local.angle = desc.angle;
+
+  if (parent.id != 0)
+  {
+    local.scale = desc.scale;     // the aspect ratio comes from the root
+
+    s32 parent_node = EntityNode(parent);
+    AddComponent(entity, COMPONENT::SCENE_NODE);
+    SceneNode* node = GetComponent<SceneNode>(entity, COMPONENT::SCENE_NODE);
+    if (IsNodeAlive(node->node))
+    {
+      SetNodeParent(node->node, parent_node);
+      SetNodeLocal(node->node, local);
+    }
+    else
     {
-      Entity e;
-      auto space = line.find(" ");
-      auto new_line = line.substr(space + 1);
+      node->node = CreateNode(parent_node, local, entity);
+    }
+    return;
+  }
 
-      auto comma = new_line.find(",");
-      auto val_str = new_line.substr(0, comma);
-      e.shader = scene_shaders.At(scene_shader_names[std::stoi(val_str)]);
+  local.scale = vec2(desc.scale.x(), desc.scale.y() * aspect_ratio);
 
-      new_line = new_line.substr(comma + 2);
-      comma = new_line.find(",");
-      val_str = new_line.substr(0, comma);
-      e.texture = scene_textures.At(scene_texture_names[std::stoi(val_str)]);
+  // an entity other entities hang off stays in the graph as a root
+  SceneNode* node = GetComponent<SceneNode>(entity, COMPONENT::SCENE_NODE);
+  if (node && IsNodeAlive(node->node))
+  {
+    SetNodeParent(node->node, -1);
+    SetNodeLocal(node->node, local);
+  }
+  else
+  {
+    *GetComponent<Transform>(entity, COMPONENT::TRANSFORM) = local;
+  }
+}
 
-      new_line = new_line.substr(comma + 2);
-      comma = new_line.find(",");
-      val_str = new_line.substr(0, comma);
-      f32 tmp_vec[2] = { 0.f, 0.f };
+void LoadScene(const char* scene_path)
+{
+  PROFILE_FUNCTION();
 
-      space = val_str.find(" ");
-      tmp_vec[0] = std::stof(val_str.substr(0, space));
-      val_str = val_str.substr(space + 1);
+  // the graph goes first, the SceneNode teardowns then have nothing to unlink one at a time
+  ClearSceneGraph();
+  DestroyAllEntities();
+  ClearPrefabs();
 
-      space = val_str.find(" ");
-      tmp_vec[1] = std::stof(val_str.substr(0, space));
+  SceneFile file;
+  ReadSceneFile(scene_path, file);
+  AcquireSceneAssets(file);
+  DefineScenePrefabs(file);
 
-      e.position = vec2(tmp_vec[0], tmp_vec[1]);
+  loaded_scene.path = scene_path;
+  loaded_scene.descs = file.entities;
+  loaded_scene.entities = en::vector<Entity>();
 
-      new_line = new_line.substr(comma + 2);
-      comma = new_line.find(",");
-      val_str = new_line.substr(space + 1);
+  for (s32 i = 0; i < file.entities.Size(); i++) loaded_scene.entities.PushBack(CreateSceneEntity(file.entities[i]));
+  for (s32 i = 0; i < file.entities.Size(); i++)
+  {
+    s32 parent = file.entities[i].parent;
+    ApplySceneEntity(loaded_scene.entities[i], file.entities[i], parent >= 0 ? loaded_scene.entities[parent] : Entity());
+  }
+}
 
-      e.angle = std::stof(val_str);
+// lines are matched up first by reading the same, then whatever is left over pairs up in file order
+void ReloadScene()
+{
+  PROFILE_FUNCTION();
 
-      new_line = new_line.substr(comma + 2);
-      comma = new_line.find(",");
-      val_str = new_line.substr(0, comma);
+  if (loaded_scene.path.empty()) return;
 
-      space = val_str.find(" ");
-      tmp_vec[0] = std::stof(val_str.substr(0, space));
-      val_str = val_str.substr(space + 1);
+  SceneFile file;
+  if (!ReadSceneFile(loaded_scene.path.c_str(), file)) return;
+  AcquireSceneAssets(file);
+  DefineScenePrefabs(file);
 
-      space = val_str.find(" ");
-      tmp_vec[1] = std::stof(val_str.substr(0, space));
+  s32 old_count = loaded_scene.descs.Size();
+  s32 new_count = file.entities.Size();
+  en::vector<s32> match(new_count + 1);           // old line for each new line, -1 for none yet
+  en::vector<bool> taken(old_count + 1);
+  for (s32 i = 0; i < new_count; i++) match.PushBack(-1);
+  for (s32 j = 0; j < old_count; j++) taken.PushBack(false);
 
-      e.scale = vec2(tmp_vec[0], tmp_vec[1] * aspect_ratio);
+  for (s32 i = 0; i < new_count; i++)
+  {
+    if (i < old_count && !taken[i] && SameSceneEntity(file.entities[i], loaded_scene.descs[i]))
+    {
+      match[i] = i;
+      taken[i] = true;
+      continue;
+    }
+
+    for (s32 j = 0; j < old_count; j++)
+    {
+      if (!taken[j] && SameSceneEntity(file.entities[i], loaded_scene.descs[j]))
+      {
+        match[i] = j;
+        taken[j] = true;
+        break;
+      }
+    }
+  }
 
-      glGenVertexArrays(1, &e.vao);
-      glGenBuffers(1, &e.vbo);
-      glGenBuffers(1, &e.ebo);
-      glBindVertexArray(e.vao);
-      glBindBuffer(GL_ARRAY_BUFFER, e.vbo);
-      glBufferData(GL_ARRAY_BUFFER, 4 * sizeof(Vertex), &e.verts[0], GL_STATIC_DRAW);
-      glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, e.ebo);
-      glBufferData(GL_ELEMENT_ARRAY_BUFFER, 6 * sizeof(u32), quad_indices, GL_STATIC_DRAW);
-      glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(f32), (void*)0);
-      glEnableVertexAttribArray(0);
-      glBindBuffer(GL_ARRAY_BUFFER, 0);
-      glBindVertexArray(0);
+  en::vector<bool> changed(new_count + 1);
+  for (s32 i = 0; i < new_count; i++) changed.PushBack(match[i] < 0);
+
+  s32 next_old = 0;
+  for (s32 i = 0; i < new_count; i++)
+  {
+    if (match[i] >= 0) continue;
 
-      entities.PushBack(e);
-      original_scales.PushBack(vec2(e.scale.x(), e.scale.y() / aspect_ratio));
+    while (next_old < old_count && taken[next_old]) next_old++;
+    if (next_old < old_count)
+    {
+      match[i] = next_old;
+      taken[next_old] = true;
+    }
+  }
+
+  u32 destroyed = 0, created = 0, updated = 0;
+  for (s32 j = 0; j < old_count; j++)
+  {
+    if (taken[j]) continue;
+
+    // anything parented to it moves up to the top of the graph rather than going with it, the
+    // entities below give it its new parent
+    DestroyEntity(loaded_scene.entities[j]);
+    destroyed++;
+  }
+
+  en::vector<Entity> entities(new_count + 1);
+  for (s32 i = 0; i < new_count; i++)
+  {
+    if (match[i] >= 0) entities.PushBack(loaded_scene.entities[match[i]]);
+    else entities.PushBack(CreateSceneEntity(file.entities[i]));
+    if (match[i] < 0) created++;
+  }
+
+  // an unchanged line still has to be applied when its parent line now belongs to another entity
+  for (s32 i = 0; i < new_count; i++)
+  {
+    s32 parent = file.entities[i].parent;
+    Entity parent_entity = parent >= 0 ? entities[parent] : Entity();
+
+    if (!changed[i])
+    {
+      s32 old_parent = loaded_scene.descs[match[i]].parent;
+      Entity old_parent_entity = old_parent >= 0 ? loaded_scene.entities[old_parent] : Entity();
+      if (old_parent_entity.id == parent_entity.id) continue;
     }
+
+    ApplySceneEntity(entities[i], file.entities[i], parent_entity);
+    updated++;
   }
+
+  loaded_scene.descs = file.entities;
+  loaded_scene.entities = entities;
+
+  char summary[128];
+  snprintf(summary, sizeof(summary), "%u created, %u destroyed, %u applied", created, destroyed, updated);
+  DebugPrintToConsole("Reloaded scene: ", summary);
+}
+
+const char* LoadedScenePath()
+{
+  return loaded_scene.path.c_str();
 }
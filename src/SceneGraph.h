@@ -0,0 +1,468 @@
+#pragma once
+
+#include "Core.h"
+#include "Profiler.h"
+#include "ECS.h"
+#include "vector.h"
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+
+
+/// Scene Graph API Reference
+////// s32 CreateNode(s32 parent, const Transform& local, Entity entity);
+////// void DestroyNode(s32 node);
+////// void ReleaseNode(s32 node);
+////// void SetNodeParent(s32 node, s32 parent);
+////// void SetNodeLocal(s32 node, const Transform& local);
+////// void TranslateNode(s32 node, vec2 offset);
+////// Transform GetNodeLocal(s32 node);
+////// Transform GetNodeWorld(s32 node);
+////// bool IsRootNode(s32 node);
+////// s32 EntityNode(Entity entity);
+////// s32 AttachEntity(Entity child, Entity parent);
+////// void UpdateSceneGraph();
+////// void ClearSceneGraph();
+
+// parent/child hierarchies...a node has a transform local to its parent and works out its world
+// transform from the parent's. an entity that sits in the graph has a SceneNode component, and its
+// Transform component is the node's world transform, written by UpdateSceneGraph
+
+// nodes are kept in one flat array in depth first order, so every node comes after its parent and a
+// whole subtree is one contiguous run. moving a node marks it dirty, and the update walks just the
+// runs under dirty nodes, a subtree nobody touched costs nothing. creating, destroying or reparenting
+// nodes only relinks them, the array is put back in order (and every world transform redone) at
+// the next update
+
+// node handles stay the same for as long as the node lives, they are not positions in the array
+
+const s32 SCENE_NODE_FREE = -2;
+
+static struct
+{
+  // by handle
+  en::vector<s32> parent;           // handle, -1 for roots, SCENE_NODE_FREE for free handles
+  en::vector<s32> first_child;
+  en::vector<s32> next_sibling;
+  en::vector<s32> index;            // where the node sits in the arrays below
+  en::vector<s32> free_handles;
+  s32 first_root = -1;              // roots are siblings of each other
+
+  // by position, depth first
+  s32* handle = nullptr;
+  s32* parent_index = nullptr;      // -1 for roots
+  s32* subtree_size = nullptr;      // the node and everything below it
+  Transform* local = nullptr;
+  Transform* world = nullptr;
+  Entity* entity = nullptr;
+  u8* dirty = nullptr;
+  s32 count = 0;
+  s32 capacity = 0;
+
+  en::vector<s32> dirty_nodes;      // positions marked since the last update
+  s32 dirty_count = 0;
+  bool order_dirty = false;         // nodes were added, removed or moved since the last rebuild
+
+  struct
+  {
+    u32 nodes_updated = 0;
+    u32 subtrees = 0;
+    bool rebuilt = false;
+  } stats;                          // for the last UpdateSceneGraph
+} scene_graph;
+
+static void ReserveNodes(s32 capacity)
+{
+  if (capacity <= scene_graph.capacity) return;
+
+  s32 grown = scene_graph.capacity ? scene_graph.capacity : 256;
+  while (grown < capacity) grown *= 2;
+
+  auto grow = [&](auto*& array)
+  {
+    using T = typename std::remove_reference<decltype(*array)>::type;
+    T* bigger = new T[grown];
+    if (array) memcpy((void*)bigger, (void*)array, scene_graph.count * sizeof(T));
+    delete[] array;
+    array = bigger;
+  };
+
+  grow(scene_graph.handle);
+  grow(scene_graph.parent_index);
+  grow(scene_graph.subtree_size);
+  grow(scene_graph.local);
+  grow(scene_graph.world);
+  grow(scene_graph.entity);
+  grow(scene_graph.dirty);
+  scene_graph.capacity = grown;
+}
+
+static inline bool IsNodeAlive(s32 node)
+{
+  return node >= 0 && node < scene_graph.parent.Size() && scene_graph.parent[node] != SCENE_NODE_FREE;
+}
+
+static void LinkNode(s32 node, s32 parent)
+{
+  scene_graph.parent[node] = parent;
+  s32& head = parent >= 0 ? scene_graph.first_child[parent] : scene_graph.first_root;
+  scene_graph.next_sibling[node] = head;
+  head = node;
+}
+
+static void UnlinkNode(s32 node)
+{
+  s32 parent = scene_graph.parent[node];
+  s32* link = parent >= 0 ? &scene_graph.first_child[parent] : &scene_graph.first_root;
+  while (*link != node) link = &scene_graph.next_sibling[*link];
+  *link = scene_graph.next_sibling[node];
+}
+
+static inline void MarkNodeDirty(s32 position)
+{
+  if (scene_graph.dirty[position]) return;
+
+  scene_graph.dirty[position] = 1;
+  if (scene_graph.dirty_count == scene_graph.dirty_nodes.Size()) scene_graph.dirty_nodes.PushBack(position);
+  else scene_graph.dirty_nodes[scene_graph.dirty_count] = position;
+  scene_graph.dirty_count++;
+}
+
+// angles add up, scales multiply, and the local position is scaled and turned by the parent
+static inline Transform ComposeTransform(const Transform& parent, const Transform& local)
+{
+  f32 c = cosf(parent.angle);
+  f32 s = sinf(parent.angle);
+  f32 x = local.position.x() * parent.scale.x();
+  f32 y = local.position.y() * parent.scale.y();
+
+  Transform world;
+  world.position = vec2(parent.position.x() + c * x - s * y, parent.position.y() + s * x + c * y);
+  world.scale = vec2(parent.scale.x() * local.scale.x(), parent.scale.y() * local.scale.y());
+  world.angle = parent.angle + local.angle;
+  return world;
+}
+
+s32 CreateNode(s32 parent, const Transform& local, Entity entity)
+{
+  if (parent >= 0 && !IsNodeAlive(parent)) parent = -1;
+
+  s32 node;
+  if (scene_graph.free_handles.Size() > 0)
+  {
+    node = scene_graph.free_handles[scene_graph.free_handles.Size() - 1];
+    scene_graph.free_handles.PopBack();
+  }
+  else
+  {
+    node = scene_graph.parent.Size();
+    scene_graph.parent.PushBack(-1);
+    scene_graph.first_child.PushBack(-1);
+    scene_graph.next_sibling.PushBack(-1);
+    scene_graph.index.PushBack(-1);
+  }
+
+  scene_graph.first_child[node] = -1;
+  LinkNode(node, parent);
+
+  // goes on the end for now, the next update puts it in its place
+  ReserveNodes(scene_graph.count + 1);
+  s32 position = scene_graph.count++;
+  scene_graph.index[node] = position;
+  scene_graph.handle[position] = node;
+  scene_graph.parent_index[position] = -1;
+  scene_graph.subtree_size[position] = 1;
+  scene_graph.local[position] = local;
+  scene_graph.world[position] = local;
+  scene_graph.entity[position] = entity;
+  scene_graph.dirty[position] = 0;
+  scene_graph.order_dirty = true;
+
+  return node;
+}
+
+// takes every node below it too, the entities on them leave the graph and keep their last world transform
+void DestroyNode(s32 node)
+{
+  if (!IsNodeAlive(node)) return;
+
+  UnlinkNode(node);
+
+  en::vector<s32> stack;
+  stack.PushBack(node);
+  while (stack.Size() > 0)
+  {
+    s32 n = stack[stack.Size() - 1];
+    stack.PopBack();
+
+    for (s32 child = scene_graph.first_child[n]; child >= 0; child = scene_graph.next_sibling[child]) stack.PushBack(child);
+
+    // freed first so the component's teardown finds nothing left to release
+    scene_graph.parent[n] = SCENE_NODE_FREE;
+    scene_graph.handle[scene_graph.index[n]] = -1;
+    scene_graph.free_handles.PushBack(n);
+
+    // the handle gets reused, an entity can't be left holding it
+    Entity entity = scene_graph.entity[scene_graph.index[n]];
+    if (IsEntityAlive(entity)) RemoveComponent(entity, COMPONENT::SCENE_NODE);
+  }
+
+  scene_graph.order_dirty = true;
+}
+
+// just the one node, its children become roots where they last were on screen...it never touches
+// the ECS, so the SceneNode teardown can call it while an entity is being destroyed
+void ReleaseNode(s32 node)
+{
+  if (!IsNodeAlive(node)) return;
+
+  for (s32 child = scene_graph.first_child[node]; child >= 0;)
+  {
+    s32 next = scene_graph.next_sibling[child];
+    scene_graph.local[scene_graph.index[child]] = scene_graph.world[scene_graph.index[child]];
+    UnlinkNode(child);
+    LinkNode(child, -1);
+    child = next;
+  }
+
+  UnlinkNode(node);
+  scene_graph.parent[node] = SCENE_NODE_FREE;
+  scene_graph.handle[scene_graph.index[node]] = -1;
+  scene_graph.free_handles.PushBack(node);
+  scene_graph.order_dirty = true;
+}
+
+// a node can't be moved under itself or anything below it
+void SetNodeParent(s32 node, s32 parent)
+{
+  if (!IsNodeAlive(node) || (parent >= 0 && !IsNodeAlive(parent)) || scene_graph.parent[node] == parent) return;
+
+  for (s32 p = parent; p >= 0; p = scene_graph.parent[p])
+  {
+    if (p == node) return;
+  }
+
+  UnlinkNode(node);
+  LinkNode(node, parent);
+  scene_graph.order_dirty = true;
+}
+
+void SetNodeLocal(s32 node, const Transform& local)
+{
+  if (!IsNodeAlive(node)) return;
+
+  s32 position = scene_graph.index[node];
+  scene_graph.local[position] = local;
+  MarkNodeDirty(position);
+}
+
+void TranslateNode(s32 node, vec2 offset)
+{
+  if (!IsNodeAlive(node)) return;
+
+  s32 position = scene_graph.index[node];
+  Transform& local = scene_graph.local[position];
+  local.position = vec2(local.position.x() + offset.x(), local.position.y() + offset.y());
+  MarkNodeDirty(position);
+}
+
+Transform GetNodeLocal(s32 node)
+{
+  return IsNodeAlive(node) ? scene_graph.local[scene_graph.index[node]] : Transform();
+}
+
+// as of the last update
+Transform GetNodeWorld(s32 node)
+{
+  return IsNodeAlive(node) ? scene_graph.world[scene_graph.index[node]] : Transform();
+}
+
+bool IsRootNode(s32 node)
+{
+  return IsNodeAlive(node) && scene_graph.parent[node] == -1;
+}
+
+// the entity's node, the entity goes in as a root where it is now if it isn't in the graph yet
+s32 EntityNode(Entity entity)
+{
+  Transform* transform = GetComponent<Transform>(entity, COMPONENT::TRANSFORM);
+  if (!transform) return -1;
+
+  Transform world = *transform;
+  AddComponent(entity, COMPONENT::SCENE_NODE);
+  SceneNode* node = GetComponent<SceneNode>(entity, COMPONENT::SCENE_NODE);
+  if (!IsNodeAlive(node->node)) node->node = CreateNode(-1, world, entity);
+  return node->node;
+}
+
+// puts both entities in the graph if they aren't yet, the child keeps where it is on screen
+s32 AttachEntity(Entity child, Entity parent)
+{
+  Transform* parent_transform = GetComponent<Transform>(parent, COMPONENT::TRANSFORM);
+  Transform* child_transform = GetComponent<Transform>(child, COMPONENT::TRANSFORM);
+  if (!parent_transform || !child_transform) return -1;
+
+  Transform parent_world = *parent_transform;
+  Transform child_world = *child_transform;
+
+  s32 parent_handle = EntityNode(parent);
+
+  // the inverse of ComposeTransform against the parent's world transform
+  f32 c = cosf(-parent_world.angle);
+  f32 s = sinf(-parent_world.angle);
+  f32 dx = child_world.position.x() - parent_world.position.x();
+  f32 dy = child_world.position.y() - parent_world.position.y();
+  Transform local;
+  local.position = vec2((c * dx - s * dy) / parent_world.scale.x(), (s * dx + c * dy) / parent_world.scale.y());
+  local.scale = vec2(child_world.scale.x() / parent_world.scale.x(), child_world.scale.y() / parent_world.scale.y());
+  local.angle = child_world.angle - parent_world.angle;
+
+  AddComponent(child, COMPONENT::SCENE_NODE);
+  SceneNode* child_node = GetComponent<SceneNode>(child, COMPONENT::SCENE_NODE);
+  if (IsNodeAlive(child_node->node))
+  {
+    SetNodeParent(child_node->node, parent_handle);
+    SetNodeLocal(child_node->node, local);
+  }
+  else
+  {
+    child_node->node = CreateNode(parent_handle, local, child);
+  }
+
+  return child_node->node;
+}
+
+// lays the live nodes out depth first again, dropping the destroyed ones
+static void RebuildSceneGraphOrder()
+{
+  PROFILE_FUNCTION();
+
+  s32 live = scene_graph.parent.Size() - scene_graph.free_handles.Size();
+  s32* handle = new s32[scene_graph.capacity];
+  s32* parent_index = new s32[scene_graph.capacity];
+  s32* subtree_size = new s32[scene_graph.capacity];
+  Transform* local = new Transform[scene_graph.capacity];
+  Transform* world = new Transform[scene_graph.capacity];
+  Entity* entity = new Entity[scene_graph.capacity];
+  u8* dirty = new u8[scene_graph.capacity];
+
+  en::vector<s32> stack;
+  for (s32 root = scene_graph.first_root; root >= 0; root = scene_graph.next_sibling[root]) stack.PushBack(root);
+
+  s32 count = 0;
+  while (stack.Size() > 0)
+  {
+    s32 node = stack[stack.Size() - 1];
+    stack.PopBack();
+
+    s32 old = scene_graph.index[node];
+    s32 parent = scene_graph.parent[node];
+    handle[count] = node;
+    parent_index[count] = parent >= 0 ? scene_graph.index[parent] : -1;   // parents were placed first, so this is already the new position
+    subtree_size[count] = 1;
+    local[count] = scene_graph.local[old];
+    entity[count] = scene_graph.entity[old];
+    dirty[count] = 0;
+    scene_graph.index[node] = count++;
+
+    for (s32 child = scene_graph.first_child[node]; child >= 0; child = scene_graph.next_sibling[child]) stack.PushBack(child);
+  }
+
+  for (s32 i = count - 1; i > 0; i--)
+  {
+    if (parent_index[i] >= 0) subtree_size[parent_index[i]] += subtree_size[i];
+  }
+
+  delete[] scene_graph.handle;
+  delete[] scene_graph.parent_index;
+  delete[] scene_graph.subtree_size;
+  delete[] scene_graph.local;
+  delete[] scene_graph.world;
+  delete[] scene_graph.entity;
+  delete[] scene_graph.dirty;
+
+  scene_graph.handle = handle;
+  scene_graph.parent_index = parent_index;
+  scene_graph.subtree_size = subtree_size;
+  scene_graph.local = local;
+  scene_graph.world = world;
+  scene_graph.entity = entity;
+  scene_graph.dirty = dirty;
+  scene_graph.count = count;
+  scene_graph.order_dirty = false;
+
+  if (count != live) DebugPrintToConsole("Scene graph lost nodes while rebuilding: ", live - count);
+}
+
+// works out world transforms for the run [first, first + subtree_size) and hands them to the entities
+static void UpdateSubtree(s32 first)
+{
+  s32 end = first + scene_graph.subtree_size[first];
+  const s32* parent_index = scene_graph.parent_index;
+  const Transform* local = scene_graph.local;
+  Transform* world = scene_graph.world;
+
+  for (s32 i = first; i < end; i++)
+  {
+    world[i] = parent_index[i] >= 0 ? ComposeTransform(world[parent_index[i]], local[i]) : local[i];
+    scene_graph.dirty[i] = 0;
+
+    if (scene_graph.entity[i].id != 0)
+    {
+      Transform* transform = GetComponent<Transform>(scene_graph.entity[i], COMPONENT::TRANSFORM);
+      if (transform) *transform = world[i];
+    }
+  }
+
+  scene_graph.stats.nodes_updated += end - first;
+  scene_graph.stats.subtrees++;
+}
+
+void UpdateSceneGraph()
+{
+  PROFILE_FUNCTION();
+
+  scene_graph.stats.nodes_updated = 0;
+  scene_graph.stats.subtrees = 0;
+  scene_graph.stats.rebuilt = scene_graph.order_dirty;
+
+  if (scene_graph.order_dirty)
+  {
+    RebuildSceneGraphOrder();
+
+    // roots are the runs that start where the previous root's run ends
+    for (s32 i = 0; i < scene_graph.count; i += scene_graph.subtree_size[i]) UpdateSubtree(i);
+    scene_graph.dirty_count = 0;
+    return;
+  }
+
+  if (scene_graph.dirty_count == 0) return;
+
+  // in array order a dirty node inside a run that was already redone has nothing left to do
+  s32* dirty = &scene_graph.dirty_nodes[0];
+  std::sort(dirty, dirty + scene_graph.dirty_count);
+
+  s32 done_until = 0;
+  for (s32 d = 0; d < scene_graph.dirty_count; d++)
+  {
+    if (dirty[d] < done_until) continue;
+
+    UpdateSubtree(dirty[d]);
+    done_until = dirty[d] + scene_graph.subtree_size[dirty[d]];
+  }
+
+  scene_graph.dirty_count = 0;
+}
+
+void ClearSceneGraph()
+{
+  scene_graph.parent = en::vector<s32>();
+  scene_graph.first_child = en::vector<s32>();
+  scene_graph.next_sibling = en::vector<s32>();
+  scene_graph.index = en::vector<s32>();
+  scene_graph.free_handles = en::vector<s32>();
+  scene_graph.first_root = -1;
+  scene_graph.count = 0;
+  scene_graph.dirty_count = 0;
+  scene_graph.order_dirty = false;
+}
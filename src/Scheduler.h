@@ -0,0 +1,347 @@
+#pragma once
+
+#include "Core.h"
+#include "Profiler.h"
+#include "WorkerPool.h"
+#include "ECS.h"
+#include "vector.h"
+#include "imgui/imgui.h"
+
+
+/// Scheduler API Reference
+////// void InitSchedule(Schedule& schedule, const char* name);
+////// s32 AddSystem(Schedule& schedule, const char* name, SystemFunc func, AccessMask reads, AccessMask writes, SYSTEM_THREAD thread);
+////// void AddSystemOrder(Schedule& schedule, s32 before, s32 after);
+////// void AddSyncPoint(Schedule& schedule);
+////// void RunSchedule(Schedule& schedule);
+////// AccessMask ComponentAccess(COMPONENT component);
+////// AccessMask ResourceAccess(RESOURCE resource);
+////// void DrawScheduleWindow(bool* open);
+
+// systems say which components and engine resources they read and write, and every run the
+// schedule works out a dependency graph from that: a system waits on every earlier system that
+// writes something it touches or touches something it writes. anything without such a conflict
+// runs at the same time on the worker pool
+
+// on top of the conflicts there are explicit orderings between two systems, and sync points that
+// make everything added after them wait for everything added before. MAIN systems only ever run on
+// the thread calling RunSchedule, that's where gl, glfw and the audio command queue have to be used
+
+// a system that can touch anything declares ACCESS_ALL as its writes and runs on its own
+
+using SystemFunc = void(*)(void);
+using AccessMask = u64;
+
+// engine state that isn't a component, the bits sit above the component bits
+enum class RESOURCE : u8
+{
+  INPUT,
+  AUDIO,
+  ANIMATION,      // the animation states in Animation.h
+  TIMERS,
+  GL,
+  UI,
+  SCENE_GRAPH
+};
+
+const u32 RESOURCE_COUNT = 7;
+
+enum class SYSTEM_THREAD : u8
+{
+  ANY,
+  MAIN
+};
+
+const AccessMask ACCESS_ALL = ~0ull;
+const u32 SCHEDULE_MAX_SYSTEMS = 64;
+
+struct Schedule;
+
+struct SystemInfo
+{
+  const char* name;
+  SystemFunc func;
+  AccessMask reads;
+  AccessMask writes;
+  SYSTEM_THREAD thread;
+  u32 sync_group;                         // sync points passed before the system was added
+  u64 after;                              // explicit orderings, one bit per earlier system
+
+  // rebuilt every run
+  Schedule* schedule;
+  u64 successors;
+  std::atomic<s32> waiting{ 0 };
+  u64 start_ns;
+  u64 end_ns;
+  u32 worker;
+};
+
+struct Schedule
+{
+  const char* name = "";
+  SystemInfo systems[SCHEDULE_MAX_SYSTEMS];
+  u32 count = 0;
+  u32 sync_group = 0;
+
+  std::atomic<u32> remaining{ 0 };
+  std::mutex lock;
+  s32 main_ready[SCHEDULE_MAX_SYSTEMS];   // MAIN systems whose dependencies are done, guarded by lock
+  u32 main_ready_count = 0;
+
+  struct
+  {
+    u64 start_ns = 0;
+    u64 end_ns = 0;
+    u32 edges = 0;
+    u64 busy_ns = 0;                      // time spent inside systems, more than end - start once things overlap
+  } stats;
+};
+
+en::vector<Schedule*> schedules;
+
+static inline AccessMask ComponentAccess(COMPONENT component)
+{
+  return 1ull << (u32)component;
+}
+
+static inline AccessMask ResourceAccess(RESOURCE resource)
+{
+  return 1ull << (32 + (u32)resource);
+}
+
+void InitSchedule(Schedule& schedule, const char* name)
+{
+  schedule.name = name;
+  schedule.count = 0;
+  schedule.sync_group = 0;
+  schedules.PushBack(&schedule);
+}
+
+s32 AddSystem(Schedule& schedule, const char* name, SystemFunc func, AccessMask reads, AccessMask writes, SYSTEM_THREAD thread)
+{
+  if (schedule.count == SCHEDULE_MAX_SYSTEMS)
+  {
+    DebugPrintToConsole("Too many systems in schedule: ", schedule.name);
+    return -1;
+  }
+
+  SystemInfo& system = schedule.systems[schedule.count];
+  system.name = name;
+  system.func = func;
+  system.reads = reads;
+  system.writes = writes;
+  system.thread = thread;
+  system.sync_group = schedule.sync_group;
+  system.after = 0;
+  system.schedule = &schedule;
+  system.start_ns = 0;
+  system.end_ns = 0;
+  system.worker = 0;
+
+  return (s32)schedule.count++;
+}
+
+// orderings only go forwards, a system can only be made to wait on one added before it
+void AddSystemOrder(Schedule& schedule, s32 before, s32 after)
+{
+  if (before < 0 || after < 0 || before >= after || after >= (s32)schedule.count) return;
+  schedule.systems[after].after |= 1ull << before;
+}
+
+void AddSyncPoint(Schedule& schedule)
+{
+  schedule.sync_group++;
+}
+
+static void BuildScheduleGraph(Schedule& schedule)
+{
+  schedule.stats.edges = 0;
+  for (u32 i = 0; i < schedule.count; i++) schedule.systems[i].successors = 0;
+
+  for (u32 i = 0; i < schedule.count; i++)
+  {
+    SystemInfo& system = schedule.systems[i];
+    s32 waiting = 0;
+
+    for (u32 j = 0; j < i; j++)
+    {
+      SystemInfo& earlier = schedule.systems[j];
+      bool conflict = (earlier.writes & (system.reads | system.writes)) || (system.writes & earlier.reads);
+      bool ordered = (system.after >> j) & 1;
+      bool synced = earlier.sync_group != system.sync_group;
+
+      if (conflict || ordered || synced)
+      {
+        earlier.successors |= 1ull << i;
+        waiting++;
+      }
+    }
+
+    system.waiting.store(waiting, std::memory_order_relaxed);
+    schedule.stats.edges += waiting;
+  }
+}
+
+static void RunScheduledSystem(void* data);
+
+static void DispatchSystem(Schedule& schedule, u32 index)
+{
+  if (schedule.systems[index].thread == SYSTEM_THREAD::MAIN)
+  {
+    std::lock_guard<std::mutex> lock(schedule.lock);
+    schedule.main_ready[schedule.main_ready_count++] = (s32)index;
+  }
+  else
+  {
+    RunJob(RunScheduledSystem, &schedule.systems[index], nullptr);
+  }
+}
+
+static void RunScheduledSystem(void* data)
+{
+  SystemInfo& system = *(SystemInfo*)data;
+  Schedule& schedule = *system.schedule;
+
+  system.worker = WorkerIndex();
+  system.start_ns = ProfilerNow();
+  {
+    PROFILE_SCOPE(system.name);
+    system.func();
+  }
+  system.end_ns = ProfilerNow();
+
+  // successors are always systems added later
+  for (u32 next = (u32)(&system - schedule.systems) + 1; next < schedule.count; next++)
+  {
+    if (!((system.successors >> next) & 1)) continue;
+    if (schedule.systems[next].waiting.fetch_sub(1, std::memory_order_acq_rel) == 1) DispatchSystem(schedule, next);
+  }
+
+  schedule.remaining.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+void RunSchedule(Schedule& schedule)
+{
+  PROFILE_SCOPE(schedule.name);
+
+  if (schedule.count == 0) return;
+
+  schedule.stats.start_ns = ProfilerNow();
+  BuildScheduleGraph(schedule);
+  schedule.remaining.store(schedule.count, std::memory_order_release);
+  schedule.main_ready_count = 0;
+
+  // roots are picked out before any of them run, after that a finished system can bring others down to 0
+  u64 roots = 0;
+  for (u32 i = 0; i < schedule.count; i++)
+  {
+    if (schedule.systems[i].waiting.load(std::memory_order_relaxed) == 0) roots |= 1ull << i;
+  }
+
+  for (u32 i = 0; i < schedule.count; i++)
+  {
+    if ((roots >> i) & 1) DispatchSystem(schedule, i);
+  }
+
+  // the calling thread runs the MAIN systems as they come free and helps out with jobs in between
+  while (schedule.remaining.load(std::memory_order_acquire) > 0)
+  {
+    s32 ready = -1;
+    {
+      std::lock_guard<std::mutex> lock(schedule.lock);
+      if (schedule.main_ready_count > 0) ready = schedule.main_ready[--schedule.main_ready_count];
+    }
+
+    if (ready >= 0) RunScheduledSystem(&schedule.systems[ready]);
+    else if (!RunOneJob()) std::this_thread::yield();
+  }
+
+  schedule.stats.end_ns = ProfilerNow();
+  schedule.stats.busy_ns = 0;
+  for (u32 i = 0; i < schedule.count; i++) schedule.stats.busy_ns += schedule.systems[i].end_ns - schedule.systems[i].start_ns;
+}
+
+static void AccessNames(AccessMask mask, char* out, u32 size)
+{
+  static const char* resource_names[] = { "Input", "Audio", "Animation", "Timers", "GL", "UI", "SceneGraph" };
+
+  out[0] = 0;
+  if (mask == ACCESS_ALL)
+  {
+    snprintf(out, size, "everything");
+    return;
+  }
+
+  u32 used = 0;
+  for (u32 bit = 0; bit < 64 && used < size; bit++)
+  {
+    if (!((mask >> bit) & 1)) continue;
+
+    const char* name = bit < COMPONENT_COUNT ? component_names[bit] : bit >= 32 && bit - 32 < RESOURCE_COUNT ? resource_names[bit - 32] : "?";
+    used += snprintf(out + used, size - used, used ? ", %s" : "%s", name);
+  }
+}
+
+// one lane per thread with every system of the last run where and when it ran, like the profiler
+// but without needing EN_PROFILE
+void DrawScheduleWindow(bool* open)
+{
+  if (!ImGui::Begin("Schedule", open))
+  {
+    ImGui::End();
+    return;
+  }
+
+  ImGui::Text("%u workers", WorkerCount());
+
+  for (Schedule* schedule : schedules)
+  {
+    f64 span_ns = (f64)(schedule->stats.end_ns - schedule->stats.start_ns);
+    ImGui::Separator();
+    ImGui::Text("%s: %u systems, %u edges, %.3f ms (%.3f ms of work)", schedule->name, schedule->count, schedule->stats.edges,
+      span_ns / 1e6, schedule->stats.busy_ns / 1e6);
+    if (span_ns <= 0.0) continue;
+
+    ImDrawList* draw_list = ImGui::GetWindowDrawList();
+    f32 width = ImGui::GetContentRegionAvail().x;
+    f32 row_height = ImGui::GetTextLineHeight() + 4.f;
+    f64 px_per_ns = width / span_ns;
+    ImVec2 mouse = ImGui::GetIO().MousePos;
+
+    for (u32 lane = 0; lane <= WorkerCount(); lane++)
+    {
+      ImVec2 origin = ImGui::GetCursorScreenPos();
+      ImGui::PushID((s32)lane);
+      ImGui::InvisibleButton("lane", ImVec2(width, row_height));
+      ImGui::PopID();
+
+      for (u32 i = 0; i < schedule->count; i++)
+      {
+        const SystemInfo& system = schedule->systems[i];
+        if (system.worker != lane) continue;
+
+        ImVec2 min = ImVec2(origin.x + (f32)((system.start_ns - schedule->stats.start_ns) * px_per_ns), origin.y);
+        ImVec2 max = ImVec2(origin.x + (f32)((system.end_ns - schedule->stats.start_ns) * px_per_ns), origin.y + row_height - 1.f);
+        if (max.x - min.x < 1.f) max.x = min.x + 1.f;
+
+        draw_list->AddRectFilled(min, max, system.thread == SYSTEM_THREAD::MAIN ? IM_COL32(200, 140, 90, 255) : IM_COL32(110, 170, 210, 255));
+        if (max.x - min.x > 20.f)
+        {
+          ImVec4 clip = ImVec4(min.x, min.y, max.x - 2.f, max.y);
+          draw_list->AddText(nullptr, 0.f, ImVec2(min.x + 2.f, min.y + 2.f), IM_COL32_BLACK, system.name, nullptr, 0.f, &clip);
+        }
+
+        if (mouse.x >= min.x && mouse.x < max.x && mouse.y >= min.y && mouse.y < max.y)
+        {
+          char reads[128], writes[128];
+          AccessNames(system.reads, reads, sizeof(reads));
+          AccessNames(system.writes, writes, sizeof(writes));
+          ImGui::SetTooltip("%s on %s\n%.3f ms\nreads: %s\nwrites: %s", system.name, lane == 0 ? "main" : "a worker",
+            (system.end_ns - system.start_ns) / 1e6, reads, writes);
+        }
+      }
+    }
+  }
+
+  ImGui::End();
+}
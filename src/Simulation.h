@@ -0,0 +1,56 @@
+#pragma once
+
+#include "Core.h"
+#include <chrono>
+
+
+/// Simulation API Reference
+////// u64 SimulationNow();
+////// u32 AdvanceSimulation(u64 now_ns, SimulationTickFunc tick);
+
+// gameplay runs on fixed ticks so the same input always produces the same result no matter what
+// the frame rate is...input events are timestamped on the same clock as the simulation and each
+// tick consumes the events that happened before the end of that tick
+
+using SimulationTickFunc = void(*)(void);
+
+const u32 SIMULATION_TICK_HZ = 120;
+const u64 SIMULATION_TICK_NS = 1000000000ull / SIMULATION_TICK_HZ;
+const f32 SIMULATION_TICK_SECONDS = 1.f / SIMULATION_TICK_HZ;
+const u32 MAX_SIMULATION_TICKS_PER_FRAME = 8;   // after a long hitch the simulation skips ahead instead of spiraling
+
+static struct
+{
+  u64 tick = 0;           // index of the next tick to run
+  u64 time_ns = 0;        // simulation clock at the start of the next tick
+  u64 skipped_ticks = 0;
+} simulation;
+
+static inline u64 SimulationNow()
+{
+  static const auto origin = std::chrono::steady_clock::now();
+  return (u64)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - origin).count();
+}
+
+// runs every whole tick between the simulation clock and now_ns, returns how many ran
+u32 AdvanceSimulation(u64 now_ns, SimulationTickFunc tick)
+{
+  u32 ticks = 0;
+
+  if (now_ns > simulation.time_ns + MAX_SIMULATION_TICKS_PER_FRAME * SIMULATION_TICK_NS)
+  {
+    u64 behind = (now_ns - simulation.time_ns) / SIMULATION_TICK_NS - MAX_SIMULATION_TICKS_PER_FRAME;
+    simulation.time_ns += behind * SIMULATION_TICK_NS;
+    simulation.skipped_ticks += behind;
+  }
+
+  while (simulation.time_ns + SIMULATION_TICK_NS <= now_ns)
+  {
+    tick();
+    simulation.time_ns += SIMULATION_TICK_NS;
+    simulation.tick++;
+    ticks++;
+  }
+
+  return ticks;
+}
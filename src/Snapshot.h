@@ -0,0 +1,1327 @@
+#pragma once
+
+#include "Core.h"
+#include "Profiler.h"
+#include "vector.h"
+#include "Simulation.h"
+#include "Random.h"
+#include "TimerWheel.h"
+#include "ECS.h"
+#include "Animation.h"
+#include "SceneGraph.h"
+#include "Compression.h"
+#include "WorkerPool.h"
+#include <cfloat>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#endif
+
+
+/// Snapshot API Reference
+////// void CaptureSnapshot(Snapshot& snapshot);
+////// bool RestoreSnapshot(Snapshot& snapshot);
+////// void DiffSnapshot(Snapshot& baseline, Snapshot& snapshot, Snapshot& delta);
+////// bool ApplySnapshotDelta(Snapshot& baseline, Snapshot& delta, Snapshot& snapshot);
+////// bool CompressSnapshot(Snapshot& snapshot, Snapshot* baseline, Snapshot& compressed);
+////// bool DecompressSnapshot(Snapshot& compressed, Snapshot* baseline, Snapshot& snapshot);
+////// bool SaveSnapshot(Snapshot& snapshot, const char* path);
+////// void SaveSnapshotAsync(Snapshot& snapshot, Snapshot* baseline, const char* path);
+////// void WaitForSnapshotWrites();
+////// bool LoadSnapshot(Snapshot& snapshot, const char* path, Snapshot* baseline = nullptr);
+////// void FreeSnapshot(Snapshot& snapshot);
+
+// a snapshot is the whole simulation in one buffer: the tick, the calling thread's random stream, the
+// timer wheel, every entity (the ecs slot tables and each archetype's chunks exactly as they sit in
+// memory), the animation states and the scene graph. everything is already flat arrays, so capturing
+// is a run of memcpys into the buffer and restoring is a run of memcpys back out
+
+// the buffer is a header and one section per system, and inside a section every array is a count and
+// its elements, each starting on SNAPSHOT_ALIGN bytes. the layout only depends on how many of each
+// thing there are, so two snapshots of nearby ticks line up byte for byte and a delta against a
+// baseline only has to carry the blocks that changed
+
+// components and timers are stored as they are, so a snapshot is only good for the build that wrote
+// it...gl names, sounds and prefab ids in components are taken to still mean the same thing. timer
+// callbacks are stored as the ids they were registered under, a snapshot with a timer whose callback
+// this build doesn't know is turned away
+
+// restoring checks the whole buffer before touching anything, every count and every index included, so
+// a snapshot that doesn't fit leaves the simulation as it was. restore between ticks, never while a schedule is running
+
+// on disk a snapshot is compressed: xor'd against a baseline snapshot when there is one, so whatever
+// didn't change turns into zeroes, shuffled 4 bytes at a time so the floats' exponents line up, then
+// run through LzCompress. SaveSnapshotAsync does the filtering into a buffer of its own on the
+// calling thread and hands compressing and writing to a worker, the caller can reuse the snapshot
+// straight away. filtering uses scratch buffers shared by everyone, keep it to one thread
+
+// files are written next to where they go and renamed over them once complete, a crash halfway
+// through a save leaves the last good one in place. only one write per path is ever in flight, saving
+// again while one is still going queues the new one behind it and replaces anything already queued
+
+const u32 SNAPSHOT_MAGIC = 0x50414E53;          // "SNAP"
+const u32 SNAPSHOT_DELTA_MAGIC = 0x544C4544;    // "DELT"
+const u32 SNAPSHOT_VERSION = 3;
+const u32 SNAPSHOT_ALIGN = 16;
+const u32 SNAPSHOT_DELTA_BLOCK = 64;
+const u32 SNAPSHOT_COMPRESSED_MAGIC = 0x5A504E53;   // "SNPZ"
+const u32 SNAPSHOT_SHUFFLE_STRIDE = 4;
+const u64 SNAPSHOT_MAX_BYTES = 1ull << 30;  // far past any real world, sizes read from a file are held to it
+
+const u32 SNAPSHOT_FILTER_XOR = 1 << 0;
+const u32 SNAPSHOT_FILTER_SHUFFLE = 1 << 1;
+
+enum class SNAPSHOT_SECTION : u32
+{
+  SIMULATION,
+  RANDOM,
+  TIMERS,
+  ENTITIES,
+  ANIMATIONS,
+  SCENE_GRAPH
+};
+
+const u32 SNAPSHOT_SECTION_COUNT = 6;
+
+struct Snapshot
+{
+  u8* data = nullptr;
+  u64 size = 0;
+  u64 capacity = 0;
+};
+
+struct SnapshotHeader
+{
+  u32 magic;
+  u32 version;
+  u64 tick;
+  u64 bytes;              // the whole snapshot, header included
+  u64 reserved;
+};
+
+struct SnapshotSectionHeader
+{
+  u32 section;
+  u32 reserved;
+  u64 bytes;              // everything after this header up to the next one
+};
+
+struct CompressedSnapshotHeader
+{
+  u32 magic;
+  u32 version;
+  u64 tick;
+  u64 bytes;              // of the snapshot once decompressed
+  u64 baseline_tick;
+  u64 baseline_bytes;
+  u32 filters;
+  u32 reserved;
+  u64 compressed_bytes;   // what follows the header
+};
+
+struct SnapshotArrayHeader
+{
+  u64 count;
+  u64 element_size;
+};
+
+struct SnapshotDeltaHeader
+{
+  u32 magic;
+  u32 version;
+  u64 baseline_tick;
+  u64 baseline_bytes;
+  u64 bytes;              // of the snapshot the delta rebuilds
+  u64 runs;
+  u64 reserved;
+};
+
+struct SnapshotDeltaRun
+{
+  u64 offset;
+  u64 bytes;
+};
+
+// where an array sits inside the buffer being restored
+struct SnapshotArray
+{
+  const u8* data = nullptr;
+  s32 count = 0;
+};
+
+struct SnapshotReader
+{
+  const u8* data;
+  u64 at;
+  u64 end;
+  bool ok;
+};
+
+static inline u64 SnapshotAligned(u64 bytes)
+{
+  return (bytes + SNAPSHOT_ALIGN - 1) & ~(u64)(SNAPSHOT_ALIGN - 1);
+}
+
+static void ReserveSnapshot(Snapshot& snapshot, u64 capacity)
+{
+  if (capacity <= snapshot.capacity) return;
+
+  u64 grown = snapshot.capacity ? snapshot.capacity : 64 * 1024;
+  while (grown < capacity) grown *= 2;
+
+  u8* bigger = new u8[grown];
+  if (snapshot.size) memcpy(bigger, snapshot.data, snapshot.size);
+  delete[] snapshot.data;
+  snapshot.data = bigger;
+  snapshot.capacity = grown;
+}
+
+// room for bytes at the end of the snapshot, padded out to the next SNAPSHOT_ALIGN with zeroes
+static u8* AppendSnapshot(Snapshot& snapshot, u64 bytes)
+{
+  u64 aligned = SnapshotAligned(bytes);
+  ReserveSnapshot(snapshot, snapshot.size + aligned);
+
+  u8* at = snapshot.data + snapshot.size;
+  if (aligned != bytes) memset(at + bytes, 0, aligned - bytes);
+  snapshot.size += aligned;
+  return at;
+}
+
+static inline void WriteSnapshot(Snapshot& snapshot, const void* data, u64 bytes)
+{
+  memcpy(AppendSnapshot(snapshot, bytes), data, bytes);
+}
+
+// the array header, and room for the elements right after it for whoever fills them in
+static u8* AppendSnapshotArray(Snapshot& snapshot, s32 count, u64 element_size)
+{
+  SnapshotArrayHeader header = { (u64)count, element_size };
+  WriteSnapshot(snapshot, &header, sizeof(header));
+  return AppendSnapshot(snapshot, (u64)count * element_size);
+}
+
+template <typename T>
+static void WriteSnapshotArray(Snapshot& snapshot, const T* values, s32 count)
+{
+  u8* at = AppendSnapshotArray(snapshot, count, sizeof(T));
+  if (count > 0) memcpy(at, (const void*)values, (u64)count * sizeof(T));
+}
+
+template <typename T>
+static inline void WriteSnapshotVector(Snapshot& snapshot, en::vector<T>& values)
+{
+  WriteSnapshotArray(snapshot, values.begin(), values.Size());
+}
+
+static u64 BeginSnapshotSection(Snapshot& snapshot, SNAPSHOT_SECTION section)
+{
+  SnapshotSectionHeader header = { (u32)section, 0, 0 };
+  WriteSnapshot(snapshot, &header, sizeof(header));
+  return snapshot.size;
+}
+
+static void EndSnapshotSection(Snapshot& snapshot, u64 start)
+{
+  ((SnapshotSectionHeader*)(snapshot.data + start - sizeof(SnapshotSectionHeader)))->bytes = snapshot.size - start;
+}
+
+static const u8* ReadSnapshot(SnapshotReader& reader, u64 bytes)
+{
+  u64 aligned = SnapshotAligned(bytes);
+  if (!reader.ok || aligned > reader.end - reader.at)
+  {
+    reader.ok = false;
+    return nullptr;
+  }
+
+  const u8* at = reader.data + reader.at;
+  reader.at += aligned;
+  return at;
+}
+
+template <typename T>
+static bool ReadSnapshotValue(SnapshotReader& reader, T& value)
+{
+  const u8* at = ReadSnapshot(reader, sizeof(T));
+  if (at) memcpy((void*)&value, at, sizeof(T));
+  return at != nullptr;
+}
+
+// fails on an array of anything but T, which is what a snapshot from another build would look like
+template <typename T>
+static bool ReadSnapshotArray(SnapshotReader& reader, SnapshotArray& array)
+{
+  SnapshotArrayHeader header;
+  if (!ReadSnapshotValue(reader, header) || header.element_size != sizeof(T) || header.count > 0x7FFFFFFF)
+  {
+    reader.ok = false;
+    return false;
+  }
+
+  array.count = (s32)header.count;
+  array.data = ReadSnapshot(reader, header.count * sizeof(T));
+  return reader.ok;
+}
+
+template <typename T>
+static inline void RestoreSnapshotVector(en::vector<T>& values, const SnapshotArray& array)
+{
+  values.Assign((const T*)array.data, array.count);
+}
+
+// for the index arrays, every value has to be in [low, high)
+static bool SnapshotIndicesInRange(const SnapshotArray& array, s32 low, s32 high)
+{
+  const s32* values = (const s32*)array.data;
+  for (s32 i = 0; i < array.count; i++)
+  {
+    if (values[i] < low || values[i] >= high) return false;
+  }
+  return true;
+}
+
+// a section's reader, limited to the section so a bad count can't run into the next one
+static bool ReadSnapshotSection(SnapshotReader& reader, SNAPSHOT_SECTION section, SnapshotReader& contents)
+{
+  SnapshotSectionHeader header;
+  if (!ReadSnapshotValue(reader, header) || header.section != (u32)section || header.bytes > reader.end - reader.at)
+  {
+    reader.ok = false;
+    return false;
+  }
+
+  contents = { reader.data, reader.at, reader.at + header.bytes, true };
+  reader.at += header.bytes;
+  return true;
+}
+
+// ---- simulation clock and random stream
+
+struct RandomSnapshot
+{
+  u64 seed;
+  u32 stream;
+  RandomThreadState state;
+};
+
+static void CaptureRandom(Snapshot& snapshot)
+{
+  RandomSnapshot random;
+  memset((void*)&random, 0, sizeof(random));
+  // a thread that hasn't drawn a number since the last seed picks up its stream here, before it's read
+  random.state = RandomState();
+  random.seed = random_context.seed.load();
+  random.stream = random_thread_stream;
+  WriteSnapshot(snapshot, &random, sizeof(random));
+}
+
+// only the calling thread's stream goes back, other threads carry on with theirs
+static void RestoreRandom(const RandomSnapshot& random)
+{
+  random_context.seed.store(random.seed);
+  random_thread_stream = random.stream;
+  random_thread_state = random.state;
+  random_thread_state.seed_generation = random_context.seed_generation.load();
+}
+
+// ---- timer wheel
+
+struct TimerWheelSnapshot
+{
+  u64 tick;
+  u32 pending;
+  s32 free_head;
+  s32 heads[TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOTS + 1];
+};
+
+struct TimerWheelView
+{
+  TimerWheelSnapshot state;
+  SnapshotArray expiry, period, callback, user_data, generation, next, prev, bucket;
+};
+
+static void CaptureTimers(Snapshot& snapshot)
+{
+  if (!timer_wheel.initialized) InitTimerWheel();
+
+  // zeroed first so the padding is the same in every capture, and not whatever was on the stack
+  TimerWheelSnapshot state;
+  memset((void*)&state, 0, sizeof(state));
+  state.tick = timer_wheel.tick;
+  state.pending = timer_wheel.pending;
+  state.free_head = timer_wheel.free_head;
+  memcpy(state.heads, timer_wheel.heads, sizeof(state.heads));
+  WriteSnapshot(snapshot, &state, sizeof(state));
+
+  WriteSnapshotVector(snapshot, timer_wheel.expiry);
+  WriteSnapshotVector(snapshot, timer_wheel.period);
+
+  // nearly every timer shares its callback with the one before it, so the last lookup is kept
+  s32 count = timer_wheel.callback.Size();
+  u64* callbacks = (u64*)AppendSnapshotArray(snapshot, count, sizeof(u64));
+  TimerCallback last = nullptr;
+  u64 last_id = 0;
+  for (s32 t = 0; t < count; t++)
+  {
+    TimerCallback callback = timer_wheel.callback[t];
+    if (callback != last) last_id = callback ? TimerCallbackId(callback) : 0;
+    last = callback;
+    callbacks[t] = last_id;
+  }
+
+  WriteSnapshotVector(snapshot, timer_wheel.user_data);
+  WriteSnapshotVector(snapshot, timer_wheel.generation);
+  WriteSnapshotVector(snapshot, timer_wheel.next);
+  WriteSnapshotVector(snapshot, timer_wheel.prev);
+  WriteSnapshotVector(snapshot, timer_wheel.bucket);
+}
+
+static bool ReadTimers(SnapshotReader& reader, TimerWheelView& view)
+{
+  ReadSnapshotValue(reader, view.state);
+  ReadSnapshotArray<u64>(reader, view.expiry);
+  ReadSnapshotArray<u64>(reader, view.period);
+  ReadSnapshotArray<u64>(reader, view.callback);
+  ReadSnapshotArray<u64>(reader, view.user_data);
+  ReadSnapshotArray<u32>(reader, view.generation);
+  ReadSnapshotArray<s32>(reader, view.next);
+  ReadSnapshotArray<s32>(reader, view.prev);
+  ReadSnapshotArray<s32>(reader, view.bucket);
+
+  s32 count = view.expiry.count;
+  if (!reader.ok || view.period.count != count || view.callback.count != count || view.user_data.count != count ||
+    view.generation.count != count || view.next.count != count || view.prev.count != count || view.bucket.count != count) return false;
+
+  // snapshots are taken between ticks, nothing is halfway through firing
+  if (view.state.pending > (u32)count || view.state.free_head < -1 || view.state.free_head >= count) return false;
+  for (s32 b = 0; b < TIMER_WHEEL_FIRING; b++)
+  {
+    if (view.state.heads[b] < -1 || view.state.heads[b] >= count) return false;
+  }
+  if (view.state.heads[TIMER_WHEEL_FIRING] != -1) return false;
+
+  if (!SnapshotIndicesInRange(view.next, -1, count) || !SnapshotIndicesInRange(view.prev, -1, count) ||
+    !SnapshotIndicesInRange(view.bucket, -1, TIMER_WHEEL_FIRING)) return false;
+
+  // a scheduled timer has to have a callback this build knows, free slots keep whatever they last had
+  const u64* callbacks = (const u64*)view.callback.data;
+  const s32* bucket = (const s32*)view.bucket.data;
+  for (s32 t = 0; t < count; t++)
+  {
+    if (bucket[t] >= 0 && !FindTimerCallback(callbacks[t])) return false;
+  }
+
+  return true;
+}
+
+static void RestoreTimers(TimerWheelView& view)
+{
+  timer_wheel.tick = view.state.tick;
+  timer_wheel.pending = view.state.pending;
+  timer_wheel.free_head = view.state.free_head;
+  memcpy(timer_wheel.heads, view.state.heads, sizeof(timer_wheel.heads));
+  timer_wheel.initialized = true;
+
+  RestoreSnapshotVector(timer_wheel.expiry, view.expiry);
+  RestoreSnapshotVector(timer_wheel.period, view.period);
+  RestoreSnapshotVector(timer_wheel.user_data, view.user_data);
+  RestoreSnapshotVector(timer_wheel.generation, view.generation);
+  RestoreSnapshotVector(timer_wheel.next, view.next);
+  RestoreSnapshotVector(timer_wheel.prev, view.prev);
+  RestoreSnapshotVector(timer_wheel.bucket, view.bucket);
+
+  const u64* callbacks = (const u64*)view.callback.data;
+  timer_wheel.callback.Assign(nullptr, 0);
+  for (s32 t = 0; t < view.callback.count; t++)
+  {
+    TimerCallback callback = callbacks[t] ? FindTimerCallback(callbacks[t]) : nullptr;
+    timer_wheel.callback.PushBack(callback);
+  }
+}
+
+// ---- entities
+
+struct EntitySnapshot
+{
+  u32 live;
+  s32 archetypes;
+};
+
+struct ArchetypeSnapshot
+{
+  ComponentMask mask;
+  s32 chunk_capacity;
+  s32 count;
+  s32 chunks;
+};
+
+struct EntityView
+{
+  EntitySnapshot state;
+  SnapshotArray archetype, row, generation, free_entities;
+};
+
+// kept between restores so restoring doesn't allocate
+static struct
+{
+  en::vector<ArchetypeSnapshot> archetypes;
+  en::vector<const u8*> chunks;         // every archetype's chunks back to back
+  en::vector<s32> targets;              // the archetype each one is in this run, they needn't be in the same order
+} snapshot_archetypes;
+
+static void CaptureEntities(Snapshot& snapshot)
+{
+  EntitySnapshot state;
+  memset((void*)&state, 0, sizeof(state));
+  state.live = ecs.live;
+  state.archetypes = ecs.archetypes.Size();
+  WriteSnapshot(snapshot, &state, sizeof(state));
+
+  WriteSnapshotVector(snapshot, ecs.entity_archetype);
+  WriteSnapshotVector(snapshot, ecs.entity_row);
+  WriteSnapshotVector(snapshot, ecs.entity_generation);
+  WriteSnapshotVector(snapshot, ecs.free_entities);
+
+  for (auto& archetype : ecs.archetypes)
+  {
+    s32 chunks = (archetype.count + archetype.chunk_capacity - 1) / archetype.chunk_capacity;
+    ArchetypeSnapshot record;
+    memset((void*)&record, 0, sizeof(record));
+    record.mask = archetype.mask;
+    record.chunk_capacity = archetype.chunk_capacity;
+    record.count = archetype.count;
+    record.chunks = chunks;
+    WriteSnapshot(snapshot, &record, sizeof(record));
+
+    for (s32 c = 0; c < chunks; c++) WriteSnapshot(snapshot, archetype.chunks[c], ECS_CHUNK_BYTES);
+  }
+}
+
+// archetypes are matched up by mask, a snapshot from a run that made them in another order restores
+// fine...the ones this run hasn't made yet are only checked against the layout they'd get, restoring
+// makes them
+static bool ReadEntities(SnapshotReader& reader, EntityView& view)
+{
+  ReadSnapshotValue(reader, view.state);
+  ReadSnapshotArray<s32>(reader, view.archetype);
+  ReadSnapshotArray<s32>(reader, view.row);
+  ReadSnapshotArray<u32>(reader, view.generation);
+  ReadSnapshotArray<s32>(reader, view.free_entities);
+  if (!reader.ok || view.row.count != view.archetype.count || view.generation.count != view.archetype.count) return false;
+
+  snapshot_archetypes.archetypes.Assign(nullptr, 0);
+  snapshot_archetypes.chunks.Assign(nullptr, 0);
+  snapshot_archetypes.targets.Assign(nullptr, 0);
+
+  for (s32 a = 0; a < view.state.archetypes; a++)
+  {
+    ArchetypeSnapshot record;
+    if (!ReadSnapshotValue(reader, record) || (record.mask >> COMPONENT_COUNT) != 0 || record.count < 0) return false;
+
+    s32 column_offsets[COMPONENT_COUNT];
+    if (ArchetypeLayout(record.mask, column_offsets) != record.chunk_capacity) return false;
+    if (record.chunks != (record.count + record.chunk_capacity - 1) / record.chunk_capacity) return false;
+    for (auto& earlier : snapshot_archetypes.archetypes)
+    {
+      if (earlier.mask == record.mask) return false;
+    }
+
+    snapshot_archetypes.archetypes.PushBack(record);
+    for (s32 c = 0; c < record.chunks; c++) snapshot_archetypes.chunks.PushBack(ReadSnapshot(reader, ECS_CHUNK_BYTES));
+  }
+
+  if (!reader.ok) return false;
+
+  // free slots are -1, live ones have to sit on a row their archetype actually has
+  s32 slots = view.archetype.count;
+  const s32* archetype = (const s32*)view.archetype.data;
+  const s32* row = (const s32*)view.row.data;
+  for (s32 slot = 0; slot < slots; slot++)
+  {
+    if (archetype[slot] < -1 || archetype[slot] >= view.state.archetypes) return false;
+    if (archetype[slot] >= 0 && (row[slot] < 0 || row[slot] >= snapshot_archetypes.archetypes[archetype[slot]].count)) return false;
+  }
+
+  return view.state.live <= (u32)slots && SnapshotIndicesInRange(view.free_entities, 0, slots);
+}
+
+// what's in the chunks, once the other sections are read...every row's entity has to be the one the
+// slot tables put there, RemoveRow goes by it, and the handles components hold have to be in range
+static bool ChunkContentsInRange(EntityView& view, s32 animation_count, s32 node_handles)
+{
+  s32 slots = view.archetype.count;
+  const s32* archetype = (const s32*)view.archetype.data;
+  const s32* row = (const s32*)view.row.data;
+  const u32* generation = (const u32*)view.generation.data;
+
+  s32 chunk = 0;
+  for (s32 a = 0; a < snapshot_archetypes.archetypes.Size(); a++)
+  {
+    ArchetypeSnapshot& record = snapshot_archetypes.archetypes[a];
+    s32 column_offsets[COMPONENT_COUNT];
+    ArchetypeLayout(record.mask, column_offsets);
+    s32 animated = column_offsets[(u32)COMPONENT::ANIMATED];
+    s32 scene_node = column_offsets[(u32)COMPONENT::SCENE_NODE];
+
+    for (s32 r = 0; r < record.count; r++)
+    {
+      const u8* data = snapshot_archetypes.chunks[chunk + r / record.chunk_capacity];
+      s32 at = r % record.chunk_capacity;
+
+      Entity entity = ((const Entity*)data)[at];
+      s32 slot = (s32)(entity.id & 0xFFFFFFFF);
+      if ((entity.id & 0xFFFFFFFF) >= (u64)slots || archetype[slot] != a || row[slot] != r || generation[slot] != (u32)(entity.id >> 32)) return false;
+
+      if (animated >= 0)
+      {
+        s32 animation = ((const Animated*)(data + animated))[at].animation;
+        if (animation < -1 || animation >= animation_count) return false;
+      }
+
+      if (scene_node >= 0)
+      {
+        s32 node = ((const SceneNode*)(data + scene_node))[at].node;
+        if (node < -1 || node >= node_handles) return false;
+      }
+    }
+
+    chunk += record.chunks;
+  }
+
+  return true;
+}
+
+static void RestoreEntities(EntityView& view)
+{
+  for (auto& archetype : ecs.archetypes) archetype.count = 0;
+  for (auto& record : snapshot_archetypes.archetypes) snapshot_archetypes.targets.PushBack(FindArchetype(record.mask));
+
+  s32 chunk = 0;
+  for (s32 a = 0; a < snapshot_archetypes.archetypes.Size(); a++)
+  {
+    EcsArchetype& archetype = ecs.archetypes[snapshot_archetypes.targets[a]];
+    archetype.count = snapshot_archetypes.archetypes[a].count;
+
+    for (s32 c = 0; c < snapshot_archetypes.archetypes[a].chunks; c++)
+    {
+      if (c >= archetype.chunks.Size())
+      {
+        archetype.chunks.PushBack(new u8[ECS_CHUNK_BYTES]);
+        ecs.stats.chunks++;
+      }
+
+      memcpy(archetype.chunks[c], snapshot_archetypes.chunks[chunk++], ECS_CHUNK_BYTES);
+    }
+  }
+
+  RestoreSnapshotVector(ecs.entity_archetype, view.archetype);
+  RestoreSnapshotVector(ecs.entity_row, view.row);
+  RestoreSnapshotVector(ecs.entity_generation, view.generation);
+  RestoreSnapshotVector(ecs.free_entities, view.free_entities);
+  ecs.live = view.state.live;
+
+  for (s32 slot = 0; slot < ecs.entity_archetype.Size(); slot++)
+  {
+    if (ecs.entity_archetype[slot] >= 0) ecs.entity_archetype[slot] = snapshot_archetypes.targets[ecs.entity_archetype[slot]];
+  }
+}
+
+// ---- animation states
+
+struct AnimationView
+{
+  SnapshotArray clip, frame, direction, elapsed, frame_end, speed, flipped, rect, free_slots, due;
+};
+
+static void CaptureAnimations(Snapshot& snapshot)
+{
+  WriteSnapshotVector(snapshot, animations.clip);
+  WriteSnapshotVector(snapshot, animations.frame);
+  WriteSnapshotVector(snapshot, animations.direction);
+  WriteSnapshotVector(snapshot, animations.elapsed);
+  WriteSnapshotVector(snapshot, animations.frame_end);
+  WriteSnapshotVector(snapshot, animations.speed);
+  WriteSnapshotVector(snapshot, animations.flipped);
+  WriteSnapshotVector(snapshot, animations.rect);
+  WriteSnapshotVector(snapshot, animations.free_slots);
+  WriteSnapshotVector(snapshot, animations.due);
+}
+
+static bool ReadAnimations(SnapshotReader& reader, AnimationView& view)
+{
+  ReadSnapshotArray<s32>(reader, view.clip);
+  ReadSnapshotArray<s32>(reader, view.frame);
+  ReadSnapshotArray<s32>(reader, view.direction);
+  ReadSnapshotArray<f32>(reader, view.elapsed);
+  ReadSnapshotArray<f32>(reader, view.frame_end);
+  ReadSnapshotArray<f32>(reader, view.speed);
+  ReadSnapshotArray<u8>(reader, view.flipped);
+  ReadSnapshotArray<vec4>(reader, view.rect);
+  ReadSnapshotArray<s32>(reader, view.free_slots);
+  ReadSnapshotArray<s32>(reader, view.due);
+
+  s32 count = view.clip.count;
+  if (!reader.ok || view.frame.count != count || view.direction.count != count || view.elapsed.count != count ||
+    view.frame_end.count != count || view.speed.count != count || view.flipped.count != count || view.rect.count != count ||
+    view.due.count != count || !SnapshotIndicesInRange(view.free_slots, 0, count)) return false;
+
+  // UpdateAnimations indexes the clip and its frames by these and steps through frames until elapsed
+  // is back under frame_end, so every slot is partway through a frame that can end...a free slot
+  // (clip -1) never moves, a live one is on a frame its clip has
+  const s32* clip = (const s32*)view.clip.data;
+  const s32* frame = (const s32*)view.frame.data;
+  const s32* direction = (const s32*)view.direction.data;
+  const f32* elapsed = (const f32*)view.elapsed.data;
+  const f32* frame_end = (const f32*)view.frame_end.data;
+  const f32* speed = (const f32*)view.speed.data;
+  for (s32 i = 0; i < count; i++)
+  {
+    if ((direction[i] != 1 && direction[i] != -1) || !(elapsed[i] >= 0.f && elapsed[i] < frame_end[i]) || !(speed[i] >= 0.f && speed[i] <= FLT_MAX)) return false;
+
+    if (clip[i] == -1)
+    {
+      if (speed[i] != 0.f) return false;
+      continue;
+    }
+
+    if (clip[i] < 0 || clip[i] >= animation_clips.clips.Size() || frame[i] < 0 || frame[i] >= animation_clips.clips[clip[i]].frame_count) return false;
+  }
+
+  const s32* free_slots = (const s32*)view.free_slots.data;
+  for (s32 f = 0; f < view.free_slots.count; f++)
+  {
+    if (clip[free_slots[f]] != -1) return false;
+  }
+
+  return true;
+}
+
+static void RestoreAnimations(AnimationView& view)
+{
+  RestoreSnapshotVector(animations.clip, view.clip);
+  RestoreSnapshotVector(animations.frame, view.frame);
+  RestoreSnapshotVector(animations.direction, view.direction);
+  RestoreSnapshotVector(animations.elapsed, view.elapsed);
+  RestoreSnapshotVector(animations.frame_end, view.frame_end);
+  RestoreSnapshotVector(animations.speed, view.speed);
+  RestoreSnapshotVector(animations.flipped, view.flipped);
+  RestoreSnapshotVector(animations.rect, view.rect);
+  RestoreSnapshotVector(animations.free_slots, view.free_slots);
+  RestoreSnapshotVector(animations.due, view.due);
+}
+
+// ---- scene graph
+
+struct SceneGraphSnapshot
+{
+  s32 first_root;
+  s32 count;
+  s32 dirty_count;
+  u8 order_dirty;
+};
+
+struct SceneGraphView
+{
+  SceneGraphSnapshot state;
+  SnapshotArray parent, first_child, next_sibling, index, free_handles;
+  SnapshotArray handle, parent_index, subtree_size, local, world, entity, dirty, dirty_nodes;
+};
+
+static void CaptureSceneGraph(Snapshot& snapshot)
+{
+  SceneGraphSnapshot state;
+  memset((void*)&state, 0, sizeof(state));
+  state.first_root = scene_graph.first_root;
+  state.count = scene_graph.count;
+  state.dirty_count = scene_graph.dirty_count;
+  state.order_dirty = (u8)scene_graph.order_dirty;
+  WriteSnapshot(snapshot, &state, sizeof(state));
+
+  WriteSnapshotVector(snapshot, scene_graph.parent);
+  WriteSnapshotVector(snapshot, scene_graph.first_child);
+  WriteSnapshotVector(snapshot, scene_graph.next_sibling);
+  WriteSnapshotVector(snapshot, scene_graph.index);
+  WriteSnapshotVector(snapshot, scene_graph.free_handles);
+
+  WriteSnapshotArray(snapshot, scene_graph.handle, scene_graph.count);
+  WriteSnapshotArray(snapshot, scene_graph.parent_index, scene_graph.count);
+  WriteSnapshotArray(snapshot, scene_graph.subtree_size, scene_graph.count);
+  WriteSnapshotArray(snapshot, scene_graph.local, scene_graph.count);
+  WriteSnapshotArray(snapshot, scene_graph.world, scene_graph.count);
+  WriteSnapshotArray(snapshot, scene_graph.entity, scene_graph.count);
+  WriteSnapshotArray(snapshot, scene_graph.dirty, scene_graph.count);
+  WriteSnapshotVector(snapshot, scene_graph.dirty_nodes);
+}
+
+static bool ReadSceneGraph(SnapshotReader& reader, SceneGraphView& view)
+{
+  ReadSnapshotValue(reader, view.state);
+  ReadSnapshotArray<s32>(reader, view.parent);
+  ReadSnapshotArray<s32>(reader, view.first_child);
+  ReadSnapshotArray<s32>(reader, view.next_sibling);
+  ReadSnapshotArray<s32>(reader, view.index);
+  ReadSnapshotArray<s32>(reader, view.free_handles);
+  ReadSnapshotArray<s32>(reader, view.handle);
+  ReadSnapshotArray<s32>(reader, view.parent_index);
+  ReadSnapshotArray<s32>(reader, view.subtree_size);
+  ReadSnapshotArray<Transform>(reader, view.local);
+  ReadSnapshotArray<Transform>(reader, view.world);
+  ReadSnapshotArray<Entity>(reader, view.entity);
+  ReadSnapshotArray<u8>(reader, view.dirty);
+  ReadSnapshotArray<s32>(reader, view.dirty_nodes);
+
+  s32 handles = view.parent.count;
+  s32 count = view.state.count;
+  if (!reader.ok || count < 0 || view.first_child.count != handles || view.next_sibling.count != handles || view.index.count != handles ||
+    view.handle.count != count || view.parent_index.count != count || view.subtree_size.count != count || view.local.count != count ||
+    view.world.count != count || view.entity.count != count || view.dirty.count != count) return false;
+
+  // handles link to handles and live ones point into the arrays, a free handle's index is left over and never read
+  if (view.state.first_root < -1 || view.state.first_root >= handles) return false;
+  if (!SnapshotIndicesInRange(view.first_child, -1, handles) || !SnapshotIndicesInRange(view.next_sibling, -1, handles) ||
+    !SnapshotIndicesInRange(view.free_handles, 0, handles)) return false;
+
+  const s32* parent = (const s32*)view.parent.data;
+  const s32* index = (const s32*)view.index.data;
+  for (s32 h = 0; h < handles; h++)
+  {
+    if (parent[h] == SCENE_NODE_FREE) continue;
+    if (parent[h] < -1 || parent[h] >= handles || index[h] < 0 || index[h] >= count) return false;
+  }
+
+  // handle is -1 for a node destroyed since the last rebuild, and a subtree never runs off the end
+  if (!SnapshotIndicesInRange(view.handle, -1, handles) || !SnapshotIndicesInRange(view.parent_index, -1, count)) return false;
+  const s32* subtree_size = (const s32*)view.subtree_size.data;
+  for (s32 i = 0; i < count; i++)
+  {
+    if (subtree_size[i] < 1 || subtree_size[i] > count - i) return false;
+  }
+
+  if (view.state.dirty_count < 0 || view.state.dirty_count > view.dirty_nodes.count) return false;
+  const s32* dirty_nodes = (const s32*)view.dirty_nodes.data;
+  for (s32 d = 0; d < view.state.dirty_count; d++)
+  {
+    if (dirty_nodes[d] < 0 || dirty_nodes[d] >= count) return false;
+  }
+
+  return true;
+}
+
+static void RestoreSceneGraph(SceneGraphView& view)
+{
+  RestoreSnapshotVector(scene_graph.parent, view.parent);
+  RestoreSnapshotVector(scene_graph.first_child, view.first_child);
+  RestoreSnapshotVector(scene_graph.next_sibling, view.next_sibling);
+  RestoreSnapshotVector(scene_graph.index, view.index);
+  RestoreSnapshotVector(scene_graph.free_handles, view.free_handles);
+  RestoreSnapshotVector(scene_graph.dirty_nodes, view.dirty_nodes);
+
+  s32 count = view.state.count;
+  ReserveNodes(count);
+  memcpy(scene_graph.handle, view.handle.data, count * sizeof(s32));
+  memcpy(scene_graph.parent_index, view.parent_index.data, count * sizeof(s32));
+  memcpy(scene_graph.subtree_size, view.subtree_size.data, count * sizeof(s32));
+  memcpy((void*)scene_graph.local, view.local.data, count * sizeof(Transform));
+  memcpy((void*)scene_graph.world, view.world.data, count * sizeof(Transform));
+  memcpy((void*)scene_graph.entity, view.entity.data, count * sizeof(Entity));
+  memcpy(scene_graph.dirty, view.dirty.data, count * sizeof(u8));
+
+  scene_graph.count = count;
+  scene_graph.first_root = view.state.first_root;
+  scene_graph.dirty_count = view.state.dirty_count;
+  scene_graph.order_dirty = view.state.order_dirty != 0;
+}
+
+// ---- whole snapshots
+
+// reuses the snapshot's buffer, after the first capture there is nothing left to allocate
+void CaptureSnapshot(Snapshot& snapshot)
+{
+  PROFILE_FUNCTION();
+
+  snapshot.size = 0;
+  SnapshotHeader header = { SNAPSHOT_MAGIC, SNAPSHOT_VERSION, simulation.tick, 0, 0 };
+  WriteSnapshot(snapshot, &header, sizeof(header));
+
+  u64 section = BeginSnapshotSection(snapshot, SNAPSHOT_SECTION::SIMULATION);
+  WriteSnapshot(snapshot, &simulation.tick, sizeof(simulation.tick));
+  EndSnapshotSection(snapshot, section);
+
+  section = BeginSnapshotSection(snapshot, SNAPSHOT_SECTION::RANDOM);
+  CaptureRandom(snapshot);
+  EndSnapshotSection(snapshot, section);
+
+  section = BeginSnapshotSection(snapshot, SNAPSHOT_SECTION::TIMERS);
+  CaptureTimers(snapshot);
+  EndSnapshotSection(snapshot, section);
+
+  section = BeginSnapshotSection(snapshot, SNAPSHOT_SECTION::ENTITIES);
+  CaptureEntities(snapshot);
+  EndSnapshotSection(snapshot, section);
+
+  section = BeginSnapshotSection(snapshot, SNAPSHOT_SECTION::ANIMATIONS);
+  CaptureAnimations(snapshot);
+  EndSnapshotSection(snapshot, section);
+
+  section = BeginSnapshotSection(snapshot, SNAPSHOT_SECTION::SCENE_GRAPH);
+  CaptureSceneGraph(snapshot);
+  EndSnapshotSection(snapshot, section);
+
+  ((SnapshotHeader*)snapshot.data)->bytes = snapshot.size;
+}
+
+// the simulation clock's tick comes back but not its time, the next frame carries on from now
+bool RestoreSnapshot(Snapshot& snapshot)
+{
+  PROFILE_FUNCTION();
+
+  SnapshotReader reader = { snapshot.data, 0, snapshot.size, snapshot.data != nullptr };
+  SnapshotHeader header;
+  if (!ReadSnapshotValue(reader, header) || header.magic != SNAPSHOT_MAGIC || header.version != SNAPSHOT_VERSION || header.bytes != snapshot.size)
+  {
+    DebugPrintToConsole("Snapshot restore failed: ", "not a snapshot from this version");
+    return false;
+  }
+
+  SnapshotReader section;
+  u64 tick = 0;
+  RandomSnapshot random;
+  TimerWheelView timers;
+  EntityView entities;
+  AnimationView animation_states;
+  SceneGraphView graph;
+
+  bool ok = ReadSnapshotSection(reader, SNAPSHOT_SECTION::SIMULATION, section) && ReadSnapshotValue(section, tick);
+  ok = ok && ReadSnapshotSection(reader, SNAPSHOT_SECTION::RANDOM, section) && ReadSnapshotValue(section, random);
+  ok = ok && ReadSnapshotSection(reader, SNAPSHOT_SECTION::TIMERS, section) && ReadTimers(section, timers);
+  ok = ok && ReadSnapshotSection(reader, SNAPSHOT_SECTION::ENTITIES, section) && ReadEntities(section, entities);
+  ok = ok && ReadSnapshotSection(reader, SNAPSHOT_SECTION::ANIMATIONS, section) && ReadAnimations(section, animation_states);
+  ok = ok && ReadSnapshotSection(reader, SNAPSHOT_SECTION::SCENE_GRAPH, section) && ReadSceneGraph(section, graph);
+  ok = ok && ChunkContentsInRange(entities, animation_states.clip.count, graph.parent.count);
+  if (!ok)
+  {
+    DebugPrintToConsole("Snapshot restore failed: ", "the snapshot doesn't match this build");
+    return false;
+  }
+
+  simulation.tick = tick;
+  RestoreRandom(random);
+  RestoreTimers(timers);
+  RestoreEntities(entities);
+  RestoreAnimations(animation_states);
+  RestoreSceneGraph(graph);
+  return true;
+}
+
+// the SNAPSHOT_DELTA_BLOCK sized blocks of snapshot that differ from baseline, neighbouring blocks
+// merged into one run
+void DiffSnapshot(Snapshot& baseline, Snapshot& snapshot, Snapshot& delta)
+{
+  PROFILE_FUNCTION();
+
+  delta.size = 0;
+  SnapshotDeltaHeader header = { SNAPSHOT_DELTA_MAGIC, SNAPSHOT_VERSION, 0, baseline.size, snapshot.size, 0, 0 };
+  if (baseline.size >= sizeof(SnapshotHeader)) header.baseline_tick = ((SnapshotHeader*)baseline.data)->tick;
+  WriteSnapshot(delta, &header, sizeof(header));
+
+  u64 runs = 0;
+  u64 shared = baseline.size < snapshot.size ? baseline.size : snapshot.size;
+  u64 at = 0;
+  while (at < snapshot.size)
+  {
+    // skip what is the same
+    while (at < shared)
+    {
+      u64 block = shared - at < SNAPSHOT_DELTA_BLOCK ? shared - at : SNAPSHOT_DELTA_BLOCK;
+      if (memcmp(baseline.data + at, snapshot.data + at, block) != 0) break;
+      at += block;
+    }
+
+    if (at >= snapshot.size) break;
+
+    // and take everything up to the next block that is
+    u64 end = at;
+    while (end < snapshot.size)
+    {
+      u64 block = snapshot.size - end < SNAPSHOT_DELTA_BLOCK ? snapshot.size - end : SNAPSHOT_DELTA_BLOCK;
+      if (end + block <= shared && memcmp(baseline.data + end, snapshot.data + end, block) == 0) break;
+      end += block;
+    }
+
+    SnapshotDeltaRun run = { at, end - at };
+    WriteSnapshot(delta, &run, sizeof(run));
+    WriteSnapshot(delta, snapshot.data + at, run.bytes);
+    runs++;
+    at = end;
+  }
+
+  ((SnapshotDeltaHeader*)delta.data)->runs = runs;
+}
+
+// rebuilds into snapshot what DiffSnapshot was given, false if the delta wasn't made against this baseline
+bool ApplySnapshotDelta(Snapshot& baseline, Snapshot& delta, Snapshot& snapshot)
+{
+  PROFILE_FUNCTION();
+
+  SnapshotReader reader = { delta.data, 0, delta.size, delta.data != nullptr };
+  SnapshotDeltaHeader header;
+  if (!ReadSnapshotValue(reader, header) || header.magic != SNAPSHOT_DELTA_MAGIC || header.baseline_bytes != baseline.size ||
+    (baseline.size >= sizeof(SnapshotHeader) && header.baseline_tick != ((SnapshotHeader*)baseline.data)->tick))
+  {
+    DebugPrintToConsole("Snapshot delta failed: ", "it was made against another baseline");
+    return false;
+  }
+
+  if (header.bytes > SNAPSHOT_MAX_BYTES)
+  {
+    DebugPrintToConsole("Snapshot delta failed: ", "the delta is corrupt");
+    return false;
+  }
+
+  snapshot.size = 0;
+  ReserveSnapshot(snapshot, header.bytes);
+  memcpy(snapshot.data, baseline.data, baseline.size < header.bytes ? baseline.size : header.bytes);
+  snapshot.size = header.bytes;
+
+  for (u64 r = 0; r < header.runs; r++)
+  {
+    SnapshotDeltaRun run;
+    const u8* bytes = ReadSnapshotValue(reader, run) && run.offset <= header.bytes && run.bytes <= header.bytes - run.offset ? ReadSnapshot(reader, run.bytes) : nullptr;
+    if (!bytes)
+    {
+      DebugPrintToConsole("Snapshot delta failed: ", "the delta is cut short");
+      snapshot.size = 0;
+      return false;
+    }
+
+    memcpy(snapshot.data + run.offset, bytes, run.bytes);
+  }
+
+  return true;
+}
+
+void FreeSnapshot(Snapshot& snapshot)
+{
+  delete[] snapshot.data;
+  snapshot = Snapshot();
+}
+
+static struct
+{
+  Snapshot xor_scratch;
+  Snapshot shuffle_scratch;
+  Snapshot file;
+} snapshot_scratch;
+
+struct SnapshotWrite;
+
+static struct
+{
+  JobCounter pending{ 0 };
+  std::atomic<u32> failed{ 0 };
+  std::atomic<u32> coalesced{ 0 };      // saves replaced by a newer one before they were written
+
+  std::mutex lock;
+  en::vector<SnapshotWrite*> writing;   // one per path with a write in flight
+} snapshot_writes;
+
+static inline u64 SnapshotTick(Snapshot& snapshot)
+{
+  return snapshot.size >= sizeof(SnapshotHeader) ? ((SnapshotHeader*)snapshot.data)->tick : 0;
+}
+
+static CompressedSnapshotHeader CompressedHeaderFor(Snapshot& snapshot, Snapshot* baseline)
+{
+  CompressedSnapshotHeader header;
+  memset(&header, 0, sizeof(header));
+  header.magic = SNAPSHOT_COMPRESSED_MAGIC;
+  header.version = SNAPSHOT_VERSION;
+  header.tick = SnapshotTick(snapshot);
+  header.bytes = snapshot.size;
+  header.filters = SNAPSHOT_FILTER_SHUFFLE;
+  if (baseline && baseline->size)
+  {
+    header.filters |= SNAPSHOT_FILTER_XOR;
+    header.baseline_tick = SnapshotTick(*baseline);
+    header.baseline_bytes = baseline->size;
+  }
+
+  return header;
+}
+
+// xor against what the baseline shares with the snapshot, anything past its end stays as it is
+static void FilterSnapshot(Snapshot& snapshot, Snapshot* baseline, u8* filtered)
+{
+  const u8* source = snapshot.data;
+  if (baseline && baseline->size)
+  {
+    u64 shared = baseline->size < snapshot.size ? baseline->size : snapshot.size;
+    ReserveSnapshot(snapshot_scratch.xor_scratch, snapshot.size);
+    XorBytes(snapshot_scratch.xor_scratch.data, snapshot.data, baseline->data, shared);
+    memcpy(snapshot_scratch.xor_scratch.data + shared, snapshot.data + shared, snapshot.size - shared);
+    source = snapshot_scratch.xor_scratch.data;
+  }
+
+  ShuffleBytes(filtered, source, snapshot.size, SNAPSHOT_SHUFFLE_STRIDE);
+}
+
+static void UnfilterSnapshot(const CompressedSnapshotHeader& header, const u8* filtered, Snapshot* baseline, u8* snapshot)
+{
+  if (!(header.filters & SNAPSHOT_FILTER_XOR))
+  {
+    UnshuffleBytes(snapshot, filtered, header.bytes, SNAPSHOT_SHUFFLE_STRIDE);
+    return;
+  }
+
+  ReserveSnapshot(snapshot_scratch.xor_scratch, header.bytes);
+  UnshuffleBytes(snapshot_scratch.xor_scratch.data, filtered, header.bytes, SNAPSHOT_SHUFFLE_STRIDE);
+
+  u64 shared = baseline->size < header.bytes ? baseline->size : header.bytes;
+  XorBytes(snapshot, snapshot_scratch.xor_scratch.data, baseline->data, shared);
+  memcpy(snapshot + shared, snapshot_scratch.xor_scratch.data + shared, header.bytes - shared);
+}
+
+// compressed holds a CompressedSnapshotHeader and the compressed bytes afterwards, ready to write out
+bool CompressSnapshot(Snapshot& snapshot, Snapshot* baseline, Snapshot& compressed)
+{
+  PROFILE_FUNCTION();
+
+  CompressedSnapshotHeader header = CompressedHeaderFor(snapshot, baseline);
+  ReserveSnapshot(snapshot_scratch.shuffle_scratch, snapshot.size);
+  FilterSnapshot(snapshot, baseline, snapshot_scratch.shuffle_scratch.data);
+
+  compressed.size = 0;
+  ReserveSnapshot(compressed, sizeof(header) + LzCompressBound(snapshot.size));
+  header.compressed_bytes = LzCompress(snapshot_scratch.shuffle_scratch.data, snapshot.size, compressed.data + sizeof(header), compressed.capacity - sizeof(header));
+  if (!header.compressed_bytes) return false;
+
+  memcpy(compressed.data, &header, sizeof(header));
+  compressed.size = sizeof(header) + header.compressed_bytes;
+  return true;
+}
+
+// baseline has to be the one the snapshot was compressed against, if it was
+bool DecompressSnapshot(Snapshot& compressed, Snapshot* baseline, Snapshot& snapshot)
+{
+  PROFILE_FUNCTION();
+
+  CompressedSnapshotHeader header;
+  if (compressed.size < sizeof(header))
+  {
+    DebugPrintToConsole("Snapshot decompression failed: ", "not a compressed snapshot");
+    return false;
+  }
+
+  memcpy(&header, compressed.data, sizeof(header));
+  if (header.magic != SNAPSHOT_COMPRESSED_MAGIC || header.version != SNAPSHOT_VERSION || header.compressed_bytes != compressed.size - sizeof(header))
+  {
+    DebugPrintToConsole("Snapshot decompression failed: ", "not a compressed snapshot");
+    return false;
+  }
+
+  if ((header.filters & SNAPSHOT_FILTER_XOR) &&
+    (!baseline || baseline->size != header.baseline_bytes || SnapshotTick(*baseline) != header.baseline_tick))
+  {
+    DebugPrintToConsole("Snapshot decompression failed: ", "it was compressed against another baseline");
+    return false;
+  }
+
+  // the size comes from the file, nothing gets reserved for it until it could be real
+  if (header.bytes > SNAPSHOT_MAX_BYTES || header.bytes > LzDecompressBound(header.compressed_bytes))
+  {
+    DebugPrintToConsole("Snapshot decompression failed: ", "the data is corrupt");
+    return false;
+  }
+
+  ReserveSnapshot(snapshot_scratch.shuffle_scratch, header.bytes);
+  s64 bytes = LzDecompress(compressed.data + sizeof(header), header.compressed_bytes, snapshot_scratch.shuffle_scratch.data, header.bytes);
+  if (bytes != (s64)header.bytes)
+  {
+    DebugPrintToConsole("Snapshot decompression failed: ", "the data is corrupt");
+    return false;
+  }
+
+  snapshot.size = 0;
+  ReserveSnapshot(snapshot, header.bytes);
+  UnfilterSnapshot(header, snapshot_scratch.shuffle_scratch.data, baseline, snapshot.data);
+  snapshot.size = header.bytes;
+  return true;
+}
+
+static bool ReplaceSnapshotFile(const char* from, const char* to)
+{
+#ifdef _WIN32
+  return MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+  return std::rename(from, to) == 0;
+#endif
+}
+
+static bool WriteSnapshotFile(const char* path, const CompressedSnapshotHeader& header, const u8* compressed)
+{
+  std::string temporary = std::string(path) + ".tmp";
+  {
+    std::ofstream stream(temporary, std::ios::binary);
+    if (!stream) return false;
+
+    stream.write((const char*)&header, sizeof(header));
+    stream.write((const char*)compressed, (std::streamsize)header.compressed_bytes);
+    stream.close();
+    if (!stream)
+    {
+      std::remove(temporary.c_str());
+      return false;
+    }
+  }
+
+  if (ReplaceSnapshotFile(temporary.c_str(), path)) return true;
+
+  std::remove(temporary.c_str());
+  return false;
+}
+
+bool SaveSnapshot(Snapshot& snapshot, const char* path)
+{
+  Snapshot compressed;
+  bool saved = CompressSnapshot(snapshot, nullptr, compressed) &&
+    WriteSnapshotFile(path, *(CompressedSnapshotHeader*)compressed.data, compressed.data + sizeof(CompressedSnapshotHeader));
+  FreeSnapshot(compressed);
+
+  if (!saved) DebugPrintToConsole("Failed to save snapshot: ", path);
+  return saved;
+}
+
+struct SnapshotWrite
+{
+  CompressedSnapshotHeader header;
+  u8* filtered;
+  std::string path;
+  SnapshotWrite* next = nullptr;        // the save queued behind this one for the same path
+};
+
+static void FreeSnapshotWrite(SnapshotWrite* write)
+{
+  delete[] write->filtered;
+  delete write;
+}
+
+// writes whatever got queued behind it for the same path too, so a path never has two writers
+static void WriteSnapshotJob(void* data)
+{
+  PROFILE_SCOPE("WriteSnapshotJob");
+
+  SnapshotWrite* write = (SnapshotWrite*)data;
+  while (write)
+  {
+    u8* compressed = new u8[LzCompressBound(write->header.bytes)];
+    write->header.compressed_bytes = LzCompress(write->filtered, write->header.bytes, compressed, LzCompressBound(write->header.bytes));
+
+    if (!write->header.compressed_bytes || !WriteSnapshotFile(write->path.c_str(), write->header, compressed))
+    {
+      DebugPrintToConsole("Failed to save snapshot: ", write->path.c_str());
+      snapshot_writes.failed.fetch_add(1);
+    }
+    delete[] compressed;
+
+    SnapshotWrite* next;
+    {
+      std::lock_guard<std::mutex> lock(snapshot_writes.lock);
+      next = write->next;
+
+      en::vector<SnapshotWrite*>& writing = snapshot_writes.writing;
+      for (s32 w = 0; w < writing.Size(); w++)
+      {
+        if (writing[w] != write) continue;
+
+        if (next) writing[w] = next;
+        else
+        {
+          writing[w] = writing[writing.Size() - 1];
+          writing.PopBack();
+        }
+        break;
+      }
+    }
+
+    FreeSnapshotWrite(write);
+    write = next;
+  }
+}
+
+// the file shows up once a worker gets to it, WaitForSnapshotWrites before relying on it
+void SaveSnapshotAsync(Snapshot& snapshot, Snapshot* baseline, const char* path)
+{
+  PROFILE_FUNCTION();
+
+  SnapshotWrite* write = new SnapshotWrite;
+  write->header = CompressedHeaderFor(snapshot, baseline);
+  write->filtered = new u8[snapshot.size > 0 ? snapshot.size : 1];
+  write->path = path;
+  FilterSnapshot(snapshot, baseline, write->filtered);
+
+  {
+    std::lock_guard<std::mutex> lock(snapshot_writes.lock);
+    for (SnapshotWrite* writing : snapshot_writes.writing)
+    {
+      if (writing->path != write->path) continue;
+
+      // only the newest save for a path is worth writing
+      if (writing->next)
+      {
+        FreeSnapshotWrite(writing->next);
+        snapshot_writes.coalesced.fetch_add(1);
+      }
+      writing->next = write;
+      return;
+    }
+
+    snapshot_writes.writing.PushBack(write);
+  }
+
+  RunBackgroundJob(WriteSnapshotJob, write, &snapshot_writes.pending);
+}
+
+void WaitForSnapshotWrites()
+{
+  WaitForJobs(snapshot_writes.pending);
+}
+
+// a raw or a compressed snapshot, whichever the file holds...one compressed against a baseline needs
+// that baseline back
+bool LoadSnapshot(Snapshot& snapshot, const char* path, Snapshot* baseline = nullptr)
+{
+  std::ifstream stream(path, std::ios::binary | std::ios::ate);
+  if (!stream)
+  {
+    DebugPrintToConsole("Failed to open snapshot: ", path);
+    return false;
+  }
+
+  Snapshot& file = snapshot_scratch.file;
+  u64 size = (u64)stream.tellg();
+  stream.seekg(0);
+  file.size = 0;
+  ReserveSnapshot(file, size);
+  stream.read((char*)file.data, (std::streamsize)size);
+  file.size = (u64)stream.gcount();
+  if (file.size != size) return false;
+
+  if (size >= sizeof(u32) && *(u32*)file.data == SNAPSHOT_COMPRESSED_MAGIC) return DecompressSnapshot(file, baseline, snapshot);
+
+  snapshot.size = 0;
+  ReserveSnapshot(snapshot, size);
+  memcpy(snapshot.data, file.data, size);
+  snapshot.size = size;
+  return true;
+}
+
@@ -0,0 +1,123 @@
+#pragma once
+
+#include "Core.h"
+#include "Profiler.h"
+#include "FrameStats.h"
+#include "GLGraphics.h"
+#include "vec2.h"
+#include "vec4.h"
+
+
+/// Sprite Batch API Reference
+////// bool InitSpriteBatch(SpriteBatch& batch);
+////// void PushSprite(SpriteBatch& batch, u32 texture, vec2 position, vec2 scale, f32 angle, vec4 rect);
+////// void FlushSprites(SpriteBatch& batch);
+
+// sprites are one shared quad drawn instanced...each sprite is a position/scale, a uv rect and an
+// angle in the instance buffer, so a whole sheet's worth of animated sprites is one upload and one
+// draw call with no per sprite uniforms. pushing a sprite with a different texture flushes the batch
+
+struct SpriteInstance
+{
+  vec4 transform;       // position xy, scale zw
+  vec4 rect;
+  f32 angle;
+};
+
+struct SpriteBatch
+{
+  u32 vao = 0;
+  u32 quad_vbo = 0;
+  u32 instance_vbo = 0;
+  u32 ebo = 0;
+  u32 shader = 0;
+  u32 texture = 0;
+  SpriteInstance* instances = nullptr;
+  s32 count = 0;
+  s32 capacity = 0;
+  s32 buffer_capacity = 0;    // instances the gpu buffer currently has room for
+};
+
+bool InitSpriteBatch(SpriteBatch& batch)
+{
+  batch.shader = LoadGLShader("sprite_instanced.glsl");
+  if (batch.shader == 9999) return false;
+
+  batch.capacity = 1024;
+  batch.instances = new SpriteInstance[batch.capacity];
+
+  const f32 quad[] = { 1.f, 1.f, 1.f, -1.f, -1.f, -1.f, -1.f, 1.f };
+  glGenVertexArrays(1, &batch.vao);
+  glGenBuffers(1, &batch.quad_vbo);
+  glGenBuffers(1, &batch.instance_vbo);
+  glGenBuffers(1, &batch.ebo);
+
+  glBindVertexArray(batch.vao);
+  glBindBuffer(GL_ARRAY_BUFFER, batch.quad_vbo);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
+  CountVerticesUploaded(4);
+  glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(f32), (void*)0);
+  glEnableVertexAttribArray(0);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, batch.ebo);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, 6 * sizeof(u32), quad_indices, GL_STATIC_DRAW);
+
+  glBindBuffer(GL_ARRAY_BUFFER, batch.instance_vbo);
+  glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(SpriteInstance), (void*)offsetof(SpriteInstance, transform));
+  glEnableVertexAttribArray(1);
+  glVertexAttribDivisor(1, 1);
+  glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(SpriteInstance), (void*)offsetof(SpriteInstance, rect));
+  glEnableVertexAttribArray(2);
+  glVertexAttribDivisor(2, 1);
+  glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, sizeof(SpriteInstance), (void*)offsetof(SpriteInstance, angle));
+  glEnableVertexAttribArray(3);
+  glVertexAttribDivisor(3, 1);
+
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  glBindVertexArray(0);
+  return true;
+}
+
+void FlushSprites(SpriteBatch& batch)
+{
+  if (batch.count == 0) return;
+
+  PROFILE_FUNCTION();
+
+  // orphan the old storage every frame so the upload never waits on the previous frame's draw
+  glBindBuffer(GL_ARRAY_BUFFER, batch.instance_vbo);
+  if (batch.count > batch.buffer_capacity) batch.buffer_capacity = batch.capacity;
+  glBufferData(GL_ARRAY_BUFFER, batch.buffer_capacity * sizeof(SpriteInstance), nullptr, GL_STREAM_DRAW);
+  glBufferSubData(GL_ARRAY_BUFFER, 0, batch.count * sizeof(SpriteInstance), batch.instances);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+  glUseProgram(batch.shader);
+  glBindVertexArray(batch.vao);
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D, batch.texture);
+  glDrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0, batch.count);
+  glBindVertexArray(0);
+  CountDrawCall();
+  CountStateChanges(3);
+
+  batch.count = 0;
+}
+
+void PushSprite(SpriteBatch& batch, u32 texture, vec2 position, vec2 scale, f32 angle, vec4 rect)
+{
+  if (batch.count > 0 && texture != batch.texture) FlushSprites(batch);
+  batch.texture = texture;
+
+  if (batch.count == batch.capacity)
+  {
+    SpriteInstance* grown = new SpriteInstance[batch.capacity * 2];
+    memcpy(grown, batch.instances, batch.count * sizeof(SpriteInstance));
+    delete[] batch.instances;
+    batch.instances = grown;
+    batch.capacity *= 2;
+  }
+
+  SpriteInstance& s = batch.instances[batch.count++];
+  s.transform = vec4(position.x(), position.y(), scale.x(), scale.y());
+  s.rect = rect;
+  s.angle = angle;
+}
@@ -0,0 +1,328 @@
+#pragma once
+
+#include "Core.h"
+#include "Profiler.h"
+#include "Simulation.h"
+#include "vector.h"
+
+
+/// Timer Wheel API Reference
+////// void RegisterTimerCallback(const char* name, TimerCallback callback);
+////// TimerHandle ScheduleTimer(f32 delay_seconds, TimerCallback callback, u64 user_data);
+////// TimerHandle ScheduleRepeatingTimer(f32 period_seconds, TimerCallback callback, u64 user_data);
+////// TimerHandle ScheduleTimerTicks(u64 delay_ticks, u64 period_ticks, TimerCallback callback, u64 user_data);
+////// bool CancelTimer(TimerHandle& timer);
+////// bool IsTimerPending(TimerHandle timer);
+////// void AdvanceTimers(u64 tick);
+////// u32 PendingTimers();
+
+// timers run on the simulation clock, not the wall clock...a timer is due on a simulation tick and
+// fires during that tick's AdvanceTimers, so recorded sessions replay them on exactly the same tick
+
+// the wheel is 4 levels of 256 slots. level 0 holds the timers due in the next 256 ticks, one slot
+// per tick, and each level above covers 256 times the range of the one below. every 256 ticks the
+// next slot of the level above is spread down a level, so scheduling and cancelling are O(1) and a
+// tick only touches the timers that fire plus the odd slot being cascaded
+
+// repeating timers are rescheduled before their callback runs, so a callback can cancel its own timer
+// and can schedule or cancel any other timer...anything it schedules fires on a later tick at the earliest
+
+// a callback has to be registered under a name before a timer can use it. snapshots store a timer's
+// callback as the hash of that name rather than its address, so it means the same function in any build
+
+using TimerCallback = void(*)(u64 user_data);
+
+const u32 TIMER_WHEEL_LEVELS = 4;
+const u32 TIMER_WHEEL_BITS = 8;
+const u32 TIMER_WHEEL_SLOTS = 1 << TIMER_WHEEL_BITS;
+const u32 TIMER_WHEEL_MASK = TIMER_WHEEL_SLOTS - 1;
+const s32 TIMER_WHEEL_FIRING = TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOTS;   // the extra list the due timers are moved to
+
+struct TimerHandle
+{
+  u64 id = 0;     // slot in the low 32 bits, generation in the high 32, 0 is never a live timer
+};
+
+static struct
+{
+  // one entry per timer slot, slots are reused through the free list once a timer is done
+  en::vector<u64> expiry;           // simulation tick the timer is due on
+  en::vector<u64> period;           // ticks between repeats, 0 for one shot timers
+  en::vector<TimerCallback> callback;
+  en::vector<u64> user_data;
+  en::vector<u32> generation;       // bumped whenever a slot is released so stale handles stop matching
+  en::vector<s32> next;             // doubly linked list of the wheel slot the timer sits in...
+  en::vector<s32> prev;
+  en::vector<s32> bucket;           // ...and which one, level * TIMER_WHEEL_SLOTS + slot, -1 when not scheduled
+
+  s32 heads[TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOTS + 1];
+  s32 free_head = -1;
+  u64 tick = 0;                     // next tick AdvanceTimers will process
+  u32 pending = 0;
+  bool initialized = false;
+
+  struct
+  {
+    u32 fired = 0;
+    u32 cascaded = 0;
+  } stats;                          // for the last AdvanceTimers call
+} timer_wheel;
+
+static struct
+{
+  en::vector<u64> id;               // FNV-1a of the name
+  en::vector<TimerCallback> callback;
+} timer_callbacks;
+
+static void InitTimerWheel()
+{
+  for (u32 i = 0; i <= TIMER_WHEEL_LEVELS * TIMER_WHEEL_SLOTS; i++) timer_wheel.heads[i] = -1;
+  timer_wheel.initialized = true;
+}
+
+// registering the same callback under the same name again is fine
+void RegisterTimerCallback(const char* name, TimerCallback callback)
+{
+  u64 id = 14695981039346656037ull;
+  for (const char* c = name; *c; c++) id = (id ^ (u8)*c) * 1099511628211ull;
+
+  for (s32 i = 0; i < timer_callbacks.id.Size(); i++)
+  {
+    if (timer_callbacks.id[i] != id) continue;
+    if (timer_callbacks.callback[i] != callback) DebugPrintToConsole("Timer callback name already taken: ", name);
+    return;
+  }
+
+  timer_callbacks.id.PushBack(id);
+  timer_callbacks.callback.PushBack(callback);
+}
+
+// 0 for a callback that was never registered
+static u64 TimerCallbackId(TimerCallback callback)
+{
+  for (s32 i = 0; i < timer_callbacks.id.Size(); i++)
+  {
+    if (timer_callbacks.callback[i] == callback) return timer_callbacks.id[i];
+  }
+  return 0;
+}
+
+static TimerCallback FindTimerCallback(u64 id)
+{
+  for (s32 i = 0; i < timer_callbacks.id.Size(); i++)
+  {
+    if (timer_callbacks.id[i] == id) return timer_callbacks.callback[i];
+  }
+  return nullptr;
+}
+
+static void LinkTimer(s32 timer)
+{
+  u64 expiry = timer_wheel.expiry[timer];
+  u64 delta = expiry > timer_wheel.tick ? expiry - timer_wheel.tick : 0;
+
+  // the level is picked by how far away the timer is, the slot by the expiry tick itself so it lines
+  // up with the slot that will be cascaded or fired on the way there
+  u32 level = 0;
+  while (level < TIMER_WHEEL_LEVELS - 1 && delta >= (1ull << (TIMER_WHEEL_BITS * (level + 1)))) level++;
+
+  // past the top level's range the timer waits in the furthest slot and gets relinked when that cascades
+  u64 range = 1ull << (TIMER_WHEEL_BITS * TIMER_WHEEL_LEVELS);
+  if (delta >= range) expiry = timer_wheel.tick + range - 1;
+
+  s32 bucket = (s32)(level * TIMER_WHEEL_SLOTS + ((expiry >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK));
+  s32 head = timer_wheel.heads[bucket];
+
+  timer_wheel.bucket[timer] = bucket;
+  timer_wheel.prev[timer] = -1;
+  timer_wheel.next[timer] = head;
+  if (head >= 0) timer_wheel.prev[head] = timer;
+  timer_wheel.heads[bucket] = timer;
+}
+
+static void UnlinkTimer(s32 timer)
+{
+  s32 bucket = timer_wheel.bucket[timer];
+  s32 prev = timer_wheel.prev[timer];
+  s32 next = timer_wheel.next[timer];
+
+  if (prev >= 0) timer_wheel.next[prev] = next;
+  else timer_wheel.heads[bucket] = next;
+  if (next >= 0) timer_wheel.prev[next] = prev;
+
+  timer_wheel.bucket[timer] = -1;
+}
+
+static void ReleaseTimer(s32 timer)
+{
+  timer_wheel.generation[timer]++;
+  if (timer_wheel.generation[timer] == 0) timer_wheel.generation[timer] = 1;
+
+  timer_wheel.next[timer] = timer_wheel.free_head;
+  timer_wheel.free_head = timer;
+  timer_wheel.pending--;
+}
+
+static inline s32 TimerSlot(TimerHandle timer)
+{
+  s32 slot = (s32)(timer.id & 0xFFFFFFFF);
+  if (timer.id == 0 || slot >= timer_wheel.expiry.Size()) return -1;
+  if (timer_wheel.generation[slot] != (u32)(timer.id >> 32) || timer_wheel.bucket[slot] < 0) return -1;
+  return slot;
+}
+
+// delays are rounded up to whole ticks and are at least one tick
+static inline u64 SecondsToTicks(f32 seconds)
+{
+  if (seconds <= 0.f) return 1;
+  u64 ticks = (u64)ceil((f64)seconds * SIMULATION_TICK_HZ - 0.0001);
+  return ticks > 0 ? ticks : 1;
+}
+
+TimerHandle ScheduleTimerTicks(u64 delay_ticks, u64 period_ticks, TimerCallback callback, u64 user_data)
+{
+  if (!callback) return {};
+  if (!TimerCallbackId(callback))
+  {
+    DebugPrintToConsole("Timer not scheduled: ", "its callback was never registered");
+    return {};
+  }
+  if (!timer_wheel.initialized) InitTimerWheel();
+
+  s32 timer;
+  if (timer_wheel.free_head >= 0)
+  {
+    timer = timer_wheel.free_head;
+    timer_wheel.free_head = timer_wheel.next[timer];
+  }
+  else
+  {
+    timer = timer_wheel.expiry.Size();
+    timer_wheel.expiry.PushBack(0);
+    timer_wheel.period.PushBack(0);
+    timer_wheel.callback.PushBack(nullptr);
+    timer_wheel.user_data.PushBack(0);
+    timer_wheel.generation.PushBack(1);
+    timer_wheel.next.PushBack(-1);
+    timer_wheel.prev.PushBack(-1);
+    timer_wheel.bucket.PushBack(-1);
+  }
+
+  timer_wheel.expiry[timer] = timer_wheel.tick + (delay_ticks > 0 ? delay_ticks : 1) - 1;
+  timer_wheel.period[timer] = period_ticks;
+  timer_wheel.callback[timer] = callback;
+  timer_wheel.user_data[timer] = user_data;
+  LinkTimer(timer);
+  timer_wheel.pending++;
+
+  return { ((u64)timer_wheel.generation[timer] << 32) | (u64)timer };
+}
+
+TimerHandle ScheduleTimer(f32 delay_seconds, TimerCallback callback, u64 user_data)
+{
+  return ScheduleTimerTicks(SecondsToTicks(delay_seconds), 0, callback, user_data);
+}
+
+TimerHandle ScheduleRepeatingTimer(f32 period_seconds, TimerCallback callback, u64 user_data)
+{
+  u64 period = SecondsToTicks(period_seconds);
+  return ScheduleTimerTicks(period, period, callback, user_data);
+}
+
+// clears the handle either way, returns false if the timer had already fired or been cancelled
+bool CancelTimer(TimerHandle& timer)
+{
+  s32 slot = TimerSlot(timer);
+  timer = {};
+  if (slot < 0) return false;
+
+  UnlinkTimer(slot);
+  ReleaseTimer(slot);
+  return true;
+}
+
+bool IsTimerPending(TimerHandle timer)
+{
+  return TimerSlot(timer) >= 0;
+}
+
+u32 PendingTimers()
+{
+  return timer_wheel.pending;
+}
+
+static void CascadeTimers(u32 level, u32 slot)
+{
+  s32 bucket = (s32)(level * TIMER_WHEEL_SLOTS + slot);
+  s32 timer = timer_wheel.heads[bucket];
+  timer_wheel.heads[bucket] = -1;
+
+  while (timer >= 0)
+  {
+    s32 next = timer_wheel.next[timer];
+    LinkTimer(timer);
+    timer_wheel.stats.cascaded++;
+    timer = next;
+  }
+}
+
+// runs every tick up to and including tick, the simulation calls it once per tick with its own tick index
+void AdvanceTimers(u64 tick)
+{
+  PROFILE_FUNCTION();
+
+  timer_wheel.stats.fired = 0;
+  timer_wheel.stats.cascaded = 0;
+  if (!timer_wheel.initialized) InitTimerWheel();
+
+  while (timer_wheel.tick <= tick)
+  {
+    u64 now = timer_wheel.tick;
+
+    if (timer_wheel.pending > 0)
+    {
+      // higher levels first so timers they bring down can be spread again by the level below this tick
+      for (u32 level = TIMER_WHEEL_LEVELS - 1; level > 0; level--)
+      {
+        if ((now & ((1ull << (TIMER_WHEEL_BITS * level)) - 1)) == 0)
+        {
+          CascadeTimers(level, (u32)((now >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK));
+        }
+      }
+
+      // the due timers move to their own list before any callback runs...from here on the wheel is
+      // already at the next tick, so whatever the callbacks schedule lands on a later tick
+      s32 bucket = (s32)(now & TIMER_WHEEL_MASK);
+      s32 due = timer_wheel.heads[bucket];
+      timer_wheel.heads[bucket] = -1;
+      timer_wheel.heads[TIMER_WHEEL_FIRING] = due;
+      for (s32 timer = due; timer >= 0; timer = timer_wheel.next[timer]) timer_wheel.bucket[timer] = TIMER_WHEEL_FIRING;
+      timer_wheel.tick = now + 1;
+
+      // popped one at a time rather than walked, a callback may cancel timers further along the list
+      while (timer_wheel.heads[TIMER_WHEEL_FIRING] >= 0)
+      {
+        s32 timer = timer_wheel.heads[TIMER_WHEEL_FIRING];
+        UnlinkTimer(timer);
+
+        TimerCallback callback = timer_wheel.callback[timer];
+        u64 user_data = timer_wheel.user_data[timer];
+
+        if (timer_wheel.period[timer] > 0)
+        {
+          timer_wheel.expiry[timer] = now + timer_wheel.period[timer];
+          LinkTimer(timer);
+        }
+        else
+        {
+          ReleaseTimer(timer);
+        }
+
+        timer_wheel.stats.fired++;
+        callback(user_data);
+      }
+    }
+
+    timer_wheel.tick = now + 1;
+  }
+}
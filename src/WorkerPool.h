@@ -0,0 +1,213 @@
+#pragma once
+
+#include "Core.h"
+#include "Profiler.h"
+#include "Random.h"
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+
+/// Worker Pool API Reference
+////// void InitWorkers(u32 count);                  // 0 picks one less than the number of cores
+////// void ShutdownWorkers();
+////// u32 WorkerCount();
+////// void RunJob(JobFunc func, void* data, JobCounter* counter);
+////// void RunBackgroundJob(JobFunc func, void* data, JobCounter* counter);
+////// bool RunOneJob();
+////// void WaitForJobs(JobCounter& counter);
+////// u32 WorkerIndex();
+
+// a handful of threads that pull small jobs off one shared queue...a job is a function pointer and
+// a pointer to its data, and whoever queues it can count it on a JobCounter to wait for it later.
+// a thread waiting on jobs runs queued jobs itself instead of sleeping, so waiting never deadlocks
+// even when every worker is busy waiting too
+
+// with no workers (or a full queue) RunJob runs the job straight away on the calling thread
+
+// background jobs (disk writes, file reads, chunk parsing) go on a second queue that only the workers
+// take from, so the main thread never picks one up while it waits mid-tick...it just yields until
+// the workers get to them. jobs queued from inside a background job are background too, and a worker
+// waiting on jobs takes from both queues
+
+using JobFunc = void(*)(void* data);
+using JobCounter = std::atomic<u32>;
+
+const u32 WORKER_MAX_THREADS = 15;
+const u32 WORKER_QUEUE_SIZE = 4096;
+
+struct Job
+{
+  JobFunc func;
+  void* data;
+  JobCounter* counter;
+  bool background;
+};
+
+static struct
+{
+  std::thread threads[WORKER_MAX_THREADS];
+  u32 thread_count = 0;
+  std::mutex lock;
+  std::condition_variable wake;
+  Job queue[WORKER_QUEUE_SIZE];       // rings, guarded by lock
+  u32 head = 0;
+  u32 tail = 0;
+  Job background[WORKER_QUEUE_SIZE];
+  u32 background_head = 0;
+  u32 background_tail = 0;
+  bool running = false;
+} workers;
+
+static thread_local u32 worker_index = 0;   // 0 on the main thread and anything that isn't a worker
+static thread_local bool worker_in_background_job = false;
+
+static inline void FinishJob(const Job& job)
+{
+  bool was_background = worker_in_background_job;
+  worker_in_background_job = job.background;
+  job.func(job.data);
+  worker_in_background_job = was_background;
+  if (job.counter) job.counter->fetch_sub(1, std::memory_order_acq_rel);
+}
+
+// the caller holds workers.lock
+static inline bool TakeQueuedJob(Job& job, bool background)
+{
+  if (workers.head != workers.tail)
+  {
+    job = workers.queue[workers.head % WORKER_QUEUE_SIZE];
+    workers.head++;
+    return true;
+  }
+
+  if (background && workers.background_head != workers.background_tail)
+  {
+    job = workers.background[workers.background_head % WORKER_QUEUE_SIZE];
+    workers.background_head++;
+    return true;
+  }
+
+  return false;
+}
+
+static inline bool WorkQueued()
+{
+  return workers.head != workers.tail || workers.background_head != workers.background_tail;
+}
+
+static void WorkerMain(u32 index)
+{
+  worker_index = index;
+  char name[32];
+  snprintf(name, sizeof(name), "Worker %u", index);
+  ProfilerSetThreadName(name);
+  SetRandomStream(index);
+
+  while (true)
+  {
+    Job job;
+    {
+      std::unique_lock<std::mutex> lock(workers.lock);
+      workers.wake.wait(lock, [] { return !workers.running || WorkQueued(); });
+      if (!TakeQueuedJob(job, true)) return;
+    }
+
+    FinishJob(job);
+  }
+}
+
+void InitWorkers(u32 count)
+{
+  if (workers.running) return;
+
+  if (count == 0)
+  {
+    u32 cores = std::thread::hardware_concurrency();
+    count = cores > 1 ? cores - 1 : 0;
+  }
+  if (count > WORKER_MAX_THREADS) count = WORKER_MAX_THREADS;
+
+  workers.running = true;
+  workers.thread_count = count;
+  for (u32 i = 0; i < count; i++) workers.threads[i] = std::thread(WorkerMain, i + 1);
+}
+
+// finishes whatever is still queued before the workers exit
+void ShutdownWorkers()
+{
+  {
+    std::lock_guard<std::mutex> lock(workers.lock);
+    workers.running = false;
+  }
+  workers.wake.notify_all();
+
+  for (u32 i = 0; i < workers.thread_count; i++) workers.threads[i].join();
+  workers.thread_count = 0;
+}
+
+u32 WorkerCount()
+{
+  return workers.thread_count;
+}
+
+u32 WorkerIndex()
+{
+  return worker_index;
+}
+
+static void QueueJob(const Job& job)
+{
+  if (job.counter) job.counter->fetch_add(1, std::memory_order_relaxed);
+
+  bool queued = false;
+  if (workers.thread_count > 0)
+  {
+    std::lock_guard<std::mutex> lock(workers.lock);
+    Job* queue = job.background ? workers.background : workers.queue;
+    u32& head = job.background ? workers.background_head : workers.head;
+    u32& tail = job.background ? workers.background_tail : workers.tail;
+    if (tail - head < WORKER_QUEUE_SIZE)
+    {
+      queue[tail % WORKER_QUEUE_SIZE] = job;
+      tail++;
+      queued = true;
+    }
+  }
+
+  if (queued) workers.wake.notify_one();
+  else FinishJob(job);
+}
+
+void RunJob(JobFunc func, void* data, JobCounter* counter)
+{
+  QueueJob({ func, data, counter, worker_in_background_job });
+}
+
+void RunBackgroundJob(JobFunc func, void* data, JobCounter* counter)
+{
+  QueueJob({ func, data, counter, true });
+}
+
+// runs one queued job on the calling thread, false if there was nothing to run...off the workers
+// that means nothing in the foreground queue
+bool RunOneJob()
+{
+  Job job;
+  {
+    std::lock_guard<std::mutex> lock(workers.lock);
+    if (!TakeQueuedJob(job, worker_index != 0)) return false;
+  }
+
+  FinishJob(job);
+  return true;
+}
+
+void WaitForJobs(JobCounter& counter)
+{
+  while (counter.load(std::memory_order_acquire) > 0)
+  {
+    if (!RunOneJob()) std::this_thread::yield();
+  }
+}
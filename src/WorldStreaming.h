@@ -0,0 +1,587 @@
+#pragma once
+
+#include "Core.h"
+#include "Profiler.h"
+#include "vector.h"
+#include "Assets.h"
+#include "ECS.h"
+#include "WorkerPool.h"
+#include "AssetPack.h"
+#include "AsyncIO.h"
+#include "imgui/imgui.h"
+#include <atomic>
+#include <algorithm>
+
+
+/// World Streaming API Reference
+////// bool OpenWorld(const char* world_name);
+////// bool OpenGeneratedWorld(f32 chunk_size, s32 chunks_x, s32 chunks_y, WorldChunkSource source);
+////// void CloseWorld();
+////// void UpdateWorldStreaming(vec2 camera_position, vec2 camera_velocity);
+////// void SetWorldStreamingBudget(u32 entities_per_frame, u64 memory_bytes);
+////// void SetWorldStreamingRange(f32 load_radius, f32 prefetch_seconds);
+////// void DrawWorldStreamingWindow(bool* open);
+
+// a world is too big to be one scene, so it is cut into a grid of square chunks that come and go as
+// the camera moves...assets/worlds/<name>/world.enworld gives the grid:
+//   chunk_size <world units>
+//   chunks <x> <y>
+//   load_radius <world units>            (optional)
+// and chunk_<x>_<y>.enchunk next to it lists the chunk's textures, then one line per entity:
+//   "#Entity: texture index, x y, angle, scale x scale y"       (world space)
+// a chunk without a file is just empty. chunk (0, 0) starts at the world origin
+
+// chunks touching the load radius around the camera are wanted, and so are the ones around where the
+// camera will be prefetch_seconds from now, so moving in a straight line finds them already there.
+// chunk files are read through async io, up to WORLD_STREAM_MAX_LOADS of them in flight, and parsed on
+// a worker (a generated world's chunks are made on a worker instead). the main thread only acquires
+// their textures and creates their entities, at most entities_per_frame of them a frame (and destroys
+// at most as many)
+
+// chunks that aren't wanted any more stay until the memory budget is exceeded, then the ones wanted
+// longest ago go first...coming back to where the camera just was costs nothing
+
+// streamed entities have no shader, so they are drawn through the sprite batch. loading a scene
+// destroys every entity, so a world has to be opened after it
+
+enum class CHUNK_STATE : u8
+{
+  UNLOADED,
+  LOADING,        // a worker owns the chunk's data until it is LOADED
+  LOADED,
+  TEXTURES_LOADING,   // textures acquired, their files still being read
+  SPAWNING,       // textures uploaded, entities going in a budget at a time
+  RESIDENT,
+  DESPAWNING
+};
+
+const u32 WORLD_CHUNK_MAX_TEXTURES = 8;
+const u32 WORLD_STREAM_MAX_LOADS = 32;                 // chunk reads and parses in flight at once
+const u32 WORLD_STREAM_DEFAULT_ENTITIES_PER_FRAME = 4096;
+const u64 WORLD_STREAM_DEFAULT_MEMORY_BYTES = 64ull * 1024 * 1024;
+const f32 WORLD_STREAM_DEFAULT_PREFETCH_SECONDS = 0.5f;
+
+struct ChunkEntityDesc
+{
+  s32 texture;
+  vec2 position;
+  f32 angle;
+  vec2 scale;
+};
+
+struct WorldChunkData
+{
+  std::string textures[WORLD_CHUNK_MAX_TEXTURES];
+  u32 texture_count = 0;
+  ChunkEntityDesc* entities = nullptr;
+  u32 entity_count = 0;
+  u32 entity_capacity = 0;
+};
+
+// fills a chunk's data, on a worker...false (and whatever it filled in) if the chunk can't be read
+using WorldChunkSource = bool(*)(s32 x, s32 y, WorldChunkData& data);
+
+struct WorldChunk
+{
+  std::atomic<CHUNK_STATE> state{ CHUNK_STATE::UNLOADED };
+  s32 x = 0;
+  s32 y = 0;
+  WorldChunkData data;
+  MappedFile file;                      // the chunk file, between its read and its parse
+  AssetHandle textures[WORLD_CHUNK_MAX_TEXTURES];
+  u32 textures_pending = 0;             // texture reads not back yet, counted down by PollAsyncReads
+  Entity* entities = nullptr;           // the first spawned of them are alive
+  u32 spawned = 0;
+  u64 bytes = 0;
+  u64 wanted_frame = 0;
+};
+
+static struct
+{
+  std::string path;                     // the world's folder, empty for a generated world
+  WorldChunk* chunks = nullptr;         // chunks_x * chunks_y, row by row
+  s32 chunks_x = 0;
+  s32 chunks_y = 0;
+  f32 chunk_size = 1.f;
+  WorldChunkSource source = nullptr;    // nullptr reads chunk files from path
+  en::vector<s32> active;               // every chunk that isn't UNLOADED
+  JobCounter loads{ 0 };                // parse (or generate) jobs
+  u32 reads = 0;                        // chunk files being read
+
+  f32 load_radius = 1.f;
+  f32 prefetch_seconds = WORLD_STREAM_DEFAULT_PREFETCH_SECONDS;
+  u32 entities_per_frame = WORLD_STREAM_DEFAULT_ENTITIES_PER_FRAME;
+  u64 memory_budget = WORLD_STREAM_DEFAULT_MEMORY_BYTES;
+  u64 frame = 0;
+
+  struct
+  {
+    u64 bytes = 0;                      // everything loaded, resident or not
+    u32 resident = 0;
+    u32 entities = 0;
+    u32 missing = 0;                    // chunks in the load radius not resident yet, this frame
+    u32 spawned = 0;                    // this frame
+    u32 despawned = 0;
+    u64 loads = 0;
+    u64 evictions = 0;
+  } stats;
+} world_streaming;
+
+static void PushChunkEntity(WorldChunkData& data, const ChunkEntityDesc& desc)
+{
+  if (data.entity_count == data.entity_capacity)
+  {
+    u32 capacity = data.entity_capacity ? data.entity_capacity * 2 : 64;
+    ChunkEntityDesc* grown = new ChunkEntityDesc[capacity];
+    if (data.entity_count) memcpy(grown, data.entities, data.entity_count * sizeof(ChunkEntityDesc));
+    delete[] data.entities;
+    data.entities = grown;
+    data.entity_capacity = capacity;
+  }
+
+  data.entities[data.entity_count++] = desc;
+}
+
+static void FreeChunkData(WorldChunkData& data)
+{
+  for (u32 t = 0; t < data.texture_count; t++) data.textures[t].clear();
+  data.texture_count = 0;
+
+  delete[] data.entities;
+  data.entities = nullptr;
+  data.entity_count = 0;
+  data.entity_capacity = 0;
+}
+
+// the chunk file's lines, from wherever async io read it to...a file saved with crlf endings loses
+// the '\r' too, or it would stay on the end of texture paths
+static void ParseWorldChunk(const char* text, u64 size, const char* name, WorldChunkData& data)
+{
+  std::string line;
+  for (u64 at = 0; at < size; at++)
+  {
+    u64 end = at;
+    while (end < size && text[end] != '\n') end++;
+    u64 length = end - at;
+    if (length > 0 && text[end - 1] == '\r') length--;
+    line.assign(text + at, length);
+    at = end;
+
+    if (line.find("#Entity") != std::string::npos)
+    {
+      ChunkEntityDesc desc;
+      f32 px, py, sx, sy;
+      s32 fields = sscanf(line.c_str(), "#Entity: %d, %f %f, %f, %f %f", &desc.texture, &px, &py, &desc.angle, &sx, &sy);
+      if (fields < 6 || desc.texture < 0 || desc.texture >= (s32)data.texture_count)
+      {
+        DebugPrintToConsole("Bad chunk entity: ", line);
+        continue;
+      }
+
+      desc.position = vec2(px, py);
+      desc.scale = vec2(sx, sy);
+      PushChunkEntity(data, desc);
+    }
+    else if (line.find(".png") != std::string::npos || line.find(".jpg") != std::string::npos)
+    {
+      if (data.texture_count == WORLD_CHUNK_MAX_TEXTURES)
+      {
+        DebugPrintToConsole("Too many textures in chunk: ", name);
+        continue;
+      }
+
+      data.textures[data.texture_count++] = line;
+    }
+  }
+}
+
+// a chunk file that isn't there is an empty chunk
+static void ParseChunkJob(void* user_data)
+{
+  PROFILE_SCOPE("ParseWorldChunk");
+  WorldChunk* chunk = (WorldChunk*)user_data;
+  if (chunk->file.data)
+  {
+    char name[64];
+    snprintf(name, sizeof(name), "chunk_%d_%d.enchunk", chunk->x, chunk->y);
+    ParseWorldChunk((const char*)chunk->file.data, chunk->file.size, name, chunk->data);
+    UnmapFile(chunk->file);
+  }
+
+  chunk->state.store(CHUNK_STATE::LOADED, std::memory_order_release);
+}
+
+// main thread, from the async io poll
+static void ChunkReadDone(void* user_data, MappedFile& file)
+{
+  WorldChunk* chunk = (WorldChunk*)user_data;
+  chunk->file = file;
+  world_streaming.reads--;
+  RunBackgroundJob(ParseChunkJob, chunk, &world_streaming.loads);
+}
+
+static void LoadChunkJob(void* user_data)
+{
+  PROFILE_SCOPE("LoadWorldChunk");
+  WorldChunk* chunk = (WorldChunk*)user_data;
+  if (!world_streaming.source(chunk->x, chunk->y, chunk->data))
+  {
+    char name[64];
+    snprintf(name, sizeof(name), "%d, %d", chunk->x, chunk->y);
+    DebugPrintToConsole("Failed to load world chunk: ", name);
+  }
+
+  chunk->state.store(CHUNK_STATE::LOADED, std::memory_order_release);
+}
+
+// what a chunk costs while it is loaded, its descs plus the entities made from them
+static u64 ChunkBytes(const WorldChunk& chunk)
+{
+  u64 per_entity = sizeof(ChunkEntityDesc) + sizeof(Entity) * 2 + sizeof(Transform) + sizeof(BaseScale) + sizeof(Sprite);
+  return sizeof(WorldChunk) + chunk.data.entity_capacity * per_entity;
+}
+
+static void DespawnChunkEntities(WorldChunk& chunk, u32 budget)
+{
+  while (chunk.spawned > 0 && world_streaming.stats.despawned < budget)
+  {
+    DestroyEntity(chunk.entities[--chunk.spawned]);
+    world_streaming.stats.despawned++;
+  }
+}
+
+static void UnloadChunk(WorldChunk& chunk)
+{
+  for (u32 t = 0; t < chunk.data.texture_count; t++) ReleaseAsset(chunk.textures[t]);
+
+  // a chunk still LOADING when the world closes was never counted
+  if (chunk.bytes > 0)
+  {
+    world_streaming.stats.bytes -= chunk.bytes;
+    world_streaming.stats.entities -= chunk.data.entity_count;
+    chunk.bytes = 0;
+  }
+
+  FreeChunkData(chunk.data);
+  delete[] chunk.entities;
+  chunk.entities = nullptr;
+  chunk.spawned = 0;
+  chunk.state.store(CHUNK_STATE::UNLOADED, std::memory_order_relaxed);
+}
+
+void CloseWorld()
+{
+  if (!world_streaming.chunks) return;
+
+  WaitForAsyncReads();
+  WaitForJobs(world_streaming.loads);
+  for (s32 i = 0; i < world_streaming.active.Size(); i++)
+  {
+    WorldChunk& chunk = world_streaming.chunks[world_streaming.active[i]];
+    while (chunk.spawned > 0) DestroyEntity(chunk.entities[--chunk.spawned]);
+    UnloadChunk(chunk);
+  }
+
+  delete[] world_streaming.chunks;
+  world_streaming.chunks = nullptr;
+  world_streaming.active = en::vector<s32>();
+  world_streaming.chunks_x = 0;
+  world_streaming.chunks_y = 0;
+}
+
+static void StartWorld(s32 chunks_x, s32 chunks_y, f32 chunk_size, WorldChunkSource source)
+{
+  world_streaming.chunks_x = chunks_x;
+  world_streaming.chunks_y = chunks_y;
+  world_streaming.chunk_size = chunk_size;
+  world_streaming.source = source;
+  world_streaming.chunks = new WorldChunk[chunks_x * chunks_y];
+  for (s32 y = 0; y < chunks_y; y++)
+  {
+    for (s32 x = 0; x < chunks_x; x++)
+    {
+      world_streaming.chunks[y * chunks_x + x].x = x;
+      world_streaming.chunks[y * chunks_x + x].y = y;
+    }
+  }
+
+  world_streaming.active = en::vector<s32>();
+  world_streaming.frame = 0;
+  world_streaming.stats = {};
+}
+
+// for worlds that come from somewhere other than files, the benchmark's for one
+bool OpenGeneratedWorld(f32 chunk_size, s32 chunks_x, s32 chunks_y, WorldChunkSource source)
+{
+  CloseWorld();
+  if (chunk_size <= 0.f || chunks_x <= 0 || chunks_y <= 0 || !source) return false;
+
+  world_streaming.path.clear();
+  StartWorld(chunks_x, chunks_y, chunk_size, source);
+  return true;
+}
+
+bool OpenWorld(const char* world_name)
+{
+  CloseWorld();
+
+  std::string path = AssetPath("worlds/").append(world_name).append("/");
+  AssetStream world_stream(path + "world.enworld");
+  if (!world_stream)
+  {
+    DebugPrintToConsole("Failed to open world: ", path);
+    return false;
+  }
+
+  f32 chunk_size = 0.f;
+  s32 chunks_x = 0, chunks_y = 0;
+  f32 load_radius = -1.f;
+  std::string line;
+  while (std::getline(world_stream, line))
+  {
+    sscanf(line.c_str(), "chunk_size %f", &chunk_size);
+    sscanf(line.c_str(), "chunks %d %d", &chunks_x, &chunks_y);
+    sscanf(line.c_str(), "load_radius %f", &load_radius);
+  }
+
+  if (chunk_size <= 0.f || chunks_x <= 0 || chunks_y <= 0)
+  {
+    DebugPrintToConsole("Bad world header: ", path);
+    return false;
+  }
+
+  world_streaming.path = path;
+  StartWorld(chunks_x, chunks_y, chunk_size, nullptr);
+  world_streaming.load_radius = load_radius > 0.f ? load_radius : chunk_size;
+  return true;
+}
+
+static void AcquireChunkTextures(WorldChunk& chunk)
+{
+  const char* paths[WORLD_CHUNK_MAX_TEXTURES];
+  for (u32 t = 0; t < chunk.data.texture_count; t++) paths[t] = chunk.data.textures[t].c_str();
+  AcquireTexturesAsync(paths, (s32)chunk.data.texture_count, chunk.textures, &chunk.textures_pending);
+}
+
+static void SpawnChunkEntities(WorldChunk& chunk, u32 budget)
+{
+  ComponentMask components = ComponentBit(COMPONENT::TRANSFORM) | ComponentBit(COMPONENT::BASE_SCALE) | ComponentBit(COMPONENT::SPRITE);
+  while (chunk.spawned < chunk.data.entity_count && world_streaming.stats.spawned < budget)
+  {
+    const ChunkEntityDesc& desc = chunk.data.entities[chunk.spawned];
+    Entity entity = CreateEntity(components);
+
+    Transform* transform = GetComponent<Transform>(entity, COMPONENT::TRANSFORM);
+    transform->position = desc.position;
+    transform->angle = desc.angle;
+    transform->scale = vec2(desc.scale.x(), desc.scale.y() * aspect_ratio);
+    GetComponent<BaseScale>(entity, COMPONENT::BASE_SCALE)->scale = desc.scale;
+    GetComponent<Sprite>(entity, COMPONENT::SPRITE)->texture = AssetTexture(chunk.textures[desc.texture]);
+
+    chunk.entities[chunk.spawned++] = entity;
+    world_streaming.stats.spawned++;
+  }
+}
+
+// marks every chunk touching the circle as wanted this frame and queues the unloaded ones
+static void WantChunksAround(vec2 centre, f32 radius, bool count_missing)
+{
+  f32 size = world_streaming.chunk_size;
+  s32 min_x = std::max(0, (s32)floorf((centre.x() - radius) / size));
+  s32 max_x = std::min(world_streaming.chunks_x - 1, (s32)floorf((centre.x() + radius) / size));
+  s32 min_y = std::max(0, (s32)floorf((centre.y() - radius) / size));
+  s32 max_y = std::min(world_streaming.chunks_y - 1, (s32)floorf((centre.y() + radius) / size));
+
+  for (s32 y = min_y; y <= max_y; y++)
+  {
+    for (s32 x = min_x; x <= max_x; x++)
+    {
+      // nearest point of the chunk to the centre
+      f32 dx = std::max(std::max(x * size - centre.x(), centre.x() - (x + 1) * size), 0.f);
+      f32 dy = std::max(std::max(y * size - centre.y(), centre.y() - (y + 1) * size), 0.f);
+      if (dx * dx + dy * dy > radius * radius) continue;
+
+      s32 index = y * world_streaming.chunks_x + x;
+      WorldChunk& chunk = world_streaming.chunks[index];
+      chunk.wanted_frame = world_streaming.frame;
+
+      CHUNK_STATE state = chunk.state.load(std::memory_order_acquire);
+      if (count_missing && state != CHUNK_STATE::RESIDENT) world_streaming.stats.missing++;
+
+      if (state == CHUNK_STATE::UNLOADED && world_streaming.loads.load(std::memory_order_relaxed) + world_streaming.reads < WORLD_STREAM_MAX_LOADS)
+      {
+        chunk.state.store(CHUNK_STATE::LOADING, std::memory_order_relaxed);
+        world_streaming.active.PushBack(index);
+        world_streaming.stats.loads++;
+        if (world_streaming.source)
+        {
+          RunBackgroundJob(LoadChunkJob, &chunk, &world_streaming.loads);
+          continue;
+        }
+
+        char name[64];
+        snprintf(name, sizeof(name), "chunk_%d_%d.enchunk", x, y);
+        world_streaming.reads++;
+        ReadAssetAsync((world_streaming.path + name).c_str(), ChunkReadDone, &chunk);
+      }
+    }
+  }
+}
+
+// main thread, once a frame
+void UpdateWorldStreaming(vec2 camera_position, vec2 camera_velocity)
+{
+  if (!world_streaming.chunks) return;
+
+  PROFILE_FUNCTION();
+
+  world_streaming.frame++;
+  world_streaming.stats.missing = 0;
+  world_streaming.stats.spawned = 0;
+  world_streaming.stats.despawned = 0;
+
+  WantChunksAround(camera_position, world_streaming.load_radius, true);
+  if (world_streaming.prefetch_seconds > 0.f)
+  {
+    f32 ahead = world_streaming.prefetch_seconds;
+    WantChunksAround(vec2(camera_position.x() + camera_velocity.x() * ahead, camera_position.y() + camera_velocity.y() * ahead),
+      world_streaming.load_radius, false);
+  }
+
+  // sends this frame's chunk reads off together and hands the ones that came back to the workers
+  PollAsyncReads();
+
+  u32 budget = world_streaming.entities_per_frame;
+  for (s32 i = 0; i < world_streaming.active.Size(); i++)
+  {
+    WorldChunk& chunk = world_streaming.chunks[world_streaming.active[i]];
+    bool wanted = chunk.wanted_frame == world_streaming.frame;
+
+    switch (chunk.state.load(std::memory_order_acquire))
+    {
+    case CHUNK_STATE::LOADED:
+      chunk.bytes = ChunkBytes(chunk);
+      world_streaming.stats.bytes += chunk.bytes;
+      world_streaming.stats.entities += chunk.data.entity_count;
+      if (!wanted)
+      {
+        // the camera turned around before it got here
+        UnloadChunk(chunk);
+        break;
+      }
+
+      AcquireChunkTextures(chunk);
+      chunk.entities = new Entity[chunk.data.entity_count];
+      chunk.state.store(CHUNK_STATE::TEXTURES_LOADING, std::memory_order_relaxed);
+      // falls through, the textures may all have been loaded already
+    case CHUNK_STATE::TEXTURES_LOADING:
+      // the reads point at the chunk, so it stays put until they are back even if it isn't wanted
+      if (chunk.textures_pending > 0) break;
+      chunk.state.store(CHUNK_STATE::SPAWNING, std::memory_order_relaxed);
+      // falls through to spawn what the budget allows this frame
+    case CHUNK_STATE::SPAWNING:
+      if (!wanted)
+      {
+        chunk.state.store(CHUNK_STATE::DESPAWNING, std::memory_order_relaxed);
+        break;
+      }
+
+      SpawnChunkEntities(chunk, budget);
+      if (chunk.spawned == chunk.data.entity_count)
+      {
+        chunk.state.store(CHUNK_STATE::RESIDENT, std::memory_order_relaxed);
+        world_streaming.stats.resident++;
+      }
+      break;
+    default:
+      break;
+    }
+  }
+
+  // over budget, the chunks wanted longest ago start going...never one that is still wanted
+  u64 bytes = 0;
+  for (s32 i = 0; i < world_streaming.active.Size(); i++)
+  {
+    WorldChunk& chunk = world_streaming.chunks[world_streaming.active[i]];
+    if (chunk.state.load(std::memory_order_relaxed) != CHUNK_STATE::DESPAWNING) bytes += chunk.bytes;
+  }
+
+  while (bytes > world_streaming.memory_budget)
+  {
+    WorldChunk* oldest = nullptr;
+    for (s32 i = 0; i < world_streaming.active.Size(); i++)
+    {
+      WorldChunk& chunk = world_streaming.chunks[world_streaming.active[i]];
+      if (chunk.state.load(std::memory_order_relaxed) != CHUNK_STATE::RESIDENT || chunk.wanted_frame == world_streaming.frame) continue;
+      if (!oldest || chunk.wanted_frame < oldest->wanted_frame) oldest = &chunk;
+    }
+
+    if (!oldest) break;
+
+    oldest->state.store(CHUNK_STATE::DESPAWNING, std::memory_order_relaxed);
+    world_streaming.stats.resident--;
+    world_streaming.stats.evictions++;
+    bytes -= oldest->bytes;
+  }
+
+  for (s32 i = world_streaming.active.Size() - 1; i >= 0; i--)
+  {
+    WorldChunk& chunk = world_streaming.chunks[world_streaming.active[i]];
+    if (chunk.state.load(std::memory_order_relaxed) != CHUNK_STATE::DESPAWNING) continue;
+
+    DespawnChunkEntities(chunk, budget);
+    if (chunk.spawned > 0) continue;
+
+    UnloadChunk(chunk);
+    world_streaming.active[i] = world_streaming.active[world_streaming.active.Size() - 1];
+    world_streaming.active.PopBack();
+  }
+
+  for (s32 i = world_streaming.active.Size() - 1; i >= 0; i--)
+  {
+    if (world_streaming.chunks[world_streaming.active[i]].state.load(std::memory_order_relaxed) != CHUNK_STATE::UNLOADED) continue;
+
+    world_streaming.active[i] = world_streaming.active[world_streaming.active.Size() - 1];
+    world_streaming.active.PopBack();
+  }
+}
+
+// budget on entities created (and, separately, destroyed) per frame, and on loaded chunk memory
+void SetWorldStreamingBudget(u32 entities_per_frame, u64 memory_bytes)
+{
+  world_streaming.entities_per_frame = entities_per_frame > 0 ? entities_per_frame : 1;
+  world_streaming.memory_budget = memory_bytes;
+}
+
+// 0 prefetch seconds only loads around the camera itself
+void SetWorldStreamingRange(f32 load_radius, f32 prefetch_seconds)
+{
+  world_streaming.load_radius = load_radius;
+  world_streaming.prefetch_seconds = prefetch_seconds;
+}
+
+void DrawWorldStreamingWindow(bool* open)
+{
+  if (!ImGui::Begin("World Streaming", open))
+  {
+    ImGui::End();
+    return;
+  }
+
+  if (!world_streaming.chunks)
+  {
+    ImGui::Text("No world open");
+    ImGui::End();
+    return;
+  }
+
+  ImGui::Text("%d x %d chunks of %.2f, load radius %.2f, prefetch %.2f s", world_streaming.chunks_x, world_streaming.chunks_y,
+    world_streaming.chunk_size, world_streaming.load_radius, world_streaming.prefetch_seconds);
+  ImGui::Text("Resident: %u chunks, %u entities loaded, %.2f / %.2f MB", world_streaming.stats.resident, world_streaming.stats.entities,
+    world_streaming.stats.bytes / (1024.0 * 1024.0), world_streaming.memory_budget / (1024.0 * 1024.0));
+  ImGui::Text("This frame: %u spawned, %u despawned, %u chunks in range still missing", world_streaming.stats.spawned,
+    world_streaming.stats.despawned, world_streaming.stats.missing);
+  ImGui::Text("Loads: %llu   Evictions: %llu", (unsigned long long)world_streaming.stats.loads, (unsigned long long)world_streaming.stats.evictions);
+
+  ImGui::End();
+}
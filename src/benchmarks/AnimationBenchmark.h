@@ -0,0 +1,100 @@
+#pragma once
+
+#include "../Core.h"
+#include "../Benchmark.h"
+#include "../Animation.h"
+#include "../SpriteBatch.h"
+#include "../Random.h"
+
+
+// the per entity stepping the engine used before animation clips, one struct per sprite that polls
+// its own timer and wraps a hard coded 10 frame sheet
+struct LegacyAnimInfo
+{
+  s32 anim_frame = 0;
+  bool anim_flipped = false;
+  f32 anim_elapsed = 0.f;
+};
+
+static void LegacyStepAnimation(LegacyAnimInfo& anim, f32 delta_seconds)
+{
+  anim.anim_elapsed += delta_seconds;
+  if (anim.anim_elapsed > 0.1f)
+  {
+    if (anim.anim_frame == 9) anim.anim_frame = 0;
+    else anim.anim_frame++;
+
+    anim.anim_elapsed = 0.f;
+  }
+}
+
+static s32 AddBenchmarkClip(const char* name, ANIM_LOOP loop, s32 frames, f32 seconds)
+{
+  AnimationClip clip;
+  clip.name = name;
+  clip.first_frame = animation_clips.frame_rects.Size();
+  clip.frame_count = 0;
+  clip.loop = loop;
+  for (s32 i = 0; i < frames; i++) AddAnimationFrame(clip, vec4((f32)(i % 5) / 5.f, (f32)(i / 5) / 2.f, 0.2f, 0.5f), seconds);
+
+  animation_clips.names.Insert(clip.name, animation_clips.clips.Size());
+  animation_clips.clips.PushBack(clip);
+  return animation_clips.clips.Size() - 1;
+}
+
+void BenchmarkAnimation()
+{
+  const s32 sprite_count = 100000;
+  const u32 ticks = 600;
+
+  s32 clips[3] =
+  {
+    AddBenchmarkClip("bench_run", ANIM_LOOP::LOOP, 10, 0.1f),
+    AddBenchmarkClip("bench_idle", ANIM_LOOP::PING_PONG, 4, 0.25f),
+    AddBenchmarkClip("bench_hit", ANIM_LOOP::ONCE, 6, 0.05f),
+  };
+
+  s32* sprites = new s32[sprite_count];
+  for (s32 i = 0; i < sprite_count; i++)
+  {
+    sprites[i] = CreateAnimation(clips[i % 3]);
+    SetAnimationSpeed(sprites[i], RandomFloatInRange(0.5f, 1.5f));
+    SetAnimationFlipped(sprites[i], (i & 1) != 0);
+  }
+
+  u64 start = BenchmarkNow();
+  for (u32 t = 0; t < ticks; t++) UpdateAnimations(1.f / 60.f);
+  ReportBenchmark("UpdateAnimations 100k (per tick)", ticks, BenchmarkNow() - start);
+
+  // the instance data the sprite batch uploads, without a gl context there is nothing to draw it with
+  SpriteBatch batch;
+  batch.capacity = sprite_count;
+  batch.instances = new SpriteInstance[batch.capacity];
+  start = BenchmarkNow();
+  for (u32 t = 0; t < ticks; t++)
+  {
+    for (s32 i = 0; i < sprite_count; i++)
+    {
+      PushSprite(batch, 1, vec2((f32)(i % 300), (f32)(i / 300)), vec2(1.f, 1.f), 0.f, GetAnimationRect(sprites[i]));
+    }
+
+    benchmark_sink += (u64)(batch.instances[t].rect.x() * 1000.f);
+    batch.count = 0;
+  }
+  ReportBenchmark("PushSprite 100k (per frame)", ticks, BenchmarkNow() - start);
+
+  LegacyAnimInfo* legacy = new LegacyAnimInfo[sprite_count];
+  start = BenchmarkNow();
+  for (u32 t = 0; t < ticks; t++)
+  {
+    for (s32 i = 0; i < sprite_count; i++) LegacyStepAnimation(legacy[i], 1.f / 60.f);
+    benchmark_sink += legacy[t].anim_frame;
+  }
+  ReportBenchmark("legacy per sprite stepping 100k (per tick)", ticks, BenchmarkNow() - start);
+  printf("    the legacy path also set 2 uniforms and issued a draw call per sprite\n");
+
+  delete[] legacy;
+  delete[] batch.instances;
+  for (s32 i = 0; i < sprite_count; i++) DestroyAnimation(sprites[i]);
+  delete[] sprites;
+}
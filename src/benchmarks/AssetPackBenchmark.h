@@ -0,0 +1,288 @@
+#pragma once
+
+#include "../Core.h"
+#include "../Benchmark.h"
+#include "../AssetPack.h"
+
+
+// 10k small files in a scratch folder shaped like assets/, read loose one at a time and then out of
+// a pack of the same folder...the os cache is warm for both, a cold cache only widens the gap
+void BenchmarkAssetPack()
+{
+  const s32 file_count = 10000;
+  const char* folders[] = { "textures", "audio", "scenes", "shaders", "animations" };
+
+  std::filesystem::path root = std::filesystem::temp_directory_path() / "en_asset_pack_benchmark";
+  std::filesystem::remove_all(root);
+  for (const char* folder : folders) std::filesystem::create_directories(root / folder);
+
+  en::vector<std::string> names;
+  std::string contents;
+  for (s32 f = 0; f < file_count; f++)
+  {
+    char name[64];
+    snprintf(name, sizeof(name), "%s/asset_%05d.bin", folders[f % 5], f);
+    names.PushBack(name);
+
+    contents.assign(512 + (f * 7919) % 3584, (char)('a' + f % 26));
+    std::ofstream((root / name).string(), std::ios::binary) << contents;
+  }
+
+  std::string pack_path = (std::filesystem::temp_directory_path() / "en_asset_pack_benchmark.enpak").string();
+  u64 start = BenchmarkNow();
+  bool packed = WriteAssetPack(root.string().c_str(), pack_path.c_str(), false);
+  ReportBenchmark("WriteAssetPack, 10k files", 1, BenchmarkNow() - start);
+
+  start = BenchmarkNow();
+  bool mounted = packed && MountAssetPack(pack_path.c_str());
+  ReportBenchmark("MountAssetPack", 1, BenchmarkNow() - start);
+  if (!mounted)
+  {
+    printf("    could not build or mount %s\n", pack_path.c_str());
+    return;
+  }
+
+  // what every loader did before, a path built and a file opened and read per asset
+  std::string loose_root = root.generic_string() + "/";
+  u64 bytes = 0;
+  char* buffer = new char[4096];
+  start = BenchmarkNow();
+  for (s32 f = 0; f < file_count; f++)
+  {
+    std::string path = loose_root + names[f];
+    std::ifstream stream(path, std::ios::binary);
+    stream.read(buffer, 4096);
+    bytes += (u64)stream.gcount() + (u8)buffer[0];
+  }
+  ReportBenchmark("loose files, open and read", file_count, BenchmarkNow() - start);
+
+  start = BenchmarkNow();
+  for (s32 f = 0; f < file_count; f++)
+  {
+    MappedFile file;
+    if (MapFile((loose_root + names[f]).c_str(), file)) bytes += file.size + file.data[0];
+    UnmapFile(file);
+  }
+  ReportBenchmark("loose files, mapped", file_count, BenchmarkNow() - start);
+
+  start = BenchmarkNow();
+  for (s32 f = 0; f < file_count; f++)
+  {
+    AssetSpan span = FindPackedAsset(names[f].c_str());
+    bytes += span.size + span.data[0];
+  }
+  ReportBenchmark("FindPackedAsset, touching the first byte", file_count, BenchmarkNow() - start);
+
+  // lookups alone, every name 10 times over
+  start = BenchmarkNow();
+  for (s32 r = 0; r < 10; r++)
+  {
+    for (s32 f = 0; f < file_count; f++) bytes += FindPackedAsset(names[f].c_str()).size;
+  }
+  ReportBenchmark("FindPackedAsset lookup", file_count * 10, BenchmarkNow() - start);
+  printf("    %u entries in %u buckets, %llu KB pack\n", asset_pack.header->entry_count, 1u << asset_pack.header->bucket_bits,
+    (unsigned long long)(asset_pack.header->size / 1024));
+
+  benchmark_sink += bytes;
+  delete[] buffer;
+  UnmountAssetPack();
+  std::filesystem::remove(pack_path);
+  std::filesystem::remove_all(root);
+}
+
+// drops a file from the os cache so the next read comes off the disk, only where posix_fadvise is
+static bool DropFromFileCache(const std::string& path)
+{
+#ifdef __linux__
+  s32 fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) return false;
+  fdatasync(fd);          // dirty pages aren't dropped, a pack just written is all dirty
+  s32 result = posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+  close(fd);
+  return result == 0;
+#else
+  (void)path;
+  return false;
+#endif
+}
+
+// every file through MapFile or MapPackedAsset with every cache line of it touched, what a loader
+// uploading or parsing the whole asset pays
+static u64 LoadBenchmarkAssets(en::vector<std::string>& names, const std::string& loose_root, bool packed)
+{
+  u64 sum = 0;
+  for (s32 f = 0; f < names.Size(); f++)
+  {
+    MappedFile file;
+    bool mapped = packed ? MapPackedAsset(names[f].c_str(), file) : MapFile((loose_root + names[f]).c_str(), file);
+    if (!mapped) continue;
+
+    for (u64 i = 0; i < file.size; i += 64) sum += file.data[i];
+    UnmapFile(file);
+  }
+
+  return sum;
+}
+
+static void ReportAssetLoads(const char* label, const char* layout, u64 bytes, u64 ns)
+{
+  printf("    %-6s %-18s %8.2f ms  %8.1f MB/s\n", label, layout, ns / 1e6, ns ? bytes / 1048576.0 / (ns / 1e9) : 0.0);
+}
+
+// one set of files loose, in a stored pack and in a compressed pack...sizes, then every file loaded
+// with a cold os cache (linux only) and a warm one
+static void CompareAssetPackLayouts(const char* label, const std::string& directory)
+{
+  std::string loose_root = directory + "/";
+  en::vector<std::string> names;
+  u64 loose_bytes = 0, loose_disk = 0;
+  std::error_code error;
+  for (auto& item : std::filesystem::recursive_directory_iterator(directory, error))
+  {
+    if (!item.is_regular_file(error)) continue;
+    names.PushBack(item.path().lexically_relative(directory).generic_string());
+    loose_bytes += (u64)item.file_size(error);
+    loose_disk += (u64)(item.file_size(error) + 4095) / 4096 * 4096;
+  }
+
+  std::filesystem::path temp = std::filesystem::temp_directory_path();
+  std::string plain_path = (temp / "en_asset_pack_plain.enpak").string();
+  std::string compressed_path = (temp / "en_asset_pack_compressed.enpak").string();
+
+  u64 start = BenchmarkNow();
+  bool written = WriteAssetPack(directory.c_str(), plain_path.c_str(), false);
+  u64 plain_ns = BenchmarkNow() - start;
+  start = BenchmarkNow();
+  written = written && WriteAssetPack(directory.c_str(), compressed_path.c_str(), true);
+  u64 compressed_ns = BenchmarkNow() - start;
+  if (!written)
+  {
+    printf("  %s: could not write the packs\n", label);
+    return;
+  }
+
+  u64 plain_size = std::filesystem::file_size(plain_path, error);
+  u64 compressed_size = std::filesystem::file_size(compressed_path, error);
+  printf("  %s, %d files, %.2f MB\n", label, names.Size(), loose_bytes / 1048576.0);
+  printf("    loose %.2f MB on disk in 4 KB blocks, stored pack %.2f MB (%.1f ms to write), compressed pack %.2f MB (%.1f ms, %.2fx)\n",
+    loose_disk / 1048576.0, plain_size / 1048576.0, plain_ns / 1e6, compressed_size / 1048576.0, compressed_ns / 1e6,
+    compressed_size ? (f64)plain_size / compressed_size : 0.0);
+
+  MountAssetPack(compressed_path.c_str());
+  u32 compressed_entries = 0;
+  for (u32 e = 0; e < asset_pack.header->entry_count; e++)
+  {
+    if (asset_pack.entries[e].flags & ASSET_PACK_COMPRESSED) compressed_entries++;
+  }
+  printf("    %u of %u entries compressed\n", compressed_entries, asset_pack.header->entry_count);
+  UnmountAssetPack();
+
+  const char* layouts[] = { "loose", "stored pack", "compressed pack" };
+  const char* packs[] = { nullptr, plain_path.c_str(), compressed_path.c_str() };
+  bool cold_measured = true;
+  u64 sum = 0;
+
+  for (s32 l = 0; l < 3; l++)
+  {
+    // cold, the pack is mounted after its pages are dropped and the mount isn't timed
+    bool dropped = true;
+    if (packs[l]) dropped = DropFromFileCache(packs[l]);
+    else for (s32 f = 0; f < names.Size(); f++) dropped = DropFromFileCache(loose_root + names[f]) && dropped;
+    cold_measured = cold_measured && dropped;
+    if (packs[l]) MountAssetPack(packs[l]);
+
+    start = BenchmarkNow();
+    sum += LoadBenchmarkAssets(names, loose_root, packs[l] != nullptr);
+    if (dropped) ReportAssetLoads("cold", layouts[l], loose_bytes, BenchmarkNow() - start);
+
+    const s32 rounds = 5;
+    start = BenchmarkNow();
+    for (s32 r = 0; r < rounds; r++) sum += LoadBenchmarkAssets(names, loose_root, packs[l] != nullptr);
+    ReportAssetLoads("warm", layouts[l], loose_bytes, (BenchmarkNow() - start) / rounds);
+
+    if (packs[l]) UnmountAssetPack();
+  }
+
+  if (!cold_measured) printf("    no cold numbers, the os cache can't be dropped here\n");
+  printf("    %llu compressed loads in scratch, %llu on the heap, %llu spread over the workers\n",
+    (unsigned long long)asset_scratch.stats.scratch_loads, (unsigned long long)asset_scratch.stats.heap_loads,
+    (unsigned long long)asset_scratch.stats.parallel_loads);
+  asset_scratch.stats = {};
+
+  benchmark_sink += sum;
+  std::filesystem::remove(plain_path);
+  std::filesystem::remove(compressed_path);
+}
+
+// the engine's own assets, then a made up set shaped like a bigger game's: lots of small text (scenes,
+// shaders, animations), a few long 16 bit sounds and images that are already compressed
+void BenchmarkAssetPackCompression()
+{
+  InitWorkers(0);
+
+  if (std::filesystem::is_directory(asset_root)) CompareAssetPackLayouts("assets/", std::filesystem::path(asset_root).lexically_normal().generic_string());
+  else printf("  no assets folder at %s, skipping it\n", asset_root.c_str());
+
+  std::filesystem::path root = std::filesystem::temp_directory_path() / "en_asset_pack_compression_benchmark";
+  std::filesystem::remove_all(root);
+  const char* folders[] = { "scenes", "shaders", "animations", "audio", "textures" };
+  for (const char* folder : folders) std::filesystem::create_directories(root / folder);
+
+  u32 state = 0x2545F491u;
+  auto next = [&]()
+  {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+  };
+
+  std::string contents;
+  for (s32 f = 0; f < 3000; f++)
+  {
+    contents.clear();
+    u32 lines = 40 + next() % 400;
+    for (u32 l = 0; l < lines; l++)
+    {
+      char line[128];
+      snprintf(line, sizeof(line), "entity %u texture %u position %.3f %.3f scale 0.%03u\n", next() % 5000, next() % 64,
+        (next() % 100000) / 1000.f, (next() % 100000) / 1000.f, next() % 1000);
+      contents += line;
+    }
+
+    char name[64];
+    snprintf(name, sizeof(name), "%s/text_%04d.txt", folders[f % 3], f);
+    std::ofstream((root / name).string(), std::ios::binary) << contents;
+  }
+
+  for (s32 f = 0; f < 24; f++)
+  {
+    u32 samples = 100000 + next() % 900000;
+    contents.assign((u64)samples * 2, '\0');
+    f32 phase = 0.f, step = 0.01f + (next() % 100) / 2000.f;
+    for (u32 s = 0; s < samples; s++)
+    {
+      s16 sample = (s16)(sinf(phase) * 12000.f) + (s16)(next() % 512) - 256;
+      memcpy(&contents[(u64)s * 2], &sample, 2);
+      phase += step;
+    }
+
+    char name[64];
+    snprintf(name, sizeof(name), "audio/sound_%02d.wav", f);
+    std::ofstream((root / name).string(), std::ios::binary) << contents;
+  }
+
+  for (s32 f = 0; f < 200; f++)
+  {
+    contents.resize(8192 + next() % 131072);
+    for (char& c : contents) c = (char)next();
+
+    char name[64];
+    snprintf(name, sizeof(name), "textures/image_%03d.png", f);
+    std::ofstream((root / name).string(), std::ios::binary) << contents;
+  }
+
+  CompareAssetPackLayouts("generated", root.generic_string());
+  std::filesystem::remove_all(root);
+  ShutdownWorkers();
+}
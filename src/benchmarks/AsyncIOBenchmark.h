@@ -0,0 +1,101 @@
+#pragma once
+
+#include "../Core.h"
+#include "../Benchmark.h"
+#include "../AsyncIO.h"
+#include "AssetPackBenchmark.h"
+
+
+static u64 async_benchmark_bytes = 0;
+
+static void CountAsyncBenchmarkRead(void* /*user_data*/, MappedFile& file)
+{
+  if (file.data) async_benchmark_bytes += file.size + file.data[file.size - 1];
+  UnmapFile(file);
+}
+
+// drops every file from the os cache first when cold, then reads them all, through async io when
+// backend isn't null and one after the other on this thread when it is
+static void ReadBenchmarkFiles(const char* label, en::vector<std::string>& paths, const ASYNC_IO* backend, u32 depth, bool cold)
+{
+  if (cold)
+  {
+    bool dropped = true;
+    for (s32 f = 0; f < paths.Size(); f++) dropped = DropFromFileCache(paths[f]) && dropped;
+    if (!dropped) return;
+  }
+
+  if (backend) InitAsyncIO(depth, *backend);
+  async_benchmark_bytes = 0;
+
+  u64 start = BenchmarkNow();
+  if (backend)
+  {
+    for (s32 f = 0; f < paths.Size(); f++) ReadFileAsync(paths[f].c_str(), CountAsyncBenchmarkRead, nullptr);
+    WaitForAsyncReads();
+  }
+  else
+  {
+    u8* buffer = new u8[ASYNC_IO_SLOT_SIZE];
+    for (s32 f = 0; f < paths.Size(); f++)
+    {
+      FILE* file = fopen(paths[f].c_str(), "rb");
+      if (!file) continue;
+      size_t size = fread(buffer, 1, ASYNC_IO_SLOT_SIZE, file);
+      if (size > 0) async_benchmark_bytes += size + buffer[size - 1];
+      fclose(file);
+    }
+    delete[] buffer;
+  }
+  u64 elapsed = BenchmarkNow() - start;
+
+  char name[96];
+  snprintf(name, sizeof(name), "%s, %s", cold ? "cold" : "warm", label);
+  ReportBenchmark(name, paths.Size(), elapsed);
+  benchmark_sink += async_benchmark_bytes;
+
+  if (backend)
+  {
+    printf("    %s, %llu staged, %llu submits\n", AsyncIOBackendName(), (unsigned long long)async_io.stats.staged,
+      (unsigned long long)async_io.stats.submits);
+    ShutdownAsyncIO();
+  }
+}
+
+// 10k files of 512 bytes to 4 KB, read whole one at a time and then through async io at a few queue depths
+void BenchmarkAsyncIO()
+{
+  const s32 file_count = 10000;
+  InitWorkers(0);
+
+  std::filesystem::path root = std::filesystem::temp_directory_path() / "en_async_io_benchmark";
+  std::filesystem::remove_all(root);
+  std::filesystem::create_directories(root);
+
+  en::vector<std::string> paths;
+  std::string contents;
+  for (s32 f = 0; f < file_count; f++)
+  {
+    char name[64];
+    snprintf(name, sizeof(name), "file_%05d.bin", f);
+    paths.PushBack((root / name).string());
+
+    contents.assign(512 + (f * 7919) % 3584, (char)('a' + f % 26));
+    std::ofstream(paths[f], std::ios::binary) << contents;
+  }
+
+  ASYNC_IO threads = ASYNC_IO::THREADS;
+  ASYNC_IO ring = ASYNC_IO::RING;
+  for (s32 pass = 0; pass < 2; pass++)
+  {
+    bool cold = pass == 0;
+    ReadBenchmarkFiles("fopen and fread, one at a time", paths, nullptr, 0, cold);
+    ReadBenchmarkFiles("worker pool, 64 in flight", paths, &threads, 64, cold);
+    ReadBenchmarkFiles("io_uring, 8 in flight", paths, &ring, 8, cold);
+    ReadBenchmarkFiles("io_uring, 32 in flight", paths, &ring, 32, cold);
+    ReadBenchmarkFiles("io_uring, 128 in flight", paths, &ring, 128, cold);
+  }
+
+  ShutdownWorkers();
+  std::filesystem::remove_all(root);
+}
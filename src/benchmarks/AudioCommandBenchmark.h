@@ -0,0 +1,102 @@
+#pragma once
+
+#include "../Core.h"
+#include "../Benchmark.h"
+#include "../Random.h"
+#include "../Audio.h"
+#include <thread>
+
+
+// what a sound event costs the main thread: pushing commands to the audio thread against the old
+// path of looking the sound up by name and running the voice manager on the calling thread
+void BenchmarkAudioCommands()
+{
+  const s32 rounds = 2000;
+  const s32 plays_per_round = 256;
+  const s32 sound_count = 16;
+
+  if (!InitSound(AUDIO_BACKEND::NONE, nullptr))
+  {
+    printf("  could not start the null audio backend\n");
+    return;
+  }
+
+  SoundHandle sounds[sound_count];
+  {
+    std::lock_guard<std::mutex> guard(audio.lock);
+    NullAudioBackend* backend = static_cast<NullAudioBackend*>(audio_backend);
+    for (s32 i = 0; i < sound_count; i++)
+    {
+      sounds[i].id = RegisterSound(backend->AddNullSound(0.25f + i * 0.05f, false), 0.25f + i * 0.05f, false, SOUND_PRIORITY_EFFECT, SOUND_EFFECT_MAX_INSTANCES);
+    }
+  }
+
+  SeedRandom(33);
+  u64 queued = audio.processed_commands.load();
+  u64 play_ns = 0;
+  u64 param_ns = 0;
+  u64 param_ops = 0;
+
+  for (s32 r = 0; r < rounds; r++)
+  {
+    SoundEvent events[plays_per_round];
+
+    u64 start = BenchmarkNow();
+    for (s32 i = 0; i < plays_per_round; i++) events[i] = PlaySound(sounds[i & (sound_count - 1)]);
+    play_ns += BenchmarkNow() - start;
+
+    VoiceParams params;
+    params.volume = 0.5f;
+    start = BenchmarkNow();
+    for (s32 i = 0; i < plays_per_round; i += 8)
+    {
+      if (i & 8) StopSound(events[i]);
+      else SetSoundParams(events[i], params);
+    }
+    param_ns += BenchmarkNow() - start;
+    param_ops += plays_per_round / 8;
+
+    // give the audio thread a chance to drain, like a frame boundary would
+    while (audio.commands.Size() > AUDIO_COMMAND_QUEUE_SIZE / 2) std::this_thread::yield();
+  }
+
+  u64 pushed = (u64)rounds * (plays_per_round + plays_per_round / 8);
+  while (audio.processed_commands.load() - queued < pushed - audio.dropped_commands) std::this_thread::yield();
+
+  ReportBenchmark("PlaySound (queued)", (u64)rounds * plays_per_round, play_ns);
+  ReportBenchmark("StopSound / SetSoundParams (queued)", param_ops, param_ns);
+  printf("  commands processed by the audio thread %llu, dropped %llu\n",
+    (unsigned long long)(audio.processed_commands.load() - queued), (unsigned long long)audio.dropped_commands);
+
+  ShutdownSound();
+
+  // the old path, name lookup then the voice manager on the calling thread
+  NullAudioBackend backend;
+  backend.Init(MAX_REAL_VOICES);
+  InitVoiceManager(&backend);
+  en::unordered_map<std::string, s32> names;
+  std::string sound_names[sound_count];
+  for (s32 i = 0; i < sound_count; i++)
+  {
+    sound_names[i] = "sound" + std::to_string(i) + ".wav";
+    names.Insert(sound_names[i], RegisterSound(backend.AddNullSound(0.25f, false), 0.25f, false, SOUND_PRIORITY_EFFECT, SOUND_EFFECT_MAX_INSTANCES));
+  }
+
+  u64 direct_ns = 0;
+  for (s32 r = 0; r < rounds; r++)
+  {
+    u64 start = BenchmarkNow();
+    for (s32 i = 0; i < plays_per_round; i++)
+    {
+      const char* name = sound_names[i & (sound_count - 1)].c_str();
+      std::string path = AssetPath("audio/").append(name);
+      benchmark_sink += path.size();
+      if (names.Find(name)) PlayVoice(names.At(name), VoiceParams());
+    }
+    direct_ns += BenchmarkNow() - start;
+    UpdateVoices(1.f / 60.f);
+  }
+
+  ReportBenchmark("PlaySound by name, voices on caller", (u64)rounds * plays_per_round, direct_ns);
+  backend.Shutdown();
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "../Core.h"
+#include "../Benchmark.h"
+#include "../Audio.h"
+
+
+static const char* audio_load_benchmark_files[] = { "Hit.wav", "Score.wav", "Victory.wav", "MainTheme.wav" };
+
+// loads every test asset with one policy and mixes a second of each, so the memory a policy saves
+// can be weighed against what it costs to load and to play
+static void BenchmarkAudioLoadPolicy(AUDIO_LOAD policy)
+{
+  SoftwareAudioBackend backend;
+  backend.Init(4);
+
+  const u32 rounds = 8;
+  u64 load_ns = 0;
+  u64 bytes = 0;
+  s32 sounds[4];
+
+  for (u32 r = 0; r < rounds; r++)
+  {
+    for (u32 f = 0; f < 4; f++)
+    {
+      std::string path = AssetPath("audio/").append(audio_load_benchmark_files[f]);
+      PreparedSound prepared;
+
+      u64 start = BenchmarkNow();
+      bool loaded = backend.PrepareSound(path.c_str(), false, policy, prepared);
+      load_ns += BenchmarkNow() - start;
+
+      if (!loaded)
+      {
+        printf("  could not load %s, run from the build directory\n", path.c_str());
+        backend.Shutdown();
+        return;
+      }
+
+      if (r == 0)
+      {
+        bytes += prepared.resident_bytes;
+        sounds[f] = backend.AddSound(prepared);
+      }
+      else
+      {
+        FreeMixerSound(*(MixerSound*)prepared.native);
+        delete (MixerSound*)prepared.native;
+      }
+    }
+  }
+
+  char label[96];
+  snprintf(label, sizeof(label), "load %s (per file)", audio_load_names[(u32)policy]);
+  ReportBenchmark(label, rounds * 4, load_ns);
+  printf("    resident: %.1f KB for %d files\n", bytes / 1024.0, 4);
+
+  for (u32 f = 0; f < 4; f++) backend.StartVoice(f, sounds[f], VoiceParams(), 0.f);
+
+  // streams read their first chunk on the stream thread, only the steady state is timed
+  if (policy == AUDIO_LOAD::STREAM) std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+  alignas(32) static f32 block[2][MIXER_BLOCK_FRAMES];
+  const u32 blocks = MIXER_SAMPLE_RATE / MIXER_BLOCK_FRAMES;
+  u64 mix_ns = 0;
+  for (u32 b = 0; b < blocks; b++)
+  {
+    u64 start = BenchmarkNow();
+    MixAudio(backend.mixer, block[0], block[1], MIXER_BLOCK_FRAMES);
+    mix_ns += BenchmarkNow() - start;
+    benchmark_sink += (u64)(block[0][b % MIXER_BLOCK_FRAMES] * 1000.f);
+
+    // give the stream thread the time it would have between real blocks
+    if (policy == AUDIO_LOAD::STREAM) std::this_thread::sleep_for(std::chrono::microseconds(500));
+  }
+
+  snprintf(label, sizeof(label), "mix %s (4 voice block)", audio_load_names[(u32)policy]);
+  ReportBenchmark(label, blocks, mix_ns);
+  if (policy == AUDIO_LOAD::STREAM) printf("    stream stalls: %llu\n", (unsigned long long)backend.mixer.stream_stalls);
+
+  backend.Shutdown();
+}
+
+// the scene path: every file queued at once on the loader thread, timed until the last one is playable
+static void BenchmarkAudioLoadAsync()
+{
+  InitSound(AUDIO_BACKEND::SOFTWARE, nullptr);
+
+  u64 start = BenchmarkNow();
+  u64 queue_ns = 0;
+  for (u32 f = 0; f < 4; f++)
+  {
+    bool looping = f == 3;
+    u64 queued = BenchmarkNow();
+    LoadSound(audio_load_benchmark_files[f], looping, DefaultLoadPolicy(looping));
+    queue_ns += BenchmarkNow() - queued;
+  }
+
+  WaitForSoundLoads();
+  u64 total_ns = BenchmarkNow() - start;
+
+  ReportBenchmark("async LoadSound call", 4, queue_ns);
+  printf("    all 4 files ready after %.2f ms, %u failed\n", total_ns / 1e6, audio_memory.failed.load());
+
+  ShutdownSound();
+}
+
+void BenchmarkAudioLoad()
+{
+  BenchmarkAudioLoadPolicy(AUDIO_LOAD::RESIDENT);
+  BenchmarkAudioLoadPolicy(AUDIO_LOAD::COMPRESSED);
+  BenchmarkAudioLoadPolicy(AUDIO_LOAD::STREAM);
+  BenchmarkAudioLoadPolicy(AUDIO_LOAD::MAPPED);
+  BenchmarkAudioLoadAsync();
+}
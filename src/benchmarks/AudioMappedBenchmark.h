@@ -0,0 +1,133 @@
+#pragma once
+
+#include "../Core.h"
+#include "../Benchmark.h"
+#include "../AudioBackend.h"
+
+
+const u32 MAPPED_BENCHMARK_FILES = 1000;
+
+// short 44.1k stereo tones between a tenth and half a second long, about what a sound effect is
+static bool WriteBenchmarkSfx(const std::string& directory)
+{
+  std::filesystem::create_directories(directory);
+
+  alignas(32) static f32 block[2][MIXER_BLOCK_FRAMES];
+  for (u32 f = 0; f < MAPPED_BENCHMARK_FILES; f++)
+  {
+    std::string path = directory + "/sfx" + std::to_string(f) + ".wav";
+    AudioSink sink;
+    if (!OpenAudioSink(sink, AUDIO_SINK::WAV, path.c_str(), SAMPLE_FORMAT::S16, 44100)) return false;
+
+    u32 frames = 4410 + (f * 7919) % 17640;
+    f32 frequency = 200.f + (f % 50) * 20.f;
+    for (u32 offset = 0; offset < frames; offset += MIXER_BLOCK_FRAMES)
+    {
+      u32 count = frames - offset < MIXER_BLOCK_FRAMES ? frames - offset : MIXER_BLOCK_FRAMES;
+      for (u32 i = 0; i < count; i++)
+      {
+        block[0][i] = 0.25f * sinf(6.2831853f * frequency * (offset + i) / 44100.f);
+        block[1][i] = block[0][i];
+      }
+
+      WriteAudioSink(sink, block[0], block[1], count);
+    }
+
+    CloseAudioSink(sink);
+  }
+
+  return true;
+}
+
+// loads every file through the backend, then mixes a second with 32 of them playing at once
+static void BenchmarkMappedLoad(const char* name, AudioBackend& backend, const std::string& directory, AUDIO_LOAD policy, bool mix)
+{
+  backend.Init(32);
+
+  u64 bytes = 0;
+  u64 start = BenchmarkNow();
+  for (u32 f = 0; f < MAPPED_BENCHMARK_FILES; f++)
+  {
+    std::string path = directory + "/sfx" + std::to_string(f) + ".wav";
+    PreparedSound prepared;
+    if (!backend.PrepareSound(path.c_str(), false, policy, prepared))
+    {
+      printf("  could not load %s\n", path.c_str());
+      backend.Shutdown();
+      return;
+    }
+
+    bytes += prepared.resident_bytes;
+    backend.AddSound(prepared);
+  }
+
+  char label[96];
+  snprintf(label, sizeof(label), "load %s (per file)", name);
+  ReportBenchmark(label, MAPPED_BENCHMARK_FILES, BenchmarkNow() - start);
+  printf("    %s: %.1f MB for %u files\n", policy == AUDIO_LOAD::MAPPED ? "mapped" : "heap", bytes / (1024.0 * 1024.0), MAPPED_BENCHMARK_FILES);
+
+  if (mix)
+  {
+    SoftwareAudioBackend& software = (SoftwareAudioBackend&)backend;
+    for (u32 v = 0; v < 32; v++) backend.StartVoice(v, (s32)(v * 31 % MAPPED_BENCHMARK_FILES), VoiceParams(), 0.f);
+
+    alignas(32) static f32 block[2][MIXER_BLOCK_FRAMES];
+    const u32 blocks = MIXER_SAMPLE_RATE / MIXER_BLOCK_FRAMES;
+    u64 mix_start = BenchmarkNow();
+    for (u32 b = 0; b < blocks; b++)
+    {
+      MixAudio(software.mixer, block[0], block[1], MIXER_BLOCK_FRAMES);
+      benchmark_sink += (u64)(block[0][b % MIXER_BLOCK_FRAMES] * 1000.f);
+    }
+
+    snprintf(label, sizeof(label), "mix %s (32 voice block)", name);
+    ReportBenchmark(label, blocks, BenchmarkNow() - mix_start);
+  }
+
+  backend.Shutdown();
+}
+
+void BenchmarkAudioMapped()
+{
+  std::string directory = (std::filesystem::temp_directory_path() / "engine_sfx_benchmark").string();
+  if (!WriteBenchmarkSfx(directory))
+  {
+    printf("  could not write the test files to %s\n", directory.c_str());
+    return;
+  }
+
+  // every case reads from a warm file cache, the first one to run would otherwise pay for the disk
+  for (u32 f = 0; f < MAPPED_BENCHMARK_FILES; f++)
+  {
+    MappedFile file;
+    std::string path = directory + "/sfx" + std::to_string(f) + ".wav";
+    if (!MapFile(path.c_str(), file)) continue;
+    for (u64 i = 0; i < file.size; i += 4096) benchmark_sink += file.data[i];
+    UnmapFile(file);
+  }
+
+  {
+    SoftwareAudioBackend backend;
+    BenchmarkMappedLoad("software resident", backend, directory, AUDIO_LOAD::RESIDENT, true);
+  }
+  {
+    SoftwareAudioBackend backend;
+    BenchmarkMappedLoad("software mapped", backend, directory, AUDIO_LOAD::MAPPED, true);
+  }
+
+#ifdef EN_FMOD
+  {
+    FMODAudioBackend backend;
+    BenchmarkMappedLoad("fmod createSound", backend, directory, AUDIO_LOAD::RESIDENT, false);
+  }
+  {
+    FMODAudioBackend backend;
+    BenchmarkMappedLoad("fmod mapped", backend, directory, AUDIO_LOAD::MAPPED, false);
+  }
+#else
+  printf("  built without EN_FMOD, skipping the createSound comparison\n");
+#endif
+
+  std::error_code error;
+  std::filesystem::remove_all(directory, error);
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "../Core.h"
+#include "../Benchmark.h"
+#include "../AudioMixer.h"
+
+
+static void CreateBenchmarkTone(MixerSound& sound, u32 channels, u32 sample_rate, f32 frequency)
+{
+  AllocMixerSound(sound, channels, sample_rate * 2, sample_rate, true);
+  for (u32 c = 0; c < channels; c++)
+  {
+    for (u32 i = 0; i < sound.frame_count; i++)
+    {
+      sound.planes[c][i] = 0.25f * sinf(6.2831853f * frequency * (c + 1) * i / sample_rate);
+    }
+  }
+
+  WriteMixerSoundGuards(sound);
+}
+
+// mixes two seconds of audio per case and reports it against the time one block is allowed to take
+static void BenchmarkMixerCase(const char* name, u32 voices, RESAMPLE_MODE resample, u32 channels, u32 sample_rate, f32 pitch)
+{
+  AudioMixer mixer;
+  InitMixer(mixer, voices, resample);
+
+  MixerSound tone;
+  CreateBenchmarkTone(tone, channels, sample_rate, 220.f);
+  s32 sound = AddMixerSound(mixer, tone);
+  for (u32 i = 0; i < voices; i++)
+  {
+    StartMixerVoice(mixer, i, sound, 1.f / voices, (f32)i / voices * 2.f - 1.f, pitch, (f32)i / voices);
+  }
+
+  AudioSink sink;
+  OpenAudioSink(sink, AUDIO_SINK::NONE, nullptr, SAMPLE_FORMAT::S16, MIXER_SAMPLE_RATE);
+
+  alignas(32) static f32 block[2][MIXER_BLOCK_FRAMES];
+  const u32 blocks = MIXER_SAMPLE_RATE * 2 / MIXER_BLOCK_FRAMES;
+  u64 mix_ns = 0;
+  u64 output_ns = 0;
+
+  for (u32 b = 0; b < blocks; b++)
+  {
+    u64 start = BenchmarkNow();
+    MixAudio(mixer, block[0], block[1], MIXER_BLOCK_FRAMES);
+    u64 mixed = BenchmarkNow();
+    WriteAudioSink(sink, block[0], block[1], MIXER_BLOCK_FRAMES);
+    output_ns += BenchmarkNow() - mixed;
+    mix_ns += mixed - start;
+    benchmark_sink += (u64)(block[0][b % MIXER_BLOCK_FRAMES] * 1000.f);
+  }
+
+  char label[96];
+  snprintf(label, sizeof(label), "%s x%u (per voice block)", name, voices);
+  ReportBenchmark(label, (u64)blocks * voices, mix_ns);
+
+  f64 budget_ns = 1e9 * MIXER_BLOCK_FRAMES / MIXER_SAMPLE_RATE;
+  f64 block_ns = (f64)(mix_ns + output_ns) / blocks;
+  printf("    %.1f%% of the %.2f ms block budget\n", 100.0 * block_ns / budget_ns, budget_ns / 1e6);
+
+  CloseAudioSink(sink);
+  ShutdownMixer(mixer);
+}
+
+void BenchmarkAudioMixer()
+{
+  printf("  mixer lanes: %d\n", EN_MIXER_LANES);
+
+  const u32 voice_counts[] = { 32, 256 };
+  for (u32 voices : voice_counts)
+  {
+    BenchmarkMixerCase("48k stereo native", voices, RESAMPLE_MODE::LINEAR, 2, 48000, 1.f);
+    BenchmarkMixerCase("44.1k stereo linear", voices, RESAMPLE_MODE::LINEAR, 2, 44100, 1.f);
+    BenchmarkMixerCase("44.1k stereo cubic", voices, RESAMPLE_MODE::CUBIC, 2, 44100, 1.f);
+    BenchmarkMixerCase("44.1k mono cubic", voices, RESAMPLE_MODE::CUBIC, 1, 44100, 1.f);
+    BenchmarkMixerCase("48k stereo cubic 1.5x", voices, RESAMPLE_MODE::CUBIC, 2, 48000, 1.5f);
+  }
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "../Core.h"
+#include "../Benchmark.h"
+#include "../AudioSpatial.h"
+
+
+// what a straightforward emitter loop would do, one emitter at a time with no budget or culling ahead
+// of the voice pool...kept as the baseline for the batched pass
+static void LegacySpatializeEmitters(u32 count, f32* gain, f32* pan)
+{
+  for (u32 i = 0; i < count; i++)
+  {
+    f32 dx = sound_emitters.x[i] - sound_emitters.listener_x;
+    f32 dy = sound_emitters.y[i] - sound_emitters.listener_y;
+    f32 distance = sqrtf(dx * dx + dy * dy);
+    f32 max_distance = sqrtf(sound_emitters.max_distance_sq[i]);
+    f32 falloff = distance < max_distance ? 1.f - distance / max_distance : 0.f;
+    gain[i] = sound_emitters.volume[i] * falloff * falloff;
+    pan[i] = fminf(fmaxf(dx / (0.5f * max_distance), -1.f), 1.f);
+  }
+}
+
+void BenchmarkAudioSpatial()
+{
+  const u32 emitter_count = 50000;
+  const u32 ticks = 600;
+
+  InitSound(AUDIO_BACKEND::NONE, nullptr);
+  SoundHandle sound = LoadSound("ambience.wav", true, AUDIO_LOAD::RESIDENT);    // the null backend never opens it
+  WaitForSoundLoads();
+
+  // a 200x200 world with emitters heard from 2 to 10 units away
+  for (u32 i = 0; i < emitter_count; i++)
+  {
+    vec2 position(RandomFloatInRange(-100.f, 100.f), RandomFloatInRange(-100.f, 100.f));
+    CreateSoundEmitter(sound, position, RandomFloatInRange(2.f, 10.f), RandomFloatInRange(0.5f, 1.f));
+  }
+
+  u64 update_ns = 0;
+  u64 worst_ns = 0;
+  u64 in_range = 0;
+  u64 playing = 0;
+  u64 commands = 0;
+
+  for (u32 t = 0; t < ticks; t++)
+  {
+    // the listener walks across the world while a tenth of the emitters move about
+    SetAudioListener(vec2(-90.f + 180.f * t / ticks, 20.f * sinf(t * 0.05f)));
+    for (u32 i = t % 10; i < emitter_count; i += 10)
+    {
+      SetSoundEmitterPosition((s32)i, vec2(sound_emitters.x[i] + 0.05f, sound_emitters.y[i]));
+    }
+
+    u64 start = BenchmarkNow();
+    UpdateSoundEmitters();
+    u64 elapsed = BenchmarkNow() - start;
+
+    update_ns += elapsed;
+    worst_ns = elapsed > worst_ns ? elapsed : worst_ns;
+    in_range += sound_emitters.stats.in_range;
+    playing += sound_emitters.stats.playing;
+    commands += sound_emitters.stats.started + sound_emitters.stats.stopped + sound_emitters.stats.updated;
+
+    // let the audio thread drain the queue like it would between real ticks
+    std::this_thread::sleep_for(std::chrono::microseconds(AUDIO_THREAD_PERIOD_US));
+  }
+
+  ReportBenchmark("UpdateSoundEmitters 50k (per tick)", ticks, update_ns);
+  printf("    worst tick %.3f ms, %.0f in range, %.0f playing, %.1f commands per tick, %llu dropped\n",
+    worst_ns / 1e6, (f64)in_range / ticks, (f64)playing / ticks, (f64)commands / ticks, (unsigned long long)audio.dropped_commands);
+
+  f32* gain = new f32[emitter_count];
+  f32* pan = new f32[emitter_count];
+  u64 start = BenchmarkNow();
+  for (u32 t = 0; t < ticks; t++)
+  {
+    SetAudioListener(vec2(-90.f + 180.f * t / ticks, 0.f));
+    LegacySpatializeEmitters(emitter_count, gain, pan);
+    benchmark_sink += (u64)(gain[t] * 1000.f);
+  }
+  ReportBenchmark("scalar emitter loop 50k (per tick)", ticks, BenchmarkNow() - start);
+
+  start = BenchmarkNow();
+  for (u32 t = 0; t < ticks; t++)
+  {
+    SetAudioListener(vec2(-90.f + 180.f * t / ticks, 0.f));
+    SpatializeEmitters();
+    benchmark_sink += sound_emitters.candidate_count;
+  }
+  ReportBenchmark("batched emitter pass 50k (per tick)", ticks, BenchmarkNow() - start);
+
+  delete[] gain;
+  delete[] pan;
+
+  for (u32 i = 0; i < emitter_count; i++) DestroySoundEmitter((s32)i);
+  ShutdownSound();
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "../Core.h"
+#include "../Benchmark.h"
+#include "../Random.h"
+#include "../AudioBackend.h"
+#include "../AudioVoices.h"
+
+
+// 10 seconds of 10k sound triggers per second against the null backend, with volumes, stops and
+// parameter changes mixed in the way gameplay would do them
+void BenchmarkAudioVoices()
+{
+  const s32 sound_count = 64;
+  const s32 updates_per_second = 200;
+  const s32 plays_per_update = 10000 / updates_per_second;
+  const s32 seconds = 10;
+  const f32 update_seconds = 1.f / updates_per_second;
+
+  NullAudioBackend backend;
+  backend.Init(MAX_REAL_VOICES);
+  InitVoiceManager(&backend);
+  SeedRandom(31);
+
+  for (s32 i = 0; i < sound_count; i++)
+  {
+    bool looping = i < 4;
+    f32 length = RandomFloatInRange(0.1f, 3.f);
+    u8 priority = looping ? 255 : (u8)(RandomU32() % 200);
+    u16 max_instances = looping ? 1 : (u16)(1 + RandomU32() % 16);
+    RegisterSound(backend.AddNullSound(length, looping), length, looping, priority, max_instances);
+  }
+
+  VoiceHandle recent[256] = {};
+  u64 play_ns = 0, update_ns = 0, param_ns = 0;
+  u64 plays = 0, param_changes = 0;
+  u32 max_active = 0;
+  bool over_real_limit = false;
+
+  for (s32 u = 0; u < seconds * updates_per_second; u++)
+  {
+    u64 start = BenchmarkNow();
+    for (s32 p = 0; p < plays_per_update; p++)
+    {
+      VoiceParams params;
+      params.volume = RandomFloat() < 0.2f ? 0.001f : RandomFloatInRange(0.05f, 1.f);    // a fifth start inaudible
+      params.pan = RandomFloatInRange(-1.f, 1.f);
+      recent[(plays++) & 255] = PlayVoice(4 + RandomU32() % (sound_count - 4), params);
+    }
+    play_ns += BenchmarkNow() - start;
+
+    start = BenchmarkNow();
+    for (s32 p = 0; p < 16; p++)
+    {
+      VoiceHandle handle = recent[RandomU32() & 255];
+      VoiceParams params;
+      params.volume = RandomFloat();
+      if (RandomFloat() < 0.25f) StopVoice(handle);
+      else SetVoiceParams(handle, params);
+      param_changes++;
+    }
+    param_ns += BenchmarkNow() - start;
+
+    start = BenchmarkNow();
+    UpdateVoices(update_seconds);
+    update_ns += BenchmarkNow() - start;
+
+    if (voice_manager.active_count > max_active) max_active = voice_manager.active_count;
+
+    u32 backend_playing = 0;
+    for (u32 i = 0; i < MAX_REAL_VOICES; i++) backend_playing += backend.IsVoicePlaying(i) ? 1 : 0;
+    if (RealVoiceCount() > MAX_REAL_VOICES || backend_playing > MAX_REAL_VOICES) over_real_limit = true;
+  }
+
+  ReportBenchmark("PlayVoice", plays, play_ns);
+  ReportBenchmark("StopVoice / SetVoiceParams", param_changes, param_ns);
+  ReportBenchmark("UpdateVoices (200 Hz)", seconds * updates_per_second, update_ns);
+
+  VoiceStats& stats = voice_manager.stats;
+  printf("  plays %llu, rejected %llu, stolen %llu, instance limited %llu, virtualized %llu, promoted %llu\n",
+    (unsigned long long)stats.plays, (unsigned long long)stats.rejected, (unsigned long long)stats.stolen,
+    (unsigned long long)stats.instance_limited, (unsigned long long)stats.virtualized, (unsigned long long)stats.promoted);
+  printf("  backend starts %llu, peak active voices %u / %u, real voices now %u / %u%s\n",
+    (unsigned long long)backend.voices_started, max_active, MAX_VOICES, RealVoiceCount(), MAX_REAL_VOICES,
+    over_real_limit ? "  ** REAL VOICE LIMIT EXCEEDED **" : "");
+
+  backend.Shutdown();
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "../Benchmark.h"
+#include "RandomBenchmark.h"
+#include "AudioVoiceBenchmark.h"
+#include "AudioMixerBenchmark.h"
+#include "AudioCommandBenchmark.h"
+#include "AudioLoadBenchmark.h"
+#include "AudioMappedBenchmark.h"
+#include "AudioSpatialBenchmark.h"
+#include "AnimationBenchmark.h"
+#include "TimerWheelBenchmark.h"
+#include "EcsBenchmark.h"
+#include "SchedulerBenchmark.h"
+#include "SceneGraphBenchmark.h"
+#include "AssetBenchmark.h"
+#include "HotReloadBenchmark.h"
+#include "WorldStreamingBenchmark.h"
+#include "PrefabBenchmark.h"
+#include "SnapshotBenchmark.h"
+#include "AssetPackBenchmark.h"
+#include "AsyncIOBenchmark.h"
+
+
+void RegisterBenchmarks()
+{
+  RegisterBenchmark("random", BenchmarkRandom);
+  RegisterBenchmark("audio_voices", BenchmarkAudioVoices);
+  RegisterBenchmark("audio_mixer", BenchmarkAudioMixer);
+  RegisterBenchmark("audio_commands", BenchmarkAudioCommands);
+  RegisterBenchmark("audio_load", BenchmarkAudioLoad);
+  RegisterBenchmark("audio_mapped", BenchmarkAudioMapped);
+  RegisterBenchmark("audio_spatial", BenchmarkAudioSpatial);
+  RegisterBenchmark("animation", BenchmarkAnimation);
+  RegisterBenchmark("timers", BenchmarkTimerWheel);
+  RegisterBenchmark("ecs", BenchmarkEcs);
+  RegisterBenchmark("scheduler", BenchmarkScheduler);
+  RegisterBenchmark("scene_graph", BenchmarkSceneGraph);
+  RegisterBenchmark("assets", BenchmarkAssets);
+  RegisterBenchmark("hot_reload", BenchmarkHotReload);
+  RegisterBenchmark("world_streaming", BenchmarkWorldStreaming);
+  RegisterBenchmark("prefabs", BenchmarkPrefabs);
+  RegisterBenchmark("snapshot", BenchmarkSnapshot);
+  RegisterBenchmark("snapshot_compression", BenchmarkSnapshotCompression);
+  RegisterBenchmark("asset_pack", BenchmarkAssetPack);
+  RegisterBenchmark("asset_pack_compression", BenchmarkAssetPackCompression);
+  RegisterBenchmark("async_io", BenchmarkAsyncIO);
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "../Core.h"
+#include "../Benchmark.h"
+#include "../ECS.h"
+#include "../Random.h"
+
+
+// the Entity struct the engine kept in one en::vector before the ecs, every system walked all of it
+struct LegacyEntity
+{
+  Vertex verts[4] = { vec2(1.f, 1.f), vec2(1.f, -1.f), vec2(-1.f, -1.f), vec2(-1.f, 1.f) };
+  vec2 position;
+  vec2 scale;
+  u32 vao, vbo, ebo;
+  u32 shader;
+  u32 texture;
+  f32 angle = 0.f;
+  s32 sound_emitter = -1;
+  s32 animation = -1;
+  bool editor_selected = false;
+  vec2 velocity;
+};
+
+void BenchmarkEcs()
+{
+  const u32 entity_count = 1000000;
+  const u32 passes = 50;
+  const f32 dt = 1.f / 120.f;
+
+  const ComponentMask moving = ComponentBit(COMPONENT::TRANSFORM) | ComponentBit(COMPONENT::VELOCITY);
+  const ComponentMask sprites = ComponentBit(COMPONENT::TRANSFORM) | ComponentBit(COMPONENT::SPRITE);
+  const ComponentMask animated = sprites | ComponentBit(COMPONENT::ANIMATED) | ComponentBit(COMPONENT::VELOCITY);
+
+  // a mix of archetypes like a real scene would have, half of everything moves
+  Entity* entities = new Entity[entity_count];
+  u64 start = BenchmarkNow();
+  for (u32 i = 0; i < entity_count; i++)
+  {
+    ComponentMask mask = i % 4 == 0 ? moving : i % 4 == 1 ? animated : i % 4 == 2 ? sprites : sprites | ComponentBit(COMPONENT::BASE_SCALE);
+    entities[i] = CreateEntity(mask);
+  }
+  ReportBenchmark("CreateEntity 1M", entity_count, BenchmarkNow() - start);
+  printf("    %d archetypes, %u chunks\n", ecs.archetypes.Size(), ecs.stats.chunks);
+
+  EcsQuery query = CreateQuery(moving, 0);
+  ForEachChunk(query, [&](const EcsChunk& chunk)
+  {
+    Velocity* velocity = ChunkColumn<Velocity>(chunk, COMPONENT::VELOCITY);
+    for (s32 i = 0; i < chunk.count; i++) velocity[i].velocity = vec2(RandomFloatInRange(-1.f, 1.f), RandomFloatInRange(-1.f, 1.f));
+  });
+
+  start = BenchmarkNow();
+  u64 moved = 0;
+  for (u32 p = 0; p < passes; p++)
+  {
+    ForEachChunk(query, [&](const EcsChunk& chunk)
+    {
+      Transform* transform = ChunkColumn<Transform>(chunk, COMPONENT::TRANSFORM);
+      const Velocity* velocity = ChunkColumn<Velocity>(chunk, COMPONENT::VELOCITY);
+      for (s32 i = 0; i < chunk.count; i++)
+      {
+        transform[i].position = vec2(transform[i].position.x() + velocity[i].velocity.x() * dt, transform[i].position.y() + velocity[i].velocity.y() * dt);
+      }
+      moved += chunk.count;
+    });
+  }
+  ReportBenchmark("movement query, 500k of 1M (per pass)", passes, BenchmarkNow() - start);
+  benchmark_sink += moved;
+
+  LegacyEntity* legacy = new LegacyEntity[entity_count];
+  for (u32 i = 0; i < entity_count; i += 2) legacy[i].velocity = vec2(RandomFloatInRange(-1.f, 1.f), RandomFloatInRange(-1.f, 1.f));
+  start = BenchmarkNow();
+  for (u32 p = 0; p < passes; p++)
+  {
+    for (u32 i = 0; i < entity_count; i++)
+    {
+      LegacyEntity& e = legacy[i];
+      e.position = vec2(e.position.x() + e.velocity.x() * dt, e.position.y() + e.velocity.y() * dt);
+    }
+  }
+  ReportBenchmark("legacy Entity array 1M (per pass)", passes, BenchmarkNow() - start);
+  benchmark_sink += (u64)legacy[entity_count / 2].position.x();
+  delete[] legacy;
+
+  // structural changes, every static sprite starts moving and then stops again
+  const u32 changes = entity_count / 4;
+  start = BenchmarkNow();
+  for (u32 i = 2; i < entity_count; i += 4) AddComponent(entities[i], COMPONENT::VELOCITY);
+  ReportBenchmark("AddComponent 250k", changes, BenchmarkNow() - start);
+
+  start = BenchmarkNow();
+  for (u32 i = 2; i < entity_count; i += 4) RemoveComponent(entities[i], COMPONENT::VELOCITY);
+  ReportBenchmark("RemoveComponent 250k", changes, BenchmarkNow() - start);
+
+  start = BenchmarkNow();
+  u64 found = 0;
+  for (u32 i = 0; i < entity_count; i++)
+  {
+    u32 index = RandomU32() % entity_count;
+    found += GetComponent<Transform>(entities[index], COMPONENT::TRANSFORM) ? 1 : 0;
+  }
+  ReportBenchmark("GetComponent random 1M", entity_count, BenchmarkNow() - start);
+  benchmark_sink += found;
+
+  start = BenchmarkNow();
+  for (u32 i = 0; i < entity_count; i += 2) DestroyEntity(entities[i]);
+  ReportBenchmark("DestroyEntity 500k", entity_count / 2, BenchmarkNow() - start);
+  printf("    %u alive, %llu archetype moves\n", EntityCount(), (unsigned long long)ecs.stats.moves);
+
+  DestroyAllEntities();
+  delete[] entities;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "../Core.h"
+#include "../Benchmark.h"
+#include "../HotReload.h"
+#include <thread>
+
+
+// save to reload for one file, against a scratch folder shaped like assets/...most of it is the
+// debounce, what's left is how quickly the watcher notices the change
+void BenchmarkHotReload()
+{
+  const u32 saves = 20;
+
+  std::filesystem::path root = std::filesystem::temp_directory_path() / "en_hot_reload_benchmark";
+  std::filesystem::create_directories(root / "textures");
+  std::string texture = (root / "textures" / "test.png").string();
+  std::ofstream(texture) << "v0";
+
+  FileWatcher watcher;
+  if (!InitFileWatcher(watcher, (root.string() + "/").c_str()))
+  {
+    printf("    could not watch %s\n", root.string().c_str());
+    return;
+  }
+
+  u64 total_ns = 0;
+  u64 worst_ns = 0;
+  u32 seen = 0;
+  for (u32 s = 0; s < saves; s++)
+  {
+    // an editor style save, the file is written twice in quick succession
+    u64 saved = BenchmarkNow();
+    std::ofstream(texture) << "v" << s;
+    std::ofstream(texture, std::ios::app) << " more";
+
+    en::vector<std::string> changed;
+    while (BenchmarkNow() - saved < 1000000000ull)
+    {
+      if (PollFileWatcher(watcher, changed) > 0) break;
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    u64 latency = BenchmarkNow() - saved;
+    if (changed.Size() == 1 && changed[0] == "textures/test.png") seen++;
+    total_ns += latency;
+    if (latency > worst_ns) worst_ns = latency;
+  }
+
+  ReportBenchmark("save to debounced change (per save)", saves, total_ns);
+  printf("    %u of %u saves seen once, worst %.1f ms, %u ms of that is the debounce\n", seen, saves, worst_ns / 1e6, HOT_RELOAD_DEBOUNCE_MS);
+
+  // a frame with nothing changed, paid every frame while the game runs
+  const u32 polls = 100000;
+  u64 start = BenchmarkNow();
+  en::vector<std::string> nothing;
+  for (u32 p = 0; p < polls; p++) PollFileWatcher(watcher, nothing);
+  ReportBenchmark("PollFileWatcher, nothing changed", polls, BenchmarkNow() - start);
+
+  ShutdownFileWatcher(watcher);
+  std::filesystem::remove_all(root);
+}
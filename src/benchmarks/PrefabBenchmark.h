@@ -0,0 +1,70 @@
+#pragma once
+
+#include "../Core.h"
+#include "../Benchmark.h"
+#include "../ECS.h"
+#include "../Prefabs.h"
+#include "../Random.h"
+
+
+void BenchmarkPrefabs()
+{
+  const s32 instance_count = 10000;
+  const s32 rounds = 20;
+  if (aspect_ratio == 0.f) aspect_ratio = (f32)window_width / (f32)window_height;
+
+  vec2* positions = new vec2[instance_count];
+  for (s32 i = 0; i < instance_count; i++) positions[i] = vec2(RandomFloatInRange(-1.f, 1.f), RandomFloatInRange(-1.f, 1.f));
+  Entity* entities = new Entity[instance_count];
+
+  Sprite sprite;
+  sprite.texture = 1;
+  sprite.shader = 2;
+  sprite.vao = 3;
+  s32 prefab = DefinePrefab("crate", sprite, vec2(0.1f, 0.1f), 0.f);
+
+  // what a scene did before prefabs, every entity carrying its own copy of the sprite and scale
+  u64 start = BenchmarkNow();
+  for (s32 r = 0; r < rounds; r++)
+  {
+    DestroyAllEntities();
+    for (s32 i = 0; i < instance_count; i++)
+    {
+      entities[i] = CreateEntity(ComponentBit(COMPONENT::TRANSFORM) | ComponentBit(COMPONENT::BASE_SCALE) | ComponentBit(COMPONENT::SPRITE));
+      Transform* transform = GetComponent<Transform>(entities[i], COMPONENT::TRANSFORM);
+      transform->position = positions[i];
+      transform->scale = vec2(0.1f, 0.1f * aspect_ratio);
+      GetComponent<BaseScale>(entities[i], COMPONENT::BASE_SCALE)->scale = vec2(0.1f, 0.1f);
+      *GetComponent<Sprite>(entities[i], COMPONENT::SPRITE) = sprite;
+    }
+  }
+  ReportBenchmark("10k full entities, one at a time (per round)", rounds, BenchmarkNow() - start);
+  u32 full_chunks = ecs.stats.chunks;
+
+  start = BenchmarkNow();
+  for (s32 r = 0; r < rounds; r++)
+  {
+    DestroyAllEntities();
+    SpawnPrefabs(prefab, instance_count, positions, entities);
+  }
+  ReportBenchmark("SpawnPrefabs 10k (per round)", rounds, BenchmarkNow() - start);
+  u32 instance_chunks = ecs.stats.chunks;
+
+  printf("    full entities: %u KB in %u chunks, %zu bytes of components each\n", full_chunks * ECS_CHUNK_BYTES / 1024, full_chunks,
+    sizeof(Transform) + sizeof(BaseScale) + sizeof(Sprite));
+  printf("    instances:     %u KB in %u chunks, %zu bytes of components each\n", instance_chunks * ECS_CHUNK_BYTES / 1024, instance_chunks,
+    sizeof(Transform) + sizeof(PrefabInstance));
+
+  // 1% of the instances get a scale of their own, only those move to the bigger archetype
+  start = BenchmarkNow();
+  for (s32 i = 0; i < instance_count; i += 100) OverridePrefabScale(entities[i], vec2(0.2f, 0.2f));
+  ReportBenchmark("OverridePrefabScale on 1%", instance_count / 100, BenchmarkNow() - start);
+  printf("    with 1%% overridden: %u KB in %u chunks\n", ecs.stats.chunks * ECS_CHUNK_BYTES / 1024, ecs.stats.chunks);
+
+  benchmark_sink += (u64)(EntityBaseScale(entities[instance_count - 1]).x() * 1000.f) + EntitySprite(entities[0]).texture;
+
+  DestroyAllEntities();
+  ClearPrefabs();
+  delete[] positions;
+  delete[] entities;
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "../Core.h"
+#include "../Benchmark.h"
+#include "../Random.h"
+
+
+// the per-call mt19937 functions the engine used before Random.h, kept here as the baseline
+static f32 LegacyRandomFloat()
+{
+  std::mt19937 generator((u32)std::chrono::steady_clock::now().time_since_epoch().count());
+  std::uniform_real_distribution<f32> distribution(0.f, 1.f);
+  return distribution(generator);
+}
+
+static f32 LegacyRandomFloatInRange(f32 lower, f32 upper)
+{
+  std::mt19937 generator((u32)std::chrono::steady_clock::now().time_since_epoch().count());
+  std::uniform_real_distribution<f32> distribution(lower, upper);
+  return distribution(generator);
+}
+
+void BenchmarkRandom()
+{
+  const s32 legacy_count = 30000;       // what the 5000 particle setup used to draw
+  const s32 count = 10000000;
+  f32* out = new f32[count];
+  memset(out, 0, count * sizeof(f32));    // fault the pages in up front so the batch fill isn't timing the OS
+  f32 sum = 0.f;
+
+  u64 start = BenchmarkNow();
+  for (s32 i = 0; i < legacy_count; i++) sum += LegacyRandomFloatInRange(-1.f, 1.f);
+  ReportBenchmark("legacy mt19937 per call (30k)", legacy_count, BenchmarkNow() - start);
+
+  start = BenchmarkNow();
+  for (s32 i = 0; i < legacy_count; i++) sum += LegacyRandomFloat();
+  ReportBenchmark("legacy GetRandomFloat (30k)", legacy_count, BenchmarkNow() - start);
+
+  start = BenchmarkNow();
+  for (s32 i = 0; i < legacy_count; i++) sum += RandomFloatInRange(-1.f, 1.f);
+  ReportBenchmark("RandomFloatInRange (30k)", legacy_count, BenchmarkNow() - start);
+
+  start = BenchmarkNow();
+  for (s32 i = 0; i < count; i++) sum += RandomFloat();
+  ReportBenchmark("RandomFloat pcg32", count, BenchmarkNow() - start);
+
+  Xoshiro256 xoshiro;
+  xoshiro.Seed(1);
+  u64 bits = 0;
+  start = BenchmarkNow();
+  for (s32 i = 0; i < count; i++) bits ^= xoshiro.Next();
+  ReportBenchmark("Xoshiro256 next u64", count, BenchmarkNow() - start);
+
+  start = BenchmarkNow();
+  for (s32 i = 0; i < count; i++) sum += RandomNormal(0.f, 1.f);
+  ReportBenchmark("RandomNormal", count, BenchmarkNow() - start);
+
+  start = BenchmarkNow();
+  for (s32 i = 0; i < count; i++) sum += RandomUnitVec2().x();
+  ReportBenchmark("RandomUnitVec2", count, BenchmarkNow() - start);
+
+  start = BenchmarkNow();
+  RandomFillFloats(out, count, -1.f, 1.f);
+  u64 elapsed = BenchmarkNow() - start;
+  ReportBenchmark(EN_RANDOM_LANES == 8 ? "RandomFillFloats avx2" : (EN_RANDOM_LANES == 4 ? "RandomFillFloats sse2" : "RandomFillFloats scalar"), count, elapsed);
+
+  // sanity check the batch fill stays in range and looks uniform
+  f64 mean = 0.0;
+  s32 out_of_range = 0;
+  for (s32 i = 0; i < count; i++)
+  {
+    mean += out[i];
+    if (out[i] < -1.f || out[i] >= 1.f) out_of_range++;
+  }
+  printf("  batch fill mean %.5f (expected 0), %d out of range\n", mean / count, out_of_range);
+
+  benchmark_sink = (u64)sum ^ bits;
+  delete[] out;
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "../Core.h"
+#include "../Benchmark.h"
+#include "../SceneGraph.h"
+#include "../Random.h"
+
+
+void BenchmarkSceneGraph()
+{
+  const u32 node_count = 100000;
+  const u32 frames = 200;
+  const u32 moves_per_frame = node_count / 100;
+
+  // a forest of 1000 trees, every other node hangs off a random earlier node so depths and
+  // subtree sizes vary like a real scene's would
+  s32* nodes = new s32[node_count];
+  u64 start = BenchmarkNow();
+  for (u32 i = 0; i < node_count; i++)
+  {
+    Transform local;
+    local.position = vec2(RandomFloatInRange(-1.f, 1.f), RandomFloatInRange(-1.f, 1.f));
+    local.scale = vec2(1.f, 1.f);
+    local.angle = RandomFloatInRange(-0.1f, 0.1f);
+
+    s32 parent = i % 100 == 0 ? -1 : nodes[RandomU32() % i];
+    nodes[i] = CreateNode(parent, local, Entity());
+  }
+  ReportBenchmark("CreateNode 100k", node_count, BenchmarkNow() - start);
+
+  start = BenchmarkNow();
+  UpdateSceneGraph();
+  ReportBenchmark("first UpdateSceneGraph, rebuild and every node", 1, BenchmarkNow() - start);
+
+  // 1% of the nodes move every frame
+  u64 updated = 0;
+  start = BenchmarkNow();
+  for (u32 f = 0; f < frames; f++)
+  {
+    for (u32 m = 0; m < moves_per_frame; m++) TranslateNode(nodes[RandomU32() % node_count], vec2(0.001f, 0.f));
+    UpdateSceneGraph();
+    updated += scene_graph.stats.nodes_updated;
+  }
+  u64 incremental_ns = BenchmarkNow() - start;
+  ReportBenchmark("UpdateSceneGraph, 1% moved (per frame)", frames, incremental_ns);
+  printf("    %llu nodes recomputed per frame on average\n", (unsigned long long)(updated / frames));
+
+  // what it costs to redo every world transform, the same as moving every root
+  start = BenchmarkNow();
+  for (u32 f = 0; f < frames; f++)
+  {
+    for (u32 i = 0; i < node_count; i += 100) TranslateNode(nodes[i], vec2(0.001f, 0.f));
+    UpdateSceneGraph();
+  }
+  u64 full_ns = BenchmarkNow() - start;
+  ReportBenchmark("UpdateSceneGraph, every node (per frame)", frames, full_ns);
+  printf("    %.1fx less work with 1%% moved\n", (f64)full_ns / (f64)incremental_ns);
+
+  start = BenchmarkNow();
+  for (u32 f = 0; f < frames; f++) UpdateSceneGraph();
+  ReportBenchmark("UpdateSceneGraph, nothing moved (per frame)", frames, BenchmarkNow() - start);
+
+  // structural changes put the array back in order on the next update
+  const u32 reparents = 1000;
+  for (u32 r = 0; r < reparents; r++) SetNodeParent(nodes[RandomU32() % node_count], nodes[RandomU32() % node_count]);
+  start = BenchmarkNow();
+  UpdateSceneGraph();
+  ReportBenchmark("UpdateSceneGraph after 1000 reparents, rebuild", 1, BenchmarkNow() - start);
+
+  benchmark_sink += (u64)(GetNodeWorld(nodes[node_count - 1]).position.x() * 1000.f);
+
+  ClearSceneGraph();
+  delete[] nodes;
+}
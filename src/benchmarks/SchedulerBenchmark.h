@@ -0,0 +1,104 @@
+#pragma once
+
+#include "../Core.h"
+#include "../Benchmark.h"
+#include "../Scheduler.h"
+
+
+// stand in systems that each grind through their own 256KB for a fixed amount of work, roughly what
+// a system walking a few columns of a big scene costs
+const u32 SCHEDULER_BENCH_SYSTEMS = 16;
+const u32 SCHEDULER_BENCH_FLOATS = 64 * 1024;
+
+static f32* scheduler_bench_data[SCHEDULER_BENCH_SYSTEMS];
+
+template <u32 N>
+static void SchedulerBenchSystem()
+{
+  f32* data = scheduler_bench_data[N];
+  for (u32 pass = 0; pass < 8; pass++)
+  {
+    for (u32 i = 0; i < SCHEDULER_BENCH_FLOATS; i++) data[i] = data[i] * 0.999f + 0.5f;
+  }
+}
+
+static void BuildBenchmarkSchedule(Schedule& schedule)
+{
+  static const SystemFunc funcs[SCHEDULER_BENCH_SYSTEMS] =
+  {
+    SchedulerBenchSystem<0>, SchedulerBenchSystem<1>, SchedulerBenchSystem<2>, SchedulerBenchSystem<3>,
+    SchedulerBenchSystem<4>, SchedulerBenchSystem<5>, SchedulerBenchSystem<6>, SchedulerBenchSystem<7>,
+    SchedulerBenchSystem<8>, SchedulerBenchSystem<9>, SchedulerBenchSystem<10>, SchedulerBenchSystem<11>,
+    SchedulerBenchSystem<12>, SchedulerBenchSystem<13>, SchedulerBenchSystem<14>, SchedulerBenchSystem<15>
+  };
+  static const char* names[SCHEDULER_BENCH_SYSTEMS] =
+  {
+    "bench 0", "bench 1", "bench 2", "bench 3", "bench 4", "bench 5", "bench 6", "bench 7",
+    "bench 8", "bench 9", "bench 10", "bench 11", "bench 12", "bench 13", "bench 14", "bench 15"
+  };
+
+  // a frame shaped like the engine's: a main thread system up front, a wide middle where most
+  // systems only share reads, a couple of writers that force short chains, and gl at the end
+  schedule.count = 0;
+  schedule.sync_group = 0;
+  AddSystem(schedule, names[0], funcs[0], 0, ResourceAccess(RESOURCE::INPUT), SYSTEM_THREAD::MAIN);
+  for (u32 i = 1; i < SCHEDULER_BENCH_SYSTEMS - 1; i++)
+  {
+    AccessMask writes = 1ull << (8 + i);
+    AccessMask reads = ResourceAccess(RESOURCE::INPUT) | (i % 5 == 0 ? 1ull << (8 + i - 1) : 0);
+    AddSystem(schedule, names[i], funcs[i], reads, writes, SYSTEM_THREAD::ANY);
+  }
+  AddSyncPoint(schedule);
+  AddSystem(schedule, names[SCHEDULER_BENCH_SYSTEMS - 1], funcs[SCHEDULER_BENCH_SYSTEMS - 1], 0, ResourceAccess(RESOURCE::GL), SYSTEM_THREAD::MAIN);
+}
+
+void BenchmarkScheduler()
+{
+  const u32 frames = 100;
+  static Schedule schedule;
+
+  for (u32 i = 0; i < SCHEDULER_BENCH_SYSTEMS; i++)
+  {
+    scheduler_bench_data[i] = new f32[SCHEDULER_BENCH_FLOATS];
+    for (u32 f = 0; f < SCHEDULER_BENCH_FLOATS; f++) scheduler_bench_data[i][f] = (f32)f;
+  }
+
+  schedule.name = "bench";
+  BuildBenchmarkSchedule(schedule);
+
+  printf("    %u cores reported\n", std::thread::hardware_concurrency());
+
+  u64 serial_ns = 0;
+  const u32 worker_counts[] = { 0, 1, 3, 7, 15 };
+  for (u32 workers_wanted : worker_counts)
+  {
+    ShutdownWorkers();
+    if (workers_wanted > 0) InitWorkers(workers_wanted);
+
+    RunSchedule(schedule);    // warm up
+
+    u64 start = BenchmarkNow();
+    for (u32 f = 0; f < frames; f++) RunSchedule(schedule);
+    u64 elapsed = BenchmarkNow() - start;
+    if (workers_wanted == 0) serial_ns = elapsed;
+
+    char label[64];
+    snprintf(label, sizeof(label), "RunSchedule 16 systems, %u workers (per frame)", workers_wanted);
+    ReportBenchmark(label, frames, elapsed);
+    printf("    %.2fx over the main thread alone, %u edges, %.3f ms of work per frame\n",
+      (f64)serial_ns / (f64)elapsed, schedule.stats.edges, schedule.stats.busy_ns / 1e6);
+  }
+
+  ShutdownWorkers();
+
+  // what the graph costs on its own, it is rebuilt every run
+  u64 start = BenchmarkNow();
+  for (u32 f = 0; f < 10000; f++) BuildScheduleGraph(schedule);
+  ReportBenchmark("BuildScheduleGraph 16 systems", 10000, BenchmarkNow() - start);
+
+  for (u32 i = 0; i < SCHEDULER_BENCH_SYSTEMS; i++)
+  {
+    benchmark_sink += (u64)scheduler_bench_data[i][1];
+    delete[] scheduler_bench_data[i];
+  }
+}
@@ -0,0 +1,165 @@
+#pragma once
+
+#include "../Core.h"
+#include "../Benchmark.h"
+#include "../Snapshot.h"
+#include "../EntitySystems.h"
+#include "../Random.h"
+
+
+static void SnapshotBenchmarkTimer(u64 user_data)
+{
+  benchmark_sink += user_data;
+}
+
+static u64 SnapshotBenchmarkChecksum()
+{
+  EcsQuery positions = CreateQuery(ComponentBit(COMPONENT::TRANSFORM), 0);
+  u64 sum = 0;
+  ForEachChunk(positions, [&](const EcsChunk& chunk)
+  {
+    const Transform* transform = ChunkColumn<Transform>(chunk, COMPONENT::TRANSFORM);
+    for (s32 i = 0; i < chunk.count; i++) sum = sum * 31 + (u64)(s64)(transform[i].position.x() * 1e6f) + (u64)(s64)(transform[i].position.y() * 1e3f);
+  });
+
+  return sum;
+}
+
+// 100k entities, 5% of them moving, plus a few hundred timers
+void BenchmarkSnapshot()
+{
+  const s32 entity_count = 100000;
+  const s32 rounds = 50;
+  if (aspect_ratio == 0.f) aspect_ratio = (f32)window_width / (f32)window_height;
+
+  DestroyAllEntities();
+  for (s32 i = 0; i < entity_count; i++)
+  {
+    bool moving = i % 20 == 0;
+    Entity entity = CreateEntity(ComponentBit(COMPONENT::TRANSFORM) | (moving ? ComponentBit(COMPONENT::VELOCITY) : 0));
+    GetComponent<Transform>(entity, COMPONENT::TRANSFORM)->position = vec2(RandomFloatInRange(-1.f, 1.f), RandomFloatInRange(-1.f, 1.f));
+    if (moving) GetComponent<Velocity>(entity, COMPONENT::VELOCITY)->velocity = vec2(RandomFloatInRange(-1.f, 1.f), 0.f);
+  }
+  RegisterTimerCallback("SnapshotBenchmarkTimer", SnapshotBenchmarkTimer);
+  for (s32 t = 0; t < 500; t++) ScheduleTimerTicks(1 + t, 0, SnapshotBenchmarkTimer, t);
+
+  Snapshot baseline, snapshot, delta, rebuilt;
+  CaptureSnapshot(baseline);
+  u64 checksum = SnapshotBenchmarkChecksum();
+
+  u64 start = BenchmarkNow();
+  for (s32 r = 0; r < rounds; r++) CaptureSnapshot(snapshot);
+  ReportBenchmark("CaptureSnapshot 100k entities", rounds, BenchmarkNow() - start);
+  printf("    %llu KB a snapshot, %u chunks\n", (unsigned long long)(snapshot.size / 1024), ecs.stats.chunks);
+
+  // four ticks of movement, then back again
+  for (s32 tick = 0; tick < 4; tick++) MoveEntities(SIMULATION_TICK_SECONDS);
+  CaptureSnapshot(snapshot);
+
+  start = BenchmarkNow();
+  for (s32 r = 0; r < rounds; r++) RestoreSnapshot(baseline);
+  ReportBenchmark("RestoreSnapshot 100k entities", rounds, BenchmarkNow() - start);
+  printf("    restored world %s the captured one\n", SnapshotBenchmarkChecksum() == checksum ? "matches" : "DOES NOT match");
+
+  start = BenchmarkNow();
+  for (s32 r = 0; r < rounds; r++) DiffSnapshot(baseline, snapshot, delta);
+  ReportBenchmark("DiffSnapshot after 4 ticks", rounds, BenchmarkNow() - start);
+  printf("    delta %llu KB, %.1f%% of the snapshot\n", (unsigned long long)(delta.size / 1024), 100.0 * delta.size / snapshot.size);
+
+  start = BenchmarkNow();
+  for (s32 r = 0; r < rounds; r++) ApplySnapshotDelta(baseline, delta, rebuilt);
+  ReportBenchmark("ApplySnapshotDelta", rounds, BenchmarkNow() - start);
+  bool same = rebuilt.size == snapshot.size && memcmp(rebuilt.data, snapshot.data, snapshot.size) == 0;
+  printf("    rebuilt snapshot %s\n", same ? "matches byte for byte" : "DOES NOT match");
+
+  FreeSnapshot(baseline);
+  FreeSnapshot(snapshot);
+  FreeSnapshot(delta);
+  FreeSnapshot(rebuilt);
+  DestroyAllEntities();
+}
+
+// a recorded session: the same world ticking along with a snapshot every 10 ticks, each one
+// compressed on its own and against the one before
+void BenchmarkSnapshotCompression()
+{
+  const s32 entity_count = 100000;
+  const s32 snapshot_count = 30;
+  const s32 ticks_between = 10;
+  if (aspect_ratio == 0.f) aspect_ratio = (f32)window_width / (f32)window_height;
+  InitWorkers(0);
+
+  DestroyAllEntities();
+  for (s32 i = 0; i < entity_count; i++)
+  {
+    bool moving = i % 20 == 0;
+    Entity entity = CreateEntity(ComponentBit(COMPONENT::TRANSFORM) | (moving ? ComponentBit(COMPONENT::VELOCITY) : 0));
+    Transform* transform = GetComponent<Transform>(entity, COMPONENT::TRANSFORM);
+    transform->position = vec2(RandomFloatInRange(-1.f, 1.f), RandomFloatInRange(-1.f, 1.f));
+    transform->scale = vec2(0.05f, 0.05f * aspect_ratio);
+    if (moving) GetComponent<Velocity>(entity, COMPONENT::VELOCITY)->velocity = vec2(RandomFloatInRange(-1.f, 1.f), 0.f);
+  }
+
+  Snapshot session[snapshot_count];
+  for (s32 n = 0; n < snapshot_count; n++)
+  {
+    for (s32 tick = 0; tick < ticks_between; tick++) MoveEntities(SIMULATION_TICK_SECONDS);
+    simulation.tick += ticks_between;
+    CaptureSnapshot(session[n]);
+  }
+
+  u64 raw_bytes = 0, lz_bytes = 0, shuffled_bytes = 0, xor_bytes = 0;
+  u64 compress_ns = 0, lz_decompress_ns = 0, decompress_ns = 0;
+  Snapshot compressed, restored;
+  u8* scratch = new u8[LzCompressBound(session[0].size)];
+  bool exact = true;
+
+  for (s32 n = 0; n < snapshot_count; n++)
+  {
+    raw_bytes += session[n].size;
+    lz_bytes += LzCompress(session[n].data, session[n].size, scratch, LzCompressBound(session[n].size));
+
+    CompressSnapshot(session[n], nullptr, compressed);
+    shuffled_bytes += compressed.size;
+
+    Snapshot* baseline = n > 0 ? &session[n - 1] : nullptr;
+    u64 start = BenchmarkNow();
+    CompressSnapshot(session[n], baseline, compressed);
+    compress_ns += BenchmarkNow() - start;
+    xor_bytes += compressed.size;
+
+    // the codec on its own...
+    start = BenchmarkNow();
+    LzDecompress(compressed.data + sizeof(CompressedSnapshotHeader), compressed.size - sizeof(CompressedSnapshotHeader), scratch, session[n].size);
+    lz_decompress_ns += BenchmarkNow() - start;
+
+    // ...and with the filters undone
+    start = BenchmarkNow();
+    DecompressSnapshot(compressed, baseline, restored);
+    decompress_ns += BenchmarkNow() - start;
+    exact = exact && restored.size == session[n].size && memcmp(restored.data, session[n].data, restored.size) == 0;
+  }
+
+  printf("    %d snapshots of %llu KB, %s after a round trip\n", snapshot_count, (unsigned long long)(session[0].size / 1024), exact ? "all identical" : "NOT identical");
+  printf("    lz only:            %6.2fx\n", (f64)raw_bytes / lz_bytes);
+  printf("    shuffle + lz:       %6.2fx\n", (f64)raw_bytes / shuffled_bytes);
+  printf("    xor + shuffle + lz: %6.2fx\n", (f64)raw_bytes / xor_bytes);
+  ReportBenchmark("CompressSnapshot, xor'd against the last one", snapshot_count, compress_ns);
+  printf("    LzDecompress %.2f GB/s, DecompressSnapshot %.2f GB/s of snapshot\n", (f64)raw_bytes / lz_decompress_ns, (f64)raw_bytes / decompress_ns);
+
+  // only the filtering is left on the calling thread
+  u64 start = BenchmarkNow();
+  for (s32 n = 1; n < snapshot_count; n++) SaveSnapshotAsync(session[n], &session[n - 1], "bench_snapshot.enss");
+  u64 queued = BenchmarkNow() - start;
+  WaitForSnapshotWrites();
+  ReportBenchmark("SaveSnapshotAsync, on the calling thread", snapshot_count - 1, queued);
+  ReportBenchmark("SaveSnapshotAsync, until written", snapshot_count - 1, BenchmarkNow() - start);
+  remove("bench_snapshot.enss");
+
+  delete[] scratch;
+  for (s32 n = 0; n < snapshot_count; n++) FreeSnapshot(session[n]);
+  FreeSnapshot(compressed);
+  FreeSnapshot(restored);
+  DestroyAllEntities();
+  ShutdownWorkers();
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "../Core.h"
+#include "../Benchmark.h"
+#include "../TimerWheel.h"
+#include "../Random.h"
+
+
+// what every TimerInfo check costs, a clock read and a duration_cast against the start time
+static u32 LegacyPollTimer(const std::chrono::steady_clock::time_point& timer_start)
+{
+  auto current_time = std::chrono::steady_clock::now();
+  return (u32)std::chrono::duration_cast<std::chrono::milliseconds>(current_time - timer_start).count();
+}
+
+static u64 timer_benchmark_fired = 0;
+
+static void CountTimerFired(u64 user_data)
+{
+  timer_benchmark_fired += user_data;
+}
+
+void BenchmarkTimerWheel()
+{
+  const u32 timer_count = 1000000;
+  const u32 ticks = 60 * SIMULATION_TICK_HZ;          // a minute of simulation
+  const u32 max_delay = 10 * 60 * SIMULATION_TICK_HZ; // timers spread over the next ten minutes
+
+  RegisterTimerCallback("CountTimerFired", CountTimerFired);
+  TimerHandle* timers = new TimerHandle[timer_count];
+  u64 base_tick = timer_wheel.tick;
+
+  // one in ten repeats, roughly what cooldowns and periodic spawners would look like next to one shots
+  u64 start = BenchmarkNow();
+  for (u32 i = 0; i < timer_count; i++)
+  {
+    u64 delay = 1 + RandomU32() % max_delay;
+    timers[i] = ScheduleTimerTicks(delay, i % 10 == 0 ? delay : 0, CountTimerFired, 1);
+  }
+  ReportBenchmark("ScheduleTimer 1M", timer_count, BenchmarkNow() - start);
+
+  u64 worst_ns = 0;
+  u64 cascaded = 0;
+  start = BenchmarkNow();
+  for (u32 t = 0; t < ticks; t++)
+  {
+    u64 tick_start = BenchmarkNow();
+    AdvanceTimers(base_tick + t);
+    u64 elapsed = BenchmarkNow() - tick_start;
+    worst_ns = elapsed > worst_ns ? elapsed : worst_ns;
+    cascaded += timer_wheel.stats.cascaded;
+  }
+  ReportBenchmark("AdvanceTimers 1M pending (per tick)", ticks, BenchmarkNow() - start);
+  printf("    worst tick %.3f ms, %.1f fired and %.1f cascaded per tick, %u still pending\n",
+    worst_ns / 1e6, (f64)timer_benchmark_fired / ticks, (f64)cascaded / ticks, PendingTimers());
+
+  start = BenchmarkNow();
+  u32 cancelled = 0;
+  for (u32 i = 0; i < timer_count; i++) cancelled += CancelTimer(timers[i]) ? 1 : 0;
+  ReportBenchmark("CancelTimer 1M", timer_count, BenchmarkNow() - start);
+  printf("    %u cancelled, %u pending afterwards\n", cancelled, PendingTimers());
+
+  // an idle wheel with nothing due should cost next to nothing per tick
+  start = BenchmarkNow();
+  for (u32 t = 0; t < ticks; t++) AdvanceTimers(base_tick + ticks + t);
+  ReportBenchmark("AdvanceTimers empty (per tick)", ticks, BenchmarkNow() - start);
+
+  // the polling it replaces, every timer reads the clock and compares against its threshold every frame
+  const u32 legacy_frames = 20;
+  std::chrono::steady_clock::time_point* legacy = new std::chrono::steady_clock::time_point[timer_count];
+  u32* thresholds = new u32[timer_count];
+  for (u32 i = 0; i < timer_count; i++)
+  {
+    legacy[i] = std::chrono::steady_clock::now();
+    thresholds[i] = 1000 + RandomU32() % 600000;
+  }
+
+  start = BenchmarkNow();
+  for (u32 f = 0; f < legacy_frames; f++)
+  {
+    for (u32 i = 0; i < timer_count; i++)
+    {
+      if (LegacyPollTimer(legacy[i]) > thresholds[i]) benchmark_sink += 1;
+    }
+  }
+  ReportBenchmark("polled TimerInfo 1M (per frame)", legacy_frames, BenchmarkNow() - start);
+
+  delete[] thresholds;
+  delete[] legacy;
+  delete[] timers;
+}
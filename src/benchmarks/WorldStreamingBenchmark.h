@@ -0,0 +1,88 @@
+#pragma once
+
+#include "../Core.h"
+#include "../Benchmark.h"
+#include "../WorldStreaming.h"
+#include <algorithm>
+#include <thread>
+
+
+// a 100 x 100 chunk world with 100 entities a chunk, made up on the workers instead of read from disk
+static bool GenerateBenchmarkChunk(s32 x, s32 y, WorldChunkData& data)
+{
+  u32 state = (u32)(x * 73856093) ^ (u32)(y * 19349663) ^ 0x9e3779b9u;
+  for (u32 i = 0; i < 100; i++)
+  {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+
+    ChunkEntityDesc desc;
+    desc.texture = 0;
+    desc.position = vec2(x + (state & 0xffff) / 65536.f, y + (state >> 16) / 65536.f);
+    desc.angle = 0.f;
+    desc.scale = vec2(0.02f, 0.02f);
+    PushChunkEntity(data, desc);
+  }
+
+  return true;
+}
+
+// flies the camera corner to corner and times every UpdateWorldStreaming, anything over 1 ms counts
+// as a hitch...the rest of a frame is stood in for by a short sleep so the loads get their time
+static void FlyAcrossWorld(const char* label, f32 prefetch_seconds)
+{
+  const f32 speed = 12.f;
+  const f32 frame_seconds = 1.f / 60.f;
+
+  OpenGeneratedWorld(1.f, 100, 100, GenerateBenchmarkChunk);
+  SetWorldStreamingRange(2.f, prefetch_seconds);
+  SetWorldStreamingBudget(WORLD_STREAM_DEFAULT_ENTITIES_PER_FRAME, 2ull * 1024 * 1024);
+
+  vec2 position = vec2(2.f, 2.f);
+  vec2 velocity = vec2(speed * 0.7071f, speed * 0.7071f);
+  en::vector<u64> frame_ns;
+  u64 missing = 0, frames_missing = 0, hitches = 0;
+  u32 peak_entities = 0;
+
+  while (position.x() < 98.f)
+  {
+    u64 start = BenchmarkNow();
+    UpdateWorldStreaming(position, velocity);
+    u64 elapsed = BenchmarkNow() - start;
+
+    frame_ns.PushBack(elapsed);
+    if (elapsed > 1000000) hitches++;
+    missing += world_streaming.stats.missing;
+    if (world_streaming.stats.missing > 0) frames_missing++;
+    peak_entities = std::max(peak_entities, EntityCount());
+
+    position = vec2(position.x() + velocity.x() * frame_seconds, position.y() + velocity.y() * frame_seconds);
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  }
+
+  u64 total = 0;
+  for (u64 ns : frame_ns) total += ns;
+  std::sort(frame_ns.begin(), frame_ns.end());
+
+  ReportBenchmark(label, frame_ns.Size(), total);
+  printf("    p99 %.3f ms, worst %.3f ms, %llu frames over 1 ms\n", frame_ns[frame_ns.Size() * 99 / 100] / 1e6,
+    frame_ns[frame_ns.Size() - 1] / 1e6, (unsigned long long)hitches);
+  printf("    %llu chunk loads, %llu evictions, peak %u entities alive of 1M\n", (unsigned long long)world_streaming.stats.loads,
+    (unsigned long long)world_streaming.stats.evictions, peak_entities);
+  printf("    %llu frames had a chunk in range not resident yet (%llu chunk-frames)\n", (unsigned long long)frames_missing,
+    (unsigned long long)missing);
+
+  CloseWorld();
+}
+
+void BenchmarkWorldStreaming()
+{
+  InitWorkers(0);
+  if (aspect_ratio == 0.f) aspect_ratio = (f32)window_width / (f32)window_height;
+
+  FlyAcrossWorld("UpdateWorldStreaming, prefetch (per frame)", WORLD_STREAM_DEFAULT_PREFETCH_SECONDS);
+  FlyAcrossWorld("UpdateWorldStreaming, no prefetch (per frame)", 0.f);
+
+  ShutdownWorkers();
+}
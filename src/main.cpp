@@ -9,11 +9,31 @@
 #include "mat4.h"
 #include "vector.h"
 #include "Timer.h"
+#include "TimerWheel.h"
+#include "Profiler.h"
+#include "FrameStats.h"
+#include "Random.h"
 #include "Particles.h"
 #include "Audio.h"
+#include "AudioSpatial.h"
 #include "Input.h"
+#include "Simulation.h"
+#include "Replay.h"
 #include "Scene.h"
+#include "Assets.h"
+#include "AssetPack.h"
+#include "HotReload.h"
+#include "WorldStreaming.h"
 #include "Animation.h"
+#include "SpriteBatch.h"
+#include "ECS.h"
+#include "EntitySystems.h"
+#include "SceneGraph.h"
+#include "Snapshot.h"
+#include "WorkerPool.h"
+#include "AsyncIO.h"
+#include "Scheduler.h"
+#include "benchmarks/Benchmarks.h"
 
 
 const f64 PI = 3.14159;
@@ -23,20 +43,6 @@ static inline f32 ToRadians(f32 degrees)
   return degrees * ((f32)PI / 180.f);
 }
 
-f32 GetRandomFloat()
-{
-  std::mt19937 generator((u32)std::chrono::steady_clock::now().time_since_epoch().count());
-  std::uniform_real_distribution<f32> distribution(0.f, 1.f);
-  return distribution(generator);
-}
-
-f32 GetRandomFloatInRange(f32 lower, f32 upper)
-{
-  std::mt19937 generator((u32)std::chrono::steady_clock::now().time_since_epoch().count());
-  std::uniform_real_distribution<f32> distribution(lower, upper);
-  return distribution(generator);
-}
-
 TimerInfo game_timer;
 TimerInfo frame_timer;
 f32 game_time = 0.f;
@@ -53,56 +59,296 @@ void CloseWindow()
   application_active = false;
 }
 
+SoundHandle hit_sound;
+
 void Hit()
 {
-  PlaySound("Hit.wav");
+  PlaySound(hit_sound);
 }
 
-AnimInfo megaman_anim = {};
+const f32 MEGAMAN_RUN_SPEED = 0.6f;
+
+Entity megaman;
+s32 megaman_animation = -1;
+s32 megaman_idle_clip = -1;
+s32 megaman_run_clip = -1;
+bool megaman_running = false;
+
+static void RunMegaman(f32 direction)
+{
+  SetAnimationFlipped(megaman_animation, direction < 0.f);
+  megaman_running = true;
+
+  Velocity* velocity = GetComponent<Velocity>(megaman, COMPONENT::VELOCITY);
+  if (velocity) velocity->velocity = vec2(direction * MEGAMAN_RUN_SPEED, 0.f);
+}
 
 void RunRight()
 {
-  megaman_anim.anim_flipped = false;
-  megaman_anim.anim_state = ANIM_STATE::ACTIVE;
-  u32 sprite_timer_value = GetTimerValue(megaman_anim.anim_timer);
-  if (sprite_timer_value > 100)
-  {
-    if (megaman_anim.anim_frame == 9)
-    {
-      megaman_anim.anim_frame = 0;
-    }
-    else
-    {
-      megaman_anim.anim_frame++;
-    }
+  RunMegaman(1.f);
+}
+
+void RunLeft()
+{
+  RunMegaman(-1.f);
+}
+
+// F5 keeps a copy of the world and writes it to QUICK_SAVE_PATH in the background, F9 puts it back
+// (from the file when there's nothing in memory yet)...both wait for the start of the next tick so a
+// replay of the session ends up in the same place. a replay never touches the file, it would be
+// whatever the last live session left there rather than what the recorded one saw
+const char* QUICK_SAVE_PATH = "quicksave.enss";
+Snapshot quick_save;
+bool quick_save_pending = false;
+bool quick_load_pending = false;
+bool replaying = false;
+
+// keeps sprites square on screen
+void WindowResized(GLFWwindow* window, s32 width, s32 height)
+{
+  FramebufferSizeCallback(window, width, height);
+  RescaleEntities();
+}
 
-    StartTimer(megaman_anim.anim_timer);
+void QuickSave()
+{
+  quick_save_pending = true;
+}
+
+void QuickLoad()
+{
+  quick_load_pending = true;
+}
+
+void SetupInputActions()
+{
+  s32 quit_action = CreateInputAction("Quit");
+  BindInput(quit_action, GLFW_KEY_ESCAPE);
+  BindInput(quit_action, InputGamepadButton(GLFW_JOYSTICK_1, GLFW_GAMEPAD_BUTTON_BACK));
+  OnInputAction(quit_action, BUTTON_ACTION::PRESS, CloseWindow);
+
+  s32 hit_action = CreateInputAction("Hit");
+  BindInput(hit_action, GLFW_KEY_SPACE);
+  BindInput(hit_action, InputMouseButton(GLFW_MOUSE_BUTTON_LEFT));
+  BindInput(hit_action, InputGamepadButton(GLFW_JOYSTICK_1, GLFW_GAMEPAD_BUTTON_A));
+  OnInputAction(hit_action, BUTTON_ACTION::PRESS, Hit);
+
+  s32 run_right_action = CreateInputAction("RunRight");
+  BindInput(run_right_action, GLFW_KEY_D);
+  BindInput(run_right_action, GLFW_KEY_RIGHT);
+  BindInput(run_right_action, InputGamepadButton(GLFW_JOYSTICK_1, GLFW_GAMEPAD_BUTTON_DPAD_RIGHT));
+  OnInputAction(run_right_action, BUTTON_ACTION::HOLD, RunRight);
+
+  s32 run_left_action = CreateInputAction("RunLeft");
+  BindInput(run_left_action, GLFW_KEY_A);
+  BindInput(run_left_action, GLFW_KEY_LEFT);
+  BindInput(run_left_action, InputGamepadButton(GLFW_JOYSTICK_1, GLFW_GAMEPAD_BUTTON_DPAD_LEFT));
+  OnInputAction(run_left_action, BUTTON_ACTION::HOLD, RunLeft);
+
+  s32 quick_save_action = CreateInputAction("QuickSave");
+  BindInput(quick_save_action, GLFW_KEY_F5);
+  OnInputAction(quick_save_action, BUTTON_ACTION::PRESS, QuickSave);
+
+  s32 quick_load_action = CreateInputAction("QuickLoad");
+  BindInput(quick_load_action, GLFW_KEY_F9);
+  OnInputAction(quick_load_action, BUTTON_ACTION::PRESS, QuickLoad);
+}
+
+Schedule tick_schedule;
+
+// saves and loads asked for last tick, before anything else looks at the world
+void SnapshotSystem()
+{
+  if (quick_save_pending)
+  {
+    CaptureSnapshot(quick_save);
+    if (!replaying) SaveSnapshotAsync(quick_save, nullptr, QUICK_SAVE_PATH);
   }
+
+  if (quick_load_pending && (quick_save.size || (!replaying && LoadSnapshot(quick_save, QUICK_SAVE_PATH)))) RestoreSnapshot(quick_save);
+  quick_save_pending = false;
+  quick_load_pending = false;
 }
 
-void RunLeft()
+// timer callbacks can do anything, so the timers run on their own before everything else
+void TimersSystem()
+{
+  AdvanceTimers(simulation.tick);
+}
+
+void InputSystem()
+{
+  megaman_running = false;
+  Velocity* velocity = GetComponent<Velocity>(megaman, COMPONENT::VELOCITY);
+  if (velocity) velocity->velocity = vec2();
+
+  ProcessInputTick();
+}
+
+void AnimationSystem()
 {
-  megaman_anim.anim_flipped = true;
-  megaman_anim.anim_state = ANIM_STATE::ACTIVE;
-  u32 sprite_timer_value = GetTimerValue(megaman_anim.anim_timer);
-  if (sprite_timer_value > 100)
+  PlayAnimation(megaman_animation, megaman_running ? megaman_run_clip : megaman_idle_clip);
+  UpdateAnimations(SIMULATION_TICK_SECONDS);
+}
+
+void MovementSystem()
+{
+  MoveEntities(SIMULATION_TICK_SECONDS);
+}
+
+// megaman stops at the edges of the screen
+void MegamanBoundsSystem()
+{
+  Transform* transform = GetComponent<Transform>(megaman, COMPONENT::TRANSFORM);
+  if (!transform) return;
+
+  f32 edge = 1.f - transform->scale.x();
+  f32 x = transform->position.x() < -edge ? -edge : transform->position.x() > edge ? edge : transform->position.x();
+  transform->position = vec2(x, transform->position.y());
+}
+
+// world transforms for everything parented in the scene, after anything that moved a node
+void SceneGraphSystem()
+{
+  UpdateSceneGraph();
+}
+
+void SoundSystem()
+{
+  UpdateSoundSources();
+  UpdateSoundEmitters();
+}
+
+// input callbacks and sounds have to stay on the main thread, animation and movement don't touch
+// the same data and run side by side
+void SetupSimulationSystems()
+{
+  InitSchedule(tick_schedule, "SimulationTick");
+
+  AddSystem(tick_schedule, "Snapshot", SnapshotSystem, ACCESS_ALL, ACCESS_ALL, SYSTEM_THREAD::MAIN);
+  AddSystem(tick_schedule, "Timers", TimersSystem, ACCESS_ALL, ACCESS_ALL, SYSTEM_THREAD::MAIN);
+  AddSystem(tick_schedule, "Input", InputSystem, ResourceAccess(RESOURCE::INPUT),
+    ResourceAccess(RESOURCE::INPUT) | ResourceAccess(RESOURCE::AUDIO) | ResourceAccess(RESOURCE::ANIMATION) | ComponentAccess(COMPONENT::VELOCITY), SYSTEM_THREAD::MAIN);
+  AddSystem(tick_schedule, "Animation", AnimationSystem, ComponentAccess(COMPONENT::ANIMATED), ResourceAccess(RESOURCE::ANIMATION), SYSTEM_THREAD::ANY);
+  AddSystem(tick_schedule, "Movement", MovementSystem, ComponentAccess(COMPONENT::VELOCITY) | ComponentAccess(COMPONENT::SCENE_NODE),
+    ComponentAccess(COMPONENT::TRANSFORM) | ResourceAccess(RESOURCE::SCENE_GRAPH), SYSTEM_THREAD::ANY);
+  AddSystem(tick_schedule, "MegamanBounds", MegamanBoundsSystem, ComponentAccess(COMPONENT::TRANSFORM), ComponentAccess(COMPONENT::TRANSFORM), SYSTEM_THREAD::ANY);
+  AddSystem(tick_schedule, "SceneGraph", SceneGraphSystem, ComponentAccess(COMPONENT::SCENE_NODE),
+    ComponentAccess(COMPONENT::TRANSFORM) | ResourceAccess(RESOURCE::SCENE_GRAPH), SYSTEM_THREAD::ANY);
+  AddSystem(tick_schedule, "Sound", SoundSystem, ComponentAccess(COMPONENT::TRANSFORM) | ComponentAccess(COMPONENT::SOUND_SOURCE),
+    ResourceAccess(RESOURCE::AUDIO), SYSTEM_THREAD::MAIN);
+}
+
+// everything gameplay related happens here at SIMULATION_TICK_HZ, rendering just draws the latest state
+void SimulationTick()
+{
+  RunSchedule(tick_schedule);
+}
+
+// everything the ticks run over...a replay sets up the same world as the session it recorded, just
+// without a window, so its textures and shaders all come back as gl name 0
+void SetupWorld(const char* pack_path, AUDIO_BACKEND audio_backend_type, const char* audio_capture_path)
+{
+  aspect_ratio = (f32)window_width / (f32)window_height;
+
+  // assets.enpak next to the executable, when there is one, is where assets come from
+  MountAssetPack(pack_path);
+
+  if (!InitSound(audio_backend_type, audio_capture_path))
   {
-    if (megaman_anim.anim_frame == 9)
-    {
-      megaman_anim.anim_frame = 0;
-    }
-    else
-    {
-      megaman_anim.anim_frame++;
-    }
+    DebugPrintToConsole("Error: Could not init sound!");
+  }
+
+  InitWorkers(0);
+  InitAsyncIO(ASYNC_IO_DEFAULT_DEPTH);
+  SetupInputActions();
+  SetupSimulationSystems();
+
+  const char* particle_texture_paths[] = { "cloud0.png", "cloud1.png", "cloud2.png", "cloud3.png", "cloud4.png" };
+  AssetHandle particle_assets[5];
+  AcquireTextures(particle_texture_paths, 5, particle_assets);
+  for (s32 p = 0; p < 5; p++) particle_textures[p] = AssetTexture(particle_assets[p]);
+
+  // loading a scene destroys every entity, so it has to come before megaman is created
+  LoadScene("test_scene.enscene");
+  hit_sound = FindSound("Hit.wav");
+  PlaySound(FindSound("MainTheme.wav"));
+
+  LoadAnimationClips("megaman.enanim");
+  megaman_idle_clip = FindAnimationClip("megaman_idle");
+  megaman_run_clip = FindAnimationClip("megaman_run");
+  megaman_animation = CreateAnimation(megaman_idle_clip);
+
+  // animated entities are drawn through the sprite batch, so their sprite needs no vao or shader
+  megaman = CreateEntity(ComponentBit(COMPONENT::TRANSFORM) | ComponentBit(COMPONENT::BASE_SCALE) | ComponentBit(COMPONENT::SPRITE) |
+    ComponentBit(COMPONENT::ANIMATED) | ComponentBit(COMPONENT::VELOCITY));
+  GetComponent<Transform>(megaman, COMPONENT::TRANSFORM)->position = vec2(0.75f, 0.75f);
+  GetComponent<BaseScale>(megaman, COMPONENT::BASE_SCALE)->scale = vec2(0.25f, 0.25f);
+  GetComponent<Sprite>(megaman, COMPONENT::SPRITE)->texture = AssetTexture(AcquireTexture("megaman_run.jpg"));
+  GetComponent<Animated>(megaman, COMPONENT::ANIMATED)->animation = megaman_animation;
+  RescaleEntities();
 
-    StartTimer(megaman_anim.anim_timer);
+  for (s32 i = 0; i < MAX_PARTICLES; i++)
+  {
+    particles.position.PushBack(vec2(RandomFloatInRange(-1.f, 1.f), RandomFloatInRange(-1.f, 1.f)));
+    particles.scale.PushBack(vec2(0.05f, 0.05f));
+    particles.color.PushBack(vec4(RandomFloat(), RandomFloat(), RandomFloat(), RandomFloat()));
   }
 }
 
-s32 main()
+void ShutdownWorld()
 {
-  aspect_ratio = (f32)window_width / (f32)window_height;
+  WaitForSnapshotWrites();
+  FreeSnapshot(quick_save);
+  ShutdownAsyncIO();
+  ShutdownWorkers();
+  ShutdownAssets();
+  ShutdownSound();
+  UnmountAssetPack();
+}
+
+s32 main(s32 argc, char** argv)
+{
+  ProfilerSetThreadName("Main");
+  SetRandomStream(0);
+  FindAssetRoot(argv[0]);
+  std::string pack_path = (std::filesystem::path(argv[0]).parent_path() / "assets.enpak").string();
+
+  if (argc > 2 && strcmp(argv[1], "--bench") == 0)
+  {
+    RegisterBenchmarks();
+    return RunBenchmark(argv[2]) ? 0 : 1;
+  }
+
+  if (argc > 2 && strcmp(argv[1], "--replay") == 0)
+  {
+    // the null audio backend runs every voice like the real one would, without making a sound
+    replaying = true;
+    headless_graphics = true;
+    SetupWorld(pack_path.c_str(), AUDIO_BACKEND::NONE, nullptr);
+    bool replayed = ReplayInputSession(argv[2], SimulationTick, argc > 3 ? argv[3] : nullptr);
+    ShutdownWorld();
+    return replayed ? 0 : 1;
+  }
+
+  const char* record_path = nullptr;
+  if (argc > 2 && strcmp(argv[1], "--record") == 0)
+  {
+    record_path = argv[2];
+  }
+
+  const char* audio_capture_path = nullptr;
+  if (argc > 2 && strcmp(argv[1], "--capture-audio") == 0)
+  {
+    audio_capture_path = argv[2];
+  }
+
+  const char* world_name = nullptr;
+  if (argc > 2 && strcmp(argv[1], "--world") == 0)
+  {
+    world_name = argv[2];
+  }
+
   const char* glsl_version = "#version 330";
 
   GLFWwindow* window;
@@ -118,7 +364,7 @@ s32 main()
   glfwSwapInterval(1);
   glfwSetMouseButtonCallback(window, MouseButtonCallback);
   glfwSetKeyCallback(window, KeyCallback);
-  glfwSetFramebufferSizeCallback(window, FramebufferSizeCallback);
+  glfwSetFramebufferSizeCallback(window, WindowResized);
 
   glewInit();
 
@@ -143,66 +389,36 @@ s32 main()
   ImGui_ImplGlfw_InitForOpenGL(window, true);
   ImGui_ImplOpenGL3_Init((char*)glGetString(GL_NUM_SHADING_LANGUAGE_VERSIONS));
 
-  if (!InitSound())
+  SetupWorld(pack_path.c_str(), AUDIO_BACKEND::FMOD, audio_capture_path);
+  StartTimer(game_timer);
+
+  SpriteBatch sprite_batch;
+  if (!InitSpriteBatch(sprite_batch))
   {
-    DebugPrintToConsole("Error: Could not init sound!");
+    DebugPrintToConsole("Error: Could not init sprite batch!");
   }
 
-  StartTimer(game_timer);
-
-  SetKeyboardInput(CloseWindow, GLFW_KEY_ESCAPE, BUTTON_ACTION::PRESS);
-  SetKeyboardInput(Hit, GLFW_KEY_SPACE, BUTTON_ACTION::PRESS);
-
-  SetKeyboardInput(RunRight, GLFW_KEY_D, BUTTON_ACTION::HOLD);
-  SetKeyboardInput(RunLeft, GLFW_KEY_A, BUTTON_ACTION::HOLD);
-
-  particle_textures[0] = LoadGLTexture("cloud0.png");
-  particle_textures[1] = LoadGLTexture("cloud1.png");
-  particle_textures[2] = LoadGLTexture("cloud2.png");
-  particle_textures[3] = LoadGLTexture("cloud3.png");
-  particle_textures[4] = LoadGLTexture("cloud4.png");
-
-  Entity megaman;
-  megaman.position = vec2(0.75f, 0.75f);
-  megaman.scale = vec2(0.25f, 0.25f * aspect_ratio);
-  megaman.shader = LoadGLShader("entity_animated.glsl");
-  megaman.texture = LoadGLTexture("megaman_run.jpg");
-  megaman.angle = 0.f;
-  glGenVertexArrays(1, &megaman.vao);
-  glGenBuffers(1, &megaman.vbo);
-  glGenBuffers(1, &megaman.ebo);
-  glBindVertexArray(megaman.vao);
-  glBindBuffer(GL_ARRAY_BUFFER, megaman.vbo);
-  glBufferData(GL_ARRAY_BUFFER, 4 * sizeof(Vertex), &megaman.verts[0], GL_STATIC_DRAW);
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, megaman.ebo);
-  glBufferData(GL_ELEMENT_ARRAY_BUFFER, 6 * sizeof(u32), quad_indices, GL_STATIC_DRAW);
-  glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(f32), (void*)0);
-  glEnableVertexAttribArray(0);
-  glBindBuffer(GL_ARRAY_BUFFER, 0);
-  glBindVertexArray(0);
+  if (!InitHotReload())
+  {
+    DebugPrintToConsole("Error: Could not watch assets for hot reload!");
+  }
 
-  entities.PushBack(megaman);
-  original_scales.PushBack(vec2(megaman.scale.x(), megaman.scale.y() / aspect_ratio));
-  StartTimer(megaman_anim.anim_timer);
+  if (world_name && !OpenWorld(world_name))
+  {
+    DebugPrintToConsole("Error: Could not open world!");
+  }
 
   en::vector<ParticleVertex> particle_verts;
   en::vector<u32> particle_indices;
 
-  s32 particle_shader = LoadGLShader("particle_textured.glsl");
-  glUseProgram(particle_shader);
-  s32 samplers[5] = { 0, 1, 2, 3, 4 };
-  glUniform1iv(glGetUniformLocation(particle_shader, "textures"), 5, samplers);
+  s32 particle_shader = AssetShader(AcquireShader("particle_textured.glsl"));
 
   for (s32 i = 0; i < MAX_PARTICLES; i++)
   {
-    particles.position.PushBack(vec2(GetRandomFloatInRange(-1.f, 1.f), GetRandomFloatInRange(-1.f, 1.f)));
-    particles.scale.PushBack(vec2(0.05f, 0.05f));
-    particles.color.PushBack(vec4(GetRandomFloat(), GetRandomFloat(), GetRandomFloat(), GetRandomFloat()));
-
-    particle_verts.PushBack({ vec2(0.1f + particles.position[i].x(), 0.1f + particles.position[i].y()), vec4(particles.color[i]), vec2(0.f, 0.f), 5.f * GetRandomFloat() });
-    particle_verts.PushBack({ vec2(0.1f + particles.position[i].x(), -0.1f + particles.position[i].y()), vec4(particles.color[i]), vec2(1.f, 0.f), 5.f * GetRandomFloat() });
-    particle_verts.PushBack({ vec2(-0.1f + particles.position[i].x(), -0.1f + particles.position[i].y()), vec4(particles.color[i]), vec2(1.f, 1.f), 5.f * GetRandomFloat() });
-    particle_verts.PushBack({ vec2(-0.1f + particles.position[i].x(), 0.1f + particles.position[i].y()), vec4(particles.color[i]), vec2(0.f, 1.f), 5.f * GetRandomFloat() });
+    particle_verts.PushBack({ vec2(0.1f + particles.position[i].x(), 0.1f + particles.position[i].y()), vec4(particles.color[i]), vec2(0.f, 0.f), 5.f * RandomFloat() });
+    particle_verts.PushBack({ vec2(0.1f + particles.position[i].x(), -0.1f + particles.position[i].y()), vec4(particles.color[i]), vec2(1.f, 0.f), 5.f * RandomFloat() });
+    particle_verts.PushBack({ vec2(-0.1f + particles.position[i].x(), -0.1f + particles.position[i].y()), vec4(particles.color[i]), vec2(1.f, 1.f), 5.f * RandomFloat() });
+    particle_verts.PushBack({ vec2(-0.1f + particles.position[i].x(), 0.1f + particles.position[i].y()), vec4(particles.color[i]), vec2(0.f, 1.f), 5.f * RandomFloat() });
 
     particle_indices.PushBack(0 + i * 4);
     particle_indices.PushBack(1 + i * 4);
@@ -218,6 +434,7 @@ s32 main()
   glBindVertexArray(particles.vao);
   glBindBuffer(GL_ARRAY_BUFFER, particles.vbo);
   glBufferData(GL_ARRAY_BUFFER, particles.position.Size() * 4 * sizeof(ParticleVertex), &particle_verts[0], GL_STATIC_DRAW);
+  CountVerticesUploaded(particles.position.Size() * 4);
   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, particles.ebo);
   glBufferData(GL_ELEMENT_ARRAY_BUFFER, particles.position.Size() * 6 * sizeof(u32), &particle_indices[0], GL_STATIC_DRAW);
   glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 9 * sizeof(f32), (void*)0);
@@ -231,103 +448,135 @@ s32 main()
   glBindBuffer(GL_ARRAY_BUFFER, 0);
   glBindVertexArray(0);
 
-  LoadScene("test_scene.enscene");
-  PlaySound("MainTheme.wav");
+  // setup drew from the rng, the ticks start over from the seed itself just like a replay's do
+  u64 seed = random_context.seed.load();
+  SeedRandom(seed);
+  if (record_path)
+  {
+    StartInputRecording(record_path, seed);
+  }
 
   bool show_demo_window = true;
+  bool show_profiler_window = true;
+  bool show_frame_stats_window = true;
+  bool show_audio_window = true;
+  bool show_schedule_window = true;
+  bool show_asset_window = true;
+  bool show_world_window = world_name != nullptr;
+
+  vec2 last_camera_position = camera.position;
+
+  frame_timer.time_scale = TIME::MICROSECOND;
 
   while (application_active)
   {
-    glfwPollEvents();
-    ProcessKeyboardInput(window);
-
+    ProfilerBeginFrame();
     StartTimer(frame_timer);
 
+    {
+      PROFILE_SCOPE("Input");
+      glfwPollEvents();
+      PollGamepads();
+    }
+
+    UpdateHotReload();
+    UpdateAssets();
+
+    {
+      PROFILE_SCOPE("Simulation");
+      AdvanceSimulation(SimulationNow(), SimulationTick);
+    }
+
+    {
+      f32 seconds = delta_time > 0.f ? delta_time : 1.f / 60.f;
+      vec2 camera_velocity = vec2((camera.position.x() - last_camera_position.x()) / seconds, (camera.position.y() - last_camera_position.y()) / seconds);
+      last_camera_position = camera.position;
+      UpdateWorldStreaming(camera.position, camera_velocity);
+    }
+
     glClearColor(1.f, 0.8f, 0.7f, 1.f);
     glClear(GL_COLOR_BUFFER_BIT);
 
-    if (entities.Size() > 0)
+    DrawEntities(sprite_batch);
+
     {
-      for (auto& e : entities)
+      PROFILE_SCOPE("DrawParticles");
+
+      mat4 particle_transform = mat4::Identity();
+      // set every frame, relinking the shader on a hot reload resets it
+      s32 samplers[5] = { 0, 1, 2, 3, 4 };
+      glUseProgram(particle_shader);
+      glUniform1iv(glGetUniformLocation(particle_shader, "textures"), 5, samplers);
+      glActiveTexture(GL_TEXTURE0);
+      glBindTexture(GL_TEXTURE_2D, particle_textures[0]);
+      glActiveTexture(GL_TEXTURE1);
+      glBindTexture(GL_TEXTURE_2D, particle_textures[1]);
+      glActiveTexture(GL_TEXTURE2);
+      glBindTexture(GL_TEXTURE_2D, particle_textures[2]);
+      glActiveTexture(GL_TEXTURE3);
+      glBindTexture(GL_TEXTURE_2D, particle_textures[3]);
+      glActiveTexture(GL_TEXTURE4);
+      glBindTexture(GL_TEXTURE_2D, particle_textures[4]);
+      glUniformMatrix4fv(glGetUniformLocation(particle_shader, "transform"), 1, GL_FALSE, particle_transform.elements);
+
+      glBindVertexArray(particles.vao);
+      glDrawElements(GL_TRIANGLES, 6 * particles.position.Size(), GL_UNSIGNED_INT, 0);
+      CountDrawCall();
+      CountStateChanges(12);
+    }
+
+    {
+      PROFILE_SCOPE("ImGui");
+
+      ImGui_ImplOpenGL3_NewFrame();
+      ImGui_ImplGlfw_NewFrame();
+      ImGui::NewFrame();
+
+      if (show_demo_window) ImGui::ShowDemoWindow(&show_demo_window);
+      if (show_profiler_window) DrawProfilerWindow(&show_profiler_window);
+      if (show_frame_stats_window) DrawFrameStatsWindow(&show_frame_stats_window);
+      if (show_audio_window) DrawAudioWindow(&show_audio_window);
+      if (show_schedule_window) DrawScheduleWindow(&show_schedule_window);
+      if (show_asset_window) DrawAssetWindow(&show_asset_window);
+      if (show_world_window) DrawWorldStreamingWindow(&show_world_window);
+
+      ImGui::Render();
+      ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+
+      if (io.ConfigFlags & ImGuiConfigFlags_ViewportsEnable)
       {
-        mat4 transform = mat4::Identity();
-        transform = mat4::Translate(vec3(e.position.x(), e.position.y(), 0.f));
-        transform *= mat4::Rotate(e.angle, vec3(0.f, 0.f, 1.f));
-        transform *= mat4::Scale(vec3(e.scale.x(), e.scale.y(), 1.f));
-
-        glUseProgram(e.shader);
-        glUniformMatrix4fv(glGetUniformLocation(e.shader, "transform"), 1, GL_FALSE, transform.elements);
-        if (e.shader == megaman.shader)
-        {
-          if (megaman_anim.anim_state == ANIM_STATE::ACTIVE)
-          {
-            glUniform1i(glGetUniformLocation(e.shader, "anim_frame"), megaman_anim.anim_frame);
-          }
-          else
-          {
-            megaman_anim.anim_frame = 0;
-            glUniform1i(glGetUniformLocation(e.shader, "anim_frame"), megaman_anim.anim_frame);
-          }
-        
-          if (megaman_anim.anim_flipped)
-          {
-            glUniform1f(glGetUniformLocation(e.shader, "anim_flip_val"), -1.f);
-          }
-          else
-          {
-            glUniform1f(glGetUniformLocation(e.shader, "anim_flip_val"), 1.f);
-          }
-        }
-
-        glBindVertexArray(e.vao);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, e.texture);
-        glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+        ImGui::UpdatePlatformWindows();
+        ImGui::RenderPlatformWindowsDefault();
+        glfwMakeContextCurrent(window);
       }
     }
 
-    mat4 particle_transform = mat4::Identity();
-    glUseProgram(particle_shader);
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, particle_textures[0]);
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, particle_textures[1]);
-    glActiveTexture(GL_TEXTURE2);
-    glBindTexture(GL_TEXTURE_2D, particle_textures[2]);
-    glActiveTexture(GL_TEXTURE3);
-    glBindTexture(GL_TEXTURE_2D, particle_textures[3]);
-    glActiveTexture(GL_TEXTURE4);
-    glBindTexture(GL_TEXTURE_2D, particle_textures[4]);
-    glUniformMatrix4fv(glGetUniformLocation(particle_shader, "transform"), 1, GL_FALSE, particle_transform.elements);
-
-    glBindVertexArray(particles.vao);
-    glDrawElements(GL_TRIANGLES, 6 * particles.position.Size(), GL_UNSIGNED_INT, 0);
-
-    ImGui_ImplOpenGL3_NewFrame();
-    ImGui_ImplGlfw_NewFrame();
-    ImGui::NewFrame();
-
-    if (show_demo_window) ImGui::ShowDemoWindow(&show_demo_window);
-
-    ImGui::Render();
-    ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
-
-    if (io.ConfigFlags & ImGuiConfigFlags_ViewportsEnable)
     {
-      ImGui::UpdatePlatformWindows();
-      ImGui::RenderPlatformWindowsDefault();
-      glfwMakeContextCurrent(window);
+      PROFILE_SCOPE("SwapBuffers");
+      glfwSwapBuffers(window);
     }
-
-    glfwSwapBuffers(window);
     //DebugPrintToConsole("Frame Time: ", delta_time, "s");
 
     game_time = (f32)GetTimerValue(game_timer) / 1000.f;
     StopTimer(frame_timer);
-    delta_time = frame_timer.time_delta / 1000.f;
-    megaman_anim.anim_state = ANIM_STATE::INACTIVE;
+    delta_time = frame_timer.time_delta / 1000000.f;
+
+    RecordFrameTime(frame_timer.time_delta / 1000.f);
+    SetEntityCounts(EntityCount(), particles.position.Size());
+    FrameStatsEndFrame();
+
+    ProfilerEndFrame();
   }
 
+  if (record_path)
+  {
+    StopInputRecording();
+  }
+
+  ShutdownHotReload();
+  CloseWorld();
+  ShutdownWorld();
+
   DebugPrintToConsole("Clean program exit");
 
   ImGui_ImplOpenGL3_Shutdown();
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "Core.h"
+#include <atomic>
+
+
+namespace en
+{
+  // fixed size single producer / single consumer ring...Push is only ever called from one thread and
+  // Pop from one other thread, neither of them locks or allocates and a full queue just says no
+  template <typename T, u32 capacity>
+  class spsc_queue
+  {
+    static_assert((capacity & (capacity - 1)) == 0, "spsc_queue capacity must be a power of two");
+
+    alignas(64) std::atomic<u32> head{ 0 };    // next slot to pop, written by the consumer
+    u32 cached_tail = 0;                        // consumer's last look at tail
+    alignas(64) std::atomic<u32> tail{ 0 };    // next slot to push, written by the producer
+    u32 cached_head = 0;                        // producer's last look at head
+    alignas(64) T items[capacity];
+
+  public:
+    bool Push(const T& item)
+    {
+      u32 t = tail.load(std::memory_order_relaxed);
+      if (t - cached_head >= capacity)
+      {
+        cached_head = head.load(std::memory_order_acquire);
+        if (t - cached_head >= capacity) return false;
+      }
+
+      items[t & (capacity - 1)] = item;
+      tail.store(t + 1, std::memory_order_release);
+      return true;
+    }
+
+    bool Pop(T& item)
+    {
+      u32 h = head.load(std::memory_order_relaxed);
+      if (h == cached_tail)
+      {
+        cached_tail = tail.load(std::memory_order_acquire);
+        if (h == cached_tail) return false;
+      }
+
+      item = items[h & (capacity - 1)];
+      head.store(h + 1, std::memory_order_release);
+      return true;
+    }
+
+    // only exact when neither side is running
+    u32 Size() const
+    {
+      return tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire);
+    }
+  };
+}
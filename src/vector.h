@@ -41,6 +41,19 @@ namespace en
       ++size;
     }
 
+    void PopBack()
+    {
+      if (size > 0) --size;
+    }
+
+    // replaces the contents with a copy of count values, plain data only
+    void Assign(const T* values, s32 count)
+    {
+      if (count > capacity) Resize(count);
+      if (count > 0) memcpy((void*)data, (const void*)values, count * sizeof(T));
+      size = count;
+    }
+
     void Clear()
     {
       en::vector<T> tmp_vec;
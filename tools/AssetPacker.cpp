@@ -0,0 +1,37 @@
+#include "../src/Core.h"
+#include "../src/AssetPack.h"
+
+
+// offline, builds the pack the engine mounts at startup...run it after changing anything in assets/
+//   AssetPacker [--compress] <assets folder> <pack file>
+s32 main(s32 argc, char** argv)
+{
+  bool compress = argc == 4 && strcmp(argv[1], "--compress") == 0;
+  if (argc != 3 && !compress)
+  {
+    DebugPrintToConsole("usage: AssetPacker [--compress] <assets folder> <pack file>");
+    return 1;
+  }
+
+  const char* directory = argv[argc - 2];
+  const char* output = argv[argc - 1];
+  if (!WriteAssetPack(directory, output, compress)) return 1;
+
+  if (!MountAssetPack(output))
+  {
+    DebugPrintToConsole("Wrote an asset pack that doesn't mount: ", output);
+    return 1;
+  }
+
+  u32 compressed = 0;
+  for (u32 e = 0; e < asset_pack.header->entry_count; e++)
+  {
+    if (asset_pack.entries[e].flags & ASSET_PACK_COMPRESSED) compressed++;
+  }
+
+  DebugPrintToConsole("Packed assets: ", asset_pack.header->entry_count);
+  DebugPrintToConsole("Compressed assets: ", compressed);
+  DebugPrintToConsole("Pack size in bytes: ", asset_pack.header->size);
+  UnmountAssetPack();
+  return 0;
+}